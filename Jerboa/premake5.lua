@@ -34,7 +34,8 @@ project "Jerboa"
 		"spdlog",
 		"glfw",
 		"glad",
-		"ImGui"
+		"ImGui",
+		"JerboaIPC"
 	}
 	
 	filter "system:windows"
@@ -45,6 +46,12 @@ project "Jerboa"
 			"JERBOA_PLATFORM_WINDOWS"
 		}
 
+	filter "system:linux"
+		defines 
+		{ 
+			"JERBOA_PLATFORM_LINUX"
+		}
+
 	filter "configurations:Debug"
 		defines "JERBOA_DEBUG"
 		symbols "On"
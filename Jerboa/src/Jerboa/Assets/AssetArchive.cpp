@@ -0,0 +1,178 @@
+#include "jerboa-pch.h"
+#include "AssetArchive.h"
+
+#include <cstring>
+
+namespace Jerboa {
+	static constexpr uint32_t sMagic = 0x4b41504a; // "JPAK"
+	static constexpr uint32_t sFormatVersion = 1;
+
+	static uint64_t AlignOffset(uint64_t offset, uint64_t alignment)
+	{
+		return (offset + alignment - 1) & ~(alignment - 1);
+	}
+
+	uint64_t AssetArchive::HashName(std::string_view name)
+	{
+		// FNV-1a
+		uint64_t hash = 0xcbf29ce484222325ull;
+		for (char character : name) {
+			hash ^= static_cast<uint8_t>(character);
+			hash *= 0x100000001b3ull;
+		}
+		return hash;
+	}
+
+	bool AssetArchive::Open(const std::string& path)
+	{
+		Close();
+		if (!mFile.Open(path)) {
+			JERBOA_LOG_ERROR("Could not map asset archive \"{}\"", path);
+			return false;
+		}
+
+		const uint8_t* data = mFile.GetData();
+		const uint64_t size = mFile.GetSize();
+		const AssetArchiveHeader* header = reinterpret_cast<const AssetArchiveHeader*>(data);
+		const uint64_t tocEnd = sizeof(AssetArchiveHeader) + (uint64_t)(size >= sizeof(AssetArchiveHeader) ? header->entryCount : 0) * sizeof(AssetArchiveEntry);
+
+		bool valid = size >= sizeof(AssetArchiveHeader) && header->magic == sMagic && header->formatVersion == sFormatVersion
+			&& tocEnd <= size && header->namesOffset >= tocEnd && header->namesOffset <= size && header->namesSize <= size - header->namesOffset;
+
+		const AssetArchiveEntry* entries = reinterpret_cast<const AssetArchiveEntry*>(data + sizeof(AssetArchiveHeader));
+		for (uint32_t i = 0; valid && i < header->entryCount; i++) {
+			const AssetArchiveEntry& entry = entries[i];
+			valid = entry.offset % BlobAlignment == 0 && entry.offset <= size && entry.size <= size - entry.offset
+				&& (uint64_t)entry.nameOffset + entry.nameLength <= header->namesSize
+				&& (i == 0 || entries[i - 1].nameHash <= entry.nameHash)
+				&& (entry.type != AssetType::Texture || entry.size == (uint64_t)entry.width * entry.height * 4);
+		}
+
+		if (!valid) {
+			JERBOA_LOG_ERROR("\"{}\" is not a valid asset archive", path);
+			mFile.Close();
+			return false;
+		}
+
+		mPath = path;
+		mEntries = entries;
+		mEntryCount = header->entryCount;
+		mNames = reinterpret_cast<const char*>(data + header->namesOffset);
+		return true;
+	}
+
+	void AssetArchive::Close()
+	{
+		mFile.Close();
+		mPath.clear();
+		mEntries = nullptr;
+		mEntryCount = 0;
+		mNames = nullptr;
+	}
+
+	const AssetArchiveEntry* AssetArchive::Find(std::string_view name) const
+	{
+		const uint64_t hash = HashName(name);
+		const AssetArchiveEntry* end = mEntries + mEntryCount;
+		const AssetArchiveEntry* entry = std::lower_bound(mEntries, end, hash,
+			[](const AssetArchiveEntry& entry, uint64_t hash) { return entry.nameHash < hash; });
+
+		// Names are compared too, so hash collisions only cost a few extra comparisons
+		for (; entry != end && entry->nameHash == hash; entry++) {
+			if (GetName(*entry) == name)
+				return entry;
+		}
+		return nullptr;
+	}
+
+	std::string_view AssetArchive::GetName(const AssetArchiveEntry& entry) const
+	{
+		return std::string_view(mNames + entry.nameOffset, entry.nameLength);
+	}
+
+	void AssetArchiveWriter::AddBlob(std::string_view name, const void* data, size_t size)
+	{
+		Add(name, AssetType::Blob, 0, 0, data, size);
+	}
+
+	void AssetArchiveWriter::AddTexture(std::string_view name, uint32_t width, uint32_t height, const void* pixels)
+	{
+		Add(name, AssetType::Texture, width, height, pixels, (size_t)width * height * 4);
+	}
+
+	void AssetArchiveWriter::Add(std::string_view name, AssetType type, uint32_t width, uint32_t height, const void* data, size_t size)
+	{
+		PendingEntry entry;
+		entry.name = std::string(name);
+		entry.type = type;
+		entry.width = width;
+		entry.height = height;
+		entry.data.assign(static_cast<const uint8_t*>(data), static_cast<const uint8_t*>(data) + size);
+		mEntries.push_back(std::move(entry));
+	}
+
+	bool AssetArchiveWriter::Write(const std::string& path) const
+	{
+		std::vector<const PendingEntry*> sorted;
+		sorted.reserve(mEntries.size());
+		for (const PendingEntry& entry : mEntries)
+			sorted.push_back(&entry);
+		std::stable_sort(sorted.begin(), sorted.end(), [](const PendingEntry* a, const PendingEntry* b) {
+			return AssetArchive::HashName(a->name) < AssetArchive::HashName(b->name);
+		});
+
+		AssetArchiveHeader header = {};
+		header.magic = sMagic;
+		header.formatVersion = sFormatVersion;
+		header.entryCount = (uint32_t)sorted.size();
+		header.namesOffset = sizeof(AssetArchiveHeader) + sorted.size() * sizeof(AssetArchiveEntry);
+
+		std::string names;
+		std::vector<AssetArchiveEntry> entries(sorted.size());
+		for (size_t i = 0; i < sorted.size(); i++) {
+			entries[i] = {};
+			entries[i].nameHash = AssetArchive::HashName(sorted[i]->name);
+			entries[i].nameOffset = (uint32_t)names.size();
+			entries[i].nameLength = (uint32_t)sorted[i]->name.size();
+			entries[i].type = sorted[i]->type;
+			entries[i].width = sorted[i]->width;
+			entries[i].height = sorted[i]->height;
+			entries[i].size = sorted[i]->data.size();
+			names += sorted[i]->name;
+		}
+		header.namesSize = names.size();
+
+		uint64_t offset = header.namesOffset + header.namesSize;
+		for (AssetArchiveEntry& entry : entries) {
+			offset = AlignOffset(offset, AssetArchive::BlobAlignment);
+			entry.offset = offset;
+			offset += entry.size;
+		}
+
+		std::ofstream file(path, std::ios::binary | std::ios::trunc);
+		if (!file) {
+			JERBOA_LOG_ERROR("Could not write asset archive \"{}\"", path);
+			return false;
+		}
+
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		file.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(AssetArchiveEntry));
+		file.write(names.data(), names.size());
+
+		static const char padding[AssetArchive::BlobAlignment] = {};
+		uint64_t written = header.namesOffset + header.namesSize;
+		for (size_t i = 0; i < entries.size(); i++) {
+			file.write(padding, entries[i].offset - written);
+			file.write(reinterpret_cast<const char*>(sorted[i]->data.data()), sorted[i]->data.size());
+			written = entries[i].offset + entries[i].size;
+		}
+
+		if (!file) {
+			JERBOA_LOG_ERROR("Could not write asset archive \"{}\"", path);
+			return false;
+		}
+
+		JERBOA_LOG_INFO("Wrote {} assets ({} bytes) to \"{}\"", entries.size(), written, path);
+		return true;
+	}
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include "Jerboa/Core/MappedFile.h"
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+
+namespace Jerboa {
+	enum class AssetType : uint32_t
+	{
+		Blob,
+		// RGBA8 pixels, rows bottom to top as OpenGL expects them
+		Texture
+	};
+
+	// Archive layout: header, entries sorted by name hash, names, then the payloads each
+	// starting on a BlobAlignment boundary. Everything is stored in the form the engine
+	// uses at runtime, so nothing needs parsing once the file is mapped.
+	struct AssetArchiveHeader
+	{
+		uint32_t magic;
+		uint32_t formatVersion;
+		uint32_t entryCount;
+		uint32_t reserved;
+		uint64_t namesOffset;
+		uint64_t namesSize;
+	};
+
+	struct AssetArchiveEntry
+	{
+		uint64_t nameHash;
+		uint64_t offset;
+		uint64_t size;
+		uint32_t nameOffset;
+		uint32_t nameLength;
+		AssetType type;
+		uint32_t width;
+		uint32_t height;
+		uint32_t reserved;
+	};
+
+	// Memory-mapped packed archive. Looking up an entry is a binary search over the mapped
+	// table of contents and its payload is a pointer into the mapping, valid while open.
+	class AssetArchive
+	{
+	public:
+		static constexpr uint32_t BlobAlignment = 64;
+
+		// Validates the header and the table of contents, payloads are only paged in on use
+		bool Open(const std::string& path);
+		void Close();
+
+		inline bool IsOpen() const { return mFile.IsOpen(); }
+		inline const std::string& GetPath() const { return mPath; }
+
+		// Names are the paths the assets would be loaded from as loose files
+		const AssetArchiveEntry* Find(std::string_view name) const;
+		std::string_view GetName(const AssetArchiveEntry& entry) const;
+		inline const uint8_t* GetData(const AssetArchiveEntry& entry) const { return mFile.GetData() + entry.offset; }
+
+		inline uint32_t GetEntryCount() const { return mEntryCount; }
+		inline const AssetArchiveEntry& GetEntry(uint32_t index) const { return mEntries[index]; }
+
+		static uint64_t HashName(std::string_view name);
+	private:
+		MappedFile mFile;
+		std::string mPath;
+		const AssetArchiveEntry* mEntries = nullptr;
+		uint32_t mEntryCount = 0;
+		const char* mNames = nullptr;
+	};
+
+	// Packs assets converted to their runtime form into an archive, typically offline
+	class AssetArchiveWriter
+	{
+	public:
+		void AddBlob(std::string_view name, const void* data, size_t size);
+		// pixels holds width * height RGBA8 pixels, bottom row first
+		void AddTexture(std::string_view name, uint32_t width, uint32_t height, const void* pixels);
+
+		bool Write(const std::string& path) const;
+
+		inline uint32_t GetEntryCount() const { return (uint32_t)mEntries.size(); }
+	private:
+		struct PendingEntry
+		{
+			std::string name;
+			AssetType type;
+			uint32_t width = 0;
+			uint32_t height = 0;
+			std::vector<uint8_t> data;
+		};
+
+		void Add(std::string_view name, AssetType type, uint32_t width, uint32_t height, const void* data, size_t size);
+
+		std::vector<PendingEntry> mEntries;
+	};
+}
@@ -0,0 +1,731 @@
+#include "jerboa-pch.h"
+#include "AssetManager.h"
+
+#include "ImageCodec.h"
+#include "AssetReloadedEvent.h"
+#include "Jerboa/Core/Time.h"
+#include "Jerboa/Core/Layer.h"
+#include "Jerboa/Core/StringTable.h"
+#include "Jerboa/Core/FileWatcher.h"
+#include "Jerboa/Core/EventObserver.h"
+#include "Jerboa/Core/Events/FileChangedEvent.h"
+#include "Jerboa/Renderer/Texture.h"
+#include "Jerboa/Profiling/MemoryTracker.h"
+
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <filesystem>
+
+namespace Jerboa {
+	namespace {
+		struct AssetSlot
+		{
+			AssetType type = AssetType::Blob;
+			StringID path;
+			std::atomic<uint32_t> refCount{ 0 };
+			std::atomic<AssetState> state{ AssetState::None };
+			// Set while a hot reload runs through the pipeline, the asset stays usable meanwhile
+			std::atomic<bool> reloading{ false };
+			std::atomic<uint32_t> version{ 0 };
+			bool fromArchive = false;
+
+			// Owned by whichever stage holds the slot while loading, then read only
+			std::vector<uint8_t> fileData;
+			std::vector<uint8_t> pixels;
+			const uint8_t* data = nullptr;
+			size_t size = 0;
+			uint32_t width = 0;
+			uint32_t height = 0;
+			uint32_t uploadedRows = 0;
+			// Contents of a loose blob
+			std::vector<uint8_t> blob;
+
+			// Main thread only
+			std::shared_ptr<Texture2D> texture;
+			// Receives the rows of a reloaded texture, swapped in once complete
+			std::shared_ptr<Texture2D> reloadTexture;
+		};
+
+		struct HotReloadListener
+		{
+			HotReloadListener();
+			void OnFileChanged(const FileChangedEvent& evnt);
+
+			EventObserver fileChangedObserver;
+		};
+
+		// Slots are kept in fixed pages that never move, so handles and stages use them unlocked
+		constexpr uint32_t PageBits = 10;
+		constexpr uint32_t PageSize = 1 << PageBits;
+		constexpr uint32_t MaxPages = 1024;
+
+		struct AssetManagerData
+		{
+			AssetManager::Settings settings;
+
+			std::atomic<AssetSlot*> pages[MaxPages] = {};
+			std::vector<std::unique_ptr<AssetSlot[]>> pageStorage;
+			uint32_t slotCount = 0;
+			std::vector<uint32_t> freeSlots;
+			std::unordered_map<StringID, uint32_t> slotsByPath;
+			std::vector<std::unique_ptr<AssetArchive>> archives;
+
+			std::mutex mutex;
+			std::condition_variable ioWakeUp;
+			std::condition_variable decodeWakeUp;
+			std::deque<uint32_t> ioQueue;
+			std::deque<uint32_t> decodeQueue;
+			std::deque<uint32_t> uploadQueue;
+			std::vector<uint32_t> releaseQueue;
+
+			// Main thread only
+			std::unique_ptr<HotReloadListener> hotReloadListener;
+			// Changes to assets that were still loading, retried every update
+			std::vector<StringID> deferredReloads;
+			std::vector<AssetReloadedEvent> reloaded;
+			// Replaced blob contents, freed one update later
+			std::vector<std::vector<uint8_t>> retiredBlobs;
+			std::vector<std::thread> ioThreads;
+			std::vector<std::thread> decodeThreads;
+			bool running = false;
+
+			std::atomic<uint32_t> pendingLoads{ 0 };
+			std::atomic<uint32_t> archiveLoads{ 0 };
+			std::atomic<uint32_t> fileLoads{ 0 };
+			std::atomic<uint32_t> failedLoads{ 0 };
+			uint64_t uploadedBytes = 0;
+			double lastUploadMs = 0.0;
+			double maxUploadMs = 0.0;
+		};
+
+		AssetManagerData sData;
+		const std::shared_ptr<Texture2D> sNoTexture;
+
+		// Loads whose last handle went away are dropped at the next stage
+		bool IsCancelled(const AssetSlot& slot)
+		{
+			return slot.refCount.load(std::memory_order_acquire) == 0;
+		}
+
+		// The calling stage must not touch the slot afterwards
+		void FinishLoad(AssetSlot& slot, AssetState state)
+		{
+			if (state == AssetState::Failed && !IsCancelled(slot))
+				sData.failedLoads.fetch_add(1, std::memory_order_relaxed);
+			sData.pendingLoads.fetch_sub(1, std::memory_order_relaxed);
+			slot.state.store(state, std::memory_order_release);
+		}
+
+		// A failed reload keeps the previous version of the asset
+		void FinishReload(AssetSlot& slot)
+		{
+			sData.pendingLoads.fetch_sub(1, std::memory_order_relaxed);
+			slot.reloading.store(false, std::memory_order_release);
+		}
+
+		void FinishStage(AssetSlot& slot, bool failed)
+		{
+			if (slot.reloading.load(std::memory_order_relaxed))
+				FinishReload(slot);
+			else
+				FinishLoad(slot, failed ? AssetState::Failed : AssetState::Ready);
+		}
+
+		bool IsInPipeline(const AssetSlot& slot)
+		{
+			return slot.state.load(std::memory_order_acquire) == AssetState::Loading || slot.reloading.load(std::memory_order_acquire);
+		}
+
+		// Checked again under the lock, so a Load() reviving the asset either sees it leave
+		// the pipeline and queues it again, or the stage carries on with it
+		bool DropIfCancelled(AssetSlot& slot)
+		{
+			if (!IsCancelled(slot))
+				return false;
+
+			std::lock_guard<std::mutex> lock(sData.mutex);
+			if (!IsCancelled(slot))
+				return false;
+			slot.fileData = std::vector<uint8_t>();
+			FinishStage(slot, true);
+			return true;
+		}
+
+		AssetSlot& GetSlot(uint32_t index)
+		{
+			return sData.pages[index >> PageBits].load(std::memory_order_acquire)[index % PageSize];
+		}
+
+		// Expects sData.mutex to be held
+		uint32_t AllocateSlot()
+		{
+			if (!sData.freeSlots.empty()) {
+				uint32_t index = sData.freeSlots.back();
+				sData.freeSlots.pop_back();
+				return index;
+			}
+
+			uint32_t index = sData.slotCount++;
+			uint32_t page = index >> PageBits;
+			JERBOA_ASSERT(page < MaxPages, "Too many assets loaded at once");
+			if (index % PageSize == 0) {
+				sData.pageStorage.push_back(std::make_unique<AssetSlot[]>(PageSize));
+				sData.pages[page].store(sData.pageStorage.back().get(), std::memory_order_release);
+			}
+			return index;
+		}
+
+		// Pops the next slot of a stage, false once the asset manager shuts down
+		bool WaitForWork(std::deque<uint32_t>& queue, std::condition_variable& wakeUp, uint32_t& index, AssetSlot*& slot)
+		{
+			std::unique_lock<std::mutex> lock(sData.mutex);
+			wakeUp.wait(lock, [&queue] { return !queue.empty() || !sData.running; });
+			if (!sData.running)
+				return false;
+
+			index = queue.front();
+			queue.pop_front();
+			slot = &GetSlot(index);
+			return true;
+		}
+
+		bool ReadFile(const char* path, std::vector<uint8_t>& data)
+		{
+			std::ifstream file(path, std::ios::binary | std::ios::ate);
+			if (!file)
+				return false;
+
+			std::streamoff size = file.tellg();
+			if (size < 0)
+				return false;
+
+			data.resize(static_cast<size_t>(size));
+			file.seekg(0);
+			return size == 0 || file.read(reinterpret_cast<char*>(data.data()), size).good();
+		}
+
+		void IOLoop()
+		{
+			JERBOA_MEMORY_TAG(Assets);
+			uint32_t index = 0;
+			AssetSlot* slot = nullptr;
+			while (WaitForWork(sData.ioQueue, sData.ioWakeUp, index, slot)) {
+				if (DropIfCancelled(*slot))
+					continue;
+
+				if (!ReadFile(StringTable::GetCString(slot->path), slot->fileData)) {
+					JERBOA_LOG_WARN("Could not read asset \"{}\"", StringTable::Get(slot->path));
+					FinishStage(*slot, true);
+					continue;
+				}
+
+				// Blobs are used as they are stored, reloaded ones are swapped in by Update()
+				if (slot->type == AssetType::Blob && !slot->reloading.load(std::memory_order_relaxed)) {
+					slot->blob.swap(slot->fileData);
+					slot->data = slot->blob.data();
+					slot->size = slot->blob.size();
+					sData.fileLoads.fetch_add(1, std::memory_order_relaxed);
+					FinishLoad(*slot, AssetState::Ready);
+					continue;
+				}
+
+				{
+					std::lock_guard<std::mutex> lock(sData.mutex);
+					(slot->type == AssetType::Blob ? sData.uploadQueue : sData.decodeQueue).push_back(index);
+				}
+				if (slot->type != AssetType::Blob)
+					sData.decodeWakeUp.notify_one();
+			}
+		}
+
+		void DecodeLoop()
+		{
+			JERBOA_MEMORY_TAG(Assets);
+			uint32_t index = 0;
+			AssetSlot* slot = nullptr;
+			while (WaitForWork(sData.decodeQueue, sData.decodeWakeUp, index, slot)) {
+				if (DropIfCancelled(*slot))
+					continue;
+
+				bool decoded = ImageCodec::DecodeTGA(slot->fileData.data(), slot->fileData.size(), slot->pixels, slot->width, slot->height);
+				slot->fileData = std::vector<uint8_t>();
+
+				if (!decoded) {
+					JERBOA_LOG_WARN("Could not decode texture \"{}\", only TGA files are supported", StringTable::Get(slot->path));
+					FinishStage(*slot, true);
+					continue;
+				}
+
+				slot->data = slot->pixels.data();
+				slot->size = slot->pixels.size();
+				slot->uploadedRows = 0;
+				if (!slot->reloading.load(std::memory_order_relaxed))
+					sData.fileLoads.fetch_add(1, std::memory_order_relaxed);
+
+				std::lock_guard<std::mutex> lock(sData.mutex);
+				sData.uploadQueue.push_back(index);
+			}
+		}
+
+		// Expects sData.mutex to be held and the slot to be out of the pipeline
+		void FreeSlot(uint32_t index)
+		{
+			AssetSlot& slot = GetSlot(index);
+			slot.texture.reset();
+			slot.reloadTexture.reset();
+			slot.fileData = std::vector<uint8_t>();
+			slot.pixels = std::vector<uint8_t>();
+			slot.blob = std::vector<uint8_t>();
+			slot.data = nullptr;
+			slot.size = 0;
+			slot.state.store(AssetState::None, std::memory_order_relaxed);
+
+			sData.slotsByPath.erase(slot.path);
+			sData.freeSlots.push_back(index);
+		}
+
+		// Uploads one chunk of rows, true once the texture is complete
+		bool UploadChunk(AssetSlot& slot)
+		{
+			// Reloads go to a new texture, so users never see a half updated one
+			std::shared_ptr<Texture2D>& texture = slot.reloading.load(std::memory_order_relaxed) ? slot.reloadTexture : slot.texture;
+			if (!texture)
+				texture = Texture2D::Create(slot.width, slot.height);
+
+			const size_t rowSize = (size_t)slot.width * 4;
+			const uint32_t chunkRows = std::max<uint32_t>(1, (uint32_t)(sData.settings.uploadChunkBytes / rowSize));
+			const uint32_t rows = std::min(chunkRows, slot.height - slot.uploadedRows);
+			texture->SetRows(slot.data + slot.uploadedRows * rowSize, slot.uploadedRows, rows);
+			slot.uploadedRows += rows;
+			sData.uploadedBytes += rows * rowSize;
+			return slot.uploadedRows == slot.height;
+		}
+
+		// Main thread only, expects sData.mutex to be held. False if the asset is still
+		// loading and the reload has to wait.
+		bool StartReload(StringID path)
+		{
+			auto existing = sData.slotsByPath.find(path);
+			if (existing == sData.slotsByPath.end())
+				return true;
+
+			AssetSlot& slot = GetSlot(existing->second);
+			// Archived assets shadow their loose files
+			if (slot.fromArchive || IsCancelled(slot))
+				return true;
+			if (IsInPipeline(slot))
+				return false;
+
+			JERBOA_LOG_INFO("Reloading \"{}\"", StringTable::Get(path));
+			slot.uploadedRows = 0;
+			sData.pendingLoads.fetch_add(1, std::memory_order_relaxed);
+			// Assets that failed before are simply loaded again
+			if (slot.state.load(std::memory_order_relaxed) == AssetState::Failed)
+				slot.state.store(AssetState::Loading, std::memory_order_relaxed);
+			else
+				slot.reloading.store(true, std::memory_order_relaxed);
+
+			sData.ioQueue.push_back(existing->second);
+			sData.ioWakeUp.notify_one();
+			return true;
+		}
+
+		// Swaps a reloaded blob in, main thread only
+		void CommitBlob(AssetSlot& slot)
+		{
+			// Views handed out before stay valid until the next update
+			sData.retiredBlobs.push_back(std::move(slot.blob));
+			slot.blob = std::move(slot.fileData);
+			slot.fileData = std::vector<uint8_t>();
+			slot.data = slot.blob.data();
+			slot.size = slot.blob.size();
+		}
+
+		HotReloadListener::HotReloadListener()
+			: fileChangedObserver(EventObserver::Create(Layer::GetSharedEventBus(), this, &HotReloadListener::OnFileChanged))
+		{
+		}
+
+		void HotReloadListener::OnFileChanged(const FileChangedEvent& evnt)
+		{
+			// Keep the loaded version of removed files, they are usually about to be replaced
+			if (evnt.type == FileChangeType::Removed)
+				return;
+
+			std::lock_guard<std::mutex> lock(sData.mutex);
+			if (!StartReload(evnt.path) && std::find(sData.deferredReloads.begin(), sData.deferredReloads.end(), evnt.path) == sData.deferredReloads.end())
+				sData.deferredReloads.push_back(evnt.path);
+		}
+	}
+
+	AssetHandle::AssetHandle(const AssetHandle& other)
+		: mSlot(other.mSlot)
+	{
+		if (mSlot != InvalidSlot)
+			AssetManager::AddReference(mSlot);
+	}
+
+	AssetHandle::AssetHandle(AssetHandle&& other) noexcept
+		: mSlot(other.mSlot)
+	{
+		other.mSlot = InvalidSlot;
+	}
+
+	AssetHandle& AssetHandle::operator=(const AssetHandle& other)
+	{
+		if (other.mSlot != InvalidSlot)
+			AssetManager::AddReference(other.mSlot);
+		Reset();
+		mSlot = other.mSlot;
+		return *this;
+	}
+
+	AssetHandle& AssetHandle::operator=(AssetHandle&& other) noexcept
+	{
+		if (this != &other) {
+			Reset();
+			mSlot = other.mSlot;
+			other.mSlot = InvalidSlot;
+		}
+		return *this;
+	}
+
+	AssetHandle::~AssetHandle()
+	{
+		Reset();
+	}
+
+	AssetState AssetHandle::GetState() const
+	{
+		return mSlot == InvalidSlot ? AssetState::None : AssetManager::GetState(mSlot);
+	}
+
+	uint32_t AssetHandle::GetVersion() const
+	{
+		return mSlot == InvalidSlot ? 0 : AssetManager::GetVersion(mSlot);
+	}
+
+	void AssetHandle::Reset()
+	{
+		if (mSlot != InvalidSlot)
+			AssetManager::RemoveReference(mSlot);
+		mSlot = InvalidSlot;
+	}
+
+	const std::shared_ptr<Texture2D>& TextureHandle::Get() const
+	{
+		return mSlot == InvalidSlot ? sNoTexture : AssetManager::GetTexture(mSlot);
+	}
+
+	const uint8_t* BlobHandle::GetData() const
+	{
+		return mSlot == InvalidSlot ? nullptr : AssetManager::GetBlobData(mSlot);
+	}
+
+	size_t BlobHandle::GetSize() const
+	{
+		return mSlot == InvalidSlot ? 0 : AssetManager::GetBlobSize(mSlot);
+	}
+
+	void AssetManager::Init()
+	{
+		Init(Settings());
+	}
+
+	void AssetManager::Init(const Settings& settings)
+	{
+		JERBOA_ASSERT(!sData.running, "AssetManager is already initialized");
+
+		sData.settings = settings;
+		sData.running = true;
+		for (uint32_t i = 0; i < std::max(settings.ioThreadCount, 1u); i++)
+			sData.ioThreads.emplace_back(IOLoop);
+		for (uint32_t i = 0; i < std::max(settings.decodeThreadCount, 1u); i++)
+			sData.decodeThreads.emplace_back(DecodeLoop);
+
+		JERBOA_LOG_INFO("AssetManager started {} IO and {} decode threads", sData.ioThreads.size(), sData.decodeThreads.size());
+
+		if (settings.hotReload && !FileWatcher::IsRunning()) {
+			JERBOA_LOG_WARN("Asset hot reloading needs a running FileWatcher");
+			sData.settings.hotReload = false;
+		}
+		if (sData.settings.hotReload)
+			sData.hotReloadListener = std::make_unique<HotReloadListener>();
+	}
+
+	void AssetManager::Shutdown()
+	{
+		{
+			std::lock_guard<std::mutex> lock(sData.mutex);
+			sData.running = false;
+		}
+		sData.ioWakeUp.notify_all();
+		sData.decodeWakeUp.notify_all();
+
+		for (std::thread& thread : sData.ioThreads)
+			thread.join();
+		for (std::thread& thread : sData.decodeThreads)
+			thread.join();
+		sData.ioThreads.clear();
+		sData.decodeThreads.clear();
+
+		// Handles may outlive the asset manager, their slots stay but are emptied while
+		// the GL context still exists
+		std::lock_guard<std::mutex> lock(sData.mutex);
+		for (uint32_t index = 0; index < sData.slotCount; index++) {
+			if (GetSlot(index).state.load(std::memory_order_relaxed) != AssetState::None)
+				FreeSlot(index);
+		}
+		sData.ioQueue.clear();
+		sData.decodeQueue.clear();
+		sData.uploadQueue.clear();
+		sData.releaseQueue.clear();
+		sData.deferredReloads.clear();
+		sData.retiredBlobs.clear();
+		sData.hotReloadListener.reset();
+		sData.archives.clear();
+		sData.pendingLoads.store(0, std::memory_order_relaxed);
+	}
+
+	bool AssetManager::MountArchive(const std::string& path)
+	{
+		std::unique_ptr<AssetArchive> archive = std::make_unique<AssetArchive>();
+		if (!archive->Open(path))
+			return false;
+
+		JERBOA_LOG_INFO("Mounted asset archive \"{}\" with {} assets", path, archive->GetEntryCount());
+
+		std::lock_guard<std::mutex> lock(sData.mutex);
+		sData.archives.push_back(std::move(archive));
+		return true;
+	}
+
+	TextureHandle AssetManager::LoadTexture(std::string_view path)
+	{
+		return TextureHandle(Load(path, AssetType::Texture));
+	}
+
+	BlobHandle AssetManager::LoadBlob(std::string_view path)
+	{
+		return BlobHandle(Load(path, AssetType::Blob));
+	}
+
+	uint32_t AssetManager::Load(std::string_view path, AssetType type)
+	{
+		StringID pathID = StringTable::Intern(path);
+
+		std::unique_lock<std::mutex> lock(sData.mutex);
+		JERBOA_ASSERT(sData.running, "AssetManager is not initialized");
+
+		auto existing = sData.slotsByPath.find(pathID);
+		if (existing != sData.slotsByPath.end()) {
+			AssetSlot& slot = GetSlot(existing->second);
+			if (slot.type != type) {
+				JERBOA_LOG_ERROR("Asset \"{}\" is already loaded as a different type", path);
+				return AssetHandle::InvalidSlot;
+			}
+			// Also revives assets whose last handle is gone but that are not unloaded yet
+			if (slot.refCount.fetch_add(1, std::memory_order_relaxed) > 0)
+				return existing->second;
+
+			// A stage may have dropped the load meanwhile, which left it failed
+			if (slot.state.load(std::memory_order_relaxed) == AssetState::Failed && !slot.fromArchive && !IsInPipeline(slot)) {
+				slot.uploadedRows = 0;
+				slot.state.store(AssetState::Loading, std::memory_order_relaxed);
+				sData.pendingLoads.fetch_add(1, std::memory_order_relaxed);
+				sData.ioQueue.push_back(existing->second);
+				sData.ioWakeUp.notify_one();
+			}
+			return existing->second;
+		}
+
+		uint32_t index = AllocateSlot();
+		sData.slotsByPath[pathID] = index;
+
+		AssetSlot& slot = GetSlot(index);
+		slot.type = type;
+		slot.path = pathID;
+		slot.width = 0;
+		slot.height = 0;
+		slot.uploadedRows = 0;
+		slot.fromArchive = false;
+		slot.version.store(0, std::memory_order_relaxed);
+		slot.refCount.store(1, std::memory_order_relaxed);
+		slot.state.store(AssetState::Loading, std::memory_order_relaxed);
+		sData.pendingLoads.fetch_add(1, std::memory_order_relaxed);
+
+		// Archived assets are stored ready to use, so loading one is pointing at its payload
+		for (auto archive = sData.archives.rbegin(); archive != sData.archives.rend(); archive++) {
+			const AssetArchiveEntry* entry = (*archive)->Find(path);
+			if (entry == nullptr)
+				continue;
+
+			if (entry->type != type) {
+				JERBOA_LOG_ERROR("Asset \"{}\" in \"{}\" has a different type", path, (*archive)->GetPath());
+				FinishLoad(slot, AssetState::Failed);
+				return index;
+			}
+
+			slot.fromArchive = true;
+			slot.data = (*archive)->GetData(*entry);
+			slot.size = entry->size;
+			slot.width = entry->width;
+			slot.height = entry->height;
+			sData.archiveLoads.fetch_add(1, std::memory_order_relaxed);
+
+			if (type == AssetType::Texture && slot.width > 0 && slot.height > 0)
+				sData.uploadQueue.push_back(index);
+			else
+				FinishLoad(slot, type == AssetType::Texture ? AssetState::Failed : AssetState::Ready);
+			return index;
+		}
+
+		sData.ioQueue.push_back(index);
+		lock.unlock();
+		sData.ioWakeUp.notify_one();
+
+		if (sData.settings.hotReload) {
+			std::string directory = std::filesystem::path(path).parent_path().generic_string();
+			FileWatcher::WatchDirectory(directory.empty() ? "." : directory);
+		}
+		return index;
+	}
+
+	void AssetManager::Update()
+	{
+		Timestamp start = Time::Now();
+		std::unique_lock<std::mutex> lock(sData.mutex);
+		sData.retiredBlobs.clear();
+
+		// Assets still in the pipeline are unloaded once a stage dropped them
+		size_t kept = 0;
+		for (uint32_t index : sData.releaseQueue) {
+			AssetSlot& slot = GetSlot(index);
+			if (slot.refCount.load(std::memory_order_relaxed) > 0 || slot.state.load(std::memory_order_relaxed) == AssetState::None)
+				continue;
+			if (IsInPipeline(slot))
+				sData.releaseQueue[kept++] = index;
+			else
+				FreeSlot(index);
+		}
+		sData.releaseQueue.resize(kept);
+
+		kept = 0;
+		for (StringID path : sData.deferredReloads) {
+			if (!StartReload(path))
+				sData.deferredReloads[kept++] = path;
+		}
+		sData.deferredReloads.resize(kept);
+
+		const Timestamp budget = static_cast<Timestamp>(sData.settings.uploadBudgetMs * 1000000.0);
+		while (!sData.uploadQueue.empty()) {
+			uint32_t index = sData.uploadQueue.front();
+			AssetSlot& slot = GetSlot(index);
+			lock.unlock();
+
+			const bool reload = slot.reloading.load(std::memory_order_relaxed);
+			bool done = IsCancelled(slot), complete = false;
+			if (!done && slot.type == AssetType::Blob) {
+				// Only reloaded blobs pass through here
+				CommitBlob(slot);
+				done = complete = true;
+			}
+			else if (!done && UploadChunk(slot)) {
+				// Texture data from files is not needed anymore, archived data stays mapped
+				slot.pixels = std::vector<uint8_t>();
+				slot.data = nullptr;
+				slot.size = 0;
+				if (reload)
+					slot.texture = std::move(slot.reloadTexture);
+				done = complete = true;
+			}
+
+			lock.lock();
+			// Revived by a Load() since, upload it after all
+			if (done && !complete && !IsCancelled(slot))
+				done = false;
+			if (done) {
+				sData.uploadQueue.pop_front();
+				if (reload && complete) {
+					slot.version.fetch_add(1, std::memory_order_relaxed);
+					sData.reloaded.emplace_back(slot.path, slot.type);
+				}
+				FinishStage(slot, !complete);
+			}
+			if (Time::Now() - start >= budget)
+				break;
+		}
+		lock.unlock();
+
+		// Listeners may load assets themselves
+		for (const AssetReloadedEvent& evnt : sData.reloaded)
+			Layer::GetSharedEventBus()->Publish(evnt);
+		sData.reloaded.clear();
+
+		sData.lastUploadMs = Time::ToMilliseconds(Time::Now() - start);
+		sData.maxUploadMs = std::max(sData.maxUploadMs, sData.lastUploadMs);
+	}
+
+	bool AssetManager::IsBusy()
+	{
+		return sData.pendingLoads.load(std::memory_order_relaxed) > 0;
+	}
+
+	AssetManager::Statistics AssetManager::GetStats()
+	{
+		std::lock_guard<std::mutex> lock(sData.mutex);
+		Statistics stats;
+		stats.liveAssets = (uint32_t)sData.slotsByPath.size();
+		stats.pendingLoads = sData.pendingLoads.load(std::memory_order_relaxed);
+		stats.archiveLoads = sData.archiveLoads.load(std::memory_order_relaxed);
+		stats.fileLoads = sData.fileLoads.load(std::memory_order_relaxed);
+		stats.failedLoads = sData.failedLoads.load(std::memory_order_relaxed);
+		stats.uploadedBytes = sData.uploadedBytes;
+		stats.lastUploadMs = sData.lastUploadMs;
+		stats.maxUploadMs = sData.maxUploadMs;
+		return stats;
+	}
+
+	void AssetManager::AddReference(uint32_t slot)
+	{
+		GetSlot(slot).refCount.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	void AssetManager::RemoveReference(uint32_t slot)
+	{
+		if (GetSlot(slot).refCount.fetch_sub(1, std::memory_order_acq_rel) != 1)
+			return;
+
+		// Textures are deleted on the main thread, so unloading waits for the next Update()
+		std::lock_guard<std::mutex> lock(sData.mutex);
+		sData.releaseQueue.push_back(slot);
+	}
+
+	uint32_t AssetManager::GetVersion(uint32_t slot)
+	{
+		return GetSlot(slot).version.load(std::memory_order_relaxed);
+	}
+
+	AssetState AssetManager::GetState(uint32_t slot)
+	{
+		return GetSlot(slot).state.load(std::memory_order_acquire);
+	}
+
+	const std::shared_ptr<Texture2D>& AssetManager::GetTexture(uint32_t slot)
+	{
+		return GetState(slot) == AssetState::Ready ? GetSlot(slot).texture : sNoTexture;
+	}
+
+	const uint8_t* AssetManager::GetBlobData(uint32_t slot)
+	{
+		return GetState(slot) == AssetState::Ready ? GetSlot(slot).data : nullptr;
+	}
+
+	size_t AssetManager::GetBlobSize(uint32_t slot)
+	{
+		return GetState(slot) == AssetState::Ready ? GetSlot(slot).size : 0;
+	}
+}
@@ -0,0 +1,143 @@
+#pragma once
+
+#include "AssetArchive.h"
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <cstdint>
+
+namespace Jerboa {
+	class Texture2D;
+
+	enum class AssetState : uint8_t
+	{
+		// Empty handle, or the asset manager was shut down
+		None,
+		Loading,
+		Ready,
+		Failed
+	};
+
+	// Counted reference to an asset, the asset is unloaded once its last handle is gone.
+	// Loading the same path again while a handle exists shares the asset.
+	class AssetHandle
+	{
+	public:
+		AssetHandle() = default;
+		AssetHandle(const AssetHandle& other);
+		AssetHandle(AssetHandle&& other) noexcept;
+		AssetHandle& operator=(const AssetHandle& other);
+		AssetHandle& operator=(AssetHandle&& other) noexcept;
+		~AssetHandle();
+
+		AssetState GetState() const;
+		inline bool IsReady() const { return GetState() == AssetState::Ready; }
+		inline bool IsValid() const { return mSlot != InvalidSlot; }
+		// Counts the hot reloads swapped in since the asset was loaded
+		uint32_t GetVersion() const;
+
+		void Reset();
+	protected:
+		static constexpr uint32_t InvalidSlot = 0xffffffff;
+
+		// Adopts a reference that was already counted
+		explicit AssetHandle(uint32_t slot) : mSlot(slot) {}
+
+		uint32_t mSlot = InvalidSlot;
+
+		friend class AssetManager;
+	};
+
+	class TextureHandle : public AssetHandle
+	{
+	public:
+		TextureHandle() = default;
+
+		// Empty until the last rows are uploaded, main thread only
+		const std::shared_ptr<Texture2D>& Get() const;
+	private:
+		explicit TextureHandle(uint32_t slot) : AssetHandle(slot) {}
+
+		friend class AssetManager;
+	};
+
+	class BlobHandle : public AssetHandle
+	{
+	public:
+		BlobHandle() = default;
+
+		// nullptr until ready. Blobs from archives point straight into the mapping. Hot
+		// reloads swap the data in Update(), the previous data lives until the next one.
+		const uint8_t* GetData() const;
+		size_t GetSize() const;
+	private:
+		explicit BlobHandle(uint32_t slot) : AssetHandle(slot) {}
+
+		friend class AssetManager;
+	};
+
+	// Loads assets without stalling the main thread. Assets found in a mounted archive are
+	// ready right away (blobs) or once uploaded (textures); loose files are read by IO
+	// threads and decoded by decode threads. Texture uploads happen in Update(), in chunks
+	// of rows, until the frame's upload budget is spent. With hot reloading, changed loose
+	// files are loaded again in the background and swapped in by Update(), between frames.
+	class AssetManager
+	{
+	public:
+		struct Settings
+		{
+			uint32_t ioThreadCount = 2;
+			uint32_t decodeThreadCount = 2;
+			// Main-thread time per frame for GPU uploads, at least one chunk is uploaded
+			double uploadBudgetMs = 2.0;
+			uint32_t uploadChunkBytes = 256 * 1024;
+			// Watches the directories of loose assets and reloads the ones that change.
+			// Needs a running FileWatcher.
+			bool hotReload = false;
+		};
+
+		struct Statistics
+		{
+			uint32_t liveAssets = 0;
+			uint32_t pendingLoads = 0;
+			uint32_t archiveLoads = 0;
+			uint32_t fileLoads = 0;
+			uint32_t failedLoads = 0;
+			uint64_t uploadedBytes = 0;
+			double lastUploadMs = 0.0;
+			double maxUploadMs = 0.0;
+		};
+
+		static void Init();
+		static void Init(const Settings& settings);
+		static void Shutdown();
+
+		// Archives mounted later take precedence, loose files are the fallback
+		static bool MountArchive(const std::string& path);
+
+		// Thread safe. Loose textures must be TGA files.
+		static TextureHandle LoadTexture(std::string_view path);
+		static BlobHandle LoadBlob(std::string_view path);
+
+		// Uploads pending textures and unloads released assets, main thread only
+		static void Update();
+
+		static bool IsBusy();
+		static Statistics GetStats();
+	private:
+		static uint32_t Load(std::string_view path, AssetType type);
+
+		static void AddReference(uint32_t slot);
+		static void RemoveReference(uint32_t slot);
+		static AssetState GetState(uint32_t slot);
+		static uint32_t GetVersion(uint32_t slot);
+		static const std::shared_ptr<Texture2D>& GetTexture(uint32_t slot);
+		static const uint8_t* GetBlobData(uint32_t slot);
+		static size_t GetBlobSize(uint32_t slot);
+
+		friend class AssetHandle;
+		friend class TextureHandle;
+		friend class BlobHandle;
+	};
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include "AssetArchive.h"
+#include "Jerboa/Event.h"
+#include "Jerboa/Core/StringTable.h"
+
+namespace Jerboa {
+	// Published on the shared event bus after a hot reload was swapped in
+	struct AssetReloadedEvent : public Event {
+		AssetReloadedEvent(StringID path, AssetType type)
+			: path(path), type(type) {}
+
+		StringID path;
+		AssetType type;
+	};
+}
@@ -0,0 +1,116 @@
+#include "jerboa-pch.h"
+#include "ImageCodec.h"
+
+#include <cstring>
+
+namespace Jerboa {
+	namespace {
+		constexpr size_t HeaderSize = 18;
+		constexpr uint8_t TrueColor = 2;
+		constexpr uint8_t TrueColorRLE = 10;
+		// Descriptor bit set when the first stored row is the top one
+		constexpr uint8_t TopToBottom = 0x20;
+
+		uint16_t ReadU16(const uint8_t* data)
+		{
+			return (uint16_t)(data[0] | (data[1] << 8));
+		}
+
+		void StorePixel(const uint8_t* source, uint32_t bytesPerPixel, uint8_t* destination)
+		{
+			// TGA stores BGR(A)
+			destination[0] = source[2];
+			destination[1] = source[1];
+			destination[2] = source[0];
+			destination[3] = bytesPerPixel == 4 ? source[3] : 0xff;
+		}
+	}
+
+	bool ImageCodec::DecodeTGA(const uint8_t* data, size_t size, std::vector<uint8_t>& pixels, uint32_t& width, uint32_t& height)
+	{
+		if (size < HeaderSize)
+			return false;
+
+		const uint8_t idLength = data[0];
+		const uint8_t colorMapType = data[1];
+		const uint8_t imageType = data[2];
+		const uint8_t bitsPerPixel = data[16];
+		const uint8_t descriptor = data[17];
+		width = ReadU16(data + 12);
+		height = ReadU16(data + 14);
+
+		if (colorMapType != 0 || (imageType != TrueColor && imageType != TrueColorRLE) || (bitsPerPixel != 24 && bitsPerPixel != 32) || width == 0 || height == 0)
+			return false;
+
+		const uint32_t bytesPerPixel = bitsPerPixel / 8;
+		const size_t pixelCount = (size_t)width * height;
+		const uint8_t* source = data + HeaderSize + idLength;
+		const uint8_t* end = data + size;
+		if (source > end)
+			return false;
+
+		pixels.resize(pixelCount * 4);
+		uint8_t* destination = pixels.data();
+
+		if (imageType == TrueColor) {
+			if ((size_t)(end - source) < pixelCount * bytesPerPixel)
+				return false;
+			for (size_t i = 0; i < pixelCount; i++, source += bytesPerPixel)
+				StorePixel(source, bytesPerPixel, destination + i * 4);
+		}
+		else {
+			// Packets of up to 128 pixels, either one repeated pixel or literal pixels
+			size_t i = 0;
+			while (i < pixelCount) {
+				if (source >= end)
+					return false;
+				const uint8_t packet = *source++;
+				const size_t count = std::min<size_t>((packet & 0x7f) + 1, pixelCount - i);
+				const bool repeated = (packet & 0x80) != 0;
+				const size_t needed = (repeated ? 1 : count) * bytesPerPixel;
+				if ((size_t)(end - source) < needed)
+					return false;
+
+				for (size_t j = 0; j < count; j++, i++)
+					StorePixel(source + (repeated ? 0 : j * bytesPerPixel), bytesPerPixel, destination + i * 4);
+				source += needed;
+			}
+		}
+
+		if (descriptor & TopToBottom) {
+			const size_t rowSize = (size_t)width * 4;
+			std::vector<uint8_t> row(rowSize);
+			for (uint32_t y = 0; y < height / 2; y++) {
+				uint8_t* top = destination + y * rowSize;
+				uint8_t* bottom = destination + (height - 1 - y) * rowSize;
+				std::memcpy(row.data(), top, rowSize);
+				std::memcpy(top, bottom, rowSize);
+				std::memcpy(bottom, row.data(), rowSize);
+			}
+		}
+		return true;
+	}
+
+	void ImageCodec::EncodeTGA(const uint8_t* pixels, uint32_t width, uint32_t height, std::vector<uint8_t>& data)
+	{
+		JERBOA_ASSERT(width <= 0xffff && height <= 0xffff, "TGA images are at most 65535 pixels wide and high");
+		const size_t pixelCount = (size_t)width * height;
+		data.assign(HeaderSize + pixelCount * 4, 0);
+		data[2] = TrueColor;
+		data[12] = (uint8_t)(width & 0xff);
+		data[13] = (uint8_t)(width >> 8);
+		data[14] = (uint8_t)(height & 0xff);
+		data[15] = (uint8_t)(height >> 8);
+		data[16] = 32;
+		// 8 alpha bits, bottom row first
+		data[17] = 8;
+
+		uint8_t* destination = data.data() + HeaderSize;
+		for (size_t i = 0; i < pixelCount; i++) {
+			destination[i * 4 + 0] = pixels[i * 4 + 2];
+			destination[i * 4 + 1] = pixels[i * 4 + 1];
+			destination[i * 4 + 2] = pixels[i * 4 + 0];
+			destination[i * 4 + 3] = pixels[i * 4 + 3];
+		}
+	}
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace Jerboa {
+	// Decoded images are RGBA8 with the bottom row first, matching Texture2D::SetData
+	namespace ImageCodec {
+		// Uncompressed and run-length encoded true-color TGA, 24 or 32 bits per pixel
+		bool DecodeTGA(const uint8_t* data, size_t size, std::vector<uint8_t>& pixels, uint32_t& width, uint32_t& height);
+		// Uncompressed 32 bits per pixel TGA
+		void EncodeTGA(const uint8_t* pixels, uint32_t width, uint32_t height, std::vector<uint8_t>& data);
+	}
+}
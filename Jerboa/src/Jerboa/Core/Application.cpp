@@ -2,10 +2,33 @@
 #include "Application.h"
 
 #include "Jerboa/UI/ImGui/ImGuiApp.h"
+#include "Jerboa/Renderer/Renderer2D.h"
+#include "Jerboa/Renderer/GLStateCache.h"
+#include "Jerboa/Renderer/ShaderCache.h"
+#include "Jerboa/Profiling/Profiler.h"
+#include "Jerboa/Profiling/GPUProfiler.h"
+#include "Jerboa/Profiling/MemoryTracker.h"
+#include "Jerboa/Core/JobSystem.h"
+#include "Jerboa/Core/FrameAllocator.h"
+#include "Jerboa/Core/FileWatcher.h"
+#include "Jerboa/Core/StartupTracer.h"
 
 namespace Jerboa {
+    Application* Application::sInstance = nullptr;
+
     Application::Application(const ApplicationProps& props)
-        : mWindow(std::unique_ptr<Window>(Window::Create(props.windowProps))),
+        : mCommandLineArgs(props.commandLineArgs),
+        mShaderCacheDirectory(props.shaderCacheDirectory),
+        mLazyImGuiRendering(props.lazyImGuiRendering),
+        mWorkerThreadCount(props.workerThreadCount),
+        mAssetArchives(props.assetArchives),
+        mAssetManagerSettings(props.assetManagerSettings),
+        mIPCBridge(props.ipcBridge),
+        mIPCBridgeSettings(props.ipcBridgeSettings),
+        mTelemetry(props.telemetry),
+        mTelemetrySettings(props.telemetrySettings),
+        mStartupTracePath(props.startupTracePath),
+        mWindow(StartInit(props.windowProps)),
         mWindowResizeObserver(EventObserver::Create(mWindow->GetEventBus().lock().get(), this, &Application::OnWindowResize)),
         mWindowCloseObserver(EventObserver::Create(mWindow->GetEventBus().lock().get(), this, &Application::OnWindowClose)),
         mKeyPressedObserver(EventObserver::Create(mWindow->GetEventBus().lock().get(), this, &Application::OnKeyPressed)),
@@ -16,44 +39,279 @@ namespace Jerboa {
         mMouseButtonPressedObserver(EventObserver::Create(mWindow->GetEventBus().lock().get(), this, &Application::OnMouseButtonPressed)),
         mMouseButtonReleasedObserver(EventObserver::Create(mWindow->GetEventBus().lock().get(), this, &Application::OnMouseButtonReleased))
     {
+        // Began at the end of StartInit()
+        StartupTracer::EndPhase();
+
+        JERBOA_ASSERT(!sInstance, "Only one application can exist at a time");
+        sInstance = this;
+
         mWindow->SetVSync(true);
     }
 
+    Application::~Application()
+    {
+        sInstance = nullptr;
+    }
+
     void Application::Run() {
         Init();
+        StartupTracer::BeginPhase("First frame");
         while (mRunning) {
-            mWindow->Clear();
+            Profiler::BeginFrame();
+            MemoryTracker::BeginFrame();
+            FrameAllocator::Reset();
+            GPUProfiler::BeginFrame();
+            GLStateCache::NewFrame();
+            Renderer2D::ResetStats();
+
+            {
+                JERBOA_PROFILE_RENDER_SCOPE("Clear");
+                JERBOA_MEMORY_TAG(Render);
+                mWindow->Clear();
+            }
+
+            {
+                JERBOA_PROFILE_SCOPE("AssetManager::Update");
+                JERBOA_MEMORY_TAG(Assets);
+                FileWatcher::DispatchChanges(Layer::GetSharedEventBus());
+                AssetManager::Update();
+            }
+
+            {
+                JERBOA_PROFILE_SCOPE("IPCBridge::DispatchMessages");
+                JERBOA_MEMORY_TAG(Events);
+                IPCBridge::DispatchMessages(Layer::GetSharedEventBus());
+            }
 
-            for (Layer* layer : mLayerStack)
-                layer->OnUpdate();
+            {
+                JERBOA_PROFILE_RENDER_SCOPE("Layers");
+                JERBOA_MEMORY_TAG(Layers);
+                uint32_t layerIndex = 0;
+                for (Layer* layer : mLayerStack) {
+                    JERBOA_PROFILE_RENDER_SCOPE(layer->GetProfileName());
+                    mRenderQueue.SetCurrentLayer(layerIndex++);
+                    layer->OnUpdate();
+                }
+            }
 
-            RenderImGui();
+            {
+                JERBOA_PROFILE_RENDER_SCOPE("RenderQueue");
+                JERBOA_MEMORY_TAG(Render);
+                mRenderQueue.Flush();
+            }
 
-            mWindow->Update();
+            {
+                JERBOA_PROFILE_RENDER_SCOPE("ImGui");
+                JERBOA_MEMORY_TAG(ImGui);
+                RenderImGui();
+            }
+
+            GPUProfiler::EndFrame();
+            // After the GPU frame ended, its timer queries only exist in the main context
+            if (!mSecondaryWindows.empty()) {
+                JERBOA_PROFILE_SCOPE("Secondary windows");
+                JERBOA_MEMORY_TAG(Render);
+                RenderSecondaryWindows();
+            }
+            {
+                JERBOA_PROFILE_SCOPE("Window::Update");
+                JERBOA_MEMORY_TAG(Render);
+                mWindow->Update();
+            }
+
+            if (StartupTracer::IsRecording())
+                EndFirstFrame();
+            ReportInputLatency();
+            Profiler::EndFrame();
+
+            if (Telemetry::IsConnected())
+                RecordTelemetryCounters();
+            Telemetry::EndFrame();
         }
         ShutDown();
     }
 
+    Window* Application::OpenWindow(const WindowProps& props, std::function<void(Window&)> render)
+    {
+        WindowProps sharedProps = props;
+        sharedProps.sharedContext = mWindow.get();
+        Window* window = Window::Create(sharedProps);
+
+        // Waiting for a vblank in every window's swap would stall the frame once per window,
+        // only the main window's swap paces the frame loop
+        window->SetVSync(false);
+        mWindow->MakeContextCurrent();
+
+        mSecondaryWindows.push_back(std::make_unique<SecondaryWindow>(window, std::move(render)));
+        return window;
+    }
+
+    void Application::CloseWindow(Window* window)
+    {
+        for (const std::unique_ptr<SecondaryWindow>& secondary : mSecondaryWindows) {
+            if (secondary->window.get() == window)
+                secondary->closing = true;
+        }
+    }
+
+    void Application::RenderSecondaryWindows()
+    {
+        mSecondaryWindows.erase(std::remove_if(mSecondaryWindows.begin(), mSecondaryWindows.end(),
+            [](const std::unique_ptr<SecondaryWindow>& secondary) { return secondary->closing; }), mSecondaryWindows.end());
+
+        for (const std::unique_ptr<SecondaryWindow>& secondary : mSecondaryWindows) {
+            Window& window = *secondary->window;
+            window.MakeContextCurrent();
+            GLStateCache::SetViewport(0, 0, window.GetWidth(), window.GetHeight());
+            window.Clear();
+            secondary->render(window);
+            window.Present();
+        }
+
+        // The main window presents last, its swap interval paces the frame
+        mWindow->MakeContextCurrent();
+    }
+
+    void Application::ReportInputLatency()
+    {
+        InputLatencyTracker& latency = mWindow->GetInputLatency();
+        if (latency.HasNewSample())
+            mLastInputLatencyMs = Time::ToMilliseconds(latency.GetLastLatency());
+
+        if (++mFramesSinceLatencyReport < sInputLatencyReportInterval)
+            return;
+        mFramesSinceLatencyReport = 0;
+
+        mInputLatencyStats = latency.ComputeStats();
+        latency.ResetStats();
+
+        if (mInputLatencyStats.sampleCount > 0) {
+            JERBOA_LOG_TRACE("Input-to-swap latency over {} frames: min {:.2f} ms, mean {:.2f} ms, p99 {:.2f} ms",
+                mInputLatencyStats.sampleCount, mInputLatencyStats.minMs, mInputLatencyStats.meanMs, mInputLatencyStats.p99Ms);
+        }
+    }
+
+    void Application::RecordTelemetryCounters()
+    {
+        const Renderer2D::Statistics& stats = Renderer2D::GetStats();
+        Telemetry::RecordCounter("Renderer2D draw calls", stats.drawCalls);
+        Telemetry::RecordCounter("Renderer2D quads", stats.quadCount);
+        Telemetry::RecordCounter("Renderer2D circles", stats.circleCount);
+        Telemetry::RecordCounter("Renderer2D lines", stats.lineCount);
+        Telemetry::RecordCounter("GPU frame (ms)", GPUProfiler::GetLastFrameTime());
+        Telemetry::RecordCounter("Input latency (ms)", mLastInputLatencyMs);
+        Telemetry::RecordCounter("Frame arena (bytes)", (double)FrameAllocator::Get().GetUsed());
+        if (MemoryTracker::IsEnabled()) {
+            MemoryTagStats memory = MemoryTracker::GetTotalStats();
+            Telemetry::RecordCounter("Live heap (bytes)", (double)memory.liveBytes);
+            Telemetry::RecordCounter("Heap allocations per frame", (double)memory.frameAllocations);
+        }
+    }
+
+    Window* Application::StartInit(const WindowProps& windowProps)
+    {
+        // None of these need the GL context
+        mInitGraph.Add("JobSystem::Init", [this]() { JobSystem::Init(mWorkerThreadCount); });
+        mShaderPrefetchStep = mInitGraph.Add("ShaderCache::Prefetch", [this]() { ShaderCache::Prefetch(mShaderCacheDirectory); });
+        InitGraph::Step fileWatcher = mInitGraph.Add("FileWatcher::Init", [this]() {
+            if (mAssetManagerSettings.hotReload)
+                FileWatcher::Init();
+        });
+        InitGraph::Step assetManager = mInitGraph.Add("AssetManager::Init", [this]() { AssetManager::Init(mAssetManagerSettings); }, { fileWatcher });
+        mInitGraph.Add("AssetManager::MountArchive", [this]() {
+            for (const std::string& archive : mAssetArchives)
+                AssetManager::MountArchive(archive);
+        }, { assetManager });
+        mInitGraph.Add("IPCBridge::Init", [this]() {
+            if (mIPCBridge)
+                IPCBridge::Init(mIPCBridgeSettings);
+        });
+        mInitGraph.Add("Telemetry::Init", [this]() {
+            if (mTelemetry)
+                Telemetry::Init(mTelemetrySettings);
+        });
+        mInitGraph.Start();
+
+        Window* window;
+        {
+            JERBOA_STARTUP_SCOPE("Window::Create");
+            window = Window::Create(windowProps);
+        }
+
+        // Ends in the constructor, after the event observers were created
+        StartupTracer::BeginPhase("EventObserver::Create");
+        return window;
+    }
+
     void Application::Init()
     {
+        JERBOA_STARTUP_SCOPE("Application::Init");
         JERBOA_LOG_INFO("Initializing application");
-        
-        UI::ImGuiApp::Initialize(mWindow.get());
 
-        OnInit();
+        // GL steps run on the main thread while the init graph finishes the others
+        {
+            JERBOA_STARTUP_SCOPE("ImGuiApp::Initialize");
+            UI::ImGuiApp::Initialize(mWindow.get());
+        }
+        {
+            JERBOA_STARTUP_SCOPE("GPUProfiler::Init");
+            GPUProfiler::Init();
+        }
+        {
+            JERBOA_STARTUP_SCOPE("ShaderCache::Init");
+            mInitGraph.Wait(mShaderPrefetchStep);
+            ShaderCache::Init(mShaderCacheDirectory);
+        }
+        {
+            JERBOA_STARTUP_SCOPE("Renderer2D::Init");
+            Renderer2D::Init();
+        }
+        {
+            JERBOA_STARTUP_SCOPE("InitGraph::WaitAll");
+            mInitGraph.WaitAll();
+        }
+        {
+            JERBOA_STARTUP_SCOPE("OnInit");
+            OnInit();
+        }
+
+        ShaderCache::LogStats();
+    }
+
+    void Application::EndFirstFrame()
+    {
+        // Began in Run()
+        StartupTracer::EndPhase();
+        StartupTracer::EndFirstFrame();
+        if (!mStartupTracePath.empty())
+            StartupTracer::WriteTrace(mStartupTracePath);
     }
 
     void Application::ShutDown()
     {
         JERBOA_LOG_INFO("Shutting down application");
 
-        UI::ImGuiApp::ShutDown();
-
         OnShutdown();
+        mSecondaryWindows.clear();
+
+        IPCBridge::Shutdown();
+        Telemetry::Shutdown();
+        AssetManager::Shutdown();
+        FileWatcher::Shutdown();
+        GPUProfiler::Shutdown();
+        Renderer2D::Shutdown();
+        UI::ImGuiApp::ShutDown();
+        JobSystem::Shutdown();
     }
 
     void Application::RenderImGui()
     {
+        if (!NeedsImGuiRebuild()) {
+            mImGuiFramesSkipped++;
+            Jerboa::UI::ImGuiApp::RenderCachedFrame();
+            return;
+        }
+
         Jerboa::UI::ImGuiApp::BeginFrame();
         
         for (Layer* layer : mLayerStack)
@@ -62,6 +320,28 @@ namespace Jerboa {
         Jerboa::UI::ImGuiApp::EndFrame();
     }
 
+    bool Application::NeedsImGuiRebuild()
+    {
+        // Every layer's flag is consumed each frame, so a request never lingers
+        bool dirty = mUIInputPending;
+        for (Layer* layer : mLayerStack)
+            dirty |= layer->ConsumeUIDirty();
+        dirty |= UI::ImGuiApp::ConsumeViewportInput();
+        mUIInputPending = false;
+
+        if (dirty)
+            mImGuiSettleFramesLeft = sImGuiSettleFrames;
+
+        if (!mLazyImGuiRendering || !UI::ImGuiApp::HasCachedFrame() || UI::ImGuiApp::WantsContinuousUpdate())
+            return true;
+
+        if (mImGuiSettleFramesLeft == 0)
+            return false;
+
+        mImGuiSettleFramesLeft--;
+        return true;
+    }
+
     void Application::PushLayer(Layer* layer) {
         mLayerStack.PushLayer(layer);
         layer->OnAttach();
@@ -74,46 +354,54 @@ namespace Jerboa {
 
     void Application::OnWindowResize(const WindowResizeEvent& evnt)
     {
+        mUIInputPending = true;
         Layer::GetSharedEventBus()->Publish(evnt);
     }
 
-    void Application::OnWindowClose(const WindowCloseEvent& evnt)
+    void Application::OnWindowClose(const WindowCloseEvent&)
     {
         mRunning = false;
     }
 
     void Application::OnKeyPressed(const KeyPressedEvent& evnt)
     {
-        JERBOA_LOG_TRACE("Pressed '{}' (mods {}), ", GetKeyName(evnt.key), evnt.modifiers);
+        mUIInputPending = true;
+        JERBOA_LOG_TRACE("Pressed '{}' (mods {}), ", GetKeyName(evnt.key), static_cast<int>(evnt.modifiers));
     }
 
     void Application::OnKeyReleased(const KeyReleasedEvent& evnt)
     {
-        JERBOA_LOG_TRACE("Released '{}' (mods {}), ", GetKeyName(evnt.key), evnt.modifiers);
+        mUIInputPending = true;
+        JERBOA_LOG_TRACE("Released '{}' (mods {}), ", GetKeyName(evnt.key), static_cast<int>(evnt.modifiers));
     }
 
     void Application::OnKeyRepeat(const KeyRepeatEvent& evnt)
     {
-        JERBOA_LOG_TRACE("Continiously pressing '{}' (mods {}), ", GetKeyName(evnt.key), evnt.modifiers);
+        mUIInputPending = true;
+        JERBOA_LOG_TRACE("Continiously pressing '{}' (mods {}), ", GetKeyName(evnt.key), static_cast<int>(evnt.modifiers));
     }
 
     void Application::OnMouseMoved(const MouseMovedEvent& evnt)
     {
+        mUIInputPending = true;
         JERBOA_LOG_TRACE("Mouse moved ({}, {})", evnt.x, evnt.y);
     }
 
     void Application::OnMouseScrolled(const MouseScrolledEvent& evnt)
     {
+        mUIInputPending = true;
         JERBOA_LOG_TRACE("Mouse scrolled ({}, {})", evnt.xOffset, evnt.yOffset);
     }
 
     void Jerboa::Application::OnMouseButtonPressed(const MouseButtonPressedEvent& evnt)
     {
-        JERBOA_LOG_TRACE("Pressed mouse button {} (modifiers {})", evnt.button, evnt.modifiers);
+        mUIInputPending = true;
+        JERBOA_LOG_TRACE("Pressed mouse button {} (modifiers {})", static_cast<int>(evnt.button), static_cast<int>(evnt.modifiers));
     }
 
     void Jerboa::Application::OnMouseButtonReleased(const MouseButtonReleasedEvent& evnt)
     {
-        JERBOA_LOG_TRACE("Released mouse button {} (modifiers {})", evnt.button, evnt.modifiers);
+        mUIInputPending = true;
+        JERBOA_LOG_TRACE("Released mouse button {} (modifiers {})", static_cast<int>(evnt.button), static_cast<int>(evnt.modifiers));
     }
 }
\ No newline at end of file
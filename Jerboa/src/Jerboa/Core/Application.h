@@ -11,29 +11,96 @@
 #include "Events/MouseScrolledEvent.h"
 #include "Events/MouseButtonPressedEvent.h"
 #include "Events/MouseButtonReleasedEvent.h"
+#include "Assert.h"
+#include "InitGraph.h"
+#include "Jerboa/Renderer/RenderQueue.h"
+#include "Jerboa/Assets/AssetManager.h"
+#include "IPCBridge.h"
+#include "Jerboa/Profiling/Telemetry.h"
 
 namespace Jerboa {
+    struct ApplicationCommandLineArgs {
+        int count = 0;
+        char** args = nullptr;
+
+        const char* operator[](int index) const {
+            JERBOA_ASSERT(index < count, "Command line argument index out of range");
+            return args[index];
+        }
+    };
+
     struct ApplicationProps {
         WindowProps windowProps;
+        ApplicationCommandLineArgs commandLineArgs;
+        // Linked shader binaries are cached here between runs, empty disables the cache
+        std::string shaderCacheDirectory = "cache/shaders";
+        // Skip rebuilding the ImGui UI on frames without input or dirty layers and redraw
+        // the previous frame's draw data instead
+        bool lazyImGuiRendering = false;
+        // Worker threads for the JobSystem, 0 uses one per hardware thread besides the main thread
+        uint32_t workerThreadCount = 0;
+        // Packed asset archives memory-mapped at startup, later ones take precedence
+        std::vector<std::string> assetArchives;
+        AssetManager::Settings assetManagerSettings;
+        // Lets local processes publish events into the shared event bus, see IPCBridge
+        bool ipcBridge = false;
+        IPCBridge::Settings ipcBridgeSettings;
+        // Streams profiler zones, counters and log lines to JerboaViewer, see Telemetry
+        bool telemetry = false;
+        Telemetry::Settings telemetrySettings;
+        // The startup phases are written here as a Chrome trace after the first frame, empty writes none
+        std::string startupTracePath;
     };
 
     class Application
     {
     public:
         Application(const ApplicationProps& props);
+        virtual ~Application();
 
         void Run();
+        // Stops the frame loop after the current frame, main() returns exitCode
+        void Close(int exitCode = 0) { mRunning = false; mExitCode = exitCode; }
+        inline int GetExitCode() const { return mExitCode; }
 
         virtual void OnInit() {}
         virtual void OnShutdown() {}
 
         void PushLayer(Layer* layer);
         void PushOverlay(Layer* overlay);
+
+        inline Window& GetWindow() { return *mWindow; }
+        // Opens a tool window whose context shares textures, buffers and shaders with the main
+        // window. render runs every frame with its context current, after the main window
+        // rendered. Input goes to the window's own event bus, closing it only closes the window.
+        Window* OpenWindow(const WindowProps& props, std::function<void(Window&)> render);
+        // The window is destroyed at the start of the next frame's window rendering
+        void CloseWindow(Window* window);
+        // Draws submitted here during OnUpdate are sorted and issued after all layers updated
+        inline RenderQueue& GetRenderQueue() { return mRenderQueue; }
+        inline const ApplicationCommandLineArgs& GetCommandLineArgs() const { return mCommandLineArgs; }
+
+        static Application& Get() { return *sInstance; }
+
+        // Input-to-swap latency of the most recent frame that handled input
+        inline double GetLastInputLatency() const { return mLastInputLatencyMs; }
+        // Latency statistics of the last completed reporting interval
+        inline const LatencyStats& GetInputLatencyStats() const { return mInputLatencyStats; }
+
+        inline void SetLazyImGuiRendering(bool enabled) { mLazyImGuiRendering = enabled; }
+        inline bool IsLazyImGuiRendering() const { return mLazyImGuiRendering; }
+        inline uint64_t GetSkippedImGuiFrames() const { return mImGuiFramesSkipped; }
     private:
+        Window* StartInit(const WindowProps& windowProps);
         void Init();
         void ShutDown();
+        void EndFirstFrame();
 
         void RenderImGui();
+        void RenderSecondaryWindows();
+        bool NeedsImGuiRebuild();
+        void ReportInputLatency();
+        void RecordTelemetryCounters();
 
         void OnWindowResize(const WindowResizeEvent& evnt);
         void OnWindowClose(const WindowCloseEvent& evnt);
@@ -45,9 +112,54 @@ namespace Jerboa {
         void OnMouseButtonPressed(const MouseButtonPressedEvent& evnt);
         void OnMouseButtonReleased(const MouseButtonReleasedEvent& evnt);
 
+        static Application* sInstance;
+
+        ApplicationCommandLineArgs mCommandLineArgs;
+        std::string mShaderCacheDirectory;
+        bool mLazyImGuiRendering;
+        uint32_t mWorkerThreadCount;
+        std::vector<std::string> mAssetArchives;
+        AssetManager::Settings mAssetManagerSettings;
+        bool mIPCBridge;
+        IPCBridge::Settings mIPCBridgeSettings;
+        bool mTelemetry;
+        Telemetry::Settings mTelemetrySettings;
+        std::string mStartupTracePath;
+        // Created before the window, so its steps run while the window is created
+        InitGraph mInitGraph;
+        InitGraph::Step mShaderPrefetchStep = 0;
         std::unique_ptr<Window> mWindow;
+        struct SecondaryWindow
+        {
+            SecondaryWindow(Window* window, std::function<void(Window&)> render)
+                : window(window), render(std::move(render)),
+                closeObserver(EventObserver::Create(window->GetEventBus().lock().get(), this, &SecondaryWindow::OnClose))
+            {}
+
+            void OnClose(const WindowCloseEvent&) { closing = true; }
+
+            std::unique_ptr<Window> window;
+            std::function<void(Window&)> render;
+            bool closing = false;
+            // Declared last, so it unsubscribes before the window and its event bus go away
+            EventObserver closeObserver;
+        };
+        std::vector<std::unique_ptr<SecondaryWindow>> mSecondaryWindows;
         bool mRunning = true;
+        int mExitCode = 0;
         LayerStack mLayerStack;
+        RenderQueue mRenderQueue;
+
+        static constexpr unsigned int sInputLatencyReportInterval = 300;
+        unsigned int mFramesSinceLatencyReport = 0;
+        double mLastInputLatencyMs = 0.0;
+        LatencyStats mInputLatencyStats;
+
+        // ImGui needs a few frames after a change to settle hover state and auto-sizing
+        static constexpr unsigned int sImGuiSettleFrames = 3;
+        bool mUIInputPending = true;
+        unsigned int mImGuiSettleFramesLeft = 0;
+        uint64_t mImGuiFramesSkipped = 0;
 
         EventObserver 
             mWindowResizeObserver, 
@@ -62,5 +174,5 @@ namespace Jerboa {
     };
 
     // Implemented by client
-    Application* CreateApplication();
+    Application* CreateApplication(ApplicationCommandLineArgs args);
 };
\ No newline at end of file
@@ -6,11 +6,17 @@
 	#define JERBOA_ASSERTS_ENABLED
 #endif
 
+#ifdef JERBOA_PLATFORM_WINDOWS
+	#define JERBOA_DEBUGBREAK() __debugbreak()
+#else
+	#define JERBOA_DEBUGBREAK() __builtin_trap()
+#endif
+
 #ifdef JERBOA_ASSERTS_ENABLED
 	#define JERBOA_ASSERT(condition, message) { \
 		if(!(condition)) { \
 			JERBOA_LOG_ERROR("Assertion Failed: {0}", message); \
-			__debugbreak(); } \
+			JERBOA_DEBUGBREAK(); } \
 	}
 #else
 	#define JERBOA_ASSERT(...)
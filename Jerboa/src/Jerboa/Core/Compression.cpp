@@ -0,0 +1,173 @@
+#include "jerboa-pch.h"
+#include "Compression.h"
+
+#include <cstring>
+
+namespace Jerboa {
+	namespace {
+		constexpr size_t MinMatch = 4;
+		constexpr size_t MaxOffset = 0xffff;
+		constexpr uint32_t HashBits = 12;
+		constexpr uint32_t NoPosition = 0xffffffff;
+
+		uint32_t Read32(const uint8_t* data)
+		{
+			uint32_t value;
+			std::memcpy(&value, data, sizeof(value));
+			return value;
+		}
+
+		uint32_t Hash(uint32_t sequence)
+		{
+			return (sequence * 2654435761u) >> (32 - HashBits);
+		}
+
+		// Lengths that don't fit into a token nibble continue in bytes of up to 255
+		bool WriteLength(size_t length, uint8_t*& output, const uint8_t* end)
+		{
+			for (; length >= 255; length -= 255) {
+				if (output == end)
+					return false;
+				*output++ = 255;
+			}
+			if (output == end)
+				return false;
+			*output++ = (uint8_t)length;
+			return true;
+		}
+
+		bool ReadLength(size_t& length, const uint8_t*& input, const uint8_t* end)
+		{
+			uint8_t byte;
+			do {
+				if (input == end)
+					return false;
+				byte = *input++;
+				length += byte;
+			} while (byte == 255);
+			return true;
+		}
+
+		// Token: literal count in the high nibble, match length minus MinMatch in the low one
+		bool WriteSequence(const uint8_t* literals, size_t literalCount, size_t offset, size_t matchLength, uint8_t*& output, const uint8_t* end)
+		{
+			if (output == end)
+				return false;
+
+			uint8_t* token = output++;
+			*token = (uint8_t)(std::min<size_t>(literalCount, 15) << 4);
+			if (literalCount >= 15 && !WriteLength(literalCount - 15, output, end))
+				return false;
+
+			if ((size_t)(end - output) < literalCount)
+				return false;
+			if (literalCount > 0)
+				std::memcpy(output, literals, literalCount);
+			output += literalCount;
+
+			// The last sequence only carries literals
+			if (matchLength == 0)
+				return true;
+
+			if (end - output < 2)
+				return false;
+			*output++ = (uint8_t)(offset & 0xff);
+			*output++ = (uint8_t)(offset >> 8);
+
+			size_t length = matchLength - MinMatch;
+			*token |= (uint8_t)std::min<size_t>(length, 15);
+			return length < 15 || WriteLength(length - 15, output, end);
+		}
+	}
+
+	size_t Compression::GetMaxCompressedSize(size_t size)
+	{
+		return size + size / 255 + 16;
+	}
+
+	size_t Compression::Compress(const void* source, size_t size, void* destination, size_t capacity)
+	{
+		const uint8_t* input = static_cast<const uint8_t*>(source);
+		uint8_t* output = static_cast<uint8_t*>(destination);
+		const uint8_t* end = output + capacity;
+
+		uint32_t table[1 << HashBits];
+		std::fill(std::begin(table), std::end(table), NoPosition);
+
+		size_t position = 0, anchor = 0;
+		while (position + MinMatch <= size) {
+			uint32_t sequence = Read32(input + position);
+			uint32_t& entry = table[Hash(sequence)];
+			size_t candidate = entry;
+			entry = (uint32_t)position;
+
+			if (candidate == NoPosition || position - candidate > MaxOffset || Read32(input + candidate) != sequence) {
+				position++;
+				continue;
+			}
+
+			size_t length = MinMatch;
+			while (position + length < size && input[candidate + length] == input[position + length])
+				length++;
+
+			if (!WriteSequence(input + anchor, position - anchor, position - candidate, length, output, end))
+				return 0;
+			position += length;
+			anchor = position;
+		}
+
+		if (!WriteSequence(input + anchor, size - anchor, 0, 0, output, end))
+			return 0;
+		return output - static_cast<uint8_t*>(destination);
+	}
+
+	bool Compression::Decompress(const void* source, size_t sourceSize, void* destination, size_t size)
+	{
+		const uint8_t* input = static_cast<const uint8_t*>(source);
+		const uint8_t* inputEnd = input + sourceSize;
+		uint8_t* output = static_cast<uint8_t*>(destination);
+		uint8_t* outputEnd = output + size;
+
+		while (input < inputEnd) {
+			uint8_t token = *input++;
+
+			size_t literalCount = token >> 4;
+			if (literalCount == 15 && !ReadLength(literalCount, input, inputEnd))
+				return false;
+			if ((size_t)(inputEnd - input) < literalCount || (size_t)(outputEnd - output) < literalCount)
+				return false;
+			if (literalCount > 0)
+				std::memcpy(output, input, literalCount);
+			input += literalCount;
+			output += literalCount;
+
+			if (input == inputEnd)
+				break;
+
+			if (inputEnd - input < 2)
+				return false;
+			size_t offset = input[0] | (input[1] << 8);
+			input += 2;
+
+			size_t length = token & 0x0f;
+			if (length == 15 && !ReadLength(length, input, inputEnd))
+				return false;
+			length += MinMatch;
+
+			if (offset == 0 || offset > (size_t)(output - static_cast<uint8_t*>(destination)) || (size_t)(outputEnd - output) < length)
+				return false;
+
+			// Matches may overlap their own output, e.g. runs of a repeated value
+			const uint8_t* match = output - offset;
+			if (offset >= length) {
+				std::memcpy(output, match, length);
+				output += length;
+			}
+			else {
+				for (size_t i = 0; i < length; i++)
+					*output++ = match[i];
+			}
+		}
+		return output == outputEnd;
+	}
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+namespace Jerboa {
+	// Small LZ77 block codec in the spirit of LZ4: byte-aligned literal runs and matches
+	// within the previous 64 KB, no entropy coding. Decompression is a tight copy loop,
+	// which makes it suitable for data that is loaded far more often than it is written.
+	namespace Compression {
+		// Enough room for incompressible input
+		size_t GetMaxCompressedSize(size_t size);
+
+		// Returns the compressed size, or 0 if it doesn't fit into capacity
+		size_t Compress(const void* source, size_t size, void* destination, size_t capacity);
+		// Fails on malformed input or if it doesn't decompress to exactly size bytes
+		bool Decompress(const void* source, size_t sourceSize, void* destination, size_t size);
+	}
+}
@@ -1,11 +1,17 @@
 #pragma once
 
+#include "Time.h"
+
 namespace Jerboa {
+    // Events are published by reference and must stay trivially copyable: intern strings
+    // with the StringTable and keep variable-length payloads in the FrameAllocator
     class Event {
     public:
-        virtual ~Event() = 0
-        {
-        }
+        // Monotonic time at which the event was created
+        const Timestamp timestamp;
+
+    protected:
+        Event() : timestamp(Time::Now()) {}
     };
 }
 
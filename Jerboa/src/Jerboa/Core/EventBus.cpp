@@ -3,23 +3,17 @@
 
 namespace Jerboa {
     void EventBus::Subscribe(EventCallback& callback, std::type_index id) {
-        auto callbacks = mSubscribers[id];
-
-        if (callbacks == nullptr) {
-            callbacks = std::make_shared<CallbackList>();
-            mSubscribers[id] = callbacks;
-        }
-
-        callbacks->push_back(&callback);
+        JERBOA_MEMORY_TAG(Events);
+        mSubscribers[id].push_back(&callback);
     }
 
     void EventBus::Unsubscribe(EventCallback& callback, std::type_index id) {
-        auto callbacks = mSubscribers[id];
+        auto it = mSubscribers.find(id);
 
-        if (callbacks == nullptr) {
+        if (it == mSubscribers.end()) {
             return;
         }
 
-        callbacks->remove(&callback);
+        it->second.remove(&callback);
     }
 }
\ No newline at end of file
@@ -1,34 +1,72 @@
 #pragma once
 
 #include "Event.h"
+#include "StlAllocator.h"
+#include "Jerboa/Profiling/MemoryTracker.h"
 #include <typeinfo>
 #include <typeindex>
 #include <map>
+#include <list>
 #include <unordered_map>
 #include <type_traits>
 #include <memory>
-#include <functional>
+#include <cstring>
 
 namespace Jerboa {
     class EventObserverBase;
     
-    typedef std::function<void(const Event&)> EventCallback;
+    // Member function bound to an instance. The member function pointer is stored inline,
+    // so unlike a std::function binding one never allocates.
+    class EventCallback {
+    public:
+        template<class EventType, class T>
+        static EventCallback Bind(T* instance, void (T::* memberFunction)(const EventType&)) {
+            static_assert(sizeof(memberFunction) <= MaxFunctionSize, "Member function pointer does not fit EventCallback");
+
+            EventCallback callback;
+            callback.mInstance = instance;
+            callback.mInvoke = &Invoke<EventType, T>;
+            std::memcpy(callback.mFunction, &memberFunction, sizeof(memberFunction));
+            return callback;
+        }
+
+        inline void operator()(const Event& evnt) const { mInvoke(mInstance, mFunction, evnt); }
+
+    private:
+        // Member function pointers of classes with virtual or multiple inheritance are
+        // larger than a plain pointer on MSVC
+        static constexpr size_t MaxFunctionSize = 4 * sizeof(void*);
+
+        template<class EventType, class T>
+        static void Invoke(void* instance, const void* function, const Event& evnt) {
+            void (T::* memberFunction)(const EventType&);
+            std::memcpy(&memberFunction, function, sizeof(memberFunction));
+            (static_cast<T*>(instance)->*memberFunction)(static_cast<const EventType&>(evnt));
+        }
+
+        void* mInstance = nullptr;
+        void (*mInvoke)(void*, const void*, const Event&) = nullptr;
+        alignas(void*) unsigned char mFunction[MaxFunctionSize];
+    };
 
     class EventBus {
         friend class Jerboa::EventObserverBase;
 
-        typedef std::list<EventCallback*> CallbackList;
+        typedef std::list<EventCallback*, PoolStlAllocator<EventCallback*>> CallbackList;
     
     public:
         template<class EventType>
         void Publish(const EventType& evnt) {
-            auto callbacks = mSubscribers[GetTypeIndex<EventType>()];
+            static_assert(std::is_base_of<Event, EventType>::value, "Only classes derived from Event can be published");
+            static_assert(std::is_trivially_copyable<EventType>::value, "Events must be trivially copyable, see Event");
+            JERBOA_MEMORY_TAG(Events);
+            auto it = mSubscribers.find(GetTypeIndex<EventType>());
 
-            if (callbacks == nullptr) {
+            if (it == mSubscribers.end()) {
                 return;
             }
 
-            for (auto& callback : *callbacks) {
+            for (auto& callback : it->second) {
                 if (callback != nullptr) {
                     (*callback)(evnt);
                 }
@@ -44,6 +82,7 @@ namespace Jerboa {
         void Subscribe(EventCallback& callback, std::type_index id);
         void Unsubscribe(EventCallback& callback, std::type_index id);
 
-        std::unordered_map<std::type_index, std::shared_ptr<CallbackList>> mSubscribers;
+        // Lists are never erased, an unordered_map keeps references to them stable
+        std::unordered_map<std::type_index, CallbackList> mSubscribers;
     };
 };
\ No newline at end of file
@@ -10,7 +10,7 @@ namespace Jerboa {
         static EventObserver Create(EventBus* eventBus, T* instance, void (T::* memberFunction)(const EventType&) ) {
             return EventObserver(
                 eventBus,
-                [=](const Event& evnt) { (instance->*memberFunction)(static_cast<const EventType&>(evnt)); },
+                EventCallback::Bind(instance, memberFunction),
                 EventBus::GetTypeIndex<EventType>()
             );
         }
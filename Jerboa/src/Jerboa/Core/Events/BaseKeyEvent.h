@@ -5,12 +5,11 @@
 
 namespace Jerboa {
 	struct BaseKeyEvent : Event {
-		BaseKeyEvent(KeyCode key, ModifierKeyCode mods)
-			: key(key), modifiers(mods) {}
-
 		const KeyCode key;
 		const ModifierKeyCode modifiers;
 
-		virtual ~BaseKeyEvent() = 0 {}
+	protected:
+		BaseKeyEvent(KeyCode key, ModifierKeyCode mods)
+			: key(key), modifiers(mods) {}
 	};
 }
@@ -5,12 +5,11 @@
 
 namespace Jerboa {
 	struct BaseMouseButtonEvent : Event {
-		BaseMouseButtonEvent(MouseButtonCode button, ModifierKeyCode modifiers)
-			: button(button), modifiers(modifiers) {}
-
 		const MouseButtonCode button;
 		const ModifierKeyCode modifiers;
 
-		virtual ~BaseMouseButtonEvent() = 0 {}
+	protected:
+		BaseMouseButtonEvent(MouseButtonCode button, ModifierKeyCode modifiers)
+			: button(button), modifiers(modifiers) {}
 	};
 }
\ No newline at end of file
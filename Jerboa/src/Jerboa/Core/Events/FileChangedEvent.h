@@ -0,0 +1,24 @@
+#pragma once
+
+#include "Jerboa/Event.h"
+#include "Jerboa/Core/StringTable.h"
+
+namespace Jerboa {
+	enum class FileChangeType : uint8_t
+	{
+		// Written and closed, or moved into place by a save-to-temp-and-rename
+		Modified,
+		Created,
+		Removed
+	};
+
+	// Published by the FileWatcher once a burst of changes to a file has settled
+	struct FileChangedEvent : public Event {
+		FileChangedEvent(StringID path, FileChangeType type)
+			: path(path), type(type) {}
+
+		// The watched directory joined with the file name
+		StringID path;
+		FileChangeType type;
+	};
+}
@@ -4,8 +4,9 @@
 
 namespace Jerboa {
 	struct MouseMovedEvent : Event {
-		MouseMovedEvent(int x, int y)
+		MouseMovedEvent(double x, double y)
 			: x(x), y(y) {}
-		const int x, y;
+		// Screen coordinates, fractional on high-DPI displays
+		const double x, y;
 	};
 }
@@ -2,9 +2,10 @@
 
 namespace Jerboa {
 	struct MouseScrolledEvent : Event {
-		MouseScrolledEvent(int xOffset, int yOffset)
+		MouseScrolledEvent(double xOffset, double yOffset)
 			: xOffset(xOffset), yOffset(yOffset) {}
-		const int xOffset, yOffset;
+		// Fractional for touchpads and smooth-scrolling mice
+		const double xOffset, yOffset;
 	};
 }
 #pragma once
@@ -0,0 +1,239 @@
+#include "jerboa-pch.h"
+#include "FileWatcher.h"
+
+#include "EventBus.h"
+#include "Time.h"
+#include "StringTable.h"
+#include "Events/FileChangedEvent.h"
+
+#include <mutex>
+#include <thread>
+
+#ifdef JERBOA_PLATFORM_LINUX
+	#include <sys/inotify.h>
+	#include <sys/eventfd.h>
+	#include <poll.h>
+	#include <unistd.h>
+	#include <climits>
+#endif
+
+namespace Jerboa {
+	namespace {
+		struct PendingChange
+		{
+			FileChangeType type;
+			Timestamp lastEvent;
+		};
+
+		struct FileWatcherData
+		{
+			FileWatcher::Settings settings;
+			std::thread thread;
+			bool running = false;
+			int inotify = -1;
+			// Wakes the thread up for shutdown
+			int wakeUp = -1;
+
+			std::mutex mutex;
+			std::unordered_map<int, std::string> directories;
+			std::unordered_map<std::string, int> watches;
+			// Settled changes waiting for DispatchChanges(), swapped with dispatching
+			std::vector<FileChangedEvent> settled;
+			std::vector<FileChangedEvent> dispatching;
+		};
+
+		FileWatcherData sData;
+
+#ifdef JERBOA_PLATFORM_LINUX
+		FileChangeType GetChangeType(uint32_t mask)
+		{
+			if (mask & (IN_DELETE | IN_MOVED_FROM))
+				return FileChangeType::Removed;
+			if (mask & IN_CREATE)
+				return FileChangeType::Created;
+			return FileChangeType::Modified;
+		}
+
+		// A created file that is then written stays created, a file replaced by a rename is modified
+		FileChangeType MergeChange(FileChangeType previous, FileChangeType next)
+		{
+			if (previous == FileChangeType::Created && next == FileChangeType::Modified)
+				return previous;
+			if (previous == FileChangeType::Removed && next != FileChangeType::Removed)
+				return FileChangeType::Modified;
+			return next;
+		}
+
+		void ReadEvents(std::unordered_map<std::string, PendingChange>& pending)
+		{
+			alignas(inotify_event) char buffer[16 * (sizeof(inotify_event) + NAME_MAX + 1)];
+			ssize_t length = read(sData.inotify, buffer, sizeof(buffer));
+			if (length <= 0)
+				return;
+
+			Timestamp now = Time::Now();
+			std::lock_guard<std::mutex> lock(sData.mutex);
+			for (char* cursor = buffer; cursor < buffer + length;) {
+				const inotify_event* event = reinterpret_cast<const inotify_event*>(cursor);
+				cursor += sizeof(inotify_event) + event->len;
+
+				auto directory = sData.directories.find(event->wd);
+				if (event->len == 0 || (event->mask & IN_ISDIR) || directory == sData.directories.end())
+					continue;
+
+				std::string path = directory->second == "." ? std::string(event->name) : directory->second + "/" + event->name;
+				FileChangeType type = GetChangeType(event->mask);
+				auto existing = pending.find(path);
+				if (existing == pending.end())
+					pending.emplace(std::move(path), PendingChange{ type, now });
+				else
+					existing->second = { MergeChange(existing->second.type, type), now };
+			}
+		}
+
+		void WatchLoop()
+		{
+			const Timestamp debounce = static_cast<Timestamp>(sData.settings.debounceMs) * 1000000;
+			std::unordered_map<std::string, PendingChange> pending;
+
+			while (true) {
+				// Sleep until the next event, or until the oldest pending change settles
+				int timeout = -1;
+				Timestamp now = Time::Now();
+				for (const auto& [path, change] : pending) {
+					Timestamp settlesIn = change.lastEvent + debounce > now ? change.lastEvent + debounce - now : 0;
+					int milliseconds = static_cast<int>((settlesIn + 999999) / 1000000);
+					timeout = timeout < 0 ? milliseconds : std::min(timeout, milliseconds);
+				}
+
+				pollfd descriptors[2] = { { sData.inotify, POLLIN, 0 }, { sData.wakeUp, POLLIN, 0 } };
+				if (poll(descriptors, 2, timeout) < 0 && errno != EINTR)
+					break;
+				if (descriptors[1].revents & POLLIN)
+					break;
+				if (descriptors[0].revents & POLLIN)
+					ReadEvents(pending);
+
+				now = Time::Now();
+				std::lock_guard<std::mutex> lock(sData.mutex);
+				for (auto change = pending.begin(); change != pending.end();) {
+					if (now - change->second.lastEvent < debounce) {
+						change++;
+						continue;
+					}
+					sData.settled.emplace_back(StringTable::Intern(change->first), change->second.type);
+					change = pending.erase(change);
+				}
+			}
+		}
+#endif
+	}
+
+	void FileWatcher::Init()
+	{
+		Init(Settings());
+	}
+
+	void FileWatcher::Init(const Settings& settings)
+	{
+		JERBOA_ASSERT(!sData.running, "FileWatcher is already initialized");
+		sData.settings = settings;
+
+#ifdef JERBOA_PLATFORM_LINUX
+		sData.inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+		sData.wakeUp = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+		if (sData.inotify < 0 || sData.wakeUp < 0) {
+			JERBOA_LOG_WARN("FileWatcher disabled, inotify is not available");
+			Shutdown();
+			return;
+		}
+
+		sData.running = true;
+		sData.thread = std::thread(WatchLoop);
+		JERBOA_LOG_INFO("FileWatcher started, debouncing changes for {} ms", settings.debounceMs);
+#else
+		JERBOA_LOG_WARN("FileWatcher is only supported on Linux");
+#endif
+	}
+
+	void FileWatcher::Shutdown()
+	{
+#ifdef JERBOA_PLATFORM_LINUX
+		if (sData.thread.joinable()) {
+			uint64_t value = 1;
+			if (write(sData.wakeUp, &value, sizeof(value)) != sizeof(value))
+				JERBOA_LOG_WARN("Could not wake up the FileWatcher thread");
+			sData.thread.join();
+		}
+		if (sData.inotify >= 0)
+			close(sData.inotify);
+		if (sData.wakeUp >= 0)
+			close(sData.wakeUp);
+#endif
+		std::lock_guard<std::mutex> lock(sData.mutex);
+		sData.inotify = -1;
+		sData.wakeUp = -1;
+		sData.running = false;
+		sData.directories.clear();
+		sData.watches.clear();
+		sData.settled.clear();
+	}
+
+	bool FileWatcher::IsSupported()
+	{
+#ifdef JERBOA_PLATFORM_LINUX
+		return true;
+#else
+		return false;
+#endif
+	}
+
+	bool FileWatcher::IsRunning()
+	{
+		std::lock_guard<std::mutex> lock(sData.mutex);
+		return sData.running;
+	}
+
+	bool FileWatcher::WatchDirectory(const std::string& directory)
+	{
+		std::lock_guard<std::mutex> lock(sData.mutex);
+		if (!sData.running)
+			return false;
+		if (sData.watches.find(directory) != sData.watches.end())
+			return true;
+
+#ifdef JERBOA_PLATFORM_LINUX
+		int watch = inotify_add_watch(sData.inotify, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_DELETE | IN_MOVED_FROM);
+		if (watch < 0) {
+			JERBOA_LOG_WARN("Could not watch \"{}\" for changes", directory);
+			return false;
+		}
+
+		sData.watches.emplace(directory, watch);
+		sData.directories.emplace(watch, directory);
+		return true;
+#else
+		return false;
+#endif
+	}
+
+	uint32_t FileWatcher::GetWatchCount()
+	{
+		std::lock_guard<std::mutex> lock(sData.mutex);
+		return (uint32_t)sData.watches.size();
+	}
+
+	void FileWatcher::DispatchChanges(EventBus* eventBus)
+	{
+		{
+			std::lock_guard<std::mutex> lock(sData.mutex);
+			if (sData.settled.empty())
+				return;
+			sData.settled.swap(sData.dispatching);
+		}
+
+		for (const FileChangedEvent& change : sData.dispatching)
+			eventBus->Publish(change);
+		sData.dispatching.clear();
+	}
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+
+namespace Jerboa {
+	class EventBus;
+
+	// Watches directories for changed files on a background thread (inotify, Linux only).
+	// Bursts of events for one file, like an editor saving in several writes, are merged
+	// until the file has been quiet for the debounce interval and then reported once.
+	class FileWatcher
+	{
+	public:
+		struct Settings
+		{
+			uint32_t debounceMs = 100;
+		};
+
+		static void Init();
+		static void Init(const Settings& settings);
+		static void Shutdown();
+
+		static bool IsSupported();
+		static bool IsRunning();
+
+		// Not recursive, watching a directory again does nothing. Thread safe.
+		static bool WatchDirectory(const std::string& directory);
+		static uint32_t GetWatchCount();
+
+		// Publishes a FileChangedEvent for every settled change, main thread only
+		static void DispatchChanges(EventBus* eventBus);
+	};
+}
@@ -0,0 +1,31 @@
+#include "jerboa-pch.h"
+#include "FrameAllocator.h"
+
+#include <thread>
+
+namespace Jerboa {
+	static constexpr size_t FrameArenaCapacity = 1024 * 1024;
+
+	LinearAllocator& FrameAllocator::Get()
+	{
+#if defined(JERBOA_DEBUG)
+		static const std::thread::id owner = std::this_thread::get_id();
+		JERBOA_ASSERT(std::this_thread::get_id() == owner, "The frame allocator is main thread only");
+#endif
+		static LinearAllocator arena(FrameArenaCapacity);
+		return arena;
+	}
+
+	std::string_view FrameAllocator::CopyString(std::string_view string)
+	{
+		char* copy = static_cast<char*>(Allocate(string.size() + 1, 1));
+		std::memcpy(copy, string.data(), string.size());
+		copy[string.size()] = '\0';
+		return std::string_view(copy, string.size());
+	}
+
+	void FrameAllocator::Reset()
+	{
+		Get().Reset();
+	}
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "LinearAllocator.h"
+
+#include <string_view>
+#include <cstring>
+
+namespace Jerboa {
+	// Arena for data that lives until the end of the current frame, reset by the
+	// Application at the start of every frame. Main thread only, jobs use the
+	// ScratchAllocator of their thread instead.
+	class FrameAllocator
+	{
+	public:
+		static LinearAllocator& Get();
+
+		inline static void* Allocate(size_t size, size_t alignment = alignof(std::max_align_t)) { return Get().Allocate(size, alignment); }
+
+		template<class T, class... Args>
+		static T* New(Args&&... args) { return Get().New<T>(std::forward<Args>(args)...); }
+
+		template<class T>
+		static T* NewArray(size_t count) { return Get().NewArray<T>(count); }
+
+		// Copies that stay valid until the end of the frame, e.g. for event payloads
+		template<class T>
+		static T* CopyArray(const T* data, size_t count)
+		{
+			static_assert(std::is_trivially_copyable<T>::value, "Only trivially copyable data can be copied to the frame arena");
+			T* copy = static_cast<T*>(Allocate(sizeof(T) * count, alignof(T)));
+			std::memcpy(copy, data, sizeof(T) * count);
+			return copy;
+		}
+
+		// The copy is null terminated
+		static std::string_view CopyString(std::string_view string);
+
+		static void Reset();
+	};
+}
@@ -0,0 +1,123 @@
+#include "jerboa-pch.h"
+#include "IPCBridge.h"
+
+#include <cerrno>
+#include <unordered_set>
+
+namespace Jerboa {
+	namespace {
+		struct Registration
+		{
+			uint16_t minVersion;
+			uint16_t maxVersion;
+			IPCBridge::Handler handler;
+		};
+
+		struct IPCBridgeData
+		{
+			IPCBridge::Settings settings;
+			IPCChannel channel;
+			bool running = false;
+			std::unordered_map<uint32_t, Registration> handlers;
+			IPCBridge::Statistics stats;
+			// Each problem is logged once per type, senders tend to repeat them every frame
+			std::unordered_set<uint32_t> reportedTypes;
+		};
+
+		IPCBridgeData sData;
+
+		void ReportOnce(uint32_t type, const IPCMessage& message, const char* problem)
+		{
+			if (sData.reportedTypes.insert(type).second)
+				JERBOA_LOG_WARN("IPCBridge: dropping messages of type {} version {} from process {}, {}", type, message.version, message.sender, problem);
+		}
+	}
+
+	void IPCBridge::Init()
+	{
+		Init(Settings());
+	}
+
+	void IPCBridge::Init(const Settings& settings)
+	{
+		JERBOA_ASSERT(!sData.running, "IPCBridge is already initialized");
+		sData.settings = settings;
+		sData.stats = Statistics();
+		sData.reportedTypes.clear();
+
+		if (!sData.channel.Create(settings.channel, settings.slotSize, settings.slotCount)) {
+			JERBOA_LOG_WARN("IPCBridge disabled, could not create shared memory channel \"{}\" ({})", settings.channel, std::strerror(errno));
+			return;
+		}
+
+		sData.running = true;
+		JERBOA_LOG_INFO("IPCBridge listening on \"{}\", {} slots of up to {} bytes", settings.channel, settings.slotCount, sData.channel.GetMaxPayloadSize());
+	}
+
+	void IPCBridge::Shutdown()
+	{
+		if (!sData.running)
+			return;
+
+		Statistics stats = GetStats();
+		if (stats.dropped > 0 || stats.skipped > 0)
+			JERBOA_LOG_WARN("IPCBridge: senders dropped {} messages on a full channel, {} stalled slots were skipped", stats.dropped, stats.skipped);
+
+		sData.channel.Close();
+		sData.running = false;
+	}
+
+	bool IPCBridge::IsRunning()
+	{
+		return sData.running;
+	}
+
+	const std::string& IPCBridge::GetChannelName()
+	{
+		return sData.settings.channel;
+	}
+
+	void IPCBridge::RegisterHandler(uint32_t type, uint16_t minVersion, uint16_t maxVersion, Handler handler)
+	{
+		JERBOA_ASSERT(handler && minVersion <= maxVersion, "IPC handlers need a function and a valid version range");
+		sData.handlers[type] = { minVersion, maxVersion, handler };
+		sData.reportedTypes.erase(type);
+	}
+
+	void IPCBridge::DispatchMessages(EventBus* eventBus)
+	{
+		if (!sData.running)
+			return;
+
+		sData.channel.Receive([eventBus](const IPCMessage& message) {
+			auto it = sData.handlers.find(message.type);
+			if (it == sData.handlers.end()) {
+				sData.stats.unknownType++;
+				ReportOnce(message.type, message, "no handler is registered");
+				return;
+			}
+
+			const Registration& registration = it->second;
+			if (message.version < registration.minVersion || message.version > registration.maxVersion) {
+				sData.stats.unsupportedVersion++;
+				ReportOnce(message.type, message, "the version is not supported");
+				return;
+			}
+
+			if (!registration.handler(message, eventBus)) {
+				sData.stats.malformed++;
+				ReportOnce(message.type, message, "the payload is malformed");
+				return;
+			}
+			sData.stats.dispatched++;
+		}, sData.settings.maxMessagesPerFrame);
+	}
+
+	IPCBridge::Statistics IPCBridge::GetStats()
+	{
+		Statistics stats = sData.stats;
+		stats.dropped = sData.channel.GetDroppedCount();
+		stats.skipped = sData.channel.GetSkippedCount();
+		return stats;
+	}
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "EventBus.h"
+#include "JerboaIPC/IPCChannel.h"
+
+#include <string>
+#include <cstring>
+#include <type_traits>
+#include <cstdint>
+
+namespace Jerboa {
+	// Lets local processes publish events into the engine through a shared-memory IPCChannel.
+	// Senders link the JerboaIPC library, open the channel by name and send typed, versioned
+	// payloads; DispatchMessages() drains them once per frame without syscalls and hands each
+	// to the handler registered for its type, which publishes the matching event.
+	class IPCBridge
+	{
+	public:
+		struct Settings
+		{
+			// Shared memory object name, senders open the channel by it
+			std::string channel = "/jerboa-events";
+			uint32_t slotSize = IPCChannel::DefaultSlotSize;
+			uint32_t slotCount = IPCChannel::DefaultSlotCount;
+			// Keeps a flood of messages from stalling a frame, the rest waits for the next one
+			uint32_t maxMessagesPerFrame = 4096;
+		};
+
+		struct Statistics
+		{
+			uint64_t dispatched = 0;
+			// Types without a handler, versions outside its range, payloads it rejected
+			uint64_t unknownType = 0;
+			uint64_t unsupportedVersion = 0;
+			uint64_t malformed = 0;
+			// Messages senders couldn't fit, and slots skipped after a sender stalled
+			uint64_t dropped = 0;
+			uint64_t skipped = 0;
+		};
+
+		// Copies what it needs from the payload and publishes, false if the payload is malformed.
+		// The payload is only valid during the call, variable-length data goes into the FrameAllocator.
+		using Handler = bool (*)(const IPCMessage& message, EventBus* eventBus);
+
+		static void Init();
+		static void Init(const Settings& settings);
+		static void Shutdown();
+
+		static bool IsRunning();
+		static const std::string& GetChannelName();
+
+		// Messages of the type whose version is in [minVersion, maxVersion] go to the handler,
+		// so a handler can keep accepting older senders. Registering a type again replaces it.
+		// Main thread only.
+		static void RegisterHandler(uint32_t type, uint16_t minVersion, uint16_t maxVersion, Handler handler);
+
+		// For events constructed from a trivially copyable wire struct, EventType(const Payload&).
+		// The payload has to match the struct's size exactly.
+		template<class EventType, class Payload>
+		static void RegisterEvent(uint32_t type, uint16_t version)
+		{
+			static_assert(std::is_trivially_copyable<Payload>::value, "IPC payloads are sent as raw bytes and must be trivially copyable");
+			RegisterHandler(type, version, version, &PublishPayload<EventType, Payload>);
+		}
+
+		// Main thread only
+		static void DispatchMessages(EventBus* eventBus);
+
+		static Statistics GetStats();
+	private:
+		template<class EventType, class Payload>
+		static bool PublishPayload(const IPCMessage& message, EventBus* eventBus)
+		{
+			if (message.size != sizeof(Payload))
+				return false;
+
+			Payload payload;
+			std::memcpy(&payload, message.payload, sizeof(Payload));
+			eventBus->Publish(EventType(payload));
+			return true;
+		}
+	};
+}
+
@@ -0,0 +1,82 @@
+#include "jerboa-pch.h"
+#include "InitGraph.h"
+#include "StartupTracer.h"
+
+namespace Jerboa {
+	InitGraph::~InitGraph()
+	{
+		WaitAll();
+	}
+
+	InitGraph::Step InitGraph::Add(const char* name, std::function<void()> function, std::initializer_list<Step> dependencies)
+	{
+		JERBOA_ASSERT(!IsStarted(), "Init steps must be added before the graph starts");
+
+		Step step = (Step)mSteps.size();
+		StepData& data = mSteps.emplace_back();
+		data.name = name;
+		data.function = std::move(function);
+		for (Step dependency : dependencies) {
+			JERBOA_ASSERT(dependency < step, "Init steps can only depend on steps added before them");
+			mSteps[dependency].dependents.push_back(step);
+			mSteps[step].pendingDependencies++;
+		}
+
+		if (mSteps[step].pendingDependencies == 0)
+			mReady.push_back(step);
+		return step;
+	}
+
+	void InitGraph::Start(uint32_t threadCount)
+	{
+		JERBOA_ASSERT(!IsStarted(), "The init graph was already started");
+
+		mStarted = true;
+		threadCount = std::max(std::min(threadCount, (uint32_t)mSteps.size()), 1u);
+		for (uint32_t i = 0; i < threadCount; i++)
+			mThreads.emplace_back(&InitGraph::HelperLoop, this);
+	}
+
+	void InitGraph::Wait(Step step)
+	{
+		JERBOA_ASSERT(IsStarted() && step < mSteps.size(), "Waiting for an init step that never runs");
+
+		std::unique_lock<std::mutex> lock(mMutex);
+		mStepDone.wait(lock, [&]() { return mSteps[step].done; });
+	}
+
+	void InitGraph::WaitAll()
+	{
+		for (std::thread& thread : mThreads)
+			thread.join();
+		mThreads.clear();
+	}
+
+	void InitGraph::HelperLoop()
+	{
+		std::unique_lock<std::mutex> lock(mMutex);
+		while (true) {
+			mStepReady.wait(lock, [&]() { return !mReady.empty() || mDoneCount == mSteps.size(); });
+			if (mReady.empty())
+				return;
+
+			Step step = mReady.back();
+			mReady.pop_back();
+			lock.unlock();
+			{
+				JERBOA_STARTUP_SCOPE(mSteps[step].name);
+				mSteps[step].function();
+			}
+			lock.lock();
+
+			mSteps[step].done = true;
+			mDoneCount++;
+			for (Step dependent : mSteps[step].dependents) {
+				if (--mSteps[dependent].pendingDependencies == 0)
+					mReady.push_back(dependent);
+			}
+			mStepReady.notify_all();
+			mStepDone.notify_all();
+		}
+	}
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <functional>
+#include <initializer_list>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+
+namespace Jerboa {
+	// Startup steps with dependencies, run on helper threads as soon as the steps they
+	// depend on are done. The main thread keeps doing the work that has to happen on it,
+	// e.g. creating the window and GL context, and waits for a step only once it needs
+	// its result. Every step is traced by the StartupTracer.
+	class InitGraph
+	{
+	public:
+		using Step = uint32_t;
+
+		InitGraph() = default;
+		// Waits for every step
+		~InitGraph();
+
+		InitGraph(const InitGraph&) = delete;
+		InitGraph& operator=(const InitGraph&) = delete;
+
+		// name must outlive startup, e.g. a string literal. Steps are added before Start().
+		Step Add(const char* name, std::function<void()> function, std::initializer_list<Step> dependencies = {});
+
+		void Start(uint32_t threadCount = 2);
+		void Wait(Step step);
+		void WaitAll();
+
+		inline bool IsStarted() const { return mStarted; }
+	private:
+		struct StepData
+		{
+			const char* name;
+			std::function<void()> function;
+			std::vector<Step> dependents;
+			uint32_t pendingDependencies = 0;
+			bool done = false;
+		};
+
+		void HelperLoop();
+
+		std::vector<StepData> mSteps;
+		std::vector<Step> mReady;
+		uint32_t mDoneCount = 0;
+		std::mutex mMutex;
+		std::condition_variable mStepReady;
+		std::condition_variable mStepDone;
+		std::vector<std::thread> mThreads;
+		bool mStarted = false;
+	};
+}
@@ -0,0 +1,62 @@
+#include "jerboa-pch.h"
+#include "InputLatency.h"
+
+namespace Jerboa {
+	void InputLatencyTracker::OnInput(Timestamp timestamp)
+	{
+		if (!mHasPendingInput || timestamp < mOldestPendingInput) {
+			mOldestPendingInput = timestamp;
+			mHasPendingInput = true;
+		}
+	}
+
+	void InputLatencyTracker::OnPresent(Timestamp presentTime)
+	{
+		mHasNewSample = false;
+		if (!mHasPendingInput)
+			return;
+
+		mLastLatency = presentTime > mOldestPendingInput ? presentTime - mOldestPendingInput : 0;
+		mHasPendingInput = false;
+		mHasNewSample = true;
+
+		mSamples[mNextSample] = mLastLatency;
+		mNextSample = (mNextSample + 1) % SampleCapacity;
+		mSampleCount = std::min(mSampleCount + 1, SampleCapacity);
+	}
+
+	LatencyStats InputLatencyTracker::ComputeStats() const
+	{
+		LatencyStats stats;
+		if (mSampleCount == 0)
+			return stats;
+
+		// Copy so the percentile selection does not reorder the ring
+		std::array<Timestamp, SampleCapacity> sorted;
+		std::copy(mSamples.begin(), mSamples.begin() + mSampleCount, sorted.begin());
+
+		Timestamp min = sorted[0];
+		double sum = 0.0;
+		for (size_t i = 0; i < mSampleCount; i++) {
+			min = std::min(min, sorted[i]);
+			sum += sorted[i];
+		}
+
+		size_t p99Index = (mSampleCount * 99) / 100;
+		if (p99Index >= mSampleCount)
+			p99Index = mSampleCount - 1;
+		std::nth_element(sorted.begin(), sorted.begin() + p99Index, sorted.begin() + mSampleCount);
+
+		stats.minMs = Time::ToMilliseconds(min);
+		stats.meanMs = Time::ToMilliseconds(static_cast<Timestamp>(sum / mSampleCount));
+		stats.p99Ms = Time::ToMilliseconds(sorted[p99Index]);
+		stats.sampleCount = mSampleCount;
+		return stats;
+	}
+
+	void InputLatencyTracker::ResetStats()
+	{
+		mNextSample = 0;
+		mSampleCount = 0;
+	}
+}
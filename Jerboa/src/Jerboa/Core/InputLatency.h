@@ -0,0 +1,43 @@
+#pragma once
+
+#include "Time.h"
+#include <array>
+#include <cstddef>
+
+namespace Jerboa {
+	struct LatencyStats
+	{
+		double minMs = 0.0;
+		double meanMs = 0.0;
+		double p99Ms = 0.0;
+		size_t sampleCount = 0;
+	};
+
+	// Measures, per presented frame, the time between the oldest input event handled
+	// in that frame and the buffer swap that made its result visible
+	class InputLatencyTracker
+	{
+	public:
+		static constexpr size_t SampleCapacity = 1024;
+
+		void OnInput(Timestamp timestamp);
+		void OnPresent(Timestamp presentTime);
+
+		// Statistics over the samples recorded since the last ResetStats()
+		LatencyStats ComputeStats() const;
+		void ResetStats();
+
+		inline bool HasNewSample() const { return mHasNewSample; }
+		inline Timestamp GetLastLatency() const { return mLastLatency; }
+	private:
+		std::array<Timestamp, SampleCapacity> mSamples{};
+		size_t mNextSample = 0;
+		size_t mSampleCount = 0;
+
+		Timestamp mOldestPendingInput = 0;
+		bool mHasPendingInput = false;
+
+		Timestamp mLastLatency = 0;
+		bool mHasNewSample = false;
+	};
+}
@@ -0,0 +1,174 @@
+#include "jerboa-pch.h"
+#include "JobSystem.h"
+
+#include "Jerboa/Profiling/MemoryTracker.h"
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+namespace Jerboa {
+	namespace {
+		struct Job
+		{
+			std::function<void()> function;
+			JobCounter* counter;
+		};
+
+		struct JobSystemData
+		{
+			std::vector<std::thread> workers;
+			// Ring buffer that only grows, so submitting in steady state never allocates
+			std::vector<Job> queue;
+			size_t queueHead = 0;
+			size_t queueCount = 0;
+			std::mutex mutex;
+			std::condition_variable wakeUp;
+			bool running = false;
+		};
+
+		JobSystemData sData;
+
+		// Both expect sData.mutex to be held
+		void PushJob(Job&& job)
+		{
+			if (sData.queueCount == sData.queue.size()) {
+				std::vector<Job> grown(std::max<size_t>(64, sData.queue.size() * 2));
+				for (size_t i = 0; i < sData.queueCount; i++)
+					grown[i] = std::move(sData.queue[(sData.queueHead + i) % sData.queue.size()]);
+				sData.queue.swap(grown);
+				sData.queueHead = 0;
+			}
+
+			sData.queue[(sData.queueHead + sData.queueCount) % sData.queue.size()] = std::move(job);
+			sData.queueCount++;
+		}
+
+		Job PopJob()
+		{
+			Job job = std::move(sData.queue[sData.queueHead]);
+			sData.queueHead = (sData.queueHead + 1) % sData.queue.size();
+			sData.queueCount--;
+			return job;
+		}
+	}
+
+	void JobSystem::Init(uint32_t workerCount)
+	{
+		JERBOA_ASSERT(!sData.running, "JobSystem is already initialized");
+
+		if (workerCount == 0) {
+			uint32_t hardwareThreads = std::thread::hardware_concurrency();
+			workerCount = hardwareThreads > 1 ? hardwareThreads - 1 : 0;
+		}
+
+		sData.running = true;
+		sData.workers.reserve(workerCount);
+		for (uint32_t i = 0; i < workerCount; i++)
+			sData.workers.emplace_back(WorkerLoop);
+
+		JERBOA_LOG_INFO("JobSystem started {} worker threads", workerCount);
+	}
+
+	void JobSystem::Shutdown()
+	{
+		{
+			std::lock_guard<std::mutex> lock(sData.mutex);
+			sData.running = false;
+		}
+		sData.wakeUp.notify_all();
+
+		for (std::thread& worker : sData.workers)
+			worker.join();
+		sData.workers.clear();
+
+		// Workers drain the queue before exiting, anything left was submitted without workers
+		JERBOA_ASSERT(sData.queueCount == 0, "JobSystem shut down with pending jobs");
+	}
+
+	uint32_t JobSystem::GetWorkerCount()
+	{
+		return (uint32_t)sData.workers.size();
+	}
+
+	void JobSystem::Submit(std::function<void()> job, JobCounter& counter)
+	{
+		if (sData.workers.empty()) {
+			job();
+			return;
+		}
+
+		counter.mPending.fetch_add(1, std::memory_order_relaxed);
+		{
+			std::lock_guard<std::mutex> lock(sData.mutex);
+			PushJob({ std::move(job), &counter });
+		}
+		sData.wakeUp.notify_one();
+	}
+
+	void JobSystem::Wait(JobCounter& counter)
+	{
+		while (!counter.IsDone()) {
+			if (!RunPendingJob())
+				std::this_thread::yield();
+		}
+	}
+
+	void JobSystem::ParallelFor(uint32_t count, uint32_t grainSize, const std::function<void(uint32_t, uint32_t)>& function)
+	{
+		if (count == 0)
+			return;
+
+		// A few ranges per thread evens out ranges that take longer than others
+		uint32_t threadCount = GetWorkerCount() + 1;
+		uint32_t rangeSize = std::max(grainSize, (count + threadCount * 4 - 1) / (threadCount * 4));
+		if (threadCount == 1 || rangeSize >= count) {
+			function(0, count);
+			return;
+		}
+
+		JobCounter counter;
+		for (uint32_t begin = rangeSize; begin < count; begin += rangeSize) {
+			uint32_t end = std::min(begin + rangeSize, count);
+			Submit([&function, begin, end]() { function(begin, end); }, counter);
+		}
+
+		function(0, rangeSize);
+		Wait(counter);
+	}
+
+	bool JobSystem::RunPendingJob()
+	{
+		Job job;
+		{
+			std::lock_guard<std::mutex> lock(sData.mutex);
+			if (sData.queueCount == 0)
+				return false;
+
+			job = PopJob();
+		}
+
+		job.function();
+		job.counter->mPending.fetch_sub(1, std::memory_order_release);
+		return true;
+	}
+
+	void JobSystem::WorkerLoop()
+	{
+		JERBOA_MEMORY_TAG(Jobs);
+		while (true) {
+			Job job;
+			{
+				std::unique_lock<std::mutex> lock(sData.mutex);
+				sData.wakeUp.wait(lock, []() { return sData.queueCount > 0 || !sData.running; });
+				if (sData.queueCount == 0)
+					return;
+
+				job = PopJob();
+			}
+
+			job.function();
+			job.counter->mPending.fetch_sub(1, std::memory_order_release);
+		}
+	}
+}
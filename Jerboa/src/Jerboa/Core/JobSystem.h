@@ -0,0 +1,41 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <cstdint>
+
+namespace Jerboa {
+	// Counts the outstanding jobs of one submission, wait on it with JobSystem::Wait()
+	class JobCounter
+	{
+	public:
+		inline bool IsDone() const { return mPending.load(std::memory_order_acquire) == 0; }
+	private:
+		std::atomic<uint32_t> mPending{ 0 };
+
+		friend class JobSystem;
+	};
+
+	// Fixed pool of worker threads fed from one shared queue. Waiting threads run
+	// queued jobs instead of blocking, so jobs may submit and wait on further jobs.
+	// Without Init() (or with zero workers) every job runs inline on the submitting thread.
+	class JobSystem
+	{
+	public:
+		// workerCount 0 uses one worker per hardware thread besides the main thread
+		static void Init(uint32_t workerCount = 0);
+		static void Shutdown();
+
+		static uint32_t GetWorkerCount();
+
+		static void Submit(std::function<void()> job, JobCounter& counter);
+		static void Wait(JobCounter& counter);
+
+		// Splits [0, count) into ranges of at least grainSize elements, calls
+		// function(begin, end) for each range in parallel and returns when all are done
+		static void ParallelFor(uint32_t count, uint32_t grainSize, const std::function<void(uint32_t, uint32_t)>& function);
+	private:
+		static bool RunPendingJob();
+		static void WorkerLoop();
+	};
+}
@@ -2,7 +2,7 @@
 #include "KeyCode.h"
 
 namespace Jerboa {
-	std::string GetKeyName(KeyCode key)
+	const char* GetKeyName(KeyCode key)
 	{
 		switch (key) {
 		case KeyCode::Space:
@@ -246,6 +246,7 @@ namespace Jerboa {
 		case KeyCode::Menu:
 			return "Menu";
 		};
+		return "Unknown";
 	}
 
 	bool HasModifier(ModifierKeyCode keys, ModifierKeyCode key)
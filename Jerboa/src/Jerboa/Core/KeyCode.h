@@ -141,5 +141,6 @@ namespace Jerboa {
 	};
 
 	bool HasModifier(ModifierKeyCode keys, ModifierKeyCode key);
-	std::string GetKeyName(KeyCode key);
+	// Static string, never allocates
+	const char* GetKeyName(KeyCode key);
 } 
\ No newline at end of file
@@ -1,7 +1,8 @@
 #include "jerboa-pch.h"
 #include "Layer.h"
+#include "StringTable.h"
 
 namespace Jerboa {
 	Layer::Layer(const std::string& debugName)
-		: mDebugName(debugName) {}
+		: mDebugName(debugName), mProfileName(StringTable::GetCString(StringTable::Intern(debugName))) {}
 }
\ No newline at end of file
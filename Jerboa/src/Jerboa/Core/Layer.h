@@ -1,19 +1,30 @@
 #pragma once
 
 #include "EventBus.h"
+#include <string>
 
 namespace Jerboa {
 	class Layer
 	{
 	public:
 		Layer(const std::string& debugName = "Layer");
-		virtual ~Layer() = 0 {}
+		virtual ~Layer() = 0;
 
 		virtual void OnAttach() {}
 		virtual void OnDetach() {}
 		virtual void OnUpdate() {}
 		virtual void OnImGuiRender() {}
 
+		// With lazy ImGui rendering the UI is only rebuilt after input or when a layer
+		// asks for it, layers with changing UI content call this when it changes
+		void MarkUIDirty() { mUIDirty = true; }
+		bool ConsumeUIDirty()
+		{
+			bool dirty = mUIDirty;
+			mUIDirty = false;
+			return dirty;
+		}
+
 		template<class EventType>
 		void PublishInternalEvent(const EventType& evnt) {
 			mInternalEventBus.Publish(evnt);
@@ -25,9 +36,16 @@ namespace Jerboa {
 		}
 
 		inline const std::string& GetName() const { return mDebugName; }
+		// The name interned, it outlives the layer as profiler zone names must
+		inline const char* GetProfileName() const { return mProfileName; }
 	protected:
 		EventBus mInternalEventBus;
 		std::string mDebugName;
+	private:
+		const char* mProfileName;
+		bool mUIDirty = false;
 	};
+
+	inline Layer::~Layer() {}
 }
 
@@ -0,0 +1,69 @@
+#include "jerboa-pch.h"
+#include "LinearAllocator.h"
+
+namespace Jerboa {
+	static uint8_t* AlignUp(uint8_t* pointer, size_t alignment)
+	{
+		uintptr_t address = reinterpret_cast<uintptr_t>(pointer);
+		return reinterpret_cast<uint8_t*>((address + alignment - 1) & ~(alignment - 1));
+	}
+
+	LinearAllocator::LinearAllocator(size_t capacity)
+		: mMain{ std::make_unique<uint8_t[]>(capacity), capacity }, mCapacity(capacity)
+	{
+		mCursor = mMain.data.get();
+		mEnd = mCursor + capacity;
+	}
+
+	void* LinearAllocator::Allocate(size_t size, size_t alignment)
+	{
+		JERBOA_ASSERT((alignment & (alignment - 1)) == 0, "Alignment must be a power of two");
+
+		uint8_t* aligned = AlignUp(mCursor, alignment);
+		if (aligned + size > mEnd) {
+			// Overflow blocks are sized generously so a burst does not allocate per request
+			size_t blockSize = std::max(mCapacity, size + alignment);
+			mOverflow.push_back({ std::make_unique<uint8_t[]>(blockSize), blockSize });
+			mCapacity += blockSize;
+
+			mCursor = mOverflow.back().data.get();
+			mEnd = mCursor + blockSize;
+			aligned = AlignUp(mCursor, alignment);
+		}
+
+		mUsed += (aligned - mCursor) + size;
+		mCursor = aligned + size;
+		mHighWaterMark = std::max(mHighWaterMark, mUsed);
+		return aligned;
+	}
+
+	void LinearAllocator::Rewind(const Marker& marker)
+	{
+		JERBOA_ASSERT(marker.used <= mUsed && marker.overflowCount <= mOverflow.size(), "Rewinding past the current position");
+
+		// Back at the start is a reset, which also grows the main block if needed
+		if (marker.used == 0) {
+			Reset();
+			return;
+		}
+
+		// Overflow blocks chained in after the marker are dropped, mCapacity keeps counting
+		// them so the next Reset() still grows the main block to fit
+		mOverflow.resize(marker.overflowCount);
+		mCursor = marker.cursor;
+		mEnd = marker.end;
+		mUsed = marker.used;
+	}
+
+	void LinearAllocator::Reset()
+	{
+		if (mMain.size != mCapacity) {
+			mOverflow.clear();
+			mMain = { std::make_unique<uint8_t[]>(mCapacity), mCapacity };
+		}
+
+		mCursor = mMain.data.get();
+		mEnd = mCursor + mMain.size;
+		mUsed = 0;
+	}
+}
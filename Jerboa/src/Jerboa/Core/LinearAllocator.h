@@ -0,0 +1,76 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <new>
+
+namespace Jerboa {
+	// Bump allocator for short-lived data that is released all at once with Reset().
+	// When a frame needs more than the current capacity, extra blocks are chained in and
+	// the next Reset() grows the main block to the high-water mark, so steady-state
+	// frames never touch the general heap.
+	class LinearAllocator
+	{
+	public:
+		explicit LinearAllocator(size_t capacity = 64 * 1024);
+
+		LinearAllocator(const LinearAllocator&) = delete;
+		LinearAllocator& operator=(const LinearAllocator&) = delete;
+
+		void* Allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+		// Objects are never destroyed, so only trivially destructible types are allowed
+		template<class T, class... Args>
+		T* New(Args&&... args)
+		{
+			static_assert(std::is_trivially_destructible<T>::value, "LinearAllocator does not run destructors");
+			return new (Allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+		}
+
+		template<class T>
+		T* NewArray(size_t count)
+		{
+			static_assert(std::is_trivially_destructible<T>::value, "LinearAllocator does not run destructors");
+			T* data = static_cast<T*>(Allocate(sizeof(T) * count, alignof(T)));
+			for (size_t i = 0; i < count; i++)
+				new (data + i) T();
+			return data;
+		}
+
+		// Position to rewind to, releasing everything allocated after it
+		struct Marker
+		{
+			uint8_t* cursor;
+			uint8_t* end;
+			size_t used;
+			size_t overflowCount;
+		};
+
+		inline Marker GetMarker() const { return { mCursor, mEnd, mUsed, mOverflow.size() }; }
+		void Rewind(const Marker& marker);
+
+		void Reset();
+
+		inline size_t GetUsed() const { return mUsed; }
+		inline size_t GetCapacity() const { return mCapacity; }
+		inline size_t GetHighWaterMark() const { return mHighWaterMark; }
+	private:
+		struct Block
+		{
+			std::unique_ptr<uint8_t[]> data;
+			size_t size;
+		};
+
+		Block mMain;
+		std::vector<Block> mOverflow;
+		uint8_t* mCursor;
+		uint8_t* mEnd;
+
+		size_t mCapacity;
+		size_t mUsed = 0;
+		size_t mHighWaterMark = 0;
+	};
+}
@@ -1,10 +1,12 @@
 #include "jerboa-pch.h"
 #include "Log.h"
 #include "spdlog/sinks/stdout_color_sinks.h"
+#include "Jerboa/Profiling/Telemetry.h"
 
 namespace Jerboa {
 	std::shared_ptr<spdlog::logger> Log::s_CoreLogger;
 	std::shared_ptr<spdlog::logger> Log::s_AppLogger;
+	std::shared_ptr<LogRingSink> Log::s_ConsoleSink;
 
 	void Log::Init()
 	{
@@ -14,5 +16,14 @@ namespace Jerboa {
 
 		s_AppLogger = spdlog::stdout_color_mt("APP");
 		s_AppLogger->set_level(spdlog::level::trace);
+
+		// Idle until a telemetry viewer attaches
+		auto telemetrySink = Telemetry::CreateLogSink();
+		s_CoreLogger->sinks().push_back(telemetrySink);
+		s_AppLogger->sinks().push_back(telemetrySink);
+
+		s_ConsoleSink = std::make_shared<LogRingSink>();
+		s_CoreLogger->sinks().push_back(s_ConsoleSink);
+		s_AppLogger->sinks().push_back(s_ConsoleSink);
 	}
 }
@@ -1,6 +1,8 @@
 #pragma once
 
 #include "spdlog/spdlog.h"
+#include "Jerboa/Profiling/MemoryTracker.h"
+#include "Jerboa/Core/LogRing.h"
 
 namespace Jerboa {
 	class Log
@@ -10,10 +12,13 @@ namespace Jerboa {
 
 		inline static std::shared_ptr<spdlog::logger>& GetCoreLogger() { return s_CoreLogger; }
 		inline static std::shared_ptr<spdlog::logger>& GetAppLogger() { return s_AppLogger; }
+		// Recent lines of both loggers, for the editor's console
+		inline static LogRing& GetConsoleRing() { return s_ConsoleSink->GetRing(); }
 
 	private:
 		static std::shared_ptr<spdlog::logger> s_CoreLogger;
 		static std::shared_ptr<spdlog::logger> s_AppLogger;
+		static std::shared_ptr<LogRingSink> s_ConsoleSink;
 	};
 }
 
@@ -21,19 +26,26 @@ namespace Jerboa {
 	#define JERBOA_LOGGING_ENABLED
 #endif
 
+#ifdef JERBOA_MEMORY_TRACKING
+	// Allocations made while formatting and writing a message are counted as logging
+	#define JERBOA_LOG_TAGGED(...) do { ::Jerboa::MemoryTagScope logMemoryTag(::Jerboa::MemoryTag::Logging); __VA_ARGS__; } while (0)
+#else
+	#define JERBOA_LOG_TAGGED(...) __VA_ARGS__
+#endif
+
 #ifdef JERBOA_LOGGING_ENABLED
 	#ifdef JERBOA_CORE
-		#define JERBOA_LOG_TRACE(...)	Jerboa::Log::GetCoreLogger()->trace(__VA_ARGS__)
-		#define JERBOA_LOG_INFO(...)	Jerboa::Log::GetCoreLogger()->info(__VA_ARGS__)
-		#define JERBOA_LOG_WARN(...)	Jerboa::Log::GetCoreLogger()->warn(__VA_ARGS__)
-		#define JERBOA_LOG_ERROR(...)	Jerboa::Log::GetCoreLogger()->error(__VA_ARGS__)
-		#define JERBOA_LOG_FATAL(...)	Jerboa::Log::GetCoreLogger()->critical(__VA_ARGS__)
+		#define JERBOA_LOG_TRACE(...)	JERBOA_LOG_TAGGED(Jerboa::Log::GetCoreLogger()->trace(__VA_ARGS__))
+		#define JERBOA_LOG_INFO(...)	JERBOA_LOG_TAGGED(Jerboa::Log::GetCoreLogger()->info(__VA_ARGS__))
+		#define JERBOA_LOG_WARN(...)	JERBOA_LOG_TAGGED(Jerboa::Log::GetCoreLogger()->warn(__VA_ARGS__))
+		#define JERBOA_LOG_ERROR(...)	JERBOA_LOG_TAGGED(Jerboa::Log::GetCoreLogger()->error(__VA_ARGS__))
+		#define JERBOA_LOG_FATAL(...)	JERBOA_LOG_TAGGED(Jerboa::Log::GetCoreLogger()->critical(__VA_ARGS__))
 	#else
-		#define JERBOA_LOG_TRACE(...)	Jerboa::Log::GetAppLogger()->trace(__VA_ARGS__)
-		#define JERBOA_LOG_INFO(...)	Jerboa::Log::GetAppLogger()->info(__VA_ARGS__)
-		#define JERBOA_LOG_WARN(...)	Jerboa::Log::GetAppLogger()->warn(__VA_ARGS__)
-		#define JERBOA_LOG_ERROR(...)	Jerboa::Log::GetAppLogger()->error(__VA_ARGS__)
-		#define JERBOA_LOG_FATAL(...)	Jerboa::Log::GetAppLogger()->critical(__VA_ARGS__)
+		#define JERBOA_LOG_TRACE(...)	JERBOA_LOG_TAGGED(Jerboa::Log::GetAppLogger()->trace(__VA_ARGS__))
+		#define JERBOA_LOG_INFO(...)	JERBOA_LOG_TAGGED(Jerboa::Log::GetAppLogger()->info(__VA_ARGS__))
+		#define JERBOA_LOG_WARN(...)	JERBOA_LOG_TAGGED(Jerboa::Log::GetAppLogger()->warn(__VA_ARGS__))
+		#define JERBOA_LOG_ERROR(...)	JERBOA_LOG_TAGGED(Jerboa::Log::GetAppLogger()->error(__VA_ARGS__))
+		#define JERBOA_LOG_FATAL(...)	JERBOA_LOG_TAGGED(Jerboa::Log::GetAppLogger()->critical(__VA_ARGS__))
 	#endif
 #else
 	#define JERBOA_LOG_TRACE(...)
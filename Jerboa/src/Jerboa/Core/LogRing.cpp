@@ -0,0 +1,143 @@
+#include "jerboa-pch.h"
+#include "LogRing.h"
+
+#include "spdlog/details/os.h"
+#include "spdlog/fmt/fmt.h"
+
+#include <algorithm>
+#include <chrono>
+
+namespace Jerboa {
+	namespace {
+		uint32_t RoundUpToPowerOfTwo(uint32_t value)
+		{
+			uint32_t result = 1;
+			while (result < value)
+				result <<= 1;
+			return result;
+		}
+
+		// "HH:MM:SS" only changes once a second, so each thread formats it once per second
+		struct TimeCache
+		{
+			int64_t second = -1;
+			char text[8];
+		};
+		thread_local TimeCache tTimeCache;
+
+		// Logger name to category, so most lines skip the registry's lock
+		struct CategoryCache
+		{
+			const LogRing* ring = nullptr;
+			const char* name = nullptr;
+			uint8_t category = 0;
+		};
+		thread_local CategoryCache tCategoryCache[4];
+	}
+
+	LogRing::LogRing(uint32_t capacity)
+		: mCapacity(RoundUpToPowerOfTwo(std::max(capacity, 2u))), mMask(mCapacity - 1)
+	{
+		mSlots = std::make_unique<Slot[]>(mCapacity);
+	}
+
+	LogRing::ReadResult LogRing::GetState(const Slot& slot, uint64_t number, uint64_t sequence) const
+	{
+		if (sequence == number * 2 + 2)
+			return ReadResult::Ready;
+		// Overwritten by a newer line, dropped, or its writer gave up
+		if (sequence > number * 2 + 2 || slot.dropped.load(std::memory_order_acquire) == number || number + mCapacity <= GetEnd())
+			return ReadResult::Lost;
+		return ReadResult::Pending;
+	}
+
+	LogRing::ReadResult LogRing::ReadInfo(uint64_t number, uint8_t& level, uint8_t& category) const
+	{
+		const Slot& slot = mSlots[number & mMask];
+		const uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+		const ReadResult state = GetState(slot, number, sequence);
+		if (state != ReadResult::Ready)
+			return state;
+
+		level = slot.level;
+		category = slot.category;
+		std::atomic_thread_fence(std::memory_order_acquire);
+		return slot.sequence.load(std::memory_order_relaxed) == sequence ? ReadResult::Ready : ReadResult::Lost;
+	}
+
+	LogRing::ReadResult LogRing::Read(uint64_t number, Line& line) const
+	{
+		const Slot& slot = mSlots[number & mMask];
+		const uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+		const ReadResult state = GetState(slot, number, sequence);
+		if (state != ReadResult::Ready)
+			return state;
+
+		line.level = slot.level;
+		line.category = slot.category;
+		line.length = std::min<uint16_t>(slot.length, MaxTextLength);
+		std::memcpy(line.text, slot.text, line.length);
+		std::atomic_thread_fence(std::memory_order_acquire);
+		return slot.sequence.load(std::memory_order_relaxed) == sequence ? ReadResult::Ready : ReadResult::Lost;
+	}
+
+	uint8_t LogRing::GetCategory(std::string_view name)
+	{
+		std::lock_guard<std::mutex> lock(mCategoryMutex);
+		const uint32_t count = mCategoryCount.load(std::memory_order_relaxed);
+		for (uint32_t i = 0; i < count; i++) {
+			if (mCategoryNames[i] == name)
+				return static_cast<uint8_t>(i);
+		}
+		if (count == MaxCategories)
+			return static_cast<uint8_t>(MaxCategories - 1);
+
+		mCategoryNames[count] = std::string(name);
+		mCategoryCount.store(count + 1, std::memory_order_release);
+		return static_cast<uint8_t>(count);
+	}
+
+	std::string_view LogRing::GetCategoryName(uint8_t category) const
+	{
+		return category < GetCategoryCount() ? std::string_view(mCategoryNames[category]) : std::string_view();
+	}
+
+	void LogRingSink::log(const spdlog::details::log_msg& message)
+	{
+		const std::string_view name(message.logger_name.data(), message.logger_name.size());
+
+		// Keyed by the logger's name buffer, checked against the name in case it was reused
+		CategoryCache& cached = tCategoryCache[(reinterpret_cast<uintptr_t>(name.data()) >> 4) & 3];
+		if (cached.ring != &mRing || cached.name != name.data() || mRing.GetCategoryName(cached.category) != name) {
+			cached.ring = &mRing;
+			cached.name = name.data();
+			cached.category = mRing.GetCategory(name);
+		}
+
+		const int64_t second = std::chrono::duration_cast<std::chrono::seconds>(message.time.time_since_epoch()).count();
+		TimeCache& time = tTimeCache;
+		if (time.second != second) {
+			const std::tm local = spdlog::details::os::localtime(static_cast<std::time_t>(second));
+			fmt::format_to_n(time.text, sizeof(time.text), "{:02}:{:02}:{:02}", local.tm_hour, local.tm_min, local.tm_sec);
+			time.second = second;
+		}
+
+		// "[%T] %n: %v" only concatenates, copying the pieces beats parsing a format string
+		const std::string_view payload(message.payload.data(), message.payload.size());
+		mRing.Write(static_cast<uint8_t>(message.level), cached.category, [&](char* text, size_t capacity) {
+			size_t length = 0;
+			auto append = [&](const char* data, size_t size) {
+				size = std::min(size, capacity - length);
+				std::memcpy(text + length, data, size);
+				length += size;
+			};
+			append("[", 1);
+			append(time.text, sizeof(time.text));
+			append("] ", 2);
+			append(name.data(), name.size());
+			append(": ", 2);
+			append(payload.data(), payload.size());
+			return length;
+		});
+	}
+}
@@ -0,0 +1,128 @@
+#pragma once
+
+#include "spdlog/sinks/sink.h"
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <cstdint>
+
+namespace Jerboa {
+	// Fixed-capacity ring of formatted log lines for the editor console. Writers on any thread
+	// claim a slot with one atomic add and format straight into it, once the ring is full the
+	// oldest lines are overwritten. Every slot carries a sequence number, so a reader can tell
+	// whether the line it asked for is still there and wasn't overwritten while it was copied.
+	class LogRing
+	{
+	public:
+		static constexpr uint32_t DefaultCapacity = 16384;
+		static constexpr uint32_t SlotSize = 256;
+		static constexpr uint32_t MaxTextLength = SlotSize - 20;
+		// Loggers beyond this share the last category
+		static constexpr uint32_t MaxCategories = 32;
+
+		struct Line
+		{
+			uint8_t level;
+			uint8_t category;
+			uint16_t length;
+			char text[MaxTextLength];
+		};
+
+		enum class ReadResult { Ready, Pending, Lost };
+
+		// capacity is rounded up to a power of two
+		LogRing(uint32_t capacity = DefaultCapacity);
+		LogRing(const LogRing&) = delete;
+		LogRing& operator=(const LogRing&) = delete;
+
+		// format(char* text, size_t capacity) writes at most capacity characters and returns how many
+		template<typename Formatter>
+		void Write(uint8_t level, uint8_t category, Formatter&& format)
+		{
+			const uint64_t number = mEnd.fetch_add(1, std::memory_order_relaxed);
+			Slot& slot = mSlots[number & mMask];
+
+			// A writer a full lap ahead or behind is still busy with the slot, this line is lost.
+			// The tombstone tells readers not to wait for it.
+			uint64_t sequence = slot.sequence.load(std::memory_order_relaxed);
+			if ((sequence & 1) || sequence > number * 2 || !slot.sequence.compare_exchange_strong(sequence, number * 2 + 1, std::memory_order_acquire)) {
+				slot.dropped.store(number, std::memory_order_release);
+				mLost.fetch_add(1, std::memory_order_relaxed);
+				return;
+			}
+			std::atomic_thread_fence(std::memory_order_release);
+
+			slot.level = level;
+			slot.category = category;
+			size_t length = format(slot.text, (size_t)MaxTextLength);
+			slot.length = static_cast<uint16_t>(length < MaxTextLength ? length : MaxTextLength);
+			slot.sequence.store(number * 2 + 2, std::memory_order_release);
+		}
+
+		// Lines are numbered from 0 in the order they were claimed. [GetBegin(), GetEnd()) may
+		// still be in the ring, the newest of them can still be pending.
+		inline uint64_t GetEnd() const { return mEnd.load(std::memory_order_acquire); }
+		inline uint64_t GetBegin() const { uint64_t end = GetEnd(); return end > mCapacity ? end - mCapacity : 0; }
+		inline uint32_t GetCapacity() const { return mCapacity; }
+
+		// Only the level and category, for filtering without copying the text
+		ReadResult ReadInfo(uint64_t number, uint8_t& level, uint8_t& category) const;
+		ReadResult Read(uint64_t number, Line& line) const;
+
+		// Lines lost to writers colliding after the ring wrapped around during a flood
+		inline uint64_t GetLostCount() const { return mLost.load(std::memory_order_relaxed); }
+
+		// Returns the category of the name, registering it the first time
+		uint8_t GetCategory(std::string_view name);
+		std::string_view GetCategoryName(uint8_t category) const;
+		inline uint32_t GetCategoryCount() const { return mCategoryCount.load(std::memory_order_acquire); }
+	private:
+		struct alignas(64) Slot
+		{
+			// number * 2 + 1 while line number is written, number * 2 + 2 once it is complete
+			std::atomic<uint64_t> sequence{ 0 };
+			// Number of the newest line dropped because the slot was busy
+			std::atomic<uint64_t> dropped{ UINT64_MAX };
+			uint8_t level;
+			uint8_t category;
+			uint16_t length;
+			char text[MaxTextLength];
+		};
+		static_assert(sizeof(Slot) == SlotSize, "Log ring slots should fill whole cache lines");
+
+		ReadResult GetState(const Slot& slot, uint64_t number, uint64_t sequence) const;
+
+		std::unique_ptr<Slot[]> mSlots;
+		uint32_t mCapacity;
+		uint64_t mMask;
+		std::atomic<uint64_t> mEnd{ 0 };
+		std::atomic<uint64_t> mLost{ 0 };
+
+		std::mutex mCategoryMutex;
+		std::array<std::string, MaxCategories> mCategoryNames;
+		std::atomic<uint32_t> mCategoryCount{ 0 };
+	};
+
+	// Formats every message like the console does, "[%T] %n: %v", into a LogRing. The logger
+	// name is the line's category.
+	class LogRingSink : public spdlog::sinks::sink
+	{
+	public:
+		LogRingSink(uint32_t capacity = LogRing::DefaultCapacity)
+			: mRing(capacity) {}
+
+		inline LogRing& GetRing() { return mRing; }
+
+		void log(const spdlog::details::log_msg& message) override;
+		void flush() override {}
+		// The format is fixed, the console panel draws level and category itself
+		void set_pattern(const std::string&) override {}
+		void set_formatter(std::unique_ptr<spdlog::formatter>) override {}
+	private:
+		LogRing mRing;
+	};
+}
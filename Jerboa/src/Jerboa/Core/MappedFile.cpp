@@ -0,0 +1,120 @@
+#include "jerboa-pch.h"
+#include "MappedFile.h"
+
+#ifndef JERBOA_PLATFORM_WINDOWS
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <fcntl.h>
+	#include <unistd.h>
+#endif
+
+namespace Jerboa {
+	MappedFile::~MappedFile()
+	{
+		Close();
+	}
+
+	MappedFile::MappedFile(MappedFile&& other) noexcept
+	{
+		*this = std::move(other);
+	}
+
+	MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+	{
+		if (this != &other) {
+			Close();
+			std::swap(mData, other.mData);
+			std::swap(mSize, other.mSize);
+#ifdef JERBOA_PLATFORM_WINDOWS
+			std::swap(mFile, other.mFile);
+			std::swap(mMapping, other.mMapping);
+#endif
+		}
+		return *this;
+	}
+
+#ifdef JERBOA_PLATFORM_WINDOWS
+	bool MappedFile::Open(const std::string& path)
+	{
+		Close();
+
+		HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+			return false;
+
+		LARGE_INTEGER size;
+		if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+			CloseHandle(file);
+			return false;
+		}
+
+		HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (mapping == nullptr) {
+			CloseHandle(file);
+			return false;
+		}
+
+		void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+		if (data == nullptr) {
+			CloseHandle(mapping);
+			CloseHandle(file);
+			return false;
+		}
+
+		mFile = file;
+		mMapping = mapping;
+		mData = static_cast<const uint8_t*>(data);
+		mSize = static_cast<size_t>(size.QuadPart);
+		return true;
+	}
+
+	void MappedFile::Close()
+	{
+		if (mData != nullptr)
+			UnmapViewOfFile(mData);
+		if (mMapping != nullptr)
+			CloseHandle(mMapping);
+		if (mFile != nullptr)
+			CloseHandle(mFile);
+
+		mData = nullptr;
+		mSize = 0;
+		mMapping = nullptr;
+		mFile = nullptr;
+	}
+#else
+	bool MappedFile::Open(const std::string& path)
+	{
+		Close();
+
+		int file = open(path.c_str(), O_RDONLY);
+		if (file < 0)
+			return false;
+
+		struct stat info;
+		if (fstat(file, &info) != 0 || info.st_size == 0) {
+			close(file);
+			return false;
+		}
+
+		// The mapping keeps the file alive, the descriptor is not needed anymore
+		void* data = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+		close(file);
+		if (data == MAP_FAILED)
+			return false;
+
+		mData = static_cast<const uint8_t*>(data);
+		mSize = static_cast<size_t>(info.st_size);
+		return true;
+	}
+
+	void MappedFile::Close()
+	{
+		if (mData != nullptr)
+			munmap(const_cast<uint8_t*>(mData), mSize);
+
+		mData = nullptr;
+		mSize = 0;
+	}
+#endif
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+namespace Jerboa {
+	// Read-only memory mapping of a whole file. Pages are loaded by the OS on first access
+	// and shared with its file cache, so opening costs the same for any file size.
+	class MappedFile
+	{
+	public:
+		MappedFile() = default;
+		~MappedFile();
+
+		MappedFile(MappedFile&& other) noexcept;
+		MappedFile& operator=(MappedFile&& other) noexcept;
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		// Empty files can not be mapped and fail to open
+		bool Open(const std::string& path);
+		void Close();
+
+		inline bool IsOpen() const { return mData != nullptr; }
+		inline const uint8_t* GetData() const { return mData; }
+		inline size_t GetSize() const { return mSize; }
+	private:
+		const uint8_t* mData = nullptr;
+		size_t mSize = 0;
+#ifdef JERBOA_PLATFORM_WINDOWS
+		void* mFile = nullptr;
+		void* mMapping = nullptr;
+#endif
+	};
+}
@@ -0,0 +1,57 @@
+#include "jerboa-pch.h"
+#include "PoolAllocator.h"
+
+namespace Jerboa {
+	PoolAllocator::PoolAllocator(size_t elementSize, size_t alignment, uint32_t elementsPerBlock)
+		: mAlignment(std::max(alignment, alignof(FreeElement))), mElementsPerBlock(elementsPerBlock)
+	{
+		JERBOA_ASSERT((alignment & (alignment - 1)) == 0, "Alignment must be a power of two");
+		JERBOA_ASSERT(elementsPerBlock > 0, "A pool block needs at least one element");
+
+		// Free slots hold the next pointer of the free list
+		size_t size = std::max(elementSize, sizeof(FreeElement));
+		mStride = (size + mAlignment - 1) & ~(mAlignment - 1);
+	}
+
+	PoolAllocator::~PoolAllocator()
+	{
+		JERBOA_ASSERT(mLiveCount == 0, "PoolAllocator destroyed with elements still allocated");
+
+		for (void* block : mBlocks)
+			::operator delete(block, std::align_val_t(mAlignment));
+	}
+
+	void* PoolAllocator::Allocate()
+	{
+		if (mFreeList == nullptr)
+			AddBlock();
+
+		FreeElement* element = mFreeList;
+		mFreeList = element->next;
+		mLiveCount++;
+		return element;
+	}
+
+	void PoolAllocator::Free(void* element)
+	{
+		JERBOA_ASSERT(mLiveCount > 0, "Freeing into a PoolAllocator without live elements");
+
+		FreeElement* freed = static_cast<FreeElement*>(element);
+		freed->next = mFreeList;
+		mFreeList = freed;
+		mLiveCount--;
+	}
+
+	void PoolAllocator::AddBlock()
+	{
+		uint8_t* block = static_cast<uint8_t*>(::operator new(mStride * mElementsPerBlock, std::align_val_t(mAlignment)));
+		mBlocks.push_back(block);
+
+		// Threaded back to front so elements are handed out in address order
+		for (uint32_t i = mElementsPerBlock; i-- > 0;) {
+			FreeElement* element = reinterpret_cast<FreeElement*>(block + i * mStride);
+			element->next = mFreeList;
+			mFreeList = element;
+		}
+	}
+}
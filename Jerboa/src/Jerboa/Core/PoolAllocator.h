@@ -0,0 +1,71 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <new>
+
+namespace Jerboa {
+	// Fixed-size elements handed out from a free list threaded through the unused slots.
+	// Blocks of elements are added as the pool grows and kept until it is destroyed, so a
+	// pool that reached its working set never touches the general heap again.
+	class PoolAllocator
+	{
+	public:
+		PoolAllocator(size_t elementSize, size_t alignment = alignof(std::max_align_t), uint32_t elementsPerBlock = 256);
+		~PoolAllocator();
+
+		PoolAllocator(const PoolAllocator&) = delete;
+		PoolAllocator& operator=(const PoolAllocator&) = delete;
+
+		void* Allocate();
+		void Free(void* element);
+
+		inline size_t GetElementSize() const { return mStride; }
+		inline uint32_t GetLiveCount() const { return mLiveCount; }
+		inline uint32_t GetCapacity() const { return (uint32_t)mBlocks.size() * mElementsPerBlock; }
+	private:
+		struct FreeElement
+		{
+			FreeElement* next;
+		};
+
+		void AddBlock();
+
+		size_t mStride;
+		size_t mAlignment;
+		uint32_t mElementsPerBlock;
+		std::vector<void*> mBlocks;
+		FreeElement* mFreeList = nullptr;
+		uint32_t mLiveCount = 0;
+	};
+
+	// Typed front end of a PoolAllocator that constructs and destroys the objects
+	template<class T>
+	class ObjectPool
+	{
+	public:
+		explicit ObjectPool(uint32_t elementsPerBlock = 256)
+			: mPool(sizeof(T), alignof(T), elementsPerBlock) {}
+
+		template<class... Args>
+		T* New(Args&&... args)
+		{
+			return new (mPool.Allocate()) T(std::forward<Args>(args)...);
+		}
+
+		void Delete(T* object)
+		{
+			if (object == nullptr)
+				return;
+			object->~T();
+			mPool.Free(object);
+		}
+
+		inline uint32_t GetLiveCount() const { return mPool.GetLiveCount(); }
+		inline uint32_t GetCapacity() const { return mPool.GetCapacity(); }
+	private:
+		PoolAllocator mPool;
+	};
+}
@@ -0,0 +1,12 @@
+#include "jerboa-pch.h"
+#include "ScratchAllocator.h"
+
+namespace Jerboa {
+	static constexpr size_t ScratchArenaCapacity = 256 * 1024;
+
+	LinearAllocator& ScratchAllocator::Get()
+	{
+		static thread_local LinearAllocator arena(ScratchArenaCapacity);
+		return arena;
+	}
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "LinearAllocator.h"
+
+namespace Jerboa {
+	// Per-thread arena for temporary memory inside a function or job. Allocations are
+	// released when the innermost ScratchScope on the thread ends.
+	class ScratchAllocator
+	{
+	public:
+		static LinearAllocator& Get();
+	};
+
+	// Rewinds the calling thread's scratch arena to where it was when the scope began
+	class ScratchScope
+	{
+	public:
+		ScratchScope()
+			: mArena(ScratchAllocator::Get()), mMarker(mArena.GetMarker()) {}
+		~ScratchScope() { mArena.Rewind(mMarker); }
+
+		ScratchScope(const ScratchScope&) = delete;
+		ScratchScope& operator=(const ScratchScope&) = delete;
+
+		inline LinearAllocator& GetArena() { return mArena; }
+	private:
+		LinearAllocator& mArena;
+		LinearAllocator::Marker mMarker;
+	};
+}
@@ -0,0 +1,190 @@
+#include "jerboa-pch.h"
+#include "StartupTracer.h"
+
+#include <mutex>
+#include <atomic>
+#include <fstream>
+
+#ifdef JERBOA_PLATFORM_LINUX
+	#include <time.h>
+	#include <unistd.h>
+#endif
+
+namespace Jerboa {
+	namespace {
+		constexpr uint32_t NoThread = 0xffffffff;
+		constexpr size_t NoPhase = ~(size_t)0;
+
+		struct StartupTracerData
+		{
+			std::mutex mutex;
+			std::vector<StartupPhase> phases;
+			std::atomic<bool> recording{ false };
+			std::atomic<uint32_t> threadCount{ 0 };
+			Timestamp start = 0;
+			Timestamp firstFrame = 0;
+			double beforeMainMs = -1.0;
+		};
+
+		StartupTracerData sData;
+
+		// Open phases of the calling thread, as indices into sData.phases
+		thread_local std::vector<size_t> tOpenPhases;
+		thread_local uint32_t tThread = NoThread;
+
+		uint32_t GetThread()
+		{
+			if (tThread == NoThread)
+				tThread = sData.threadCount.fetch_add(1, std::memory_order_relaxed);
+			return tThread;
+		}
+
+		double ReadTimeBeforeMain()
+		{
+#ifdef JERBOA_PLATFORM_LINUX
+			// Field 22 of /proc/self/stat is the start time in clock ticks since boot. The
+			// command name in field 2 may contain spaces, so fields are counted after it.
+			std::ifstream file("/proc/self/stat");
+			std::string stat((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+			size_t position = stat.rfind(')');
+			if (position == std::string::npos)
+				return -1.0;
+
+			for (int field = 2; field < 22 && position != std::string::npos; field++)
+				position = stat.find(' ', position + 1);
+			if (position == std::string::npos)
+				return -1.0;
+
+			unsigned long long startTicks = std::strtoull(stat.c_str() + position + 1, nullptr, 10);
+			timespec now;
+			if (clock_gettime(CLOCK_BOOTTIME, &now) != 0)
+				return -1.0;
+
+			double nowMs = now.tv_sec * 1000.0 + now.tv_nsec / 1000000.0;
+			return std::max(nowMs - startTicks * 1000.0 / sysconf(_SC_CLK_TCK), 0.0);
+#else
+			return -1.0;
+#endif
+		}
+	}
+
+	void StartupTracer::Begin()
+	{
+		sData.start = Time::Now();
+		tThread = 0;
+		sData.threadCount.store(1, std::memory_order_relaxed);
+		sData.beforeMainMs = ReadTimeBeforeMain();
+		sData.recording.store(true, std::memory_order_release);
+	}
+
+	void StartupTracer::BeginPhase(const char* name)
+	{
+		if (!IsRecording()) {
+			// Scopes inside a phase that is still open must not end it early
+			if (!tOpenPhases.empty())
+				tOpenPhases.push_back(NoPhase);
+			return;
+		}
+
+		StartupPhase phase;
+		phase.name = name;
+		phase.start = Time::Now();
+		phase.end = 0;
+		phase.depth = (uint32_t)tOpenPhases.size();
+		phase.thread = GetThread();
+
+		std::lock_guard<std::mutex> lock(sData.mutex);
+		tOpenPhases.push_back(sData.phases.size());
+		sData.phases.push_back(phase);
+	}
+
+	void StartupTracer::EndPhase()
+	{
+		// Phases that began before the first frame still end, so nesting stays intact
+		if (tOpenPhases.empty())
+			return;
+
+		size_t index = tOpenPhases.back();
+		tOpenPhases.pop_back();
+		if (index == NoPhase)
+			return;
+
+		Timestamp end = Time::Now();
+		std::lock_guard<std::mutex> lock(sData.mutex);
+		sData.phases[index].end = end;
+	}
+
+	bool StartupTracer::IsRecording()
+	{
+		return sData.recording.load(std::memory_order_acquire);
+	}
+
+	void StartupTracer::EndFirstFrame()
+	{
+		if (!sData.recording.exchange(false))
+			return;
+		sData.firstFrame = Time::Now();
+
+		std::vector<StartupPhase> phases = GetPhases();
+		if (sData.beforeMainMs >= 0.0)
+			JERBOA_LOG_INFO("Startup: first frame presented {:.2f} ms after main(), the process started about {:.0f} ms before main()", GetTimeToFirstFrame(), sData.beforeMainMs);
+		else
+			JERBOA_LOG_INFO("Startup: first frame presented {:.2f} ms after main()", GetTimeToFirstFrame());
+
+		for ([[maybe_unused]] const StartupPhase& phase : phases) {
+			JERBOA_LOG_INFO("  {:9.2f} ms {:9.2f} ms  thread {}  {:>{}}{}", Time::ToMilliseconds(phase.start - sData.start),
+				Time::ToMilliseconds(phase.end - phase.start), phase.thread, "", phase.depth * 2, phase.name);
+		}
+	}
+
+	double StartupTracer::GetTimeToFirstFrame()
+	{
+		return sData.firstFrame ? Time::ToMilliseconds(sData.firstFrame - sData.start) : 0.0;
+	}
+
+	double StartupTracer::GetTimeBeforeMain()
+	{
+		return sData.beforeMainMs;
+	}
+
+	std::vector<StartupPhase> StartupTracer::GetPhases()
+	{
+		std::lock_guard<std::mutex> lock(sData.mutex);
+		std::vector<StartupPhase> phases = sData.phases;
+		// Phases still open count as running until now
+		Timestamp now = Time::Now();
+		for (StartupPhase& phase : phases) {
+			if (phase.end == 0)
+				phase.end = now;
+		}
+		std::stable_sort(phases.begin(), phases.end(), [](const StartupPhase& a, const StartupPhase& b) { return a.start < b.start; });
+		return phases;
+	}
+
+	bool StartupTracer::WriteTrace(const std::string& path)
+	{
+		std::ofstream file(path);
+		if (!file) {
+			JERBOA_LOG_ERROR("Could not write startup trace to \"{}\"", path);
+			return false;
+		}
+
+		file << "{\"traceEvents\":[";
+		bool first = true;
+		for (const StartupPhase& phase : GetPhases()) {
+			file << (first ? "" : ",") << "\n{\"name\":\"";
+			for (const char* character = phase.name; *character; character++) {
+				if (*character == '"' || *character == '\\')
+					file << '\\';
+				file << *character;
+			}
+			file << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << phase.thread
+				<< ",\"ts\":" << (phase.start - sData.start) / 1000.0 << ",\"dur\":" << (phase.end - phase.start) / 1000.0 << "}";
+			first = false;
+		}
+		file << "\n]}\n";
+
+		JERBOA_LOG_INFO("Wrote startup trace to \"{}\"", path);
+		return true;
+	}
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "Time.h"
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace Jerboa {
+	struct StartupPhase
+	{
+		// Must point to storage that outlives startup, e.g. a string literal
+		const char* name;
+		Timestamp start;
+		Timestamp end;
+		uint32_t depth;
+		// 0 is the main thread, helper threads are numbered in the order they first traced
+		uint32_t thread;
+	};
+
+	// Times the steps from main() to the first presented frame, on every thread that helps
+	// starting up. Recording stops with the first frame, later scopes cost a flag check.
+	class StartupTracer
+	{
+	public:
+		// First thing in main(), on the main thread
+		static void Begin();
+		// Logs the report, only the first call does anything
+		static void EndFirstFrame();
+
+		static void BeginPhase(const char* name);
+		static void EndPhase();
+
+		static bool IsRecording();
+		// 0 until the first frame was presented
+		static double GetTimeToFirstFrame();
+		// Time between the process starting and main(), as far as the platform tells, or a
+		// negative value
+		static double GetTimeBeforeMain();
+		// Complete once the first frame was presented
+		static std::vector<StartupPhase> GetPhases();
+
+		// Chrome trace event JSON, for chrome://tracing or Perfetto
+		static bool WriteTrace(const std::string& path);
+	};
+
+	class StartupScope
+	{
+	public:
+		StartupScope(const char* name) { StartupTracer::BeginPhase(name); }
+		~StartupScope() { StartupTracer::EndPhase(); }
+
+		StartupScope(const StartupScope&) = delete;
+		StartupScope& operator=(const StartupScope&) = delete;
+	};
+}
+
+#define JERBOA_STARTUP_CONCAT_IMPL(a, b) a##b
+#define JERBOA_STARTUP_CONCAT(a, b) JERBOA_STARTUP_CONCAT_IMPL(a, b)
+#define JERBOA_STARTUP_SCOPE(name) ::Jerboa::StartupScope JERBOA_STARTUP_CONCAT(startupScope, __LINE__)(name)
@@ -0,0 +1,100 @@
+#pragma once
+
+#include "LinearAllocator.h"
+#include "PoolAllocator.h"
+
+#include <mutex>
+
+namespace Jerboa {
+	// Standard library allocator drawing from a LinearAllocator, e.g. for containers that
+	// only live for a frame or a ScratchScope. Deallocation is a no-op, the memory comes
+	// back when the arena is reset or rewound.
+	template<class T>
+	class ArenaStlAllocator
+	{
+	public:
+		using value_type = T;
+
+		ArenaStlAllocator(LinearAllocator& arena) : mArena(&arena) {}
+		template<class U>
+		ArenaStlAllocator(const ArenaStlAllocator<U>& other) : mArena(other.GetArena()) {}
+
+		inline T* allocate(size_t count) { return static_cast<T*>(mArena->Allocate(count * sizeof(T), alignof(T))); }
+		inline void deallocate(T*, size_t) {}
+
+		inline LinearAllocator* GetArena() const { return mArena; }
+
+		template<class U>
+		inline bool operator==(const ArenaStlAllocator<U>& other) const { return mArena == other.GetArena(); }
+		template<class U>
+		inline bool operator!=(const ArenaStlAllocator<U>& other) const { return mArena != other.GetArena(); }
+	private:
+		LinearAllocator* mArena;
+	};
+
+	// Process-wide pool for one element size, shared by every PoolStlAllocator of that size.
+	// Never destroyed, so containers with static storage duration can still free into it.
+	template<size_t Size, size_t Alignment>
+	class SharedPool
+	{
+	public:
+		static void* Allocate()
+		{
+			Data& data = Get();
+			std::lock_guard<std::mutex> lock(data.mutex);
+			return data.pool.Allocate();
+		}
+
+		static void Free(void* element)
+		{
+			Data& data = Get();
+			std::lock_guard<std::mutex> lock(data.mutex);
+			data.pool.Free(element);
+		}
+	private:
+		struct Data
+		{
+			PoolAllocator pool{ Size, Alignment };
+			std::mutex mutex;
+		};
+
+		static Data& Get()
+		{
+			static Data* data = new Data();
+			return *data;
+		}
+	};
+
+	// Standard library allocator for node-based containers (std::list, std::map, ...):
+	// single nodes come from the SharedPool of their size, arrays from the general heap
+	template<class T>
+	class PoolStlAllocator
+	{
+	public:
+		using value_type = T;
+
+		PoolStlAllocator() = default;
+		template<class U>
+		PoolStlAllocator(const PoolStlAllocator<U>&) {}
+
+		T* allocate(size_t count)
+		{
+			if (count == 1)
+				return static_cast<T*>(SharedPool<sizeof(T), alignof(T)>::Allocate());
+			return static_cast<T*>(::operator new(count * sizeof(T), std::align_val_t(alignof(T))));
+		}
+
+		void deallocate(T* pointer, size_t count)
+		{
+			if (count == 1)
+				SharedPool<sizeof(T), alignof(T)>::Free(pointer);
+			else
+				::operator delete(pointer, std::align_val_t(alignof(T)));
+		}
+
+		template<class U>
+		inline bool operator==(const PoolStlAllocator<U>&) const { return true; }
+		template<class U>
+		inline bool operator!=(const PoolStlAllocator<U>&) const { return false; }
+	};
+}
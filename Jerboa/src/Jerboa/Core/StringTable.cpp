@@ -0,0 +1,115 @@
+#include "jerboa-pch.h"
+#include "StringTable.h"
+
+#include <atomic>
+#include <shared_mutex>
+
+namespace Jerboa {
+	namespace {
+		// Views are kept in fixed pages that never move, so Get() needs no lock
+		constexpr uint32_t PageBits = 12;
+		constexpr uint32_t PageSize = 1 << PageBits;
+		constexpr uint32_t MaxPages = 4096;
+		constexpr size_t BlockSize = 64 * 1024;
+
+		struct StringTableData
+		{
+			std::shared_mutex mutex;
+			std::unordered_map<std::string_view, uint32_t> ids;
+			std::atomic<std::string_view*> pages[MaxPages] = {};
+			std::vector<std::unique_ptr<std::string_view[]>> pageStorage;
+			uint32_t count = 0;
+
+			// Characters of all strings, each followed by a null terminator
+			std::vector<std::unique_ptr<char[]>> blocks;
+			char* cursor = nullptr;
+			char* end = nullptr;
+
+			StringTableData()
+			{
+				Add(std::string_view());
+			}
+
+			std::string_view Store(std::string_view string)
+			{
+				size_t size = string.size() + 1;
+				if (cursor == nullptr || size > static_cast<size_t>(end - cursor)) {
+					size_t blockSize = std::max(BlockSize, size);
+					blocks.push_back(std::make_unique<char[]>(blockSize));
+					cursor = blocks.back().get();
+					end = cursor + blockSize;
+				}
+
+				char* stored = cursor;
+				std::memcpy(stored, string.data(), string.size());
+				stored[string.size()] = '\0';
+				cursor += size;
+				return std::string_view(stored, string.size());
+			}
+
+			uint32_t Add(std::string_view string)
+			{
+				uint32_t id = count;
+				uint32_t page = id >> PageBits;
+				JERBOA_ASSERT(page < MaxPages, "StringTable is full");
+				if (id % PageSize == 0) {
+					pageStorage.push_back(std::make_unique<std::string_view[]>(PageSize));
+					pages[page].store(pageStorage.back().get(), std::memory_order_release);
+				}
+
+				std::string_view stored = Store(string);
+				pages[page].load(std::memory_order_relaxed)[id % PageSize] = stored;
+				ids.emplace(stored, id);
+				count++;
+				return id;
+			}
+		};
+
+		StringTableData& GetData()
+		{
+			static StringTableData data;
+			return data;
+		}
+	}
+
+	StringID StringTable::Intern(std::string_view string)
+	{
+		StringTableData& data = GetData();
+		{
+			std::shared_lock<std::shared_mutex> lock(data.mutex);
+			auto it = data.ids.find(string);
+			if (it != data.ids.end())
+				return { it->second };
+		}
+
+		std::unique_lock<std::shared_mutex> lock(data.mutex);
+		// Another thread may have added it in between
+		auto it = data.ids.find(string);
+		if (it != data.ids.end())
+			return { it->second };
+		return { data.Add(string) };
+	}
+
+	StringID StringTable::Find(std::string_view string)
+	{
+		StringTableData& data = GetData();
+		std::shared_lock<std::shared_mutex> lock(data.mutex);
+		auto it = data.ids.find(string);
+		return it != data.ids.end() ? StringID{ it->second } : StringID();
+	}
+
+	std::string_view StringTable::Get(StringID id)
+	{
+		StringTableData& data = GetData();
+		std::string_view* page = data.pages[id.value >> PageBits].load(std::memory_order_acquire);
+		JERBOA_ASSERT(page != nullptr, "Invalid StringID");
+		return page[id.value % PageSize];
+	}
+
+	uint32_t StringTable::GetCount()
+	{
+		StringTableData& data = GetData();
+		std::shared_lock<std::shared_mutex> lock(data.mutex);
+		return data.count;
+	}
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <string_view>
+#include <functional>
+#include <cstdint>
+
+namespace Jerboa {
+	// Handle to an interned string, 0 is the empty string
+	struct StringID
+	{
+		uint32_t value = 0;
+
+		inline bool IsEmpty() const { return value == 0; }
+		inline bool operator==(StringID other) const { return value == other.value; }
+		inline bool operator!=(StringID other) const { return value != other.value; }
+		inline bool operator<(StringID other) const { return value < other.value; }
+	};
+
+	// Process-wide string interning. Every distinct string is stored once and never freed,
+	// so IDs and views stay valid until exit and compare in constant time. Thread safe;
+	// interning a string that is already known does not allocate.
+	class StringTable
+	{
+	public:
+		static StringID Intern(std::string_view string);
+		// The empty ID if the string was never interned
+		static StringID Find(std::string_view string);
+
+		// The view is null terminated
+		static std::string_view Get(StringID id);
+		inline static const char* GetCString(StringID id) { return Get(id).data(); }
+
+		static uint32_t GetCount();
+	};
+}
+
+namespace std {
+	template<>
+	struct hash<Jerboa::StringID>
+	{
+		size_t operator()(Jerboa::StringID id) const { return std::hash<uint32_t>()(id.value); }
+	};
+}
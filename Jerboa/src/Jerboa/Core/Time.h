@@ -0,0 +1,22 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+namespace Jerboa {
+	// Monotonic high-resolution point in time, in nanoseconds since an unspecified epoch
+	using Timestamp = uint64_t;
+
+	namespace Time {
+		inline Timestamp Now()
+		{
+			using namespace std::chrono;
+			return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+		}
+
+		inline double ToMilliseconds(Timestamp duration)
+		{
+			return duration / 1000000.0;
+		}
+	}
+}
@@ -7,4 +7,9 @@ namespace Jerboa {
 	{
 		return new GLFW_Window(props);
 	}
+
+	void Window::PollEvents()
+	{
+		GLFW_Window::PollEvents();
+	}
 }
\ No newline at end of file
@@ -1,20 +1,29 @@
 #pragma once
 
 #include "EventBus.h"
+#include "InputLatency.h"
 #include <memory>
 
 namespace Jerboa {
+	class Window;
 
 	struct WindowProps
 	{
 		std::string title;
 		unsigned int width;
 		unsigned int height;
+		bool rawMouseMotion;
+		// Hidden windows still get a GL context, e.g. for headless benchmarks
+		bool visible = true;
+		// The new context shares textures, buffers and shaders with this window's. Vertex
+		// arrays and framebuffers are never shared.
+		Window* sharedContext = nullptr;
 
 		WindowProps(const std::string& title = "Jerboa",
 			unsigned int width = 1280,
-			unsigned int height = 720)
-			: title(title), width(width), height(height)
+			unsigned int height = 720,
+			bool rawMouseMotion = false)
+			: title(title), width(width), height(height), rawMouseMotion(rawMouseMotion)
 		{}
 	};
 
@@ -28,8 +37,16 @@ namespace Jerboa {
 	public:
 		virtual ~Window() {}
 
+		// Present() followed by PollEvents()
 		virtual void Update() = 0;
+		// Swaps buffers, call it while the window's context is current
+		virtual void Present() = 0;
 		virtual void Clear() = 0;
+		// Input of every window is published to the event bus of the window it happened in
+		static void PollEvents();
+
+		// GL calls and the GLStateCache go to this window's context from now on
+		virtual void MakeContextCurrent() = 0;
 
 		virtual int GetWidth() const = 0;
 		virtual int GetHeight() const = 0;
@@ -37,9 +54,17 @@ namespace Jerboa {
 
 		// Window attributes
 		virtual std::weak_ptr<EventBus> GetEventBus() = 0;
+		// The swap interval of the window's context, it doesn't have to be current
 		virtual void SetVSync(bool enabled) = 0;
 		virtual bool IsVSync() const = 0;
 
+		// Unscaled, unaccelerated mouse motion. Only applies while the cursor is captured,
+		// so enabling it also hides and locks the cursor. Returns false if unsupported.
+		virtual bool SetRawMouseMotion(bool enabled) = 0;
+		virtual bool IsRawMouseMotion() const = 0;
+
+		virtual InputLatencyTracker& GetInputLatency() = 0;
+
 		virtual void* GetNativeWindow() const = 0;
 
 		static Window* Create(const WindowProps& props = WindowProps());
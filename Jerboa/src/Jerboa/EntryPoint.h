@@ -8,17 +8,29 @@
 #include "Jerboa/Core/Base.h"
 #include "Jerboa/Core/Application.h"
 #include "Jerboa/Core/Assert.h"
+#include "Jerboa/Core/StartupTracer.h"
 
-extern Jerboa::Application* Jerboa::CreateApplication();
+extern Jerboa::Application* Jerboa::CreateApplication(ApplicationCommandLineArgs args);
 
 int main(int argc, char** argv)
 {
-    Jerboa::InitializeCore();
-	Jerboa::Application* app = Jerboa::CreateApplication(); 
+	Jerboa::StartupTracer::Begin();
+	{
+		JERBOA_STARTUP_SCOPE("InitializeCore");
+		Jerboa::InitializeCore();
+	}
+
+	Jerboa::Application* app;
+	{
+		JERBOA_STARTUP_SCOPE("CreateApplication");
+		app = Jerboa::CreateApplication({ argc, argv });
+	}
 	JERBOA_ASSERT(app, "Jerboa::CreateApplication() must not return null");
 	
 	app->Run();
+	const int exitCode = app->GetExitCode();
 	
 	delete app;
     Jerboa::ShutdownCore();
+	return exitCode;
 }
@@ -0,0 +1,66 @@
+#include "jerboa-pch.h"
+#include "Bounds.h"
+
+#include <cmath>
+
+namespace Jerboa {
+	AABB AABB::Transform(const AABB& box, const Mat4& transform)
+	{
+		// Arvo: the new extents are the absolute matrix applied to the old extents
+		Vec3 center = TransformPoint(transform, box.GetCenter());
+		Vec3 extents = box.GetExtents();
+		const float* m = transform.m;
+		Vec3 newExtents = {
+			std::fabs(m[0]) * extents.x + std::fabs(m[4]) * extents.y + std::fabs(m[8]) * extents.z,
+			std::fabs(m[1]) * extents.x + std::fabs(m[5]) * extents.y + std::fabs(m[9]) * extents.z,
+			std::fabs(m[2]) * extents.x + std::fabs(m[6]) * extents.y + std::fabs(m[10]) * extents.z
+		};
+		return { center - newExtents, center + newExtents };
+	}
+
+	Frustum Frustum::FromMatrix(const Mat4& viewProjection)
+	{
+		// Gribb/Hartmann: each plane is the last row plus or minus one of the others
+		Vec4 x = viewProjection.GetRow(0), y = viewProjection.GetRow(1), z = viewProjection.GetRow(2), w = viewProjection.GetRow(3);
+
+		Frustum frustum;
+		frustum.planes[Left] = w + x;
+		frustum.planes[Right] = w - x;
+		frustum.planes[Bottom] = w + y;
+		frustum.planes[Top] = w - y;
+		frustum.planes[Near] = w + z;
+		frustum.planes[Far] = w - z;
+
+		for (Vec4& plane : frustum.planes) {
+			float length = std::sqrt(plane.x * plane.x + plane.y * plane.y + plane.z * plane.z);
+			if (length > 0.0f)
+				plane *= 1.0f / length;
+		}
+		return frustum;
+	}
+
+	// Both tests match the batch kernels in MathKernels, including the order of operations
+
+	bool Frustum::Intersects(const Sphere& sphere) const
+	{
+		for (const Vec4& plane : planes) {
+			float distance = ((plane.x * sphere.center.x + plane.y * sphere.center.y) + plane.z * sphere.center.z) + plane.w;
+			if (!(distance > -sphere.radius))
+				return false;
+		}
+		return true;
+	}
+
+	bool Frustum::Intersects(const AABB& box) const
+	{
+		Vec3 center = box.GetCenter();
+		Vec3 extents = box.GetExtents();
+		for (const Vec4& plane : planes) {
+			float distance = ((plane.x * center.x + plane.y * center.y) + plane.z * center.z) + plane.w;
+			float radius = (std::fabs(plane.x) * extents.x + std::fabs(plane.y) * extents.y) + std::fabs(plane.z) * extents.z;
+			if (!(distance > -radius))
+				return false;
+		}
+		return true;
+	}
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include "Vector.h"
+#include "Matrix.h"
+
+namespace Jerboa {
+	struct AABB
+	{
+		Vec3 min, max;
+
+		inline Vec3 GetCenter() const { return (min + max) * 0.5f; }
+		inline Vec3 GetExtents() const { return (max - min) * 0.5f; }
+		inline float GetSurfaceArea() const
+		{
+			Vec3 size = max - min;
+			return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+		}
+
+		inline bool Contains(const Vec3& point) const
+		{
+			return point.x >= min.x && point.x <= max.x && point.y >= min.y && point.y <= max.y && point.z >= min.z && point.z <= max.z;
+		}
+
+		inline bool Contains(const AABB& other) const
+		{
+			return other.min.x >= min.x && other.max.x <= max.x && other.min.y >= min.y && other.max.y <= max.y
+				&& other.min.z >= min.z && other.max.z <= max.z;
+		}
+
+		inline bool Intersects(const AABB& other) const
+		{
+			return min.x <= other.max.x && max.x >= other.min.x && min.y <= other.max.y && max.y >= other.min.y
+				&& min.z <= other.max.z && max.z >= other.min.z;
+		}
+
+		inline AABB Expanded(float margin) const { return { min - Vec3{ margin, margin, margin }, max + Vec3{ margin, margin, margin } }; }
+
+		static inline AABB Merge(const AABB& a, const AABB& b) { return { Min(a.min, b.min), Max(a.max, b.max) }; }
+		// Smallest box containing the transformed box
+		static AABB Transform(const AABB& box, const Mat4& transform);
+	};
+
+	// Points at origin + direction * t. Distances along a ray are in units of t, so they are
+	// world distances only for a normalized direction.
+	struct Ray
+	{
+		Vec3 origin;
+		Vec3 direction;
+
+		inline Vec3 GetPoint(float t) const { return origin + direction * t; }
+		// Per-axis reciprocal for the slab tests, infinite along axes the ray doesn't move on
+		inline Vec3 GetInverseDirection() const { return { 1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z }; }
+	};
+
+	// Slab test against [0, maxDistance]. entryDistance is 0 when the ray starts inside the box.
+	inline bool IntersectRay(const AABB& box, const Ray& ray, const Vec3& inverseDirection, float maxDistance, float& entryDistance)
+	{
+		float tx0 = (box.min.x - ray.origin.x) * inverseDirection.x, tx1 = (box.max.x - ray.origin.x) * inverseDirection.x;
+		float ty0 = (box.min.y - ray.origin.y) * inverseDirection.y, ty1 = (box.max.y - ray.origin.y) * inverseDirection.y;
+		float tz0 = (box.min.z - ray.origin.z) * inverseDirection.z, tz1 = (box.max.z - ray.origin.z) * inverseDirection.z;
+
+		// fmin/fmax drop the NaN of a ray lying exactly on a slab plane
+		float entry = std::fmax(std::fmax(std::fmin(tx0, tx1), std::fmin(ty0, ty1)), std::fmax(std::fmin(tz0, tz1), 0.0f));
+		float exit = std::fmin(std::fmin(std::fmax(tx0, tx1), std::fmax(ty0, ty1)), std::fmin(std::fmax(tz0, tz1), maxDistance));
+		entryDistance = entry;
+		return entry <= exit;
+	}
+
+	// 16 bytes, the batch culling kernels load one sphere per SIMD register
+	struct Sphere
+	{
+		Vec3 center;
+		float radius = 0.0f;
+
+		inline bool Contains(const Vec3& point) const { return LengthSquared(point - center) <= radius * radius; }
+		inline bool Intersects(const Sphere& other) const
+		{
+			float radii = radius + other.radius;
+			return LengthSquared(other.center - center) <= radii * radii;
+		}
+	};
+
+	// Six inward-facing planes (a, b, c, d) with a point p inside when a*p.x + b*p.y + c*p.z + d >= 0
+	struct Frustum
+	{
+		enum Side { Left, Right, Bottom, Top, Near, Far, SideCount };
+
+		Vec4 planes[SideCount];
+
+		// Planes of the OpenGL clip volume of viewProjection, normalized
+		static Frustum FromMatrix(const Mat4& viewProjection);
+
+		bool Intersects(const Sphere& sphere) const;
+		bool Intersects(const AABB& box) const;
+	};
+}
@@ -0,0 +1,271 @@
+#include "jerboa-pch.h"
+#include "MathKernels.h"
+
+#if defined(__x86_64__) || defined(_M_X64)
+	#define JERBOA_MATH_X86
+	#include <emmintrin.h>
+	#ifdef _MSC_VER
+		#include <intrin.h>
+	#endif
+#endif
+
+namespace Jerboa {
+	static_assert(sizeof(Vec3) == 3 * sizeof(float), "The kernels treat Vec3 arrays as packed floats");
+	static_assert(sizeof(Sphere) == 4 * sizeof(float), "The kernels load one sphere per SSE register");
+	static_assert(sizeof(AABB) == 6 * sizeof(float), "The kernels treat AABB arrays as packed floats");
+
+	namespace {
+		void TransformPointsScalar(const Mat4& transform, const Vec3* points, Vec3* out, uint32_t count)
+		{
+			for (uint32_t i = 0; i < count; i++)
+				out[i] = TransformPoint(transform, points[i]);
+		}
+
+		void MultiplyMatricesScalar(const Mat4* a, const Mat4* b, Mat4* out, uint32_t count)
+		{
+			for (uint32_t i = 0; i < count; i++)
+				out[i] = a[i] * b[i];
+		}
+
+		uint32_t CullSpheresScalar(const Frustum& frustum, const Sphere* spheres, uint8_t* visible, uint32_t count)
+		{
+			uint32_t visibleCount = 0;
+			for (uint32_t i = 0; i < count; i++) {
+				visible[i] = frustum.Intersects(spheres[i]) ? 1 : 0;
+				visibleCount += visible[i];
+			}
+			return visibleCount;
+		}
+
+		uint32_t CullAABBsScalar(const Frustum& frustum, const AABB* boxes, uint8_t* visible, uint32_t count)
+		{
+			uint32_t visibleCount = 0;
+			for (uint32_t i = 0; i < count; i++) {
+				visible[i] = frustum.Intersects(boxes[i]) ? 1 : 0;
+				visibleCount += visible[i];
+			}
+			return visibleCount;
+		}
+
+#ifdef JERBOA_MATH_X86
+		// Writes four visibility bytes from the low four bits of a movemask
+		inline uint32_t StoreVisibility(int mask, uint8_t* visible)
+		{
+			for (int lane = 0; lane < 4; lane++)
+				visible[lane] = (uint8_t)((mask >> lane) & 1);
+			return (uint32_t)(visible[0] + visible[1] + visible[2] + visible[3]);
+		}
+
+		void TransformPointsSSE2(const Mat4& transform, const Vec3* points, Vec3* out, uint32_t count)
+		{
+			const float* m = transform.m;
+			const __m128 m0 = _mm_set1_ps(m[0]), m1 = _mm_set1_ps(m[1]), m2 = _mm_set1_ps(m[2]);
+			const __m128 m4 = _mm_set1_ps(m[4]), m5 = _mm_set1_ps(m[5]), m6 = _mm_set1_ps(m[6]);
+			const __m128 m8 = _mm_set1_ps(m[8]), m9 = _mm_set1_ps(m[9]), m10 = _mm_set1_ps(m[10]);
+			const __m128 m12 = _mm_set1_ps(m[12]), m13 = _mm_set1_ps(m[13]), m14 = _mm_set1_ps(m[14]);
+
+			uint32_t i = 0;
+			for (; i + 4 <= count; i += 4) {
+				// Four packed points: x0 y0 z0 x1 | y1 z1 x2 y2 | z2 x3 y3 z3
+				const float* source = &points[i].x;
+				__m128 a = _mm_loadu_ps(source), b = _mm_loadu_ps(source + 4), c = _mm_loadu_ps(source + 8);
+
+				__m128 xs = _mm_shuffle_ps(b, c, _MM_SHUFFLE(1, 1, 2, 2));
+				__m128 x = _mm_shuffle_ps(a, xs, _MM_SHUFFLE(2, 0, 3, 0));
+				__m128 y = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 1, 1)), _mm_shuffle_ps(b, c, _MM_SHUFFLE(2, 2, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0));
+				__m128 z = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 1, 2, 2)), _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 0, 3, 0)), _MM_SHUFFLE(1, 0, 2, 0));
+
+				__m128 rx = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(m0, x), _mm_mul_ps(m4, y)), _mm_mul_ps(m8, z)), m12);
+				__m128 ry = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(m1, x), _mm_mul_ps(m5, y)), _mm_mul_ps(m9, z)), m13);
+				__m128 rz = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(m2, x), _mm_mul_ps(m6, y)), _mm_mul_ps(m10, z)), m14);
+
+				// And back to packed points
+				__m128 xyLow = _mm_unpacklo_ps(rx, ry), xyHigh = _mm_unpackhi_ps(rx, ry);
+				__m128 outA = _mm_shuffle_ps(xyLow, _mm_shuffle_ps(rz, rx, _MM_SHUFFLE(1, 1, 0, 0)), _MM_SHUFFLE(2, 0, 1, 0));
+				__m128 outB = _mm_shuffle_ps(_mm_shuffle_ps(ry, rz, _MM_SHUFFLE(1, 1, 1, 1)), xyHigh, _MM_SHUFFLE(1, 0, 2, 0));
+				__m128 outC = _mm_shuffle_ps(_mm_shuffle_ps(rz, rx, _MM_SHUFFLE(3, 3, 2, 2)), _mm_shuffle_ps(ry, rz, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0));
+
+				float* destination = &out[i].x;
+				_mm_storeu_ps(destination, outA);
+				_mm_storeu_ps(destination + 4, outB);
+				_mm_storeu_ps(destination + 8, outC);
+			}
+			TransformPointsScalar(transform, points + i, out + i, count - i);
+		}
+
+		void MultiplyMatricesSSE2(const Mat4* a, const Mat4* b, Mat4* out, uint32_t count)
+		{
+			for (uint32_t i = 0; i < count; i++) {
+				const float* left = a[i].m;
+				const float* right = b[i].m;
+				__m128 a0 = _mm_load_ps(left), a1 = _mm_load_ps(left + 4), a2 = _mm_load_ps(left + 8), a3 = _mm_load_ps(left + 12);
+				for (int column = 0; column < 4; column++) {
+					__m128 result = _mm_mul_ps(a0, _mm_set1_ps(right[column * 4]));
+					result = _mm_add_ps(result, _mm_mul_ps(a1, _mm_set1_ps(right[column * 4 + 1])));
+					result = _mm_add_ps(result, _mm_mul_ps(a2, _mm_set1_ps(right[column * 4 + 2])));
+					result = _mm_add_ps(result, _mm_mul_ps(a3, _mm_set1_ps(right[column * 4 + 3])));
+					_mm_store_ps(out[i].m + column * 4, result);
+				}
+			}
+		}
+
+		uint32_t CullSpheresSSE2(const Frustum& frustum, const Sphere* spheres, uint8_t* visible, uint32_t count)
+		{
+			const __m128 signMask = _mm_set1_ps(-0.0f);
+			uint32_t visibleCount = 0;
+			uint32_t i = 0;
+			for (; i + 4 <= count; i += 4) {
+				__m128 x = _mm_loadu_ps(&spheres[i].center.x), y = _mm_loadu_ps(&spheres[i + 1].center.x);
+				__m128 z = _mm_loadu_ps(&spheres[i + 2].center.x), radius = _mm_loadu_ps(&spheres[i + 3].center.x);
+				_MM_TRANSPOSE4_PS(x, y, z, radius);
+				__m128 negativeRadius = _mm_xor_ps(radius, signMask);
+
+				__m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+				for (const Vec4& plane : frustum.planes) {
+					__m128 distance = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.x), x), _mm_mul_ps(_mm_set1_ps(plane.y), y));
+					distance = _mm_add_ps(_mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(plane.z), z)), _mm_set1_ps(plane.w));
+					inside = _mm_and_ps(inside, _mm_cmpgt_ps(distance, negativeRadius));
+				}
+				visibleCount += StoreVisibility(_mm_movemask_ps(inside), visible + i);
+			}
+			return visibleCount + CullSpheresScalar(frustum, spheres + i, visible + i, count - i);
+		}
+
+		uint32_t CullAABBsSSE2(const Frustum& frustum, const AABB* boxes, uint8_t* visible, uint32_t count)
+		{
+			const __m128 half = _mm_set1_ps(0.5f);
+			const __m128 signMask = _mm_set1_ps(-0.0f);
+			uint32_t visibleCount = 0;
+			uint32_t i = 0;
+			for (; i + 4 <= count; i += 4) {
+				// Rows of min.x min.y min.z max.x and min.z max.x max.y max.z, both stay inside the box
+				const float* source = &boxes[i].min.x;
+				__m128 minX = _mm_loadu_ps(source), minY = _mm_loadu_ps(source + 6), minZ = _mm_loadu_ps(source + 12), maxX = _mm_loadu_ps(source + 18);
+				__m128 unused0 = _mm_loadu_ps(source + 2), unused1 = _mm_loadu_ps(source + 8), maxY = _mm_loadu_ps(source + 14), maxZ = _mm_loadu_ps(source + 20);
+				_MM_TRANSPOSE4_PS(minX, minY, minZ, maxX);
+				_MM_TRANSPOSE4_PS(unused0, unused1, maxY, maxZ);
+
+				__m128 centerX = _mm_mul_ps(_mm_add_ps(minX, maxX), half), extentX = _mm_mul_ps(_mm_sub_ps(maxX, minX), half);
+				__m128 centerY = _mm_mul_ps(_mm_add_ps(minY, maxY), half), extentY = _mm_mul_ps(_mm_sub_ps(maxY, minY), half);
+				__m128 centerZ = _mm_mul_ps(_mm_add_ps(minZ, maxZ), half), extentZ = _mm_mul_ps(_mm_sub_ps(maxZ, minZ), half);
+
+				__m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+				for (const Vec4& plane : frustum.planes) {
+					__m128 distance = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.x), centerX), _mm_mul_ps(_mm_set1_ps(plane.y), centerY));
+					distance = _mm_add_ps(_mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(plane.z), centerZ)), _mm_set1_ps(plane.w));
+					__m128 radius = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(std::fabs(plane.x)), extentX), _mm_mul_ps(_mm_set1_ps(std::fabs(plane.y)), extentY));
+					radius = _mm_add_ps(radius, _mm_mul_ps(_mm_set1_ps(std::fabs(plane.z)), extentZ));
+					inside = _mm_and_ps(inside, _mm_cmpgt_ps(distance, _mm_xor_ps(radius, signMask)));
+				}
+				visibleCount += StoreVisibility(_mm_movemask_ps(inside), visible + i);
+			}
+			return visibleCount + CullAABBsScalar(frustum, boxes + i, visible + i, count - i);
+		}
+
+		bool CpuSupportsAVX2()
+		{
+#if defined(_MSC_VER)
+			int info[4];
+			__cpuid(info, 0);
+			if (info[0] < 7)
+				return false;
+
+			__cpuid(info, 1);
+			bool fma = (info[2] & (1 << 12)) != 0;
+			bool osSavesYmm = (info[2] & (1 << 27)) != 0 && (_xgetbv(0) & 0x6) == 0x6;
+
+			__cpuidex(info, 7, 0);
+			bool avx2 = (info[1] & (1 << 5)) != 0;
+			return fma && osSavesYmm && avx2;
+#else
+			// Also checks that the OS saves the YMM registers
+			__builtin_cpu_init();
+			return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#endif
+		}
+#endif
+	}
+
+	SimdLevel MathKernels::sLevel = MathKernels::GetSupportedLevel();
+	const MathKernels::KernelTable* MathKernels::sKernels = &MathKernels::GetKernels(MathKernels::sLevel);
+
+	SimdLevel MathKernels::GetSupportedLevel()
+	{
+#ifdef JERBOA_MATH_X86
+		static const SimdLevel level = CpuSupportsAVX2() ? SimdLevel::AVX2 : SimdLevel::SSE2;
+		return level;
+#else
+		return SimdLevel::Scalar;
+#endif
+	}
+
+	SimdLevel MathKernels::GetLevel()
+	{
+		return sLevel;
+	}
+
+	void MathKernels::SetLevel(SimdLevel level)
+	{
+		if (level > GetSupportedLevel()) {
+			JERBOA_LOG_WARN("{} math kernels are not supported by this CPU, using {}", GetLevelName(level), GetLevelName(GetSupportedLevel()));
+			level = GetSupportedLevel();
+		}
+		sLevel = level;
+		sKernels = &GetKernels(level);
+	}
+
+	const char* MathKernels::GetLevelName(SimdLevel level)
+	{
+		switch (level) {
+			case SimdLevel::Scalar: return "Scalar";
+			case SimdLevel::SSE2: return "SSE2";
+			case SimdLevel::AVX2: return "AVX2";
+		}
+		return "Unknown";
+	}
+
+	void MathKernels::TransformPoints(const Mat4& transform, const Vec3* points, Vec3* out, uint32_t count)
+	{
+		sKernels->transformPoints(transform, points, out, count);
+	}
+
+	void MathKernels::MultiplyMatrices(const Mat4* a, const Mat4* b, Mat4* out, uint32_t count)
+	{
+		sKernels->multiplyMatrices(a, b, out, count);
+	}
+
+	uint32_t MathKernels::CullSpheres(const Frustum& frustum, const Sphere* spheres, uint8_t* visible, uint32_t count)
+	{
+		return sKernels->cullSpheres(frustum, spheres, visible, count);
+	}
+
+	uint32_t MathKernels::CullAABBs(const Frustum& frustum, const AABB* boxes, uint8_t* visible, uint32_t count)
+	{
+		return sKernels->cullAABBs(frustum, boxes, visible, count);
+	}
+
+	const MathKernels::KernelTable& MathKernels::GetKernels(SimdLevel level)
+	{
+		switch (level) {
+			case SimdLevel::AVX2: return GetAVX2Kernels();
+			case SimdLevel::SSE2: return GetSSE2Kernels();
+			default: return GetScalarKernels();
+		}
+	}
+
+	const MathKernels::KernelTable& MathKernels::GetScalarKernels()
+	{
+		static const KernelTable kernels = { TransformPointsScalar, MultiplyMatricesScalar, CullSpheresScalar, CullAABBsScalar };
+		return kernels;
+	}
+
+	const MathKernels::KernelTable& MathKernels::GetSSE2Kernels()
+	{
+#ifdef JERBOA_MATH_X86
+		static const KernelTable kernels = { TransformPointsSSE2, MultiplyMatricesSSE2, CullSpheresSSE2, CullAABBsSSE2 };
+		return kernels;
+#else
+		return GetScalarKernels();
+#endif
+	}
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "Vector.h"
+#include "Matrix.h"
+#include "Bounds.h"
+
+#include <cstdint>
+
+namespace Jerboa {
+	enum class SimdLevel
+	{
+		Scalar,
+		SSE2,
+		AVX2
+	};
+
+	// Batch kernels over arrays. The implementation is picked once at startup from what the
+	// CPU supports; the scalar implementation is the reference the SIMD ones are checked
+	// against and can be forced with SetSimdLevel.
+	class MathKernels
+	{
+	public:
+		static SimdLevel GetSupportedLevel();
+		static SimdLevel GetLevel();
+		// Clamped to the supported level. Not synchronized with kernels running on other threads.
+		static void SetLevel(SimdLevel level);
+		static const char* GetLevelName(SimdLevel level);
+
+		// out[i] = transform * (points[i], 1) without the perspective divide. out may alias points.
+		static void TransformPoints(const Mat4& transform, const Vec3* points, Vec3* out, uint32_t count);
+		// out[i] = a[i] * b[i]. out may alias a or b.
+		static void MultiplyMatrices(const Mat4* a, const Mat4* b, Mat4* out, uint32_t count);
+		// visible[i] = 1 when the bounds intersect the frustum, 0 otherwise. Returns the visible count.
+		static uint32_t CullSpheres(const Frustum& frustum, const Sphere* spheres, uint8_t* visible, uint32_t count);
+		static uint32_t CullAABBs(const Frustum& frustum, const AABB* boxes, uint8_t* visible, uint32_t count);
+	private:
+		struct KernelTable
+		{
+			void (*transformPoints)(const Mat4&, const Vec3*, Vec3*, uint32_t);
+			void (*multiplyMatrices)(const Mat4*, const Mat4*, Mat4*, uint32_t);
+			uint32_t (*cullSpheres)(const Frustum&, const Sphere*, uint8_t*, uint32_t);
+			uint32_t (*cullAABBs)(const Frustum&, const AABB*, uint8_t*, uint32_t);
+		};
+
+		static const KernelTable& GetKernels(SimdLevel level);
+		static const KernelTable& GetScalarKernels();
+		static const KernelTable& GetSSE2Kernels();
+		static const KernelTable& GetAVX2Kernels();
+
+		static const KernelTable* sKernels;
+		static SimdLevel sLevel;
+	};
+}
@@ -0,0 +1,184 @@
+#include "jerboa-pch.h"
+#include "MathKernels.h"
+
+// Only reached through MathKernels' dispatch once the CPU reported AVX2 and FMA support, so
+// the functions are compiled for AVX2 individually instead of building the engine with -mavx2
+#if defined(__x86_64__) || defined(_M_X64)
+	#define JERBOA_MATH_AVX2
+	#include <immintrin.h>
+	#if defined(__GNUC__) || defined(__clang__)
+		#define JERBOA_TARGET_AVX2 __attribute__((target("avx2,fma")))
+	#else
+		#define JERBOA_TARGET_AVX2
+	#endif
+#endif
+
+namespace Jerboa {
+#ifdef JERBOA_MATH_AVX2
+	namespace {
+		// The kernels keep the SSE2 data layout with a second group of four elements in the
+		// upper 128-bit lane, so every shuffle stays within its lane
+		JERBOA_TARGET_AVX2 inline __m256 LoadLanes(const float* low, const float* high)
+		{
+			return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(low)), _mm_loadu_ps(high), 1);
+		}
+
+		JERBOA_TARGET_AVX2 inline void StoreLanes(float* low, float* high, __m256 value)
+		{
+			_mm_storeu_ps(low, _mm256_castps256_ps128(value));
+			_mm_storeu_ps(high, _mm256_extractf128_ps(value, 1));
+		}
+
+		JERBOA_TARGET_AVX2 inline void TransposeLanes(__m256& row0, __m256& row1, __m256& row2, __m256& row3)
+		{
+			__m256 t0 = _mm256_unpacklo_ps(row0, row1), t1 = _mm256_unpacklo_ps(row2, row3);
+			__m256 t2 = _mm256_unpackhi_ps(row0, row1), t3 = _mm256_unpackhi_ps(row2, row3);
+			row0 = _mm256_shuffle_ps(t0, t1, _MM_SHUFFLE(1, 0, 1, 0));
+			row1 = _mm256_shuffle_ps(t0, t1, _MM_SHUFFLE(3, 2, 3, 2));
+			row2 = _mm256_shuffle_ps(t2, t3, _MM_SHUFFLE(1, 0, 1, 0));
+			row3 = _mm256_shuffle_ps(t2, t3, _MM_SHUFFLE(3, 2, 3, 2));
+		}
+
+		inline uint32_t StoreVisibility(int mask, uint8_t* visible)
+		{
+			uint32_t visibleCount = 0;
+			for (int lane = 0; lane < 8; lane++) {
+				visible[lane] = (uint8_t)((mask >> lane) & 1);
+				visibleCount += visible[lane];
+			}
+			return visibleCount;
+		}
+
+		JERBOA_TARGET_AVX2 void TransformPointsAVX2(const Mat4& transform, const Vec3* points, Vec3* out, uint32_t count)
+		{
+			const float* m = transform.m;
+			const __m256 m0 = _mm256_set1_ps(m[0]), m1 = _mm256_set1_ps(m[1]), m2 = _mm256_set1_ps(m[2]);
+			const __m256 m4 = _mm256_set1_ps(m[4]), m5 = _mm256_set1_ps(m[5]), m6 = _mm256_set1_ps(m[6]);
+			const __m256 m8 = _mm256_set1_ps(m[8]), m9 = _mm256_set1_ps(m[9]), m10 = _mm256_set1_ps(m[10]);
+			const __m256 m12 = _mm256_set1_ps(m[12]), m13 = _mm256_set1_ps(m[13]), m14 = _mm256_set1_ps(m[14]);
+
+			uint32_t i = 0;
+			for (; i + 8 <= count; i += 8) {
+				const float* source = &points[i].x;
+				__m256 a = LoadLanes(source, source + 12), b = LoadLanes(source + 4, source + 16), c = LoadLanes(source + 8, source + 20);
+
+				__m256 x = _mm256_shuffle_ps(a, _mm256_shuffle_ps(b, c, _MM_SHUFFLE(1, 1, 2, 2)), _MM_SHUFFLE(2, 0, 3, 0));
+				__m256 y = _mm256_shuffle_ps(_mm256_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 1, 1)), _mm256_shuffle_ps(b, c, _MM_SHUFFLE(2, 2, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0));
+				__m256 z = _mm256_shuffle_ps(_mm256_shuffle_ps(a, b, _MM_SHUFFLE(1, 1, 2, 2)), _mm256_shuffle_ps(c, c, _MM_SHUFFLE(3, 0, 3, 0)), _MM_SHUFFLE(1, 0, 2, 0));
+
+				__m256 rx = _mm256_fmadd_ps(m8, z, _mm256_fmadd_ps(m4, y, _mm256_fmadd_ps(m0, x, m12)));
+				__m256 ry = _mm256_fmadd_ps(m9, z, _mm256_fmadd_ps(m5, y, _mm256_fmadd_ps(m1, x, m13)));
+				__m256 rz = _mm256_fmadd_ps(m10, z, _mm256_fmadd_ps(m6, y, _mm256_fmadd_ps(m2, x, m14)));
+
+				__m256 xyLow = _mm256_unpacklo_ps(rx, ry), xyHigh = _mm256_unpackhi_ps(rx, ry);
+				__m256 outA = _mm256_shuffle_ps(xyLow, _mm256_shuffle_ps(rz, rx, _MM_SHUFFLE(1, 1, 0, 0)), _MM_SHUFFLE(2, 0, 1, 0));
+				__m256 outB = _mm256_shuffle_ps(_mm256_shuffle_ps(ry, rz, _MM_SHUFFLE(1, 1, 1, 1)), xyHigh, _MM_SHUFFLE(1, 0, 2, 0));
+				__m256 outC = _mm256_shuffle_ps(_mm256_shuffle_ps(rz, rx, _MM_SHUFFLE(3, 3, 2, 2)), _mm256_shuffle_ps(ry, rz, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0));
+
+				float* destination = &out[i].x;
+				StoreLanes(destination, destination + 12, outA);
+				StoreLanes(destination + 4, destination + 16, outB);
+				StoreLanes(destination + 8, destination + 20, outC);
+			}
+			for (; i < count; i++)
+				out[i] = TransformPoint(transform, points[i]);
+		}
+
+		JERBOA_TARGET_AVX2 void MultiplyMatricesAVX2(const Mat4* a, const Mat4* b, Mat4* out, uint32_t count)
+		{
+			for (uint32_t i = 0; i < count; i++) {
+				const float* left = a[i].m;
+				const float* right = b[i].m;
+				// Each column of a in both lanes, two columns of b at a time
+				__m256 a0 = _mm256_broadcast_ps((const __m128*)left), a1 = _mm256_broadcast_ps((const __m128*)(left + 4));
+				__m256 a2 = _mm256_broadcast_ps((const __m128*)(left + 8)), a3 = _mm256_broadcast_ps((const __m128*)(left + 12));
+				for (int columns = 0; columns < 2; columns++) {
+					__m256 b01 = _mm256_loadu_ps(right + columns * 8);
+					__m256 result = _mm256_mul_ps(a0, _mm256_permute_ps(b01, 0x00));
+					result = _mm256_fmadd_ps(a1, _mm256_permute_ps(b01, 0x55), result);
+					result = _mm256_fmadd_ps(a2, _mm256_permute_ps(b01, 0xaa), result);
+					result = _mm256_fmadd_ps(a3, _mm256_permute_ps(b01, 0xff), result);
+					_mm256_storeu_ps(out[i].m + columns * 8, result);
+				}
+			}
+		}
+
+		JERBOA_TARGET_AVX2 uint32_t CullSpheresAVX2(const Frustum& frustum, const Sphere* spheres, uint8_t* visible, uint32_t count)
+		{
+			const __m256 signMask = _mm256_set1_ps(-0.0f);
+			uint32_t visibleCount = 0;
+			uint32_t i = 0;
+			for (; i + 8 <= count; i += 8) {
+				__m256 x = LoadLanes(&spheres[i].center.x, &spheres[i + 4].center.x);
+				__m256 y = LoadLanes(&spheres[i + 1].center.x, &spheres[i + 5].center.x);
+				__m256 z = LoadLanes(&spheres[i + 2].center.x, &spheres[i + 6].center.x);
+				__m256 radius = LoadLanes(&spheres[i + 3].center.x, &spheres[i + 7].center.x);
+				TransposeLanes(x, y, z, radius);
+				__m256 negativeRadius = _mm256_xor_ps(radius, signMask);
+
+				__m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+				for (const Vec4& plane : frustum.planes) {
+					__m256 distance = _mm256_fmadd_ps(_mm256_set1_ps(plane.x), x, _mm256_set1_ps(plane.w));
+					distance = _mm256_fmadd_ps(_mm256_set1_ps(plane.y), y, distance);
+					distance = _mm256_fmadd_ps(_mm256_set1_ps(plane.z), z, distance);
+					inside = _mm256_and_ps(inside, _mm256_cmp_ps(distance, negativeRadius, _CMP_GT_OQ));
+				}
+				visibleCount += StoreVisibility(_mm256_movemask_ps(inside), visible + i);
+			}
+			for (; i < count; i++) {
+				visible[i] = frustum.Intersects(spheres[i]) ? 1 : 0;
+				visibleCount += visible[i];
+			}
+			return visibleCount;
+		}
+
+		JERBOA_TARGET_AVX2 uint32_t CullAABBsAVX2(const Frustum& frustum, const AABB* boxes, uint8_t* visible, uint32_t count)
+		{
+			const __m256 half = _mm256_set1_ps(0.5f);
+			const __m256 signMask = _mm256_set1_ps(-0.0f);
+			uint32_t visibleCount = 0;
+			uint32_t i = 0;
+			for (; i + 8 <= count; i += 8) {
+				const float* source = &boxes[i].min.x;
+				__m256 minX = LoadLanes(source, source + 24), minY = LoadLanes(source + 6, source + 30);
+				__m256 minZ = LoadLanes(source + 12, source + 36), maxX = LoadLanes(source + 18, source + 42);
+				__m256 unused0 = LoadLanes(source + 2, source + 26), unused1 = LoadLanes(source + 8, source + 32);
+				__m256 maxY = LoadLanes(source + 14, source + 38), maxZ = LoadLanes(source + 20, source + 44);
+				TransposeLanes(minX, minY, minZ, maxX);
+				TransposeLanes(unused0, unused1, maxY, maxZ);
+
+				__m256 centerX = _mm256_mul_ps(_mm256_add_ps(minX, maxX), half), extentX = _mm256_mul_ps(_mm256_sub_ps(maxX, minX), half);
+				__m256 centerY = _mm256_mul_ps(_mm256_add_ps(minY, maxY), half), extentY = _mm256_mul_ps(_mm256_sub_ps(maxY, minY), half);
+				__m256 centerZ = _mm256_mul_ps(_mm256_add_ps(minZ, maxZ), half), extentZ = _mm256_mul_ps(_mm256_sub_ps(maxZ, minZ), half);
+
+				__m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+				for (const Vec4& plane : frustum.planes) {
+					__m256 distance = _mm256_fmadd_ps(_mm256_set1_ps(plane.x), centerX, _mm256_set1_ps(plane.w));
+					distance = _mm256_fmadd_ps(_mm256_set1_ps(plane.y), centerY, distance);
+					distance = _mm256_fmadd_ps(_mm256_set1_ps(plane.z), centerZ, distance);
+					__m256 radius = _mm256_mul_ps(_mm256_set1_ps(std::fabs(plane.x)), extentX);
+					radius = _mm256_fmadd_ps(_mm256_set1_ps(std::fabs(plane.y)), extentY, radius);
+					radius = _mm256_fmadd_ps(_mm256_set1_ps(std::fabs(plane.z)), extentZ, radius);
+					inside = _mm256_and_ps(inside, _mm256_cmp_ps(distance, _mm256_xor_ps(radius, signMask), _CMP_GT_OQ));
+				}
+				visibleCount += StoreVisibility(_mm256_movemask_ps(inside), visible + i);
+			}
+			for (; i < count; i++) {
+				visible[i] = frustum.Intersects(boxes[i]) ? 1 : 0;
+				visibleCount += visible[i];
+			}
+			return visibleCount;
+		}
+	}
+#endif
+
+	const MathKernels::KernelTable& MathKernels::GetAVX2Kernels()
+	{
+#ifdef JERBOA_MATH_AVX2
+		static const KernelTable kernels = { TransformPointsAVX2, MultiplyMatricesAVX2, CullSpheresAVX2, CullAABBsAVX2 };
+		return kernels;
+#else
+		return GetSSE2Kernels();
+#endif
+	}
+}
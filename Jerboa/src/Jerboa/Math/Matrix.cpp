@@ -0,0 +1,215 @@
+#include "jerboa-pch.h"
+#include "Matrix.h"
+
+#include <cmath>
+
+namespace Jerboa {
+	Mat4 Mat4::Translation(const Vec3& translation)
+	{
+		Mat4 result = Identity();
+		result.m[12] = translation.x;
+		result.m[13] = translation.y;
+		result.m[14] = translation.z;
+		return result;
+	}
+
+	Mat4 Mat4::Scale(const Vec3& scale)
+	{
+		Mat4 result = Identity();
+		result.m[0] = scale.x;
+		result.m[5] = scale.y;
+		result.m[10] = scale.z;
+		return result;
+	}
+
+	Mat4 Mat4::Orthographic(float left, float right, float bottom, float top, float nearPlane, float farPlane)
+	{
+		Mat4 result = Identity();
+		result.m[0] = 2.0f / (right - left);
+		result.m[5] = 2.0f / (top - bottom);
+		result.m[10] = -2.0f / (farPlane - nearPlane);
+		result.m[12] = -(right + left) / (right - left);
+		result.m[13] = -(top + bottom) / (top - bottom);
+		result.m[14] = -(farPlane + nearPlane) / (farPlane - nearPlane);
+		return result;
+	}
+
+	Mat4 Mat4::Perspective(float fovY, float aspect, float nearPlane, float farPlane)
+	{
+		JERBOA_ASSERT(aspect != 0.0f && farPlane != nearPlane, "Degenerate perspective projection");
+
+		float focal = 1.0f / std::tan(fovY * 0.5f);
+		Mat4 result = {};
+		result.m[0] = focal / aspect;
+		result.m[5] = focal;
+		result.m[10] = (farPlane + nearPlane) / (nearPlane - farPlane);
+		result.m[11] = -1.0f;
+		result.m[14] = 2.0f * farPlane * nearPlane / (nearPlane - farPlane);
+		return result;
+	}
+
+	Mat4 Mat4::LookAt(const Vec3& eye, const Vec3& target, const Vec3& up)
+	{
+		Vec3 forward = Normalize(target - eye);
+		Vec3 right = Normalize(Cross(forward, up));
+		Vec3 cameraUp = Cross(right, forward);
+
+		Mat4 result = Identity();
+		result.m[0] = right.x; result.m[4] = right.y; result.m[8] = right.z;
+		result.m[1] = cameraUp.x; result.m[5] = cameraUp.y; result.m[9] = cameraUp.z;
+		result.m[2] = -forward.x; result.m[6] = -forward.y; result.m[10] = -forward.z;
+		result.m[12] = -Dot(right, eye);
+		result.m[13] = -Dot(cameraUp, eye);
+		result.m[14] = Dot(forward, eye);
+		return result;
+	}
+
+	Mat3 operator*(const Mat3& a, const Mat3& b)
+	{
+		Mat3 result;
+		for (int column = 0; column < 3; column++)
+			for (int row = 0; row < 3; row++)
+				result.m[column * 3 + row] = a.m[row] * b.m[column * 3] + a.m[3 + row] * b.m[column * 3 + 1] + a.m[6 + row] * b.m[column * 3 + 2];
+		return result;
+	}
+
+	Mat4 operator*(const Mat4& a, const Mat4& b)
+	{
+		Mat4 result;
+		for (int column = 0; column < 4; column++)
+			for (int row = 0; row < 4; row++)
+				result.m[column * 4 + row] = a.m[row] * b.m[column * 4] + a.m[4 + row] * b.m[column * 4 + 1]
+					+ a.m[8 + row] * b.m[column * 4 + 2] + a.m[12 + row] * b.m[column * 4 + 3];
+		return result;
+	}
+
+	Mat3 Transpose(const Mat3& a)
+	{
+		Mat3 result;
+		for (int column = 0; column < 3; column++)
+			for (int row = 0; row < 3; row++)
+				result.m[column * 3 + row] = a.m[row * 3 + column];
+		return result;
+	}
+
+	Mat4 Transpose(const Mat4& a)
+	{
+		Mat4 result;
+		for (int column = 0; column < 4; column++)
+			for (int row = 0; row < 4; row++)
+				result.m[column * 4 + row] = a.m[row * 4 + column];
+		return result;
+	}
+
+	float Determinant(const Mat3& a)
+	{
+		return a(0, 0) * (a(1, 1) * a(2, 2) - a(1, 2) * a(2, 1))
+			- a(0, 1) * (a(1, 0) * a(2, 2) - a(1, 2) * a(2, 0))
+			+ a(0, 2) * (a(1, 0) * a(2, 1) - a(1, 1) * a(2, 0));
+	}
+
+	Mat3 Inverse(const Mat3& a)
+	{
+		float determinant = Determinant(a);
+		JERBOA_ASSERT(determinant != 0.0f, "Inverting a singular matrix");
+		if (determinant == 0.0f)
+			return Mat3::Identity();
+
+		float inverseDeterminant = 1.0f / determinant;
+		Mat3 result;
+		result(0, 0) = (a(1, 1) * a(2, 2) - a(1, 2) * a(2, 1)) * inverseDeterminant;
+		result(0, 1) = (a(0, 2) * a(2, 1) - a(0, 1) * a(2, 2)) * inverseDeterminant;
+		result(0, 2) = (a(0, 1) * a(1, 2) - a(0, 2) * a(1, 1)) * inverseDeterminant;
+		result(1, 0) = (a(1, 2) * a(2, 0) - a(1, 0) * a(2, 2)) * inverseDeterminant;
+		result(1, 1) = (a(0, 0) * a(2, 2) - a(0, 2) * a(2, 0)) * inverseDeterminant;
+		result(1, 2) = (a(0, 2) * a(1, 0) - a(0, 0) * a(1, 2)) * inverseDeterminant;
+		result(2, 0) = (a(1, 0) * a(2, 1) - a(1, 1) * a(2, 0)) * inverseDeterminant;
+		result(2, 1) = (a(0, 1) * a(2, 0) - a(0, 0) * a(2, 1)) * inverseDeterminant;
+		result(2, 2) = (a(0, 0) * a(1, 1) - a(0, 1) * a(1, 0)) * inverseDeterminant;
+		return result;
+	}
+
+	namespace {
+		// Cofactor expansion along 2x2 sub-determinants of the lower and upper row pairs
+		struct Mat4Cofactors
+		{
+			float s[6], c[6];
+
+			Mat4Cofactors(const Mat4& a)
+			{
+				s[0] = a(0, 0) * a(1, 1) - a(1, 0) * a(0, 1);
+				s[1] = a(0, 0) * a(1, 2) - a(1, 0) * a(0, 2);
+				s[2] = a(0, 0) * a(1, 3) - a(1, 0) * a(0, 3);
+				s[3] = a(0, 1) * a(1, 2) - a(1, 1) * a(0, 2);
+				s[4] = a(0, 1) * a(1, 3) - a(1, 1) * a(0, 3);
+				s[5] = a(0, 2) * a(1, 3) - a(1, 2) * a(0, 3);
+
+				c[5] = a(2, 2) * a(3, 3) - a(3, 2) * a(2, 3);
+				c[4] = a(2, 1) * a(3, 3) - a(3, 1) * a(2, 3);
+				c[3] = a(2, 1) * a(3, 2) - a(3, 1) * a(2, 2);
+				c[2] = a(2, 0) * a(3, 3) - a(3, 0) * a(2, 3);
+				c[1] = a(2, 0) * a(3, 2) - a(3, 0) * a(2, 2);
+				c[0] = a(2, 0) * a(3, 1) - a(3, 0) * a(2, 1);
+			}
+
+			float Determinant() const
+			{
+				return s[0] * c[5] - s[1] * c[4] + s[2] * c[3] + s[3] * c[2] - s[4] * c[1] + s[5] * c[0];
+			}
+		};
+	}
+
+	float Determinant(const Mat4& a)
+	{
+		return Mat4Cofactors(a).Determinant();
+	}
+
+	Mat4 Inverse(const Mat4& a)
+	{
+		Mat4Cofactors cofactors(a);
+		const float* s = cofactors.s;
+		const float* c = cofactors.c;
+
+		float determinant = cofactors.Determinant();
+		JERBOA_ASSERT(determinant != 0.0f, "Inverting a singular matrix");
+		if (determinant == 0.0f)
+			return Mat4::Identity();
+
+		float inverseDeterminant = 1.0f / determinant;
+		Mat4 result;
+		result(0, 0) = (a(1, 1) * c[5] - a(1, 2) * c[4] + a(1, 3) * c[3]) * inverseDeterminant;
+		result(0, 1) = (-a(0, 1) * c[5] + a(0, 2) * c[4] - a(0, 3) * c[3]) * inverseDeterminant;
+		result(0, 2) = (a(3, 1) * s[5] - a(3, 2) * s[4] + a(3, 3) * s[3]) * inverseDeterminant;
+		result(0, 3) = (-a(2, 1) * s[5] + a(2, 2) * s[4] - a(2, 3) * s[3]) * inverseDeterminant;
+
+		result(1, 0) = (-a(1, 0) * c[5] + a(1, 2) * c[2] - a(1, 3) * c[1]) * inverseDeterminant;
+		result(1, 1) = (a(0, 0) * c[5] - a(0, 2) * c[2] + a(0, 3) * c[1]) * inverseDeterminant;
+		result(1, 2) = (-a(3, 0) * s[5] + a(3, 2) * s[2] - a(3, 3) * s[1]) * inverseDeterminant;
+		result(1, 3) = (a(2, 0) * s[5] - a(2, 2) * s[2] + a(2, 3) * s[1]) * inverseDeterminant;
+
+		result(2, 0) = (a(1, 0) * c[4] - a(1, 1) * c[2] + a(1, 3) * c[0]) * inverseDeterminant;
+		result(2, 1) = (-a(0, 0) * c[4] + a(0, 1) * c[2] - a(0, 3) * c[0]) * inverseDeterminant;
+		result(2, 2) = (a(3, 0) * s[4] - a(3, 1) * s[2] + a(3, 3) * s[0]) * inverseDeterminant;
+		result(2, 3) = (-a(2, 0) * s[4] + a(2, 1) * s[2] - a(2, 3) * s[0]) * inverseDeterminant;
+
+		result(3, 0) = (-a(1, 0) * c[3] + a(1, 1) * c[1] - a(1, 2) * c[0]) * inverseDeterminant;
+		result(3, 1) = (a(0, 0) * c[3] - a(0, 1) * c[1] + a(0, 2) * c[0]) * inverseDeterminant;
+		result(3, 2) = (-a(3, 0) * s[3] + a(3, 1) * s[1] - a(3, 2) * s[0]) * inverseDeterminant;
+		result(3, 3) = (a(2, 0) * s[3] - a(2, 1) * s[1] + a(2, 2) * s[0]) * inverseDeterminant;
+		return result;
+	}
+
+	Mat3 ToMat3(const Mat4& a)
+	{
+		return { {
+			a.m[0], a.m[1], a.m[2],
+			a.m[4], a.m[5], a.m[6],
+			a.m[8], a.m[9], a.m[10]
+		} };
+	}
+
+	Mat3 NormalMatrix(const Mat4& a)
+	{
+		return Transpose(Inverse(ToMat3(a)));
+	}
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include "Vector.h"
+
+namespace Jerboa {
+	// Column-major 3x3 matrix, m[column * 3 + row]
+	struct Mat3
+	{
+		float m[9];
+
+		static constexpr Mat3 Identity() { return { { 1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f } }; }
+
+		inline float& operator()(int row, int column) { return m[column * 3 + row]; }
+		inline float operator()(int row, int column) const { return m[column * 3 + row]; }
+	};
+
+	// Column-major 4x4 matrix, m[column * 4 + row], the layout OpenGL and the shaders take.
+	// Left uninitialized so large arrays of matrices cost nothing to allocate.
+	struct alignas(16) Mat4
+	{
+		float m[16];
+
+		static constexpr Mat4 Identity()
+		{
+			return { {
+				1.0f, 0.0f, 0.0f, 0.0f,
+				0.0f, 1.0f, 0.0f, 0.0f,
+				0.0f, 0.0f, 1.0f, 0.0f,
+				0.0f, 0.0f, 0.0f, 1.0f
+			} };
+		}
+
+		static Mat4 Translation(const Vec3& translation);
+		static Mat4 Scale(const Vec3& scale);
+		// Maps [left, right] x [bottom, top] x [-nearPlane, -farPlane] to the OpenGL clip cube
+		static Mat4 Orthographic(float left, float right, float bottom, float top, float nearPlane, float farPlane);
+		// fovY in radians, right-handed, OpenGL clip space
+		static Mat4 Perspective(float fovY, float aspect, float nearPlane, float farPlane);
+		static Mat4 LookAt(const Vec3& eye, const Vec3& target, const Vec3& up);
+
+		inline float& operator()(int row, int column) { return m[column * 4 + row]; }
+		inline float operator()(int row, int column) const { return m[column * 4 + row]; }
+
+		inline Vec4 GetColumn(int column) const { return { m[column * 4], m[column * 4 + 1], m[column * 4 + 2], m[column * 4 + 3] }; }
+		inline Vec4 GetRow(int row) const { return { m[row], m[4 + row], m[8 + row], m[12 + row] }; }
+	};
+
+	Mat3 operator*(const Mat3& a, const Mat3& b);
+	inline Vec3 operator*(const Mat3& a, const Vec3& v)
+	{
+		return {
+			a.m[0] * v.x + a.m[3] * v.y + a.m[6] * v.z,
+			a.m[1] * v.x + a.m[4] * v.y + a.m[7] * v.z,
+			a.m[2] * v.x + a.m[5] * v.y + a.m[8] * v.z
+		};
+	}
+
+	Mat4 operator*(const Mat4& a, const Mat4& b);
+	inline Vec4 operator*(const Mat4& a, const Vec4& v)
+	{
+		return {
+			a.m[0] * v.x + a.m[4] * v.y + a.m[8] * v.z + a.m[12] * v.w,
+			a.m[1] * v.x + a.m[5] * v.y + a.m[9] * v.z + a.m[13] * v.w,
+			a.m[2] * v.x + a.m[6] * v.y + a.m[10] * v.z + a.m[14] * v.w,
+			a.m[3] * v.x + a.m[7] * v.y + a.m[11] * v.z + a.m[15] * v.w
+		};
+	}
+
+	// w = 1 without the perspective divide, for affine matrices
+	inline Vec3 TransformPoint(const Mat4& a, const Vec3& p)
+	{
+		return {
+			a.m[0] * p.x + a.m[4] * p.y + a.m[8] * p.z + a.m[12],
+			a.m[1] * p.x + a.m[5] * p.y + a.m[9] * p.z + a.m[13],
+			a.m[2] * p.x + a.m[6] * p.y + a.m[10] * p.z + a.m[14]
+		};
+	}
+
+	// w = 0, ignores the translation
+	inline Vec3 TransformDirection(const Mat4& a, const Vec3& d)
+	{
+		return {
+			a.m[0] * d.x + a.m[4] * d.y + a.m[8] * d.z,
+			a.m[1] * d.x + a.m[5] * d.y + a.m[9] * d.z,
+			a.m[2] * d.x + a.m[6] * d.y + a.m[10] * d.z
+		};
+	}
+
+	Mat3 Transpose(const Mat3& a);
+	Mat4 Transpose(const Mat4& a);
+	float Determinant(const Mat3& a);
+	float Determinant(const Mat4& a);
+	// Singular matrices assert and return the identity
+	Mat3 Inverse(const Mat3& a);
+	Mat4 Inverse(const Mat4& a);
+
+	// Upper-left 3x3 block
+	Mat3 ToMat3(const Mat4& a);
+	// Inverse transpose of the upper-left 3x3 block, transforms normals
+	Mat3 NormalMatrix(const Mat4& a);
+}
@@ -0,0 +1,93 @@
+#include "jerboa-pch.h"
+#include "Quaternion.h"
+
+#include <cmath>
+
+namespace Jerboa {
+	Quat Quat::FromAxisAngle(const Vec3& axis, float angle)
+	{
+		float s = std::sin(angle * 0.5f);
+		return { axis.x * s, axis.y * s, axis.z * s, std::cos(angle * 0.5f) };
+	}
+
+	Quat Quat::FromEuler(const Vec3& angles)
+	{
+		return FromAxisAngle({ 1.0f, 0.0f, 0.0f }, angles.x)
+			* FromAxisAngle({ 0.0f, 1.0f, 0.0f }, angles.y)
+			* FromAxisAngle({ 0.0f, 0.0f, 1.0f }, angles.z);
+	}
+
+	Quat Normalize(const Quat& q)
+	{
+		float length = std::sqrt(Dot(q, q));
+		if (length == 0.0f)
+			return Quat::Identity();
+
+		float inverseLength = 1.0f / length;
+		return { q.x * inverseLength, q.y * inverseLength, q.z * inverseLength, q.w * inverseLength };
+	}
+
+	Vec3 Rotate(const Quat& q, const Vec3& v)
+	{
+		// v + 2w(u x v) + 2u x (u x v) with u the vector part
+		Vec3 u = { q.x, q.y, q.z };
+		Vec3 t = Cross(u, v) * 2.0f;
+		return v + t * q.w + Cross(u, t);
+	}
+
+	Quat Slerp(const Quat& a, const Quat& b, float t)
+	{
+		Quat end = b;
+		float cosine = Dot(a, b);
+		if (cosine < 0.0f) {
+			end = { -b.x, -b.y, -b.z, -b.w };
+			cosine = -cosine;
+		}
+
+		float weightA, weightB;
+		// Nearly parallel, the sine below would lose all precision
+		if (cosine > 0.9995f) {
+			weightA = 1.0f - t;
+			weightB = t;
+		}
+		else {
+			float angle = std::acos(cosine);
+			float inverseSine = 1.0f / std::sin(angle);
+			weightA = std::sin((1.0f - t) * angle) * inverseSine;
+			weightB = std::sin(t * angle) * inverseSine;
+		}
+
+		return Normalize(Quat{
+			a.x * weightA + end.x * weightB,
+			a.y * weightA + end.y * weightB,
+			a.z * weightA + end.z * weightB,
+			a.w * weightA + end.w * weightB
+		});
+	}
+
+	Mat3 ToMat3(const Quat& q)
+	{
+		float x = q.x, y = q.y, z = q.z, w = q.w;
+		return { {
+			1.0f - 2.0f * (y * y + z * z), 2.0f * (x * y + w * z), 2.0f * (x * z - w * y),
+			2.0f * (x * y - w * z), 1.0f - 2.0f * (x * x + z * z), 2.0f * (y * z + w * x),
+			2.0f * (x * z + w * y), 2.0f * (y * z - w * x), 1.0f - 2.0f * (x * x + y * y)
+		} };
+	}
+
+	Mat4 ToMat4(const Quat& q)
+	{
+		return ComposeTransform({ 0.0f, 0.0f, 0.0f }, q, { 1.0f, 1.0f, 1.0f });
+	}
+
+	Mat4 ComposeTransform(const Vec3& translation, const Quat& rotation, const Vec3& scale)
+	{
+		Mat3 r = ToMat3(rotation);
+		return { {
+			r.m[0] * scale.x, r.m[1] * scale.x, r.m[2] * scale.x, 0.0f,
+			r.m[3] * scale.y, r.m[4] * scale.y, r.m[5] * scale.y, 0.0f,
+			r.m[6] * scale.z, r.m[7] * scale.z, r.m[8] * scale.z, 0.0f,
+			translation.x, translation.y, translation.z, 1.0f
+		} };
+	}
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "Vector.h"
+#include "Matrix.h"
+
+namespace Jerboa {
+	// Rotation quaternion, w is the scalar part
+	struct Quat
+	{
+		float x = 0.0f, y = 0.0f, z = 0.0f, w = 1.0f;
+
+		static constexpr Quat Identity() { return { 0.0f, 0.0f, 0.0f, 1.0f }; }
+		// axis must be normalized, angle in radians
+		static Quat FromAxisAngle(const Vec3& axis, float angle);
+		// Applied in z, y, x order, in radians
+		static Quat FromEuler(const Vec3& angles);
+	};
+
+	// Applies b first, then a
+	inline Quat operator*(const Quat& a, const Quat& b)
+	{
+		return {
+			a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y,
+			a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x,
+			a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w,
+			a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z
+		};
+	}
+
+	inline Quat Conjugate(const Quat& q) { return { -q.x, -q.y, -q.z, q.w }; }
+	inline float Dot(const Quat& a, const Quat& b) { return a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w; }
+	Quat Normalize(const Quat& q);
+
+	// Rotates v by the unit quaternion q
+	Vec3 Rotate(const Quat& q, const Vec3& v);
+	// Shortest-path spherical interpolation of unit quaternions
+	Quat Slerp(const Quat& a, const Quat& b, float t);
+
+	Mat3 ToMat3(const Quat& q);
+	Mat4 ToMat4(const Quat& q);
+	// Translation * rotation * scale
+	Mat4 ComposeTransform(const Vec3& translation, const Quat& rotation, const Vec3& scale);
+}
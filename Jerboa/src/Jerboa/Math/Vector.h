@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cmath>
+
+namespace Jerboa {
+	struct Vec2
+	{
+		float x = 0.0f, y = 0.0f;
+
+		inline Vec2& operator+=(const Vec2& other) { x += other.x; y += other.y; return *this; }
+		inline Vec2& operator-=(const Vec2& other) { x -= other.x; y -= other.y; return *this; }
+		inline Vec2& operator*=(float scalar) { x *= scalar; y *= scalar; return *this; }
+	};
+
+	struct Vec3
+	{
+		float x = 0.0f, y = 0.0f, z = 0.0f;
+
+		inline Vec3& operator+=(const Vec3& other) { x += other.x; y += other.y; z += other.z; return *this; }
+		inline Vec3& operator-=(const Vec3& other) { x -= other.x; y -= other.y; z -= other.z; return *this; }
+		inline Vec3& operator*=(float scalar) { x *= scalar; y *= scalar; z *= scalar; return *this; }
+	};
+
+	struct Vec4
+	{
+		float x = 0.0f, y = 0.0f, z = 0.0f, w = 0.0f;
+
+		inline Vec4& operator+=(const Vec4& other) { x += other.x; y += other.y; z += other.z; w += other.w; return *this; }
+		inline Vec4& operator-=(const Vec4& other) { x -= other.x; y -= other.y; z -= other.z; w -= other.w; return *this; }
+		inline Vec4& operator*=(float scalar) { x *= scalar; y *= scalar; z *= scalar; w *= scalar; return *this; }
+	};
+
+	inline Vec2 operator+(const Vec2& a, const Vec2& b) { return { a.x + b.x, a.y + b.y }; }
+	inline Vec2 operator-(const Vec2& a, const Vec2& b) { return { a.x - b.x, a.y - b.y }; }
+	inline Vec2 operator-(const Vec2& v) { return { -v.x, -v.y }; }
+	inline Vec2 operator*(const Vec2& a, const Vec2& b) { return { a.x * b.x, a.y * b.y }; }
+	inline Vec2 operator*(const Vec2& v, float scalar) { return { v.x * scalar, v.y * scalar }; }
+	inline Vec2 operator*(float scalar, const Vec2& v) { return v * scalar; }
+	inline Vec2 operator/(const Vec2& v, float scalar) { return v * (1.0f / scalar); }
+	inline bool operator==(const Vec2& a, const Vec2& b) { return a.x == b.x && a.y == b.y; }
+	inline bool operator!=(const Vec2& a, const Vec2& b) { return !(a == b); }
+
+	inline Vec3 operator+(const Vec3& a, const Vec3& b) { return { a.x + b.x, a.y + b.y, a.z + b.z }; }
+	inline Vec3 operator-(const Vec3& a, const Vec3& b) { return { a.x - b.x, a.y - b.y, a.z - b.z }; }
+	inline Vec3 operator-(const Vec3& v) { return { -v.x, -v.y, -v.z }; }
+	inline Vec3 operator*(const Vec3& a, const Vec3& b) { return { a.x * b.x, a.y * b.y, a.z * b.z }; }
+	inline Vec3 operator*(const Vec3& v, float scalar) { return { v.x * scalar, v.y * scalar, v.z * scalar }; }
+	inline Vec3 operator*(float scalar, const Vec3& v) { return v * scalar; }
+	inline Vec3 operator/(const Vec3& v, float scalar) { return v * (1.0f / scalar); }
+	inline bool operator==(const Vec3& a, const Vec3& b) { return a.x == b.x && a.y == b.y && a.z == b.z; }
+	inline bool operator!=(const Vec3& a, const Vec3& b) { return !(a == b); }
+
+	inline Vec4 operator+(const Vec4& a, const Vec4& b) { return { a.x + b.x, a.y + b.y, a.z + b.z, a.w + b.w }; }
+	inline Vec4 operator-(const Vec4& a, const Vec4& b) { return { a.x - b.x, a.y - b.y, a.z - b.z, a.w - b.w }; }
+	inline Vec4 operator-(const Vec4& v) { return { -v.x, -v.y, -v.z, -v.w }; }
+	inline Vec4 operator*(const Vec4& a, const Vec4& b) { return { a.x * b.x, a.y * b.y, a.z * b.z, a.w * b.w }; }
+	inline Vec4 operator*(const Vec4& v, float scalar) { return { v.x * scalar, v.y * scalar, v.z * scalar, v.w * scalar }; }
+	inline Vec4 operator*(float scalar, const Vec4& v) { return v * scalar; }
+	inline Vec4 operator/(const Vec4& v, float scalar) { return v * (1.0f / scalar); }
+	inline bool operator==(const Vec4& a, const Vec4& b) { return a.x == b.x && a.y == b.y && a.z == b.z && a.w == b.w; }
+	inline bool operator!=(const Vec4& a, const Vec4& b) { return !(a == b); }
+
+	inline float Dot(const Vec2& a, const Vec2& b) { return a.x * b.x + a.y * b.y; }
+	inline float Dot(const Vec3& a, const Vec3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+	inline float Dot(const Vec4& a, const Vec4& b) { return a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w; }
+
+	inline Vec3 Cross(const Vec3& a, const Vec3& b)
+	{
+		return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x };
+	}
+
+	template<typename Vector>
+	inline float LengthSquared(const Vector& v) { return Dot(v, v); }
+
+	template<typename Vector>
+	inline float Length(const Vector& v) { return std::sqrt(Dot(v, v)); }
+
+	// The zero vector stays zero
+	template<typename Vector>
+	inline Vector Normalize(const Vector& v)
+	{
+		float length = Length(v);
+		return length > 0.0f ? v * (1.0f / length) : v;
+	}
+
+	template<typename Vector>
+	inline Vector Lerp(const Vector& a, const Vector& b, float t) { return a + (b - a) * t; }
+
+	inline Vec3 Min(const Vec3& a, const Vec3& b) { return { std::fmin(a.x, b.x), std::fmin(a.y, b.y), std::fmin(a.z, b.z) }; }
+	inline Vec3 Max(const Vec3& a, const Vec3& b) { return { std::fmax(a.x, b.x), std::fmax(a.y, b.y), std::fmax(a.z, b.z) }; }
+}
@@ -3,8 +3,11 @@
 
 #include "glad/glad.h"
 
+#include "Jerboa/Renderer/GLStateCache.h"
+
 #include "Jerboa/Debug.h"
 #include "Jerboa/Core/KeyCode.h"
+#include "Jerboa/Core/StartupTracer.h"
 
 #include "Jerboa/Core/Events/WindowResizeEvent.h"
 #include "Jerboa/Core/Events/WindowCloseEvent.h"
@@ -22,7 +25,10 @@ namespace Jerboa {
 		JERBOA_LOG_ERROR("GLFW Error ({0}): {1}", error, description);
 	}
 
-	static bool sGLFWInitialized = false;
+	// GLFW is initialized by the first window and terminated with the last one
+	static uint32_t sWindowCount = 0;
+	// Every context shares the first one's objects, so the entry points are loaded once
+	static bool sGLLoaded = false;
 
 	GLFW_Window::GLFW_Window(const WindowProps& props)
 	{
@@ -35,14 +41,33 @@ namespace Jerboa {
 	}
 
 	void GLFW_Window::Update()
+	{
+		Present();
+		PollEvents();
+	}
+
+	void GLFW_Window::Present()
 	{
 		glfwSwapBuffers(mWindow);
+		// Input polled after this is handled next frame, so it is measured against the next swap
+		mData.inputLatency.OnPresent(Time::Now());
+	}
+
+	void GLFW_Window::PollEvents()
+	{
 		glfwPollEvents();
 	}
 
+	void GLFW_Window::MakeContextCurrent()
+	{
+		if (glfwGetCurrentContext() != mWindow)
+			glfwMakeContextCurrent(mWindow);
+		GLStateCache::MakeContextCurrent(mWindow);
+	}
+
 	void GLFW_Window::Clear()
 	{
-		glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+		GLStateCache::SetClearColor(0.2f, 0.3f, 0.3f, 1.0f);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
 	}
 
@@ -55,10 +80,29 @@ namespace Jerboa {
 
 	void GLFW_Window::SetVSync(bool enabled)
 	{
+		// The swap interval applies to the current context
+		NativeGLFWWindow* current = glfwGetCurrentContext();
+		if (current != mWindow)
+			glfwMakeContextCurrent(mWindow);
 		glfwSwapInterval(enabled ? 1 : 0);
+		if (current != mWindow)
+			glfwMakeContextCurrent(current);
 		mData.VSync = enabled;
 	}
 
+	bool GLFW_Window::SetRawMouseMotion(bool enabled)
+	{
+		if (enabled && !glfwRawMouseMotionSupported()) {
+			JERBOA_LOG_WARN("Raw mouse motion is not supported on this system");
+			return false;
+		}
+
+		glfwSetInputMode(mWindow, GLFW_CURSOR, enabled ? GLFW_CURSOR_DISABLED : GLFW_CURSOR_NORMAL);
+		glfwSetInputMode(mWindow, GLFW_RAW_MOUSE_MOTION, enabled ? GLFW_TRUE : GLFW_FALSE);
+		mData.rawMouseMotion = enabled;
+		return true;
+	}
+
 	void GLFW_Window::Init(const WindowProps& props)
 	{
 		mData.height = props.height;
@@ -67,24 +111,34 @@ namespace Jerboa {
 
 		JERBOA_LOG_INFO("Creating window \"{0}\" ({1}x{2})", props.title, props.width, props.height);
 
-		if (!sGLFWInitialized) {
-			int success = glfwInit();
+		if (sWindowCount++ == 0) {
+			JERBOA_STARTUP_SCOPE("glfwInit");
+			[[maybe_unused]] int success = glfwInit();
 			JERBOA_ASSERT(success, "Could not initialize GLFW!");
 			glfwSetErrorCallback(GLFWErrorCallback);
-
-			sGLFWInitialized = true;
 		}
 
-		mWindow = glfwCreateWindow(props.width, props.height, props.title.c_str(), NULL, NULL);
-		JERBOA_ASSERT(mWindow, "Could not create GLFW window!");
+		glfwWindowHint(GLFW_VISIBLE, props.visible ? GLFW_TRUE : GLFW_FALSE);
+		{
+			JERBOA_STARTUP_SCOPE("glfwCreateWindow");
+			NativeGLFWWindow* share = props.sharedContext ? static_cast<NativeGLFWWindow*>(props.sharedContext->GetNativeWindow()) : NULL;
+			mWindow = glfwCreateWindow(props.width, props.height, props.title.c_str(), NULL, share);
+			JERBOA_ASSERT(mWindow, "Could not create GLFW window!");
+			MakeContextCurrent();
+		}
 
-		glfwMakeContextCurrent(mWindow);
 		glfwSetWindowUserPointer(mWindow, &mData);
 		glfwSetInputMode(mWindow, GLFW_CURSOR, GLFW_CURSOR_NORMAL);
+		if (props.rawMouseMotion)
+			SetRawMouseMotion(true);
 		
 		// Initialzing OpenGL
-		int status = gladLoadGLLoader((GLADloadproc)glfwGetProcAddress);
-		JERBOA_ASSERT(status, "Failed to initialize Glad!");
+		if (!sGLLoaded) {
+			JERBOA_STARTUP_SCOPE("gladLoadGLLoader");
+			[[maybe_unused]] int status = gladLoadGLLoader((GLADloadproc)glfwGetProcAddress);
+			JERBOA_ASSERT(status, "Failed to initialize Glad!");
+			sGLLoaded = true;
+		}
 
 		// Setting various callback functions for GLFW
 		glfwSetWindowSizeCallback(mWindow, [](NativeGLFWWindow* window, int width, int height)
@@ -114,17 +168,17 @@ namespace Jerboa {
 			{
 				case GLFW_PRESS:
 				{
-					data.eventBus->Publish(KeyPressedEvent(keyCode, modsKeyCode));
+					PublishInputEvent(data, KeyPressedEvent(keyCode, modsKeyCode));
 					break;
 				}
 				case GLFW_RELEASE:
 				{
-					data.eventBus->Publish(KeyReleasedEvent(keyCode, modsKeyCode));
+					PublishInputEvent(data, KeyReleasedEvent(keyCode, modsKeyCode));
 					break;
 				}
 				case GLFW_REPEAT:
 				{
-					data.eventBus->Publish(KeyRepeatEvent(keyCode, modsKeyCode));
+					PublishInputEvent(data, KeyRepeatEvent(keyCode, modsKeyCode));
 					break;
 				}
 			}
@@ -133,13 +187,13 @@ namespace Jerboa {
 		glfwSetCursorPosCallback(mWindow, [](GLFWwindow* window, double x, double y)
 		{
 			auto& data = *((WindowData*)glfwGetWindowUserPointer(window));
-			data.eventBus->Publish(MouseMovedEvent(x, y));
+			PublishInputEvent(data, MouseMovedEvent(x, y));
 		});
 
 		glfwSetScrollCallback(mWindow, [](GLFWwindow* window, double xOffset, double yOffset)
 		{
 			auto& data = *((WindowData*)glfwGetWindowUserPointer(window));
-			data.eventBus->Publish(MouseScrolledEvent(xOffset, yOffset));
+			PublishInputEvent(data, MouseScrolledEvent(xOffset, yOffset));
 		});
 
 		glfwSetMouseButtonCallback(mWindow, [](GLFWwindow* window, int button, int action, int mods)
@@ -152,12 +206,12 @@ namespace Jerboa {
 				{
 					case GLFW_PRESS:
 					{
-						data.eventBus->Publish(MouseButtonPressedEvent(buttonCode, modsKeyCode));
+						PublishInputEvent(data, MouseButtonPressedEvent(buttonCode, modsKeyCode));
 						break;
 					}
 					case GLFW_RELEASE:
 					{
-						data.eventBus->Publish(MouseButtonReleasedEvent(buttonCode, modsKeyCode));
+						PublishInputEvent(data, MouseButtonReleasedEvent(buttonCode, modsKeyCode));
 						break;
 					}
 				}
@@ -166,7 +220,13 @@ namespace Jerboa {
 
 	void GLFW_Window::ShutDown()
 	{
-		glfwTerminate(); // maybe put this at the very end of the program in case there are multiple windows
+		GLStateCache::OnContextDestroyed(mWindow);
+		glfwDestroyWindow(mWindow);
+
+		if (--sWindowCount == 0) {
+			glfwTerminate();
+			sGLLoaded = false;
+		}
 	}
 }
 
@@ -16,7 +16,11 @@ namespace Jerboa
 		~GLFW_Window();
 
 		virtual void Update() override;
+		virtual void Present() override;
 		virtual void Clear() override;
+		static void PollEvents();
+
+		virtual void MakeContextCurrent() override;
 
 		virtual int GetWidth() const override { return mData.width; };
 		virtual int GetHeight() const override { return mData.height; };
@@ -26,6 +30,11 @@ namespace Jerboa
 		virtual void SetVSync(bool enabled) override;
 		virtual bool IsVSync() const override { return mData.VSync; };
 
+		virtual bool SetRawMouseMotion(bool enabled) override;
+		virtual bool IsRawMouseMotion() const override { return mData.rawMouseMotion; }
+
+		virtual InputLatencyTracker& GetInputLatency() override { return mData.inputLatency; }
+
 		virtual void* GetNativeWindow() const { return mWindow; }
 	private:
 		struct WindowData
@@ -33,13 +42,22 @@ namespace Jerboa
 			std::string title;
 			int width, height;
 			bool VSync;
+			bool rawMouseMotion = false;
 
 			std::shared_ptr<EventBus> eventBus = std::make_shared<EventBus>();
+			InputLatencyTracker inputLatency;
 		};
 
 		void Init(const WindowProps& props);
 		void ShutDown();
 
+		template<class EventType>
+		static void PublishInputEvent(WindowData& data, const EventType& evnt)
+		{
+			data.inputLatency.OnInput(evnt.timestamp);
+			data.eventBus->Publish(evnt);
+		}
+
 		NativeGLFWWindow* mWindow;
 		WindowData mData;
 	};
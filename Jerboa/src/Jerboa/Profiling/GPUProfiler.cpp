@@ -0,0 +1,227 @@
+#include "jerboa-pch.h"
+#include "GPUProfiler.h"
+
+#include "glad/glad.h"
+
+namespace Jerboa {
+	struct PendingGPUZone
+	{
+		const char* name;
+		uint32_t depth;
+		uint32_t beginQuery;
+		uint32_t endQuery;
+	};
+
+	struct GPUFrame
+	{
+		uint64_t frameIndex = 0;
+		bool pending = false;
+		uint32_t frameQuery = 0;
+		std::vector<PendingGPUZone> zones;
+	};
+
+	struct GPUProfilerData
+	{
+		bool initialized = false;
+		std::vector<uint32_t> freeQueries;
+		std::vector<uint32_t> allQueries;
+
+		std::array<GPUFrame, GPUProfiler::MaxFramesInFlight> frames;
+		GPUFrame* current = nullptr;
+		std::vector<size_t> openZones;
+
+		// CPU time = GPU time + offset, recalibrated periodically against drift
+		int64_t gpuToCpuOffset = 0;
+		uint64_t framesSinceCalibration = 0;
+
+		double lastFrameTime = 0.0;
+		uint64_t droppedFrames = 0;
+	};
+
+	static GPUProfilerData sData;
+	static constexpr uint64_t sCalibrationInterval = 120;
+
+	static uint32_t AcquireQuery()
+	{
+		if (sData.freeQueries.empty()) {
+			const size_t growBy = 64;
+			size_t first = sData.allQueries.size();
+			sData.allQueries.resize(first + growBy);
+			glGenQueries(growBy, &sData.allQueries[first]);
+			sData.freeQueries.insert(sData.freeQueries.end(), sData.allQueries.begin() + first, sData.allQueries.end());
+		}
+
+		uint32_t query = sData.freeQueries.back();
+		sData.freeQueries.pop_back();
+		return query;
+	}
+
+	static void ReleaseFrame(GPUFrame& frame)
+	{
+		for (const PendingGPUZone& zone : frame.zones) {
+			sData.freeQueries.push_back(zone.beginQuery);
+			sData.freeQueries.push_back(zone.endQuery);
+		}
+		sData.freeQueries.push_back(frame.frameQuery);
+		frame.zones.clear();
+		frame.pending = false;
+	}
+
+	static void Calibrate()
+	{
+		GLint64 gpuNow = 0;
+		glGetInteger64v(GL_TIMESTAMP, &gpuNow);
+		sData.gpuToCpuOffset = static_cast<int64_t>(Time::Now()) - static_cast<int64_t>(gpuNow);
+		sData.framesSinceCalibration = 0;
+	}
+
+	static bool IsAvailable(uint32_t query)
+	{
+		GLint available = 0;
+		glGetQueryObjectiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+		return available != 0;
+	}
+
+	// Returns false if the frame's results are not there yet
+	static bool TryResolve(GPUFrame& frame)
+	{
+		// The frame query ends after every zone, check it first as it is the likely laggard
+		if (!IsAvailable(frame.frameQuery))
+			return false;
+		for (const PendingGPUZone& zone : frame.zones) {
+			if (!IsAvailable(zone.endQuery))
+				return false;
+		}
+
+		GLuint64 frameTime = 0;
+		glGetQueryObjectui64v(frame.frameQuery, GL_QUERY_RESULT, &frameTime);
+		sData.lastFrameTime = Time::ToMilliseconds(frameTime);
+
+		for (const PendingGPUZone& zone : frame.zones) {
+			GLuint64 begin = 0, end = 0;
+			glGetQueryObjectui64v(zone.beginQuery, GL_QUERY_RESULT, &begin);
+			glGetQueryObjectui64v(zone.endQuery, GL_QUERY_RESULT, &end);
+
+			ProfileZone resolved;
+			resolved.name = zone.name;
+			resolved.start = static_cast<Timestamp>(static_cast<int64_t>(begin) + sData.gpuToCpuOffset);
+			resolved.end = static_cast<Timestamp>(static_cast<int64_t>(end) + sData.gpuToCpuOffset);
+			resolved.depth = zone.depth;
+			resolved.track = Profiler::GPUTrack;
+			Profiler::SubmitZone(frame.frameIndex, resolved);
+		}
+
+		ReleaseFrame(frame);
+		return true;
+	}
+
+	void GPUProfiler::Init()
+	{
+		GLint bits = 0;
+		glGetQueryiv(GL_TIMESTAMP, GL_QUERY_COUNTER_BITS, &bits);
+		if (bits == 0) {
+			JERBOA_LOG_WARN("GPU profiler disabled, timestamp queries are not supported");
+			return;
+		}
+
+		sData.initialized = true;
+		Calibrate();
+	}
+
+	void GPUProfiler::Shutdown()
+	{
+		if (!sData.initialized)
+			return;
+
+		if (!sData.allQueries.empty())
+			glDeleteQueries(static_cast<GLsizei>(sData.allQueries.size()), sData.allQueries.data());
+		sData = GPUProfilerData();
+	}
+
+	void GPUProfiler::BeginFrame()
+	{
+		if (!sData.initialized)
+			return;
+
+		uint64_t frameIndex = Profiler::GetFrameIndex();
+
+		// Oldest first, stop at the first frame the GPU has not finished yet
+		for (uint64_t index = frameIndex - std::min<uint64_t>(frameIndex, MaxFramesInFlight - 1); index < frameIndex; index++) {
+			GPUFrame& frame = sData.frames[index % MaxFramesInFlight];
+			if (!frame.pending || frame.frameIndex != index)
+				continue;
+			if (!TryResolve(frame))
+				break;
+		}
+
+		GPUFrame& frame = sData.frames[frameIndex % MaxFramesInFlight];
+		if (frame.pending) {
+			// The GPU is more than MaxFramesInFlight behind; rather drop than stall
+			sData.droppedFrames++;
+			ReleaseFrame(frame);
+		}
+
+		if (++sData.framesSinceCalibration >= sCalibrationInterval)
+			Calibrate();
+
+		frame.frameIndex = frameIndex;
+		frame.pending = true;
+		frame.frameQuery = AcquireQuery();
+		sData.current = &frame;
+		glBeginQuery(GL_TIME_ELAPSED, frame.frameQuery);
+	}
+
+	void GPUProfiler::EndFrame()
+	{
+		if (!sData.current)
+			return;
+
+		while (!sData.openZones.empty())
+			EndZone();
+
+		glEndQuery(GL_TIME_ELAPSED);
+		sData.current = nullptr;
+	}
+
+	void GPUProfiler::BeginZone(const char* name)
+	{
+		if (!sData.current)
+			return;
+
+		PendingGPUZone zone;
+		zone.name = name;
+		zone.depth = static_cast<uint32_t>(sData.openZones.size());
+		zone.beginQuery = AcquireQuery();
+		zone.endQuery = 0;
+		glQueryCounter(zone.beginQuery, GL_TIMESTAMP);
+
+		sData.openZones.push_back(sData.current->zones.size());
+		sData.current->zones.push_back(zone);
+	}
+
+	void GPUProfiler::EndZone()
+	{
+		if (!sData.current || sData.openZones.empty())
+			return;
+
+		PendingGPUZone& zone = sData.current->zones[sData.openZones.back()];
+		sData.openZones.pop_back();
+		zone.endQuery = AcquireQuery();
+		glQueryCounter(zone.endQuery, GL_TIMESTAMP);
+	}
+
+	bool GPUProfiler::IsSupported()
+	{
+		return sData.initialized;
+	}
+
+	double GPUProfiler::GetLastFrameTime()
+	{
+		return sData.lastFrameTime;
+	}
+
+	uint64_t GPUProfiler::GetDroppedFrames()
+	{
+		return sData.droppedFrames;
+	}
+}
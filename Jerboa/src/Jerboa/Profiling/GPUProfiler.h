@@ -0,0 +1,52 @@
+#pragma once
+
+#include "Profiler.h"
+
+#include <cstdint>
+
+namespace Jerboa {
+	// Measures GPU execution time of named, nested scopes with pooled GL timer queries.
+	// Scopes are bracketed by GL_TIMESTAMP queries (GL_TIME_ELAPSED queries cannot nest),
+	// the whole frame by one GL_TIME_ELAPSED query. Results are read back
+	// MaxFramesInFlight frames later without ever waiting on the GPU, converted to the
+	// CPU timeline and submitted to the Profiler on its GPU track.
+	class GPUProfiler
+	{
+	public:
+		static constexpr uint32_t MaxFramesInFlight = 4;
+
+		static void Init();
+		static void Shutdown();
+
+		static void BeginFrame();
+		static void EndFrame();
+
+		static void BeginZone(const char* name);
+		static void EndZone();
+
+		static bool IsSupported();
+		// GPU time of the most recent frame whose results arrived
+		static double GetLastFrameTime();
+		// Frames whose results never arrived in time
+		static uint64_t GetDroppedFrames();
+	};
+
+	class GPUProfileScope
+	{
+	public:
+		GPUProfileScope(const char* name) { GPUProfiler::BeginZone(name); }
+		~GPUProfileScope() { GPUProfiler::EndZone(); }
+
+		GPUProfileScope(const GPUProfileScope&) = delete;
+		GPUProfileScope& operator=(const GPUProfileScope&) = delete;
+	};
+}
+
+#ifdef JERBOA_PROFILING_ENABLED
+	#define JERBOA_PROFILE_GPU_SCOPE(name) ::Jerboa::GPUProfileScope JERBOA_PROFILE_CONCAT(gpuProfileScope, __LINE__)(name)
+	// Times the same scope on the CPU and on the GPU
+	#define JERBOA_PROFILE_RENDER_SCOPE(name) JERBOA_PROFILE_SCOPE(name); JERBOA_PROFILE_GPU_SCOPE(name)
+#else
+	#define JERBOA_PROFILE_GPU_SCOPE(name)
+	#define JERBOA_PROFILE_RENDER_SCOPE(name)
+#endif
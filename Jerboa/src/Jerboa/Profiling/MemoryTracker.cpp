@@ -0,0 +1,287 @@
+#include "jerboa-pch.h"
+#include "MemoryTracker.h"
+
+#include <atomic>
+#include <fstream>
+#include <new>
+
+#if defined(JERBOA_MEMORY_TRACKING) && defined(JERBOA_PLATFORM_WINDOWS)
+	#include <malloc.h>
+#endif
+
+namespace Jerboa {
+	namespace {
+		struct Counters
+		{
+			std::atomic<int64_t> liveBytes{ 0 };
+			std::atomic<int64_t> peakBytes{ 0 };
+			std::atomic<int64_t> liveAllocations{ 0 };
+			std::atomic<uint64_t> totalAllocations{ 0 };
+		};
+
+		// Constant initialized, so allocations made during static initialization are counted too
+		Counters sCounters[MemoryTracker::TagCount];
+		Counters sTotal;
+
+		// Per-frame history, only touched by the main thread
+		uint64_t sFrameStart[MemoryTracker::TagCount] = {};
+		uint64_t sLastFrame[MemoryTracker::TagCount] = {};
+		uint32_t sHistory[MemoryTracker::FrameHistory][MemoryTracker::TagCount] = {};
+		uint32_t sHistoryNext = 0;
+		uint32_t sRecordedFrames = 0;
+		uint64_t sFrameIndex = 0;
+
+		constexpr uint32_t MaxTagDepth = 32;
+		thread_local MemoryTag tTagStack[MaxTagDepth];
+		thread_local uint32_t tTagDepth = 0;
+		thread_local uint64_t tThreadAllocations = 0;
+
+		MemoryTagStats LoadStats(const Counters& counters)
+		{
+			MemoryTagStats stats;
+			stats.liveBytes = counters.liveBytes.load(std::memory_order_relaxed);
+			stats.peakBytes = counters.peakBytes.load(std::memory_order_relaxed);
+			stats.liveAllocations = counters.liveAllocations.load(std::memory_order_relaxed);
+			stats.totalAllocations = counters.totalAllocations.load(std::memory_order_relaxed);
+			return stats;
+		}
+	}
+
+#ifdef JERBOA_MEMORY_TRACKING
+	namespace {
+		// Sits right in front of every tracked allocation
+		struct AllocationHeader
+		{
+			uint64_t size;
+			uint32_t offset;
+			MemoryTag tag;
+		};
+
+		constexpr size_t HeaderSize = 16;
+		static_assert(sizeof(AllocationHeader) <= HeaderSize, "AllocationHeader must fit in front of 16-byte aligned allocations");
+
+		void AddAllocation(Counters& counters, int64_t size)
+		{
+			int64_t live = counters.liveBytes.fetch_add(size, std::memory_order_relaxed) + size;
+			int64_t peak = counters.peakBytes.load(std::memory_order_relaxed);
+			while (live > peak && !counters.peakBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {}
+
+			counters.liveAllocations.fetch_add(1, std::memory_order_relaxed);
+			counters.totalAllocations.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		void RemoveAllocation(Counters& counters, int64_t size)
+		{
+			counters.liveBytes.fetch_sub(size, std::memory_order_relaxed);
+			counters.liveAllocations.fetch_sub(1, std::memory_order_relaxed);
+		}
+
+		void* TrackedAllocate(size_t size, size_t alignment, MemoryTag tag)
+		{
+			// The offset keeps the user pointer aligned and leaves room for the header
+			size_t offset = std::max(alignment, HeaderSize);
+#if defined(JERBOA_PLATFORM_WINDOWS)
+			void* raw = _aligned_malloc(size + offset, offset);
+#else
+			void* raw = nullptr;
+			if (posix_memalign(&raw, offset, size + offset) != 0)
+				raw = nullptr;
+#endif
+			if (raw == nullptr)
+				return nullptr;
+
+			uint8_t* pointer = static_cast<uint8_t*>(raw) + offset;
+			AllocationHeader* header = reinterpret_cast<AllocationHeader*>(pointer - HeaderSize);
+			header->size = size;
+			header->offset = static_cast<uint32_t>(offset);
+			header->tag = tag;
+
+			AddAllocation(sCounters[static_cast<uint32_t>(tag)], static_cast<int64_t>(size));
+			AddAllocation(sTotal, static_cast<int64_t>(size));
+			tThreadAllocations++;
+			return pointer;
+		}
+
+		void TrackedFree(void* pointer)
+		{
+			if (pointer == nullptr)
+				return;
+
+			AllocationHeader* header = reinterpret_cast<AllocationHeader*>(static_cast<uint8_t*>(pointer) - HeaderSize);
+			RemoveAllocation(sCounters[static_cast<uint32_t>(header->tag)], static_cast<int64_t>(header->size));
+			RemoveAllocation(sTotal, static_cast<int64_t>(header->size));
+
+			void* raw = static_cast<uint8_t*>(pointer) - header->offset;
+#if defined(JERBOA_PLATFORM_WINDOWS)
+			_aligned_free(raw);
+#else
+			std::free(raw);
+#endif
+		}
+
+		void* TrackedNew(size_t size, size_t alignment)
+		{
+			void* pointer = TrackedAllocate(size == 0 ? 1 : size, alignment, MemoryTracker::GetCurrentTag());
+			if (pointer == nullptr)
+				throw std::bad_alloc();
+			return pointer;
+		}
+	}
+
+	void* MemoryTracker::Allocate(size_t size, MemoryTag tag)
+	{
+		return TrackedAllocate(size == 0 ? 1 : size, alignof(std::max_align_t), tag);
+	}
+
+	void MemoryTracker::Free(void* pointer)
+	{
+		TrackedFree(pointer);
+	}
+#endif
+
+	void MemoryTracker::PushTag(MemoryTag tag)
+	{
+		if (tTagDepth < MaxTagDepth)
+			tTagStack[tTagDepth] = tag;
+		tTagDepth++;
+	}
+
+	void MemoryTracker::PopTag()
+	{
+		JERBOA_ASSERT(tTagDepth > 0, "MemoryTracker::PopTag() without a matching PushTag()");
+		tTagDepth--;
+	}
+
+	MemoryTag MemoryTracker::GetCurrentTag()
+	{
+		if (tTagDepth == 0)
+			return MemoryTag::General;
+		return tTagStack[std::min(tTagDepth, MaxTagDepth) - 1];
+	}
+
+	void MemoryTracker::BeginFrame()
+	{
+		if (!IsEnabled())
+			return;
+
+		// The first call only starts counting, everything before it was startup
+		bool record = sFrameIndex++ > 0;
+		for (uint32_t tag = 0; tag < TagCount; tag++) {
+			uint64_t total = sCounters[tag].totalAllocations.load(std::memory_order_relaxed);
+			sLastFrame[tag] = record ? total - sFrameStart[tag] : 0;
+			sFrameStart[tag] = total;
+			if (record)
+				sHistory[sHistoryNext][tag] = static_cast<uint32_t>(std::min<uint64_t>(sLastFrame[tag], UINT32_MAX));
+		}
+
+		if (record) {
+			sHistoryNext = (sHistoryNext + 1) % FrameHistory;
+			sRecordedFrames = std::min(sRecordedFrames + 1, FrameHistory);
+		}
+	}
+
+	MemoryTagStats MemoryTracker::GetStats(MemoryTag tag)
+	{
+		MemoryTagStats stats = LoadStats(sCounters[static_cast<uint32_t>(tag)]);
+		stats.frameAllocations = sLastFrame[static_cast<uint32_t>(tag)];
+		return stats;
+	}
+
+	MemoryTagStats MemoryTracker::GetTotalStats()
+	{
+		MemoryTagStats stats = LoadStats(sTotal);
+		for (uint32_t tag = 0; tag < TagCount; tag++)
+			stats.frameAllocations += sLastFrame[tag];
+		return stats;
+	}
+
+	uint64_t MemoryTracker::GetTotalAllocationCount()
+	{
+		return sTotal.totalAllocations.load(std::memory_order_relaxed);
+	}
+
+	uint64_t MemoryTracker::GetThreadAllocationCount()
+	{
+		return tThreadAllocations;
+	}
+
+	uint32_t MemoryTracker::GetFrameAllocations(MemoryTag tag, uint32_t framesAgo)
+	{
+		if (framesAgo >= sRecordedFrames)
+			return 0;
+		return sHistory[(sHistoryNext + FrameHistory - 1 - framesAgo) % FrameHistory][static_cast<uint32_t>(tag)];
+	}
+
+	uint32_t MemoryTracker::GetRecordedFrameCount()
+	{
+		return sRecordedFrames;
+	}
+
+	const char* MemoryTracker::GetTagName(MemoryTag tag)
+	{
+		switch (tag) {
+		case MemoryTag::General: return "General";
+		case MemoryTag::Events: return "Events";
+		case MemoryTag::Layers: return "Layers";
+		case MemoryTag::Logging: return "Logging";
+		case MemoryTag::ImGui: return "ImGui";
+		case MemoryTag::Render: return "Render";
+		case MemoryTag::Scene: return "Scene";
+		case MemoryTag::Jobs: return "Jobs";
+		case MemoryTag::Assets: return "Assets";
+		default: return "Unknown";
+		}
+	}
+
+	bool MemoryTracker::WriteCSV(const std::string& path)
+	{
+		std::ofstream file(path);
+		if (!file) {
+			JERBOA_LOG_ERROR("Could not write memory report to '{}'", path);
+			return false;
+		}
+
+		file << "frame";
+		for (uint32_t tag = 0; tag < TagCount; tag++)
+			file << ',' << GetTagName(static_cast<MemoryTag>(tag));
+		file << ",total\n";
+
+		for (uint32_t framesAgo = sRecordedFrames; framesAgo-- > 0;) {
+			file << sFrameIndex - 1 - framesAgo;
+			uint64_t total = 0;
+			for (uint32_t tag = 0; tag < TagCount; tag++) {
+				uint32_t allocations = GetFrameAllocations(static_cast<MemoryTag>(tag), framesAgo);
+				total += allocations;
+				file << ',' << allocations;
+			}
+			file << ',' << total << '\n';
+		}
+
+		JERBOA_LOG_INFO("Wrote {} frames of allocation counts to '{}'", sRecordedFrames, path);
+		return true;
+	}
+}
+
+#ifdef JERBOA_MEMORY_TRACKING
+void* operator new(size_t size) { return Jerboa::TrackedNew(size, alignof(std::max_align_t)); }
+void* operator new[](size_t size) { return Jerboa::TrackedNew(size, alignof(std::max_align_t)); }
+void* operator new(size_t size, std::align_val_t alignment) { return Jerboa::TrackedNew(size, static_cast<size_t>(alignment)); }
+void* operator new[](size_t size, std::align_val_t alignment) { return Jerboa::TrackedNew(size, static_cast<size_t>(alignment)); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept { return Jerboa::TrackedAllocate(size == 0 ? 1 : size, alignof(std::max_align_t), Jerboa::MemoryTracker::GetCurrentTag()); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept { return Jerboa::TrackedAllocate(size == 0 ? 1 : size, alignof(std::max_align_t), Jerboa::MemoryTracker::GetCurrentTag()); }
+void* operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept { return Jerboa::TrackedAllocate(size == 0 ? 1 : size, static_cast<size_t>(alignment), Jerboa::MemoryTracker::GetCurrentTag()); }
+void* operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept { return Jerboa::TrackedAllocate(size == 0 ? 1 : size, static_cast<size_t>(alignment), Jerboa::MemoryTracker::GetCurrentTag()); }
+
+void operator delete(void* pointer) noexcept { Jerboa::TrackedFree(pointer); }
+void operator delete[](void* pointer) noexcept { Jerboa::TrackedFree(pointer); }
+void operator delete(void* pointer, size_t) noexcept { Jerboa::TrackedFree(pointer); }
+void operator delete[](void* pointer, size_t) noexcept { Jerboa::TrackedFree(pointer); }
+void operator delete(void* pointer, const std::nothrow_t&) noexcept { Jerboa::TrackedFree(pointer); }
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept { Jerboa::TrackedFree(pointer); }
+void operator delete(void* pointer, std::align_val_t) noexcept { Jerboa::TrackedFree(pointer); }
+void operator delete[](void* pointer, std::align_val_t) noexcept { Jerboa::TrackedFree(pointer); }
+void operator delete(void* pointer, size_t, std::align_val_t) noexcept { Jerboa::TrackedFree(pointer); }
+void operator delete[](void* pointer, size_t, std::align_val_t) noexcept { Jerboa::TrackedFree(pointer); }
+void operator delete(void* pointer, std::align_val_t, const std::nothrow_t&) noexcept { Jerboa::TrackedFree(pointer); }
+void operator delete[](void* pointer, std::align_val_t, const std::nothrow_t&) noexcept { Jerboa::TrackedFree(pointer); }
+#endif
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+#include <cstdlib>
+
+// Opt-in (premake5 --memory-tracking): replaces the global operator new and delete to count
+// every allocation against the subsystem tag active on the allocating thread. Without it the
+// tags compile away and MemoryTracker::Allocate() is plain malloc.
+
+namespace Jerboa {
+	enum class MemoryTag : uint8_t
+	{
+		General,
+		Events,
+		Layers,
+		Logging,
+		ImGui,
+		Render,
+		Scene,
+		Jobs,
+		Assets,
+		Count
+	};
+
+	struct MemoryTagStats
+	{
+		int64_t liveBytes = 0;
+		int64_t peakBytes = 0;
+		int64_t liveAllocations = 0;
+		uint64_t totalAllocations = 0;
+		// Allocations during the last completed frame
+		uint64_t frameAllocations = 0;
+	};
+
+	class MemoryTracker
+	{
+	public:
+		static constexpr uint32_t TagCount = static_cast<uint32_t>(MemoryTag::Count);
+		static constexpr uint32_t FrameHistory = 240;
+
+#ifdef JERBOA_MEMORY_TRACKING
+		static constexpr bool IsEnabled() { return true; }
+
+		// For allocators outside operator new (e.g. C libraries), tagged explicitly
+		static void* Allocate(size_t size, MemoryTag tag);
+		static void Free(void* pointer);
+#else
+		static constexpr bool IsEnabled() { return false; }
+
+		inline static void* Allocate(size_t size, MemoryTag) { return std::malloc(size); }
+		inline static void Free(void* pointer) { std::free(pointer); }
+#endif
+
+		// Tags nest per thread, allocations are counted against the innermost one
+		static void PushTag(MemoryTag tag);
+		static void PopTag();
+		static MemoryTag GetCurrentTag();
+
+		// Closes the per-frame counters of the previous frame, main thread only
+		static void BeginFrame();
+
+		static MemoryTagStats GetStats(MemoryTag tag);
+		static MemoryTagStats GetTotalStats();
+		static uint64_t GetTotalAllocationCount();
+		// Allocations made by the calling thread, 0 without tracking
+		static uint64_t GetThreadAllocationCount();
+		// Allocations of one tag framesAgo completed frames back, 0 being the last one
+		static uint32_t GetFrameAllocations(MemoryTag tag, uint32_t framesAgo);
+		static uint32_t GetRecordedFrameCount();
+
+		static const char* GetTagName(MemoryTag tag);
+
+		// One row per recorded frame with the allocations of every tag
+		static bool WriteCSV(const std::string& path);
+	};
+
+	class MemoryTagScope
+	{
+	public:
+		MemoryTagScope(MemoryTag tag) { MemoryTracker::PushTag(tag); }
+		~MemoryTagScope() { MemoryTracker::PopTag(); }
+
+		MemoryTagScope(const MemoryTagScope&) = delete;
+		MemoryTagScope& operator=(const MemoryTagScope&) = delete;
+	};
+}
+
+#define JERBOA_MEMORY_CONCAT_IMPL(a, b) a##b
+#define JERBOA_MEMORY_CONCAT(a, b) JERBOA_MEMORY_CONCAT_IMPL(a, b)
+
+#ifdef JERBOA_MEMORY_TRACKING
+	#define JERBOA_MEMORY_TAG(tag) ::Jerboa::MemoryTagScope JERBOA_MEMORY_CONCAT(memoryTag, __LINE__)(::Jerboa::MemoryTag::tag)
+#else
+	#define JERBOA_MEMORY_TAG(tag)
+#endif
@@ -0,0 +1,96 @@
+#include "jerboa-pch.h"
+#include "Profiler.h"
+
+#include <mutex>
+#include <atomic>
+
+namespace Jerboa {
+	struct OpenZone
+	{
+		const char* name;
+		Timestamp start;
+	};
+
+	struct ProfilerData
+	{
+		std::array<ProfileFrame, Profiler::FrameHistory> frames;
+		uint64_t frameIndex = 0;
+		std::mutex mutex;
+		std::atomic<uint32_t> nextTrack{ Profiler::MainTrack + 1 };
+	};
+
+	static ProfilerData sData;
+
+	static thread_local std::vector<OpenZone> tOpenZones;
+	static thread_local uint32_t tTrack = ~0u;
+
+	static inline ProfileFrame& GetFrameSlot(uint64_t frameIndex)
+	{
+		return sData.frames[frameIndex % Profiler::FrameHistory];
+	}
+
+	void Profiler::BeginFrame()
+	{
+		// The thread driving frames is the main track
+		tTrack = MainTrack;
+
+		std::lock_guard<std::mutex> lock(sData.mutex);
+		sData.frameIndex++;
+
+		ProfileFrame& frame = GetFrameSlot(sData.frameIndex);
+		frame.index = sData.frameIndex;
+		frame.start = Time::Now();
+		frame.end = 0;
+		frame.zones.clear();
+	}
+
+	void Profiler::EndFrame()
+	{
+		std::lock_guard<std::mutex> lock(sData.mutex);
+		GetFrameSlot(sData.frameIndex).end = Time::Now();
+	}
+
+	void Profiler::BeginZone(const char* name)
+	{
+		tOpenZones.push_back({ name, Time::Now() });
+	}
+
+	void Profiler::EndZone()
+	{
+		JERBOA_ASSERT(!tOpenZones.empty(), "Profiler::EndZone() without a matching BeginZone()");
+		Timestamp end = Time::Now();
+		OpenZone zone = tOpenZones.back();
+		tOpenZones.pop_back();
+
+		ProfileZone completed = { zone.name, zone.start, end, static_cast<uint32_t>(tOpenZones.size()), GetThreadTrack() };
+
+		std::lock_guard<std::mutex> lock(sData.mutex);
+		GetFrameSlot(sData.frameIndex).zones.push_back(completed);
+	}
+
+	void Profiler::SubmitZone(uint64_t frameIndex, const ProfileZone& zone)
+	{
+		std::lock_guard<std::mutex> lock(sData.mutex);
+		ProfileFrame& frame = GetFrameSlot(frameIndex);
+		if (frame.index == frameIndex)
+			frame.zones.push_back(zone);
+	}
+
+	uint64_t Profiler::GetFrameIndex()
+	{
+		return sData.frameIndex;
+	}
+
+	const ProfileFrame* Profiler::GetFrame(uint64_t frameIndex)
+	{
+		const ProfileFrame& frame = GetFrameSlot(frameIndex);
+		return frame.index == frameIndex ? &frame : nullptr;
+	}
+
+	uint32_t Profiler::GetThreadTrack()
+	{
+		if (tTrack == ~0u)
+			tTrack = sData.nextTrack++;
+		return tTrack;
+	}
+}
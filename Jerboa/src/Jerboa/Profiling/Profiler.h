@@ -0,0 +1,77 @@
+#pragma once
+
+#include "Jerboa/Core/Time.h"
+
+#include <vector>
+#include <array>
+#include <cstdint>
+
+#ifndef JERBOA_RELEASE
+	#define JERBOA_PROFILING_ENABLED
+#endif
+
+namespace Jerboa {
+	struct ProfileZone
+	{
+		// Must point to storage that outlives the frame history, e.g. a string literal
+		const char* name;
+		Timestamp start;
+		Timestamp end;
+		uint32_t depth;
+		uint32_t track;
+	};
+
+	struct ProfileFrame
+	{
+		uint64_t index = 0;
+		Timestamp start = 0;
+		Timestamp end = 0;
+		std::vector<ProfileZone> zones;
+	};
+
+	// Collects nested, named CPU zones per frame on the Time::Now() timeline. Every thread
+	// gets its own track; other sources (the GPU profiler) submit zones on their own track
+	// into the frame they belong to, which may be several frames after it ended.
+	class Profiler
+	{
+	public:
+		static constexpr uint32_t FrameHistory = 8;
+		static constexpr uint32_t MainTrack = 0;
+		static constexpr uint32_t GPUTrack = 0xffff;
+
+		static void BeginFrame();
+		static void EndFrame();
+
+		static void BeginZone(const char* name);
+		static void EndZone();
+
+		// Adds an already measured zone to a frame, dropped if that frame left the history
+		static void SubmitZone(uint64_t frameIndex, const ProfileZone& zone);
+
+		static uint64_t GetFrameIndex();
+		// Returns nullptr if the frame is not in the history (anymore)
+		static const ProfileFrame* GetFrame(uint64_t frameIndex);
+		static uint32_t GetThreadTrack();
+	};
+
+	class ProfileScope
+	{
+	public:
+		ProfileScope(const char* name) { Profiler::BeginZone(name); }
+		~ProfileScope() { Profiler::EndZone(); }
+
+		ProfileScope(const ProfileScope&) = delete;
+		ProfileScope& operator=(const ProfileScope&) = delete;
+	};
+}
+
+#define JERBOA_PROFILE_CONCAT_IMPL(a, b) a##b
+#define JERBOA_PROFILE_CONCAT(a, b) JERBOA_PROFILE_CONCAT_IMPL(a, b)
+
+#ifdef JERBOA_PROFILING_ENABLED
+	#define JERBOA_PROFILE_SCOPE(name) ::Jerboa::ProfileScope JERBOA_PROFILE_CONCAT(profileScope, __LINE__)(name)
+	#define JERBOA_PROFILE_FUNCTION() JERBOA_PROFILE_SCOPE(__func__)
+#else
+	#define JERBOA_PROFILE_SCOPE(name)
+	#define JERBOA_PROFILE_FUNCTION()
+#endif
@@ -0,0 +1,522 @@
+#include "jerboa-pch.h"
+#include "Telemetry.h"
+#include "TelemetryProtocol.h"
+#include "GPUProfiler.h"
+
+#include "Jerboa/Core/Compression.h"
+#include "Jerboa/Core/StringTable.h"
+#include "Jerboa/Core/Time.h"
+
+#include <mutex>
+#include <thread>
+#include <cstring>
+
+#ifdef JERBOA_PLATFORM_LINUX
+	#include <sys/socket.h>
+	#include <sys/un.h>
+	#include <sys/eventfd.h>
+	#include <netinet/in.h>
+	#include <netinet/tcp.h>
+	#include <arpa/inet.h>
+	#include <poll.h>
+	#include <unistd.h>
+#endif
+
+namespace Jerboa {
+	std::atomic<bool> Telemetry::sConnected{ false };
+
+	// Lets the streaming thread flip the flag IsConnected() reads
+	struct TelemetryConnectionState
+	{
+		static void Set(bool connected) { Telemetry::sConnected.store(connected, std::memory_order_release); }
+	};
+
+	namespace {
+		// Blocks are compressed in pieces of at most this much raw data
+		constexpr size_t MaxRawBlockSize = 1024 * 1024;
+		// The thread is woken up early once this much waits, before a frame burst fills the queue
+		constexpr size_t EarlyFlushSize = 256 * 1024;
+		// Log lines held for the next frame, a flood beyond this is counted as dropped
+		constexpr size_t MaxPendingLogLines = 8192;
+
+		struct Batch
+		{
+			uint64_t connection;
+			std::vector<uint8_t> data;
+		};
+
+		struct LogLine
+		{
+			uint8_t level;
+			// Interned, stays valid until exit
+			const char* logger;
+			Timestamp time;
+			std::string text;
+		};
+
+		struct NameEntry
+		{
+			uint32_t id;
+			// Zone names may point into memory that is reused later, e.g. a destroyed layer's name
+			std::string name;
+		};
+
+		struct TelemetryData
+		{
+			Telemetry::Settings settings;
+			std::thread thread;
+			bool running = false;
+			int listener = -1;
+			// Wakes the thread up for new batches and for shutdown
+			int wakeUp = -1;
+			std::atomic<bool> stopping{ false };
+
+			// Incremented by the thread for every accepted viewer, batches for older ones are dropped
+			std::atomic<uint64_t> connection{ 0 };
+			std::atomic<Timestamp> baseTime{ 0 };
+
+			std::mutex mutex;
+			std::vector<Batch> queue;
+			size_t queuedBytes = 0;
+			std::vector<std::vector<uint8_t>> freeBuffers;
+			Telemetry::Statistics stats;
+
+			// Written from any thread while connected
+			std::mutex pendingMutex;
+			std::unordered_map<const char*, double> counters;
+			std::vector<LogLine> logLines;
+			uint64_t droppedRecords = 0;
+
+			// Main thread encoding state, reset for every connection
+			uint64_t encodedConnection = 0;
+			Timestamp encodedBaseTime = 0;
+			uint64_t lastStreamedFrame = 0;
+			std::unordered_map<const char*, NameEntry> names;
+			uint32_t nextNameId = 1;
+			std::unordered_map<const char*, double> encodingCounters;
+			std::vector<LogLine> encodingLogLines;
+		};
+
+		TelemetryData sData;
+
+		uint32_t GetNameId(TelemetryWriter& writer, const char* name)
+		{
+			auto it = sData.names.find(name);
+			if (it != sData.names.end() && it->second.name == name)
+				return it->second.id;
+
+			uint32_t id = sData.nextNameId++;
+			sData.names[name] = { id, name };
+			writer.WriteRecord(TelemetryRecord::String);
+			writer.WriteVarint(id);
+			writer.WriteString(name);
+			return id;
+		}
+
+		void EncodeFrame(TelemetryWriter& writer, const ProfileFrame& frame)
+		{
+			writer.WriteRecord(TelemetryRecord::Frame);
+			writer.WriteVarint(frame.index);
+			writer.WriteSigned(static_cast<int64_t>(frame.start - sData.encodedBaseTime));
+			writer.WriteVarint(frame.end - frame.start);
+
+			for (const ProfileZone& zone : frame.zones) {
+				uint32_t nameId = GetNameId(writer, zone.name);
+				writer.WriteRecord(TelemetryRecord::Zone);
+				writer.WriteVarint(nameId);
+				writer.WriteVarint(zone.track);
+				writer.WriteVarint(zone.depth);
+				// GPU zones can start before the CPU frame did
+				writer.WriteSigned(static_cast<int64_t>(zone.start - frame.start));
+				writer.WriteVarint(zone.end - zone.start);
+			}
+		}
+
+#ifdef JERBOA_PLATFORM_LINUX
+		bool SendAll(int socket, const void* data, size_t size)
+		{
+			const uint8_t* bytes = static_cast<const uint8_t*>(data);
+			while (size > 0) {
+				ssize_t sent = send(socket, bytes, size, MSG_NOSIGNAL);
+				if (sent < 0 && errno == EINTR)
+					continue;
+				if (sent <= 0)
+					return false;
+				bytes += sent;
+				size -= (size_t)sent;
+			}
+			return true;
+		}
+
+		int Listen(const Telemetry::Settings& settings)
+		{
+			int listener;
+			if (settings.tcpPort != 0) {
+				listener = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+				if (listener < 0)
+					return -1;
+				int reuse = 1;
+				setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+				sockaddr_in address = {};
+				address.sin_family = AF_INET;
+				address.sin_port = htons(settings.tcpPort);
+				// Telemetry reveals a lot about the process, never listen beyond this host
+				address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+				if (bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(listener, 1) != 0) {
+					close(listener);
+					return -1;
+				}
+				return listener;
+			}
+
+			sockaddr_un address = {};
+			address.sun_family = AF_UNIX;
+			if (settings.socketPath.empty() || settings.socketPath.size() >= sizeof(address.sun_path))
+				return -1;
+			std::memcpy(address.sun_path, settings.socketPath.c_str(), settings.socketPath.size() + 1);
+
+			listener = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+			if (listener < 0)
+				return -1;
+			// A crashed run leaves its socket file behind
+			unlink(settings.socketPath.c_str());
+			if (bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(listener, 1) != 0) {
+				close(listener);
+				return -1;
+			}
+			return listener;
+		}
+
+		int Accept()
+		{
+			int client = accept4(sData.listener, nullptr, nullptr, SOCK_CLOEXEC);
+			if (client < 0)
+				return -1;
+			if (sData.settings.tcpPort != 0) {
+				// Blocks are written whole, no need to wait for more
+				int noDelay = 1;
+				setsockopt(client, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+			}
+
+			TelemetryHello hello = {};
+			hello.magic = TelemetryMagic;
+			hello.version = TelemetryVersion;
+			hello.processId = (uint32_t)getpid();
+			hello.baseTime = Time::Now();
+			if (!SendAll(client, &hello, sizeof(hello))) {
+				close(client);
+				return -1;
+			}
+
+			sData.baseTime.store(hello.baseTime, std::memory_order_relaxed);
+			sData.connection.fetch_add(1, std::memory_order_release);
+			{
+				std::lock_guard<std::mutex> lock(sData.mutex);
+				sData.stats.connections++;
+			}
+			TelemetryConnectionState::Set(true);
+			JERBOA_LOG_INFO("Telemetry viewer attached");
+			return client;
+		}
+
+		void Disconnect(int& client)
+		{
+			TelemetryConnectionState::Set(false);
+			close(client);
+			client = -1;
+
+			std::lock_guard<std::mutex> lock(sData.mutex);
+			for (Batch& batch : sData.queue)
+				sData.freeBuffers.push_back(std::move(batch.data));
+			sData.queue.clear();
+			sData.queuedBytes = 0;
+		}
+
+		// Compresses and sends the queued batches of the current connection, false once the viewer is gone
+		bool SendBatches(int client, std::vector<Batch>& batches, std::vector<uint8_t>& raw, std::vector<uint8_t>& compressed)
+		{
+			const uint64_t connection = sData.connection.load(std::memory_order_relaxed);
+			size_t next = 0;
+			bool connected = true;
+			while (connected && next < batches.size()) {
+				// Several frames per block compress better and take fewer syscalls
+				raw.clear();
+				for (; next < batches.size() && (raw.empty() || raw.size() + batches[next].data.size() <= MaxRawBlockSize); next++) {
+					if (batches[next].connection == connection)
+						raw.insert(raw.end(), batches[next].data.begin(), batches[next].data.end());
+				}
+				if (raw.empty())
+					continue;
+
+				compressed.resize(sizeof(TelemetryBlockHeader) + Compression::GetMaxCompressedSize(raw.size()));
+				size_t storedSize = Compression::Compress(raw.data(), raw.size(), compressed.data() + sizeof(TelemetryBlockHeader), raw.size() - 1);
+				if (storedSize == 0) {
+					std::memcpy(compressed.data() + sizeof(TelemetryBlockHeader), raw.data(), raw.size());
+					storedSize = raw.size();
+				}
+				TelemetryBlockHeader header = { (uint32_t)raw.size(), (uint32_t)storedSize };
+				std::memcpy(compressed.data(), &header, sizeof(header));
+				connected = SendAll(client, compressed.data(), sizeof(header) + storedSize);
+
+				std::lock_guard<std::mutex> lock(sData.mutex);
+				sData.stats.sentBlocks++;
+				sData.stats.rawBytes += raw.size();
+				sData.stats.sentBytes += sizeof(header) + storedSize;
+			}
+
+			std::lock_guard<std::mutex> lock(sData.mutex);
+			for (Batch& batch : batches)
+				sData.freeBuffers.push_back(std::move(batch.data));
+			batches.clear();
+			return connected;
+		}
+
+		void StreamLoop()
+		{
+			int client = -1;
+			std::vector<Batch> batches;
+			std::vector<uint8_t> raw, compressed;
+
+			while (!sData.stopping.load(std::memory_order_relaxed)) {
+				// The viewer never sends anything, readable means it hung up
+				pollfd descriptors[2] = { { client < 0 ? sData.listener : client, POLLIN, 0 }, { sData.wakeUp, POLLIN, 0 } };
+				if (poll(descriptors, 2, client < 0 ? -1 : (int)sData.settings.flushIntervalMs) < 0 && errno != EINTR)
+					break;
+
+				if (descriptors[1].revents & POLLIN) {
+					uint64_t value;
+					if (read(sData.wakeUp, &value, sizeof(value)) < 0 && errno != EAGAIN)
+						break;
+				}
+
+				if (client < 0) {
+					if (descriptors[0].revents & POLLIN)
+						client = Accept();
+					continue;
+				}
+
+				if (descriptors[0].revents & (POLLIN | POLLHUP | POLLERR)) {
+					Disconnect(client);
+					JERBOA_LOG_INFO("Telemetry viewer detached");
+					continue;
+				}
+
+				{
+					std::lock_guard<std::mutex> lock(sData.mutex);
+					batches.swap(sData.queue);
+					sData.queuedBytes = 0;
+				}
+				if (!SendBatches(client, batches, raw, compressed)) {
+					Disconnect(client);
+					JERBOA_LOG_INFO("Telemetry viewer detached");
+				}
+			}
+
+			if (client >= 0)
+				Disconnect(client);
+		}
+#endif
+
+		class TelemetryLogSink : public spdlog::sinks::sink
+		{
+		public:
+			void log(const spdlog::details::log_msg& message) override
+			{
+				if (!Telemetry::IsConnected())
+					return;
+
+				const Timestamp now = Time::Now();
+				const char* logger = StringTable::GetCString(StringTable::Intern(std::string_view(message.logger_name.data(), message.logger_name.size())));
+				std::lock_guard<std::mutex> lock(sData.pendingMutex);
+				if (sData.logLines.size() >= MaxPendingLogLines) {
+					sData.droppedRecords++;
+					return;
+				}
+				sData.logLines.push_back({ static_cast<uint8_t>(message.level), logger, now, std::string(message.payload.data(), message.payload.size()) });
+			}
+
+			void flush() override {}
+			// Lines are sent unformatted, the viewer lays them out
+			void set_pattern(const std::string&) override {}
+			void set_formatter(std::unique_ptr<spdlog::formatter>) override {}
+		};
+	}
+
+	void Telemetry::Init()
+	{
+		Init(Settings());
+	}
+
+	void Telemetry::Init(const Settings& settings)
+	{
+		JERBOA_ASSERT(!sData.running, "Telemetry is already initialized");
+		sData.settings = settings;
+		sData.stats = Statistics();
+
+#ifdef JERBOA_PLATFORM_LINUX
+		sData.listener = Listen(settings);
+		sData.wakeUp = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+		if (sData.listener < 0 || sData.wakeUp < 0) {
+			if (settings.tcpPort != 0)
+				JERBOA_LOG_WARN("Telemetry disabled, could not listen on 127.0.0.1:{} ({})", settings.tcpPort, std::strerror(errno));
+			else
+				JERBOA_LOG_WARN("Telemetry disabled, could not listen on \"{}\" ({})", settings.socketPath, std::strerror(errno));
+			Shutdown();
+			return;
+		}
+
+		sData.stopping = false;
+		sData.running = true;
+		sData.thread = std::thread(StreamLoop);
+		if (settings.tcpPort != 0)
+			JERBOA_LOG_INFO("Telemetry waiting for a viewer on 127.0.0.1:{}", settings.tcpPort);
+		else
+			JERBOA_LOG_INFO("Telemetry waiting for a viewer on \"{}\"", settings.socketPath);
+#else
+		JERBOA_LOG_WARN("Telemetry is only supported on Linux");
+#endif
+	}
+
+	void Telemetry::Shutdown()
+	{
+#ifdef JERBOA_PLATFORM_LINUX
+		if (sData.thread.joinable()) {
+			sData.stopping = true;
+			uint64_t value = 1;
+			if (write(sData.wakeUp, &value, sizeof(value)) != sizeof(value))
+				JERBOA_LOG_WARN("Could not wake up the Telemetry thread");
+			sData.thread.join();
+		}
+		if (sData.listener >= 0) {
+			close(sData.listener);
+			if (sData.settings.tcpPort == 0)
+				unlink(sData.settings.socketPath.c_str());
+		}
+		if (sData.wakeUp >= 0)
+			close(sData.wakeUp);
+#endif
+		sData.listener = -1;
+		sData.wakeUp = -1;
+		sData.running = false;
+		TelemetryConnectionState::Set(false);
+
+		std::lock_guard<std::mutex> lock(sData.mutex);
+		sData.queue.clear();
+		sData.queuedBytes = 0;
+		sData.freeBuffers.clear();
+	}
+
+	bool Telemetry::IsRunning()
+	{
+		return sData.running;
+	}
+
+	void Telemetry::EndFrame()
+	{
+		if (!IsConnected())
+			return;
+
+		const uint64_t connection = sData.connection.load(std::memory_order_acquire);
+		if (connection != sData.encodedConnection) {
+			sData.encodedConnection = connection;
+			sData.encodedBaseTime = sData.baseTime.load(std::memory_order_relaxed);
+			sData.lastStreamedFrame = 0;
+			sData.names.clear();
+			sData.nextNameId = 1;
+		}
+
+		std::vector<uint8_t> data;
+		{
+			std::lock_guard<std::mutex> lock(sData.mutex);
+			if (sData.queue.size() >= sData.settings.maxQueuedBatches) {
+				sData.stats.droppedBatches++;
+				return;
+			}
+			if (!sData.freeBuffers.empty()) {
+				data = std::move(sData.freeBuffers.back());
+				sData.freeBuffers.pop_back();
+				data.clear();
+			}
+		}
+
+		uint64_t droppedRecords;
+		{
+			std::lock_guard<std::mutex> lock(sData.pendingMutex);
+			sData.encodingCounters.swap(sData.counters);
+			sData.encodingLogLines.swap(sData.logLines);
+			droppedRecords = sData.droppedRecords;
+			sData.droppedRecords = 0;
+		}
+
+		TelemetryWriter writer(data);
+		// Same frame as the profiler panel, by then its GPU zones arrived
+		const uint64_t frameIndex = Profiler::GetFrameIndex();
+		const uint64_t shownIndex = frameIndex > GPUProfiler::MaxFramesInFlight ? frameIndex - GPUProfiler::MaxFramesInFlight : 0;
+		const ProfileFrame* frame = Profiler::GetFrame(shownIndex);
+		if (frame && frame->end != 0 && shownIndex > sData.lastStreamedFrame) {
+			EncodeFrame(writer, *frame);
+			sData.lastStreamedFrame = shownIndex;
+		}
+
+		for (const auto& [name, value] : sData.encodingCounters) {
+			uint32_t nameId = GetNameId(writer, name);
+			writer.WriteRecord(TelemetryRecord::Counter);
+			writer.WriteVarint(frameIndex);
+			writer.WriteVarint(nameId);
+			writer.WriteDouble(value);
+		}
+		sData.encodingCounters.clear();
+
+		for (const LogLine& line : sData.encodingLogLines) {
+			uint32_t loggerId = GetNameId(writer, line.logger);
+			writer.WriteRecord(TelemetryRecord::Log);
+			writer.WriteByte(line.level);
+			writer.WriteVarint(loggerId);
+			writer.WriteSigned(static_cast<int64_t>(line.time - sData.encodedBaseTime));
+			writer.WriteString(line.text);
+		}
+		sData.encodingLogLines.clear();
+
+		if (droppedRecords > 0) {
+			writer.WriteRecord(TelemetryRecord::Dropped);
+			writer.WriteVarint(droppedRecords);
+		}
+
+		if (data.empty())
+			return;
+		bool flush;
+		{
+			std::lock_guard<std::mutex> lock(sData.mutex);
+			sData.queuedBytes += data.size();
+			sData.queue.push_back({ connection, std::move(data) });
+			flush = sData.queuedBytes >= EarlyFlushSize;
+		}
+		// Otherwise the thread sends at its flush interval, no syscall for most frames
+#ifdef JERBOA_PLATFORM_LINUX
+		uint64_t value = 1;
+		if (flush && write(sData.wakeUp, &value, sizeof(value)) != sizeof(value))
+			JERBOA_LOG_WARN("Could not wake up the Telemetry thread");
+#endif
+	}
+
+	void Telemetry::RecordCounter(const char* name, double value)
+	{
+		if (!IsConnected())
+			return;
+
+		std::lock_guard<std::mutex> lock(sData.pendingMutex);
+		sData.counters[name] = value;
+	}
+
+	std::shared_ptr<spdlog::sinks::sink> Telemetry::CreateLogSink()
+	{
+		return std::make_shared<TelemetryLogSink>();
+	}
+
+	Telemetry::Statistics Telemetry::GetStats()
+	{
+		std::lock_guard<std::mutex> lock(sData.mutex);
+		return sData.stats;
+	}
+}
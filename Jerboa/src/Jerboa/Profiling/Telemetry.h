@@ -0,0 +1,73 @@
+#pragma once
+
+#include "Profiler.h"
+
+#include "spdlog/sinks/sink.h"
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <cstdint>
+
+namespace Jerboa {
+	// Streams the profiler's frames and zones, counters and log lines to an out-of-process
+	// viewer (JerboaViewer) over a local socket, see TelemetryProtocol.h. One viewer at a time
+	// can attach and detach while the application runs. The main thread encodes a batch per
+	// frame, a background thread owns the sockets and sends the collected batches compressed.
+	// While no viewer is attached, recording costs one relaxed atomic load per call.
+	class Telemetry
+	{
+	public:
+		struct Settings
+		{
+			// Unix domain socket the viewer connects to, used unless tcpPort is set
+			std::string socketPath = "/tmp/jerboa-telemetry.sock";
+			// Listens on 127.0.0.1 at this port instead
+			uint16_t tcpPort = 0;
+			// Frames are collected for this long and sent as one block, larger blocks compress better
+			uint32_t flushIntervalMs = 50;
+			// Frames waiting for the background thread, a slow viewer drops frames beyond this
+			uint32_t maxQueuedBatches = 256;
+		};
+
+		struct Statistics
+		{
+			uint64_t connections = 0;
+			uint64_t sentBlocks = 0;
+			uint64_t rawBytes = 0;
+			uint64_t sentBytes = 0;
+			// Batches dropped because the queue was full
+			uint64_t droppedBatches = 0;
+		};
+
+		static void Init();
+		static void Init(const Settings& settings);
+		static void Shutdown();
+
+		static bool IsRunning();
+		inline static bool IsConnected() { return sConnected.load(std::memory_order_relaxed); }
+
+		// Main thread, after Profiler::EndFrame(). Streams the frame the profiler panel shows,
+		// the GPU zones of the newest frames are still in flight.
+		static void EndFrame();
+
+		// Sampled once per frame, the last value recorded in a frame is sent. The name must
+		// outlive the application, e.g. a string literal. Thread safe.
+		static void RecordCounter(const char* name, double value);
+
+		// Forwards log lines while a viewer is attached, Log::Init() adds it to every logger
+		static std::shared_ptr<spdlog::sinks::sink> CreateLogSink();
+
+		static Statistics GetStats();
+	private:
+		friend struct TelemetryConnectionState;
+
+		static std::atomic<bool> sConnected;
+	};
+}
+
+#ifdef JERBOA_PROFILING_ENABLED
+	#define JERBOA_TELEMETRY_COUNTER(name, value) do { if (::Jerboa::Telemetry::IsConnected()) ::Jerboa::Telemetry::RecordCounter(name, value); } while (0)
+#else
+	#define JERBOA_TELEMETRY_COUNTER(name, value)
+#endif
@@ -0,0 +1,154 @@
+#pragma once
+
+#include <string_view>
+#include <vector>
+#include <cstring>
+#include <cstdint>
+
+// Wire format of the telemetry stream, shared by the engine and JerboaViewer.
+//
+// On connect the engine sends a TelemetryHello, then a stream of blocks: a TelemetryBlockHeader
+// and storedSize bytes, LZ-compressed with Jerboa::Compression unless storedSize equals
+// rawSize. Decompressed, a block is a sequence of records, each a TelemetryRecord byte and its
+// fields. Integers are LEB128 varints, signed ones zigzag encoded, doubles are 8 raw bytes.
+// Names are sent once per connection as String records and referred to by id afterwards.
+namespace Jerboa {
+	constexpr uint32_t TelemetryMagic = 0x4c54424a; // "JBTL"
+	constexpr uint16_t TelemetryVersion = 1;
+	// Larger blocks are rejected by the reader as corrupt
+	constexpr uint32_t TelemetryMaxBlockSize = 4 * 1024 * 1024;
+
+	struct TelemetryHello
+	{
+		uint32_t magic;
+		uint16_t version;
+		uint16_t reserved;
+		uint32_t processId;
+		uint32_t reserved2;
+		// Time::Now() when the connection was accepted, record times are relative to it
+		uint64_t baseTime;
+	};
+
+	struct TelemetryBlockHeader
+	{
+		uint32_t rawSize;
+		uint32_t storedSize;
+	};
+
+	enum class TelemetryRecord : uint8_t
+	{
+		// id, length, bytes
+		String = 1,
+		// index, start (since baseTime), duration. The zones that follow belong to this frame.
+		Frame,
+		// nameId, track, depth, start (signed, since the frame's start), duration
+		Zone,
+		// frame index, nameId, value (double). Counters are sampled at the end of their frame,
+		// which is streamed before the frame's zones are complete.
+		Counter,
+		// level, loggerId, time (since baseTime), length, bytes
+		Log,
+		// count of records the engine could not queue since the previous Dropped record
+		Dropped
+	};
+
+	class TelemetryWriter
+	{
+	public:
+		TelemetryWriter(std::vector<uint8_t>& buffer)
+			: mBuffer(buffer) {}
+
+		inline void WriteRecord(TelemetryRecord record) { mBuffer.push_back(static_cast<uint8_t>(record)); }
+		inline void WriteByte(uint8_t value) { mBuffer.push_back(value); }
+
+		void WriteVarint(uint64_t value)
+		{
+			while (value >= 0x80) {
+				mBuffer.push_back(static_cast<uint8_t>(value) | 0x80);
+				value >>= 7;
+			}
+			mBuffer.push_back(static_cast<uint8_t>(value));
+		}
+
+		inline void WriteSigned(int64_t value) { WriteVarint((static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63)); }
+
+		void WriteDouble(double value)
+		{
+			uint8_t bytes[sizeof(double)];
+			std::memcpy(bytes, &value, sizeof(double));
+			mBuffer.insert(mBuffer.end(), bytes, bytes + sizeof(double));
+		}
+
+		void WriteString(std::string_view string)
+		{
+			WriteVarint(string.size());
+			mBuffer.insert(mBuffer.end(), string.begin(), string.end());
+		}
+	private:
+		std::vector<uint8_t>& mBuffer;
+	};
+
+	// Bounds checked, every read fails once the data ran out or was malformed
+	class TelemetryReader
+	{
+	public:
+		TelemetryReader(const uint8_t* data, size_t size)
+			: mData(data), mEnd(data + size) {}
+
+		inline bool IsAtEnd() const { return mData == mEnd; }
+
+		bool ReadByte(uint8_t& value)
+		{
+			if (mData == mEnd)
+				return false;
+			value = *mData++;
+			return true;
+		}
+
+		bool ReadVarint(uint64_t& value)
+		{
+			value = 0;
+			for (uint32_t shift = 0; shift < 64; shift += 7) {
+				uint8_t byte;
+				if (!ReadByte(byte))
+					return false;
+				value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+				if ((byte & 0x80) == 0)
+					return true;
+			}
+			return false;
+		}
+
+		bool ReadSigned(int64_t& value)
+		{
+			uint64_t encoded;
+			if (!ReadVarint(encoded))
+				return false;
+			value = static_cast<int64_t>(encoded >> 1) ^ -static_cast<int64_t>(encoded & 1);
+			return true;
+		}
+
+		bool ReadDouble(double& value)
+		{
+			if ((size_t)(mEnd - mData) < sizeof(double))
+				return false;
+			std::memcpy(&value, mData, sizeof(double));
+			mData += sizeof(double);
+			return true;
+		}
+
+		// The view points into the block
+		bool ReadString(std::string_view& string)
+		{
+			uint64_t length;
+			if (!ReadVarint(length) || length > (uint64_t)(mEnd - mData))
+				return false;
+			string = std::string_view(reinterpret_cast<const char*>(mData), (size_t)length);
+			mData += length;
+			return true;
+		}
+	private:
+		const uint8_t* mData;
+		const uint8_t* mEnd;
+	};
+}
@@ -0,0 +1,232 @@
+#include "jerboa-pch.h"
+#include "Framebuffer.h"
+
+#include "GLStateCache.h"
+
+#include "glad/glad.h"
+
+namespace Jerboa {
+	namespace {
+		bool IsDepthFormat(FramebufferFormat format)
+		{
+			return format == FramebufferFormat::Depth24Stencil8;
+		}
+
+		void GetTextureFormat(FramebufferFormat format, GLenum& internalFormat, GLenum& dataFormat, GLenum& type)
+		{
+			switch (format) {
+			case FramebufferFormat::RGBA8:
+				internalFormat = GL_RGBA8; dataFormat = GL_RGBA; type = GL_UNSIGNED_BYTE;
+				return;
+			case FramebufferFormat::RGBA16F:
+				internalFormat = GL_RGBA16F; dataFormat = GL_RGBA; type = GL_FLOAT;
+				return;
+			case FramebufferFormat::RedInteger:
+				internalFormat = GL_R32I; dataFormat = GL_RED_INTEGER; type = GL_INT;
+				return;
+			case FramebufferFormat::Depth24Stencil8:
+				internalFormat = GL_DEPTH24_STENCIL8; dataFormat = GL_DEPTH_STENCIL; type = GL_UNSIGNED_INT_24_8;
+				return;
+			default:
+				JERBOA_ASSERT(false, "Unknown framebuffer format");
+				internalFormat = GL_RGBA8; dataFormat = GL_RGBA; type = GL_UNSIGNED_BYTE;
+				return;
+			}
+		}
+
+		uint32_t CreateAttachmentTexture(FramebufferFormat format, uint32_t width, uint32_t height)
+		{
+			GLenum internalFormat, dataFormat, type;
+			GetTextureFormat(format, internalFormat, dataFormat, type);
+
+			uint32_t texture;
+			glGenTextures(1, &texture);
+			GLStateCache::BindTexture2D(0, texture);
+			glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, dataFormat, type, nullptr);
+
+			// Integer textures can't be filtered
+			GLenum filter = format == FramebufferFormat::RedInteger ? GL_NEAREST : GL_LINEAR;
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+			return texture;
+		}
+	}
+
+	Framebuffer::Framebuffer(const FramebufferSpecification& spec)
+		: mSpec(spec)
+	{
+		for (FramebufferFormat format : spec.attachments) {
+			if (IsDepthFormat(format)) {
+				JERBOA_ASSERT(mDepthFormat == FramebufferFormat::None, "Framebuffer can only have one depth attachment");
+				mDepthFormat = format;
+			}
+			else if (format != FramebufferFormat::None) {
+				mColorFormats.push_back(format);
+			}
+		}
+		JERBOA_ASSERT(mColorFormats.size() <= MaxColorAttachments, "Too many framebuffer color attachments");
+		JERBOA_ASSERT(mSpec.sizeGranularity > 0, "Framebuffer size granularity must be positive");
+
+		Resize(spec.width, spec.height);
+	}
+
+	Framebuffer::~Framebuffer()
+	{
+		Release();
+	}
+
+	void Framebuffer::Bind()
+	{
+		if (!mBound)
+			GLStateCache::GetViewport(mPreviousViewport);
+
+		mBound = true;
+		GLStateCache::BindFramebuffer(mRendererID);
+		GLStateCache::SetViewport(0, 0, mWidth, mHeight);
+	}
+
+	void Framebuffer::Unbind()
+	{
+		GLStateCache::BindFramebuffer(0);
+		if (mBound)
+			GLStateCache::SetViewport(mPreviousViewport[0], mPreviousViewport[1], mPreviousViewport[2], mPreviousViewport[3]);
+		mBound = false;
+	}
+
+	void Framebuffer::Resize(uint32_t width, uint32_t height)
+	{
+		if (width == 0 || height == 0 || width > MaxSize || height > MaxSize) {
+			JERBOA_LOG_WARN("Ignoring framebuffer resize to {}x{}", width, height);
+			return;
+		}
+
+		mWidth = width;
+		mHeight = height;
+
+		// Grow as soon as the image doesn't fit, shrink only once the allocation is more
+		// than twice as large as needed so that dragging a window edge back and forth
+		// doesn't reallocate
+		uint32_t allocatedWidth = RoundToGranularity(width);
+		uint32_t allocatedHeight = RoundToGranularity(height);
+		bool grow = allocatedWidth > mAllocatedWidth || allocatedHeight > mAllocatedHeight;
+		bool shrink = allocatedWidth * 2 < mAllocatedWidth || allocatedHeight * 2 < mAllocatedHeight;
+		if (mRendererID == 0 || grow || shrink)
+			Allocate(allocatedWidth, allocatedHeight);
+
+		if (mBound)
+			GLStateCache::SetViewport(0, 0, mWidth, mHeight);
+	}
+
+	void Framebuffer::ClearAttachment(uint32_t index, int value)
+	{
+		JERBOA_ASSERT(index < mColorFormats.size() && mColorFormats[index] == FramebufferFormat::RedInteger, "Attachment is not an integer attachment");
+
+		GLStateCache::BindFramebuffer(mRendererID);
+		glClearBufferiv(GL_COLOR, index, &value);
+	}
+
+	void Framebuffer::ClearAttachment(uint32_t index, const float* rgba)
+	{
+		JERBOA_ASSERT(index < mColorFormats.size() && mColorFormats[index] != FramebufferFormat::RedInteger, "Attachment is not a float attachment");
+
+		GLStateCache::BindFramebuffer(mRendererID);
+		glClearBufferfv(GL_COLOR, index, rgba);
+	}
+
+	void Framebuffer::ClearDepthStencil(float depth, int stencil)
+	{
+		JERBOA_ASSERT(mDepthFormat != FramebufferFormat::None, "Framebuffer has no depth attachment");
+
+		// glClearBuffer ignores the color mask but honors the depth mask
+		GLStateCache::SetDepthMask(true);
+		GLStateCache::BindFramebuffer(mRendererID);
+		glClearBufferfi(GL_DEPTH_STENCIL, 0, depth, stencil);
+	}
+
+	int Framebuffer::ReadPixel(uint32_t index, uint32_t x, uint32_t y)
+	{
+		JERBOA_ASSERT(index < mColorFormats.size() && mColorFormats[index] == FramebufferFormat::RedInteger, "Attachment is not an integer attachment");
+		if (x >= mWidth || y >= mHeight)
+			return -1;
+
+		GLStateCache::BindFramebuffer(mRendererID);
+		glReadBuffer(GL_COLOR_ATTACHMENT0 + index);
+		int value = -1;
+		glReadPixels(x, y, 1, 1, GL_RED_INTEGER, GL_INT, &value);
+		return value;
+	}
+
+	void Framebuffer::Allocate(uint32_t width, uint32_t height)
+	{
+		Release();
+
+		mAllocatedWidth = width;
+		mAllocatedHeight = height;
+		mReallocationCount++;
+
+		glGenFramebuffers(1, &mRendererID);
+		GLStateCache::BindFramebuffer(mRendererID);
+
+		for (size_t i = 0; i < mColorFormats.size(); i++) {
+			uint32_t texture = CreateAttachmentTexture(mColorFormats[i], width, height);
+			glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + (GLenum)i, GL_TEXTURE_2D, texture, 0);
+			mColorAttachments.push_back(texture);
+		}
+
+		if (mDepthFormat != FramebufferFormat::None) {
+			mDepthAttachment = CreateAttachmentTexture(mDepthFormat, width, height);
+			glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, mDepthAttachment, 0);
+		}
+
+		if (mColorAttachments.empty()) {
+			glDrawBuffer(GL_NONE);
+		}
+		else {
+			GLenum drawBuffers[MaxColorAttachments];
+			for (uint32_t i = 0; i < mColorAttachments.size(); i++)
+				drawBuffers[i] = GL_COLOR_ATTACHMENT0 + i;
+			glDrawBuffers((GLsizei)mColorAttachments.size(), drawBuffers);
+		}
+
+		[[maybe_unused]] GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+		JERBOA_ASSERT(status == GL_FRAMEBUFFER_COMPLETE, "Framebuffer is incomplete");
+
+		if (!mBound)
+			GLStateCache::BindFramebuffer(0);
+	}
+
+	void Framebuffer::Release()
+	{
+		if (mRendererID == 0)
+			return;
+
+		for (uint32_t texture : mColorAttachments)
+			GLStateCache::OnTextureDeleted(texture);
+		glDeleteTextures((GLsizei)mColorAttachments.size(), mColorAttachments.data());
+		mColorAttachments.clear();
+
+		if (mDepthAttachment) {
+			GLStateCache::OnTextureDeleted(mDepthAttachment);
+			glDeleteTextures(1, &mDepthAttachment);
+			mDepthAttachment = 0;
+		}
+
+		GLStateCache::OnFramebufferDeleted(mRendererID);
+		glDeleteFramebuffers(1, &mRendererID);
+		mRendererID = 0;
+	}
+
+	uint32_t Framebuffer::RoundToGranularity(uint32_t size) const
+	{
+		uint32_t granularity = mSpec.sizeGranularity;
+		uint32_t rounded = (size + granularity - 1) / granularity * granularity;
+		return rounded < MaxSize ? rounded : MaxSize;
+	}
+
+	std::shared_ptr<Framebuffer> Framebuffer::Create(const FramebufferSpecification& spec)
+	{
+		return std::make_shared<Framebuffer>(spec);
+	}
+}
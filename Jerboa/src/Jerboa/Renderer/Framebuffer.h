@@ -0,0 +1,88 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <cstdint>
+
+namespace Jerboa {
+	enum class FramebufferFormat
+	{
+		None = 0,
+		RGBA8,
+		RGBA16F,
+		RedInteger,
+		Depth24Stencil8
+	};
+
+	struct FramebufferSpecification
+	{
+		uint32_t width = 1280;
+		uint32_t height = 720;
+		std::vector<FramebufferFormat> attachments = { FramebufferFormat::RGBA8, FramebufferFormat::Depth24Stencil8 };
+		// Attachments are allocated in steps of this many pixels so that interactive
+		// resizing only reallocates when the size leaves the current allocation
+		uint32_t sizeGranularity = 128;
+	};
+
+	// Offscreen render target. Its logical size may be smaller than the allocated
+	// attachments, GetUVMax() gives the part of the color textures that holds the image.
+	class Framebuffer
+	{
+	public:
+		static constexpr uint32_t MaxColorAttachments = 4;
+		static constexpr uint32_t MaxSize = 8192;
+
+		Framebuffer(const FramebufferSpecification& spec);
+		~Framebuffer();
+
+		Framebuffer(const Framebuffer&) = delete;
+		Framebuffer& operator=(const Framebuffer&) = delete;
+
+		// Binds the framebuffer and sets the viewport to its logical size, Unbind()
+		// restores the default framebuffer and the previous viewport
+		void Bind();
+		void Unbind();
+
+		// Cheap when the new size fits the current allocation
+		void Resize(uint32_t width, uint32_t height);
+
+		void ClearAttachment(uint32_t index, int value);
+		void ClearAttachment(uint32_t index, const float* rgba);
+		void ClearDepthStencil(float depth = 1.0f, int stencil = 0);
+		// Only valid for RedInteger attachments, coordinates are in logical pixels
+		int ReadPixel(uint32_t index, uint32_t x, uint32_t y);
+
+		inline uint32_t GetWidth() const { return mWidth; }
+		inline uint32_t GetHeight() const { return mHeight; }
+		inline uint32_t GetAllocatedWidth() const { return mAllocatedWidth; }
+		inline uint32_t GetAllocatedHeight() const { return mAllocatedHeight; }
+		inline float GetUVMaxX() const { return mAllocatedWidth ? (float)mWidth / mAllocatedWidth : 0.0f; }
+		inline float GetUVMaxY() const { return mAllocatedHeight ? (float)mHeight / mAllocatedHeight : 0.0f; }
+		inline uint32_t GetColorAttachmentCount() const { return (uint32_t)mColorAttachments.size(); }
+		inline uint32_t GetColorAttachment(uint32_t index = 0) const { return mColorAttachments[index]; }
+		inline uint32_t GetDepthAttachment() const { return mDepthAttachment; }
+		inline uint32_t GetRendererID() const { return mRendererID; }
+		inline uint32_t GetReallocationCount() const { return mReallocationCount; }
+
+		static std::shared_ptr<Framebuffer> Create(const FramebufferSpecification& spec);
+	private:
+		void Allocate(uint32_t width, uint32_t height);
+		void Release();
+		uint32_t RoundToGranularity(uint32_t size) const;
+
+		FramebufferSpecification mSpec;
+		std::vector<FramebufferFormat> mColorFormats;
+		FramebufferFormat mDepthFormat = FramebufferFormat::None;
+
+		uint32_t mRendererID = 0;
+		std::vector<uint32_t> mColorAttachments;
+		uint32_t mDepthAttachment = 0;
+
+		uint32_t mWidth = 0, mHeight = 0;
+		uint32_t mAllocatedWidth = 0, mAllocatedHeight = 0;
+		uint32_t mReallocationCount = 0;
+
+		bool mBound = false;
+		int mPreviousViewport[4] = {};
+	};
+}
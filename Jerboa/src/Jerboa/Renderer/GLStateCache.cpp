@@ -0,0 +1,368 @@
+#include "jerboa-pch.h"
+#include "GLStateCache.h"
+
+#include "glad/glad.h"
+
+namespace Jerboa {
+	static constexpr uint32_t sUnknown = ~0u;
+	static constexpr uint32_t sMaxTextureSlots = 32;
+
+	// Tri-state flags, -1 is unknown
+	struct CachedCapability
+	{
+		int enabled = -1;
+	};
+
+	struct GLState
+	{
+		uint32_t program = sUnknown;
+		uint32_t vertexArray = sUnknown;
+		uint32_t arrayBuffer = sUnknown;
+		uint32_t elementArrayBuffer = sUnknown;
+		uint32_t uniformBuffer = sUnknown;
+		uint32_t framebuffer = sUnknown;
+		uint32_t activeTexture = sUnknown;
+		uint32_t textures2D[sMaxTextureSlots];
+
+		CachedCapability blend, depthTest, cullFace, scissorTest;
+		int depthMask = -1;
+		uint32_t blendSource = sUnknown, blendDestination = sUnknown;
+		uint32_t depthFunc = sUnknown;
+
+		bool viewportKnown = false;
+		int viewport[4] = {};
+		bool clearColorKnown = false;
+		float clearColor[4] = {};
+
+		GLState()
+		{
+			for (uint32_t& texture : textures2D)
+				texture = sUnknown;
+		}
+	};
+
+	struct ContextState
+	{
+		const void* context = nullptr;
+		uint32_t id = 0;
+		GLState state;
+	};
+
+	// Until a window makes its context current everything goes to the first entry
+	static std::vector<std::unique_ptr<ContextState>> sContexts = []() {
+		std::vector<std::unique_ptr<ContextState>> contexts;
+		contexts.push_back(std::make_unique<ContextState>());
+		return contexts;
+	}();
+	static ContextState* sCurrentContext = sContexts[0].get();
+	static GLState* sState = &sCurrentContext->state;
+	static uint32_t sNextContextId = 1;
+	static GLStateCache::Statistics sCurrentStats, sLastFrameStats;
+	static int sExternalDepth = 0;
+
+#ifdef JERBOA_GL_STATE_STATS_ENABLED
+	#define JERBOA_GL_STATE_ISSUED() sCurrentStats.issued++
+	#define JERBOA_GL_STATE_SKIPPED() sCurrentStats.skipped++
+#else
+	#define JERBOA_GL_STATE_ISSUED()
+	#define JERBOA_GL_STATE_SKIPPED()
+#endif
+
+	// Returns true (and updates the cache) if the call has to be issued
+	template<class T>
+	static inline bool Changes(T& cached, T value)
+	{
+		if (cached == value) {
+			JERBOA_GL_STATE_SKIPPED();
+			return false;
+		}
+		cached = value;
+		JERBOA_GL_STATE_ISSUED();
+		return true;
+	}
+
+	static inline void SetCapability(CachedCapability& cached, GLenum capability, bool enabled)
+	{
+		if (!Changes(cached.enabled, enabled ? 1 : 0))
+			return;
+
+		if (enabled)
+			glEnable(capability);
+		else
+			glDisable(capability);
+	}
+
+	void GLStateCache::UseProgram(uint32_t program)
+	{
+		if (Changes(sState->program, program))
+			glUseProgram(program);
+	}
+
+	void GLStateCache::BindVertexArray(uint32_t vertexArray)
+	{
+		if (Changes(sState->vertexArray, vertexArray)) {
+			glBindVertexArray(vertexArray);
+			sState->elementArrayBuffer = sUnknown;
+		}
+	}
+
+	void GLStateCache::BindBuffer(uint32_t target, uint32_t buffer)
+	{
+		uint32_t* cached = nullptr;
+		switch (target) {
+			case GL_ARRAY_BUFFER: cached = &sState->arrayBuffer; break;
+			case GL_ELEMENT_ARRAY_BUFFER: cached = &sState->elementArrayBuffer; break;
+			case GL_UNIFORM_BUFFER: cached = &sState->uniformBuffer; break;
+		}
+
+		if (!cached) {
+			JERBOA_GL_STATE_ISSUED();
+			glBindBuffer(target, buffer);
+			return;
+		}
+
+		if (Changes(*cached, buffer))
+			glBindBuffer(target, buffer);
+	}
+
+	void GLStateCache::BindTexture2D(uint32_t slot, uint32_t texture)
+	{
+		JERBOA_ASSERT(slot < sMaxTextureSlots, "Texture slot out of range");
+		// Callers edit GL_TEXTURE_2D right after binding, so the slot becomes the active unit
+		// even when the texture is bound there already
+		if (Changes(sState->activeTexture, slot))
+			glActiveTexture(GL_TEXTURE0 + slot);
+
+		if (sState->textures2D[slot] == texture) {
+			JERBOA_GL_STATE_SKIPPED();
+			return;
+		}
+
+		sState->textures2D[slot] = texture;
+		JERBOA_GL_STATE_ISSUED();
+		glBindTexture(GL_TEXTURE_2D, texture);
+	}
+
+	void GLStateCache::BindFramebuffer(uint32_t framebuffer)
+	{
+		if (Changes(sState->framebuffer, framebuffer))
+			glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	}
+
+	void GLStateCache::SetBlend(bool enabled)
+	{
+		SetCapability(sState->blend, GL_BLEND, enabled);
+	}
+
+	void GLStateCache::SetBlendFunc(uint32_t source, uint32_t destination)
+	{
+		if (sState->blendSource == source && sState->blendDestination == destination) {
+			JERBOA_GL_STATE_SKIPPED();
+			return;
+		}
+
+		sState->blendSource = source;
+		sState->blendDestination = destination;
+		JERBOA_GL_STATE_ISSUED();
+		glBlendFunc(source, destination);
+	}
+
+	void GLStateCache::SetDepthTest(bool enabled)
+	{
+		SetCapability(sState->depthTest, GL_DEPTH_TEST, enabled);
+	}
+
+	void GLStateCache::SetDepthMask(bool enabled)
+	{
+		if (Changes(sState->depthMask, enabled ? 1 : 0))
+			glDepthMask(enabled ? GL_TRUE : GL_FALSE);
+	}
+
+	void GLStateCache::SetDepthFunc(uint32_t func)
+	{
+		if (Changes(sState->depthFunc, func))
+			glDepthFunc(func);
+	}
+
+	void GLStateCache::SetCullFace(bool enabled)
+	{
+		SetCapability(sState->cullFace, GL_CULL_FACE, enabled);
+	}
+
+	void GLStateCache::SetScissorTest(bool enabled)
+	{
+		SetCapability(sState->scissorTest, GL_SCISSOR_TEST, enabled);
+	}
+
+	void GLStateCache::SetViewport(int x, int y, int width, int height)
+	{
+		int* viewport = sState->viewport;
+		if (sState->viewportKnown && viewport[0] == x && viewport[1] == y && viewport[2] == width && viewport[3] == height) {
+			JERBOA_GL_STATE_SKIPPED();
+			return;
+		}
+
+		viewport[0] = x; viewport[1] = y; viewport[2] = width; viewport[3] = height;
+		sState->viewportKnown = true;
+		JERBOA_GL_STATE_ISSUED();
+		glViewport(x, y, width, height);
+	}
+
+	void GLStateCache::GetViewport(int* viewport)
+	{
+		if (!sState->viewportKnown) {
+			glGetIntegerv(GL_VIEWPORT, sState->viewport);
+			sState->viewportKnown = true;
+		}
+
+		for (int i = 0; i < 4; i++)
+			viewport[i] = sState->viewport[i];
+	}
+
+	void GLStateCache::SetClearColor(float r, float g, float b, float a)
+	{
+		float* color = sState->clearColor;
+		if (sState->clearColorKnown && color[0] == r && color[1] == g && color[2] == b && color[3] == a) {
+			JERBOA_GL_STATE_SKIPPED();
+			return;
+		}
+
+		color[0] = r; color[1] = g; color[2] = b; color[3] = a;
+		sState->clearColorKnown = true;
+		JERBOA_GL_STATE_ISSUED();
+		glClearColor(r, g, b, a);
+	}
+
+	// Deleting an object only unbinds it in the current context. Other contexts keep the
+	// orphaned object bound until they bind something else, so their binding becomes unknown.
+	template<class Function>
+	static void ForEachContext(Function function)
+	{
+		for (const std::unique_ptr<ContextState>& context : sContexts)
+			function(context->state, context.get() == sCurrentContext ? 0u : sUnknown);
+	}
+
+	void GLStateCache::OnProgramDeleted(uint32_t program)
+	{
+		ForEachContext([program](GLState& state, uint32_t) {
+			if (state.program == program)
+				state.program = sUnknown;
+		});
+	}
+
+	void GLStateCache::OnVertexArrayDeleted(uint32_t vertexArray)
+	{
+		if (sState->vertexArray == vertexArray) {
+			sState->vertexArray = 0;
+			sState->elementArrayBuffer = sUnknown;
+		}
+	}
+
+	void GLStateCache::OnBufferDeleted(uint32_t buffer)
+	{
+		ForEachContext([buffer](GLState& state, uint32_t unbound) {
+			for (uint32_t* cached : { &state.arrayBuffer, &state.elementArrayBuffer, &state.uniformBuffer }) {
+				if (*cached == buffer)
+					*cached = unbound;
+			}
+		});
+	}
+
+	void GLStateCache::OnTextureDeleted(uint32_t texture)
+	{
+		ForEachContext([texture](GLState& state, uint32_t unbound) {
+			for (uint32_t& cached : state.textures2D) {
+				if (cached == texture)
+					cached = unbound;
+			}
+		});
+	}
+
+	void GLStateCache::OnFramebufferDeleted(uint32_t framebuffer)
+	{
+		if (sState->framebuffer == framebuffer)
+			sState->framebuffer = 0;
+	}
+
+	void GLStateCache::MakeContextCurrent(const void* context)
+	{
+		if (sCurrentContext->context == context)
+			return;
+
+		auto it = std::find_if(sContexts.begin(), sContexts.end(), [context](const std::unique_ptr<ContextState>& state) { return state->context == context; });
+		if (it == sContexts.end()) {
+			// The first context takes over the entry used before any was current
+			if (sContexts.size() == 1 && !sContexts[0]->context) {
+				it = sContexts.begin();
+			}
+			else {
+				sContexts.push_back(std::make_unique<ContextState>());
+				it = sContexts.end() - 1;
+			}
+			(*it)->context = context;
+			(*it)->id = sNextContextId++;
+		}
+
+		sCurrentContext = it->get();
+		sState = &sCurrentContext->state;
+	}
+
+	void GLStateCache::OnContextDestroyed(const void* context)
+	{
+		auto it = std::find_if(sContexts.begin(), sContexts.end(), [context](const std::unique_ptr<ContextState>& state) { return state->context == context; });
+		if (it == sContexts.end())
+			return;
+
+		if (sContexts.size() == 1) {
+			// Back to the state of no current context
+			**it = ContextState();
+			return;
+		}
+
+		const bool wasCurrent = it->get() == sCurrentContext;
+		sContexts.erase(it);
+		if (wasCurrent) {
+			// GL has no current context now, the next MakeContextCurrent() picks the right one
+			sCurrentContext = sContexts[0].get();
+			sState = &sCurrentContext->state;
+		}
+	}
+
+	uint32_t GLStateCache::GetContextId()
+	{
+		return sCurrentContext->id;
+	}
+
+	bool GLStateCache::IsContextAlive(uint32_t contextId)
+	{
+		return std::any_of(sContexts.begin(), sContexts.end(), [contextId](const std::unique_ptr<ContextState>& state) { return state->id == contextId; });
+	}
+
+	void GLStateCache::Invalidate()
+	{
+		*sState = GLState();
+	}
+
+	void GLStateCache::BeginExternal()
+	{
+		sExternalDepth++;
+	}
+
+	void GLStateCache::EndExternal()
+	{
+		JERBOA_ASSERT(sExternalDepth > 0, "GLStateCache::EndExternal() without BeginExternal()");
+		if (--sExternalDepth == 0)
+			Invalidate();
+	}
+
+	void GLStateCache::NewFrame()
+	{
+		sLastFrameStats = sCurrentStats;
+		sCurrentStats = Statistics();
+	}
+
+	const GLStateCache::Statistics& GLStateCache::GetStats()
+	{
+		return sLastFrameStats;
+	}
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+
+#ifndef JERBOA_RELEASE
+	#define JERBOA_GL_STATE_STATS_ENABLED
+#endif
+
+namespace Jerboa {
+	// Shadows the GL state of the current context and drops calls that would not change it.
+	// Code that touches GL state behind the cache's back (e.g. the ImGui backend) must be
+	// wrapped in BeginExternal()/EndExternal(), or followed by Invalidate().
+	// Objects deleted through the engine report themselves so that reused names are not
+	// mistaken for the still-bound old object.
+	// Every GL context has its own shadow state, windows switch it with MakeContextCurrent().
+	class GLStateCache
+	{
+	public:
+		struct Statistics
+		{
+			uint32_t issued = 0;
+			uint32_t skipped = 0;
+		};
+
+		static void UseProgram(uint32_t program);
+		static void BindVertexArray(uint32_t vertexArray);
+		// GL_ELEMENT_ARRAY_BUFFER is vertex array state and is only cached per bound VAO
+		static void BindBuffer(uint32_t target, uint32_t buffer);
+		// Also makes slot the active texture unit
+		static void BindTexture2D(uint32_t slot, uint32_t texture);
+		static void BindFramebuffer(uint32_t framebuffer);
+
+		static void SetBlend(bool enabled);
+		static void SetBlendFunc(uint32_t source, uint32_t destination);
+		static void SetDepthTest(bool enabled);
+		static void SetDepthMask(bool enabled);
+		static void SetDepthFunc(uint32_t func);
+		static void SetCullFace(bool enabled);
+		static void SetScissorTest(bool enabled);
+		static void SetViewport(int x, int y, int width, int height);
+		static void SetClearColor(float r, float g, float b, float a);
+		// Queries the driver if the viewport is not known yet
+		static void GetViewport(int* viewport);
+
+		// Programs, buffers and textures are shared between contexts, vertex arrays and
+		// framebuffers only exist in the current one
+		static void OnProgramDeleted(uint32_t program);
+		static void OnVertexArrayDeleted(uint32_t vertexArray);
+		static void OnBufferDeleted(uint32_t buffer);
+		static void OnTextureDeleted(uint32_t texture);
+		static void OnFramebufferDeleted(uint32_t framebuffer);
+
+		// context is the native handle of the context that was just made current
+		static void MakeContextCurrent(const void* context);
+		static void OnContextDestroyed(const void* context);
+		// Unlike native handles ids are never reused, so per-context objects can be keyed by them
+		static uint32_t GetContextId();
+		static bool IsContextAlive(uint32_t contextId);
+
+		// Forgets everything, the next call of each kind is always issued
+		static void Invalidate();
+		static void BeginExternal();
+		static void EndExternal();
+
+		// Starts a new statistics frame, GetStats() returns the last completed one
+		static void NewFrame();
+		static const Statistics& GetStats();
+	};
+}
@@ -0,0 +1,157 @@
+#include "jerboa-pch.h"
+#include "RenderQueue.h"
+#include "GLStateCache.h"
+
+#include "glad/glad.h"
+
+namespace Jerboa {
+	static bool CanMerge(const DrawCommand& a, const DrawCommand& b)
+	{
+		if (a.shader != b.shader || a.vertexArray != b.vertexArray || a.primitive != b.primitive
+			|| a.indexed != b.indexed || a.blend != b.blend || a.textureCount != b.textureCount)
+			return false;
+
+		for (uint32_t i = 0; i < a.textureCount; i++) {
+			if (a.textures[i] != b.textures[i])
+				return false;
+		}
+		return true;
+	}
+
+	RenderQueue::RenderQueue()
+		: mArena(256 * 1024)
+	{
+	}
+
+	void RenderQueue::Submit(uint64_t key, const DrawCommand& command)
+	{
+		const DrawCommand* stored = mArena.New<DrawCommand>(command);
+		mEntries.push_back({ (key & ~RenderSortKey::LayerMask) | mCurrentLayer, stored });
+	}
+
+	void RenderQueue::SetCurrentLayer(uint32_t layer)
+	{
+		uint64_t maxLayer = RenderSortKey::Mask(RenderSortKey::LayerBits);
+		mCurrentLayer = std::min<uint64_t>(layer, maxLayer) << RenderSortKey::LayerShift;
+	}
+
+	void RenderQueue::Flush()
+	{
+		mStats = Statistics();
+		mStats.submitted = static_cast<uint32_t>(mEntries.size());
+
+		if (!mEntries.empty()) {
+			Sort();
+			Execute();
+		}
+
+		mEntries.clear();
+		mArena.Reset();
+		mCurrentLayer = 0;
+	}
+
+	void RenderQueue::Sort()
+	{
+		const size_t count = mEntries.size();
+		mScratch.resize(count);
+
+		// Bytes that are identical across all keys cannot change the order
+		uint64_t anyBits = 0, allBits = ~uint64_t(0);
+		for (const Entry& entry : mEntries) {
+			anyBits |= entry.key;
+			allBits &= entry.key;
+		}
+		uint64_t varyingBits = anyBits ^ allBits;
+
+		Entry* source = mEntries.data();
+		Entry* destination = mScratch.data();
+		for (uint32_t shift = 0; shift < 64; shift += 8) {
+			if (((varyingBits >> shift) & 0xff) == 0)
+				continue;
+
+			size_t offsets[256] = {};
+			for (size_t i = 0; i < count; i++)
+				offsets[(source[i].key >> shift) & 0xff]++;
+
+			size_t total = 0;
+			for (size_t& offset : offsets) {
+				size_t bucketSize = offset;
+				offset = total;
+				total += bucketSize;
+			}
+
+			for (size_t i = 0; i < count; i++)
+				destination[offsets[(source[i].key >> shift) & 0xff]++] = source[i];
+
+			std::swap(source, destination);
+		}
+
+		if (source != mEntries.data())
+			mEntries.swap(mScratch);
+	}
+
+	void RenderQueue::Execute()
+	{
+		const DrawCommand* previous = nullptr;
+
+		const size_t count = mEntries.size();
+		size_t begin = 0;
+		while (begin < count) {
+			const DrawCommand& state = *mEntries[begin].command;
+			size_t end = begin + 1;
+			while (end < count && CanMerge(state, *mEntries[end].command))
+				end++;
+
+			// The statistics count transitions between sorted commands, i.e. how well the
+			// keys grouped state; the GL state cache drops the redundant calls
+			if (!previous || previous->shader != state.shader)
+				mStats.shaderBinds++;
+			if (!previous || previous->vertexArray != state.vertexArray)
+				mStats.vertexArrayBinds++;
+			for (uint32_t slot = 0; slot < state.textureCount; slot++) {
+				if (!previous || slot >= previous->textureCount || previous->textures[slot] != state.textures[slot])
+					mStats.textureBinds++;
+			}
+			previous = &state;
+
+			GLStateCache::UseProgram(state.shader);
+			GLStateCache::BindVertexArray(state.vertexArray);
+			for (uint32_t slot = 0; slot < state.textureCount; slot++)
+				GLStateCache::BindTexture2D(slot, state.textures[slot]);
+			GLStateCache::SetBlend(state.blend);
+			if (state.blend)
+				GLStateCache::SetBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+			const size_t drawCount = end - begin;
+			if (drawCount == 1) {
+				if (state.indexed)
+					glDrawElementsBaseVertex(state.primitive, state.count, GL_UNSIGNED_INT, reinterpret_cast<const void*>(static_cast<uintptr_t>(state.first)), state.baseVertex);
+				else
+					glDrawArrays(state.primitive, state.first, state.count);
+			}
+			else {
+				mBatchCounts.clear();
+				mBatchOffsets.clear();
+				mBatchFirsts.clear();
+				mBatchBaseVertices.clear();
+				for (size_t i = begin; i < end; i++) {
+					const DrawCommand& command = *mEntries[i].command;
+					mBatchCounts.push_back(command.count);
+					mBatchFirsts.push_back(command.first);
+					mBatchOffsets.push_back(reinterpret_cast<const void*>(static_cast<uintptr_t>(command.first)));
+					mBatchBaseVertices.push_back(command.baseVertex);
+				}
+
+				if (state.indexed)
+					glMultiDrawElementsBaseVertex(state.primitive, mBatchCounts.data(), GL_UNSIGNED_INT, mBatchOffsets.data(), static_cast<GLsizei>(drawCount), mBatchBaseVertices.data());
+				else
+					glMultiDrawArrays(state.primitive, mBatchFirsts.data(), mBatchCounts.data(), static_cast<GLsizei>(drawCount));
+
+				mStats.mergedDraws += static_cast<uint32_t>(drawCount - 1);
+			}
+
+			mStats.drawCalls++;
+			begin = end;
+		}
+	}
+}
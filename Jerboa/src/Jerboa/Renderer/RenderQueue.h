@@ -0,0 +1,80 @@
+#pragma once
+
+#include "RenderSortKey.h"
+#include "Jerboa/Core/LinearAllocator.h"
+
+#include <vector>
+#include <cstdint>
+
+namespace Jerboa {
+	// Everything the backend needs to issue one draw. Commands that only differ in their
+	// ranges are merged into a single multi-draw call.
+	struct DrawCommand
+	{
+		static constexpr uint32_t MaxTextures = 4;
+
+		uint32_t shader = 0;
+		uint32_t vertexArray = 0;
+		uint32_t textures[MaxTextures] = {};
+		uint32_t textureCount = 0;
+		uint32_t primitive = 0x0004; // GL_TRIANGLES
+		bool indexed = true;
+		bool blend = false;
+
+		// Index count and byte offset into the (32-bit) element buffer for indexed draws,
+		// vertex count and first vertex otherwise
+		uint32_t count = 0;
+		uint32_t first = 0;
+		int32_t baseVertex = 0;
+	};
+
+	// Collects draw commands during the frame and submits them sorted by their 64-bit
+	// key. Command memory comes from a per-frame linear arena; sorting is an LSD radix
+	// sort that skips bytes shared by all keys.
+	class RenderQueue
+	{
+	public:
+		struct Statistics
+		{
+			uint32_t submitted = 0;
+			uint32_t drawCalls = 0;
+			uint32_t mergedDraws = 0;
+			uint32_t shaderBinds = 0;
+			uint32_t vertexArrayBinds = 0;
+			uint32_t textureBinds = 0;
+		};
+
+		RenderQueue();
+
+		// The layer field of the key is filled in from the layer currently being updated
+		void Submit(uint64_t key, const DrawCommand& command);
+		void SetCurrentLayer(uint32_t layer);
+
+		// Sorts, submits and clears all commands of this frame
+		void Flush();
+
+		inline const Statistics& GetStats() const { return mStats; }
+	private:
+		struct Entry
+		{
+			uint64_t key;
+			const DrawCommand* command;
+		};
+
+		void Sort();
+		void Execute();
+
+		LinearAllocator mArena;
+		std::vector<Entry> mEntries;
+		std::vector<Entry> mScratch;
+		uint64_t mCurrentLayer = 0;
+
+		// Kept across frames so multi-draw batches never allocate in steady state
+		std::vector<int32_t> mBatchCounts;
+		std::vector<const void*> mBatchOffsets;
+		std::vector<int32_t> mBatchFirsts;
+		std::vector<int32_t> mBatchBaseVertices;
+
+		Statistics mStats;
+	};
+}
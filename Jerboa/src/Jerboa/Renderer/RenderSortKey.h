@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstdint>
+
+namespace Jerboa {
+	// Packed 64-bit draw sort key, most significant field first:
+	//
+	//   layer:8 | pass:4 | translucency:2 | 50 bits ordered by translucency
+	//
+	// Opaque draws order the low bits as shader:12 | material:14 | depth:24 so that
+	// state changes are grouped and depth only breaks ties (front to back).
+	// Translucent draws need back to front ordering, so they use
+	// depth:24 (inverted) | shader:12 | material:14.
+	namespace RenderSortKey {
+		enum class Translucency : uint8_t {
+			Opaque = 0,
+			AlphaTested = 1,
+			Translucent = 2
+		};
+
+		constexpr uint32_t LayerBits = 8;
+		constexpr uint32_t PassBits = 4;
+		constexpr uint32_t TranslucencyBits = 2;
+		constexpr uint32_t DepthBits = 24;
+		constexpr uint32_t ShaderBits = 12;
+		constexpr uint32_t MaterialBits = 14;
+
+		constexpr uint32_t LayerShift = 64 - LayerBits;
+		constexpr uint32_t PassShift = LayerShift - PassBits;
+		constexpr uint32_t TranslucencyShift = PassShift - TranslucencyBits;
+
+		constexpr uint64_t Mask(uint32_t bits) { return (uint64_t(1) << bits) - 1; }
+		constexpr uint64_t LayerMask = Mask(LayerBits) << LayerShift;
+
+		// Maps a view depth in [0, 1] to the key's fixed point depth field
+		constexpr uint64_t QuantizeDepth(float depth)
+		{
+			return depth <= 0.0f ? 0 : depth >= 1.0f ? Mask(DepthBits) : static_cast<uint64_t>(depth * Mask(DepthBits));
+		}
+
+		constexpr uint64_t Header(uint32_t layer, uint32_t pass, Translucency translucency)
+		{
+			return ((layer & Mask(LayerBits)) << LayerShift)
+				| ((pass & Mask(PassBits)) << PassShift)
+				| ((static_cast<uint64_t>(translucency) & Mask(TranslucencyBits)) << TranslucencyShift);
+		}
+
+		constexpr uint64_t Opaque(uint32_t pass, uint32_t shader, uint32_t material, float depth, uint32_t layer = 0)
+		{
+			return Header(layer, pass, Translucency::Opaque)
+				| ((shader & Mask(ShaderBits)) << (MaterialBits + DepthBits))
+				| ((material & Mask(MaterialBits)) << DepthBits)
+				| QuantizeDepth(depth);
+		}
+
+		constexpr uint64_t AlphaTested(uint32_t pass, uint32_t shader, uint32_t material, float depth, uint32_t layer = 0)
+		{
+			return (Opaque(pass, shader, material, depth, layer) & ~(Mask(TranslucencyBits) << TranslucencyShift))
+				| (static_cast<uint64_t>(Translucency::AlphaTested) << TranslucencyShift);
+		}
+
+		constexpr uint64_t Translucent(uint32_t pass, uint32_t shader, uint32_t material, float depth, uint32_t layer = 0)
+		{
+			return Header(layer, pass, Translucency::Translucent)
+				| ((Mask(DepthBits) - QuantizeDepth(depth)) << (ShaderBits + MaterialBits))
+				| ((shader & Mask(ShaderBits)) << MaterialBits)
+				| (material & Mask(MaterialBits));
+		}
+
+		constexpr uint32_t GetLayer(uint64_t key) { return static_cast<uint32_t>(key >> LayerShift); }
+		constexpr uint32_t GetPass(uint64_t key) { return static_cast<uint32_t>((key >> PassShift) & Mask(PassBits)); }
+		constexpr Translucency GetTranslucency(uint64_t key) { return static_cast<Translucency>((key >> TranslucencyShift) & Mask(TranslucencyBits)); }
+	}
+}
@@ -0,0 +1,595 @@
+#include "jerboa-pch.h"
+#include "Renderer2D.h"
+
+#include "Shader.h"
+#include "StreamingBuffer.h"
+#include "GLStateCache.h"
+
+#include "glad/glad.h"
+
+#include <cmath>
+
+namespace Jerboa {
+	struct QuadVertex
+	{
+		float position[3];
+		float color[4];
+		float texCoord[2];
+		float texIndex;
+		float tiling;
+	};
+
+	struct CircleVertex
+	{
+		float worldPosition[3];
+		float localPosition[2];
+		float color[4];
+		float thickness;
+		float fade;
+	};
+
+	struct LineVertex
+	{
+		float position[3];
+		float color[4];
+	};
+
+	template<class Vertex>
+	struct VertexBatch
+	{
+		std::unique_ptr<StreamingBuffer> buffer;
+		std::shared_ptr<Shader> shader;
+		uint32_t maxVertices = 0;
+		// Sets the attributes of a new vertex array while the vertex buffer is bound
+		void (*setupVertexArray)() = nullptr;
+		// Vertex arrays aren't shared between GL contexts, every context that draws gets its
+		// own. Pairs of context id and vertex array.
+		std::vector<std::pair<uint32_t, uint32_t>> vertexArrays;
+
+		Vertex* base = nullptr;
+		Vertex* next = nullptr;
+
+		// Each batch fills one segment of the ring
+		void Create(uint32_t vertexCapacity, uint32_t segmentCount, void (*setup)())
+		{
+			maxVertices = vertexCapacity;
+			setupVertexArray = setup;
+			buffer = std::make_unique<StreamingBuffer>(GL_ARRAY_BUFFER, maxVertices * sizeof(Vertex), segmentCount);
+			GetVertexArray();
+		}
+
+		void Destroy()
+		{
+			buffer.reset();
+			shader.reset();
+			// Those of other contexts are deleted along with their context
+			const uint32_t context = GLStateCache::GetContextId();
+			for (auto& [owner, vertexArray] : vertexArrays) {
+				if (owner == context) {
+					GLStateCache::OnVertexArrayDeleted(vertexArray);
+					glDeleteVertexArrays(1, &vertexArray);
+				}
+			}
+			vertexArrays.clear();
+		}
+
+		uint32_t GetVertexArray()
+		{
+			const uint32_t context = GLStateCache::GetContextId();
+			for (const auto& [owner, vertexArray] : vertexArrays) {
+				if (owner == context)
+					return vertexArray;
+			}
+
+			vertexArrays.erase(std::remove_if(vertexArrays.begin(), vertexArrays.end(), [](const std::pair<uint32_t, uint32_t>& entry) {
+				return !GLStateCache::IsContextAlive(entry.first);
+			}), vertexArrays.end());
+
+			uint32_t vertexArray = 0;
+			glGenVertexArrays(1, &vertexArray);
+			GLStateCache::BindVertexArray(vertexArray);
+			GLStateCache::BindBuffer(GL_ARRAY_BUFFER, buffer->GetRendererID());
+			setupVertexArray();
+			vertexArrays.emplace_back(context, vertexArray);
+			return vertexArray;
+		}
+
+		// Maps lazily so batches that receive no geometry cost nothing
+		inline bool HasRoomFor(uint32_t vertexCount)
+		{
+			if (!base)
+				base = next = static_cast<Vertex*>(buffer->MapSegment());
+			return VertexCount() + vertexCount <= maxVertices;
+		}
+
+		inline uint32_t VertexCount() const { return static_cast<uint32_t>(next - base); }
+
+		// Returns the first vertex of the batch inside the buffer, or -1 if empty
+		int Unmap()
+		{
+			if (!base)
+				return -1;
+
+			uint32_t count = VertexCount();
+			size_t offset = buffer->UnmapSegment(count * sizeof(Vertex));
+			base = next = nullptr;
+			if (count == 0) {
+				// Nothing to draw, the segment can be rewritten right away
+				return -1;
+			}
+			return static_cast<int>(offset / sizeof(Vertex));
+		}
+	};
+
+	static void SetAttribute(uint32_t index, int components, size_t stride, size_t offset)
+	{
+		glEnableVertexAttribArray(index);
+		glVertexAttribPointer(index, components, GL_FLOAT, GL_FALSE, static_cast<GLsizei>(stride), reinterpret_cast<const void*>(offset));
+	}
+
+	static const char* sQuadVertexSource = R"(
+		#version 330 core
+		layout(location = 0) in vec3 aPosition;
+		layout(location = 1) in vec4 aColor;
+		layout(location = 2) in vec2 aTexCoord;
+		layout(location = 3) in float aTexIndex;
+		layout(location = 4) in float aTiling;
+
+		uniform mat4 uViewProjection;
+
+		out vec4 vColor;
+		out vec2 vTexCoord;
+		flat out int vTexIndex;
+
+		void main()
+		{
+			vColor = aColor;
+			vTexCoord = aTexCoord * aTiling;
+			vTexIndex = int(aTexIndex);
+			gl_Position = uViewProjection * vec4(aPosition, 1.0);
+		}
+	)";
+
+	// GLSL 330 only allows constant sampler array indices, so the lookup is a generated switch
+	static std::string BuildQuadFragmentSource(uint32_t textureSlots)
+	{
+		std::string source = R"(
+		#version 330 core
+		layout(location = 0) out vec4 oColor;
+
+		in vec4 vColor;
+		in vec2 vTexCoord;
+		flat in int vTexIndex;
+		)";
+		source += "uniform sampler2D uTextures[" + std::to_string(textureSlots) + "];\n";
+		source += "void main()\n{\n\tvec4 texColor = vec4(1.0);\n\tswitch (vTexIndex) {\n";
+		for (uint32_t i = 0; i < textureSlots; i++) {
+			std::string slot = std::to_string(i);
+			source += "\t\tcase " + slot + ": texColor = texture(uTextures[" + slot + "], vTexCoord); break;\n";
+		}
+		source += "\t}\n\toColor = texColor * vColor;\n}\n";
+		return source;
+	}
+
+	static const char* sCircleVertexSource = R"(
+		#version 330 core
+		layout(location = 0) in vec3 aWorldPosition;
+		layout(location = 1) in vec2 aLocalPosition;
+		layout(location = 2) in vec4 aColor;
+		layout(location = 3) in float aThickness;
+		layout(location = 4) in float aFade;
+
+		uniform mat4 uViewProjection;
+
+		out vec2 vLocalPosition;
+		out vec4 vColor;
+		out float vThickness;
+		out float vFade;
+
+		void main()
+		{
+			vLocalPosition = aLocalPosition;
+			vColor = aColor;
+			vThickness = aThickness;
+			vFade = aFade;
+			gl_Position = uViewProjection * vec4(aWorldPosition, 1.0);
+		}
+	)";
+
+	static const char* sCircleFragmentSource = R"(
+		#version 330 core
+		layout(location = 0) out vec4 oColor;
+
+		in vec2 vLocalPosition;
+		in vec4 vColor;
+		in float vThickness;
+		in float vFade;
+
+		void main()
+		{
+			float distance = 1.0 - length(vLocalPosition);
+			float alpha = smoothstep(0.0, vFade, distance);
+			alpha *= smoothstep(vThickness + vFade, vThickness, distance);
+			if (alpha == 0.0)
+				discard;
+
+			oColor = vec4(vColor.rgb, vColor.a * alpha);
+		}
+	)";
+
+	static const char* sLineVertexSource = R"(
+		#version 330 core
+		layout(location = 0) in vec3 aPosition;
+		layout(location = 1) in vec4 aColor;
+
+		uniform mat4 uViewProjection;
+
+		out vec4 vColor;
+
+		void main()
+		{
+			vColor = aColor;
+			gl_Position = uViewProjection * vec4(aPosition, 1.0);
+		}
+	)";
+
+	static const char* sLineFragmentSource = R"(
+		#version 330 core
+		layout(location = 0) out vec4 oColor;
+
+		in vec4 vColor;
+
+		void main()
+		{
+			oColor = vColor;
+		}
+	)";
+
+	struct Renderer2DData
+	{
+		static constexpr uint32_t MaxQuads = 20000;
+		static constexpr uint32_t MaxQuadVertices = MaxQuads * 4;
+		static constexpr uint32_t MaxQuadIndices = MaxQuads * 6;
+		static constexpr uint32_t MaxCircles = 10000;
+		static constexpr uint32_t MaxLines = 20000;
+		static constexpr uint32_t MaxTextureSlots = 32;
+		// A segment is only reused once the GPU is done with it. The ring has to hold every
+		// batch of the frames the driver queues ahead, or a frame waits on its own first
+		// batches. Quads are sized for 100k sprites, circles and lines for one batch a frame.
+		static constexpr uint32_t FramesInFlight = 3;
+		static constexpr uint32_t QuadBatchesPerFrame = 6;
+		static constexpr uint32_t QuadSegments = FramesInFlight * QuadBatchesPerFrame;
+		static constexpr uint32_t SingleBatchSegments = FramesInFlight + 1;
+
+		VertexBatch<QuadVertex> quads;
+		VertexBatch<CircleVertex> circles;
+		VertexBatch<LineVertex> lines;
+		uint32_t quadIndexBuffer = 0;
+
+		std::shared_ptr<Texture2D> whiteTexture;
+		std::array<const Texture2D*, MaxTextureSlots> textureSlots{};
+		uint32_t textureSlotCount = 0;
+		uint32_t usedTextureSlots = 1; // 0 = white texture
+
+		float viewProjection[16] = {};
+		Renderer2D::Statistics stats;
+		uint64_t stallsAtReset = 0;
+	};
+
+	static Renderer2DData* sData = nullptr;
+
+	// Unit quad corners and their texture coordinates
+	static constexpr float sQuadCorners[4][2] = { { -0.5f, -0.5f }, { 0.5f, -0.5f }, { 0.5f, 0.5f }, { -0.5f, 0.5f } };
+	static constexpr float sQuadTexCoords[4][2] = { { 0.0f, 0.0f }, { 1.0f, 0.0f }, { 1.0f, 1.0f }, { 0.0f, 1.0f } };
+
+	static void SetupQuadVertexArray()
+	{
+		SetAttribute(0, 3, sizeof(QuadVertex), offsetof(QuadVertex, position));
+		SetAttribute(1, 4, sizeof(QuadVertex), offsetof(QuadVertex, color));
+		SetAttribute(2, 2, sizeof(QuadVertex), offsetof(QuadVertex, texCoord));
+		SetAttribute(3, 1, sizeof(QuadVertex), offsetof(QuadVertex, texIndex));
+		SetAttribute(4, 1, sizeof(QuadVertex), offsetof(QuadVertex, tiling));
+		GLStateCache::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, sData->quadIndexBuffer);
+	}
+
+	static void SetupCircleVertexArray()
+	{
+		SetAttribute(0, 3, sizeof(CircleVertex), offsetof(CircleVertex, worldPosition));
+		SetAttribute(1, 2, sizeof(CircleVertex), offsetof(CircleVertex, localPosition));
+		SetAttribute(2, 4, sizeof(CircleVertex), offsetof(CircleVertex, color));
+		SetAttribute(3, 1, sizeof(CircleVertex), offsetof(CircleVertex, thickness));
+		SetAttribute(4, 1, sizeof(CircleVertex), offsetof(CircleVertex, fade));
+		GLStateCache::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, sData->quadIndexBuffer);
+	}
+
+	static void SetupLineVertexArray()
+	{
+		SetAttribute(0, 3, sizeof(LineVertex), offsetof(LineVertex, position));
+		SetAttribute(1, 4, sizeof(LineVertex), offsetof(LineVertex, color));
+	}
+
+	void Renderer2D::Init()
+	{
+		JERBOA_ASSERT(!sData, "Renderer2D::Init() should only be called once");
+		sData = new Renderer2DData();
+
+		int maxTextureUnits = 0;
+		glGetIntegerv(GL_MAX_TEXTURE_IMAGE_UNITS, &maxTextureUnits);
+		sData->textureSlotCount = std::min<uint32_t>(maxTextureUnits, Renderer2DData::MaxTextureSlots);
+
+		// Quads and circles share one static index buffer
+		std::vector<uint32_t> indices(Renderer2DData::MaxQuadIndices);
+		for (uint32_t quad = 0, vertex = 0; quad < Renderer2DData::MaxQuads; quad++, vertex += 4) {
+			uint32_t* index = &indices[quad * 6];
+			index[0] = vertex + 0; index[1] = vertex + 1; index[2] = vertex + 2;
+			index[3] = vertex + 2; index[4] = vertex + 3; index[5] = vertex + 0;
+		}
+
+		// Uploaded through GL_ARRAY_BUFFER, the element array binding belongs to a vertex array
+		glGenBuffers(1, &sData->quadIndexBuffer);
+		GLStateCache::BindBuffer(GL_ARRAY_BUFFER, sData->quadIndexBuffer);
+		glBufferData(GL_ARRAY_BUFFER, indices.size() * sizeof(uint32_t), indices.data(), GL_STATIC_DRAW);
+
+		auto& quads = sData->quads;
+		quads.Create(Renderer2DData::MaxQuadVertices, Renderer2DData::QuadSegments, SetupQuadVertexArray);
+		quads.shader = Shader::Create("Renderer2D_Quad", sQuadVertexSource, BuildQuadFragmentSource(sData->textureSlotCount));
+
+		auto& circles = sData->circles;
+		circles.Create(Renderer2DData::MaxCircles * 4, Renderer2DData::SingleBatchSegments, SetupCircleVertexArray);
+		circles.shader = Shader::Create("Renderer2D_Circle", sCircleVertexSource, sCircleFragmentSource);
+
+		auto& lines = sData->lines;
+		lines.Create(Renderer2DData::MaxLines * 2, Renderer2DData::SingleBatchSegments, SetupLineVertexArray);
+		lines.shader = Shader::Create("Renderer2D_Line", sLineVertexSource, sLineFragmentSource);
+
+		GLStateCache::BindVertexArray(0);
+
+		uint32_t white = 0xffffffff;
+		sData->whiteTexture = Texture2D::Create(1, 1);
+		sData->whiteTexture->SetData(&white);
+		sData->textureSlots[0] = sData->whiteTexture.get();
+
+		std::array<int, Renderer2DData::MaxTextureSlots> samplers;
+		for (uint32_t i = 0; i < sData->textureSlotCount; i++)
+			samplers[i] = i;
+		quads.shader->Bind();
+		quads.shader->SetIntArray("uTextures", samplers.data(), sData->textureSlotCount);
+
+		JERBOA_LOG_INFO("Renderer2D initialized ({} texture slots, {} streaming buffers)",
+			sData->textureSlotCount, quads.buffer->IsPersistentlyMapped() ? "persistently mapped" : "per-batch mapped");
+	}
+
+	void Renderer2D::Shutdown()
+	{
+		if (!sData)
+			return;
+
+		sData->quads.Unmap();
+		sData->circles.Unmap();
+		sData->lines.Unmap();
+
+		sData->quads.Destroy();
+		sData->circles.Destroy();
+		sData->lines.Destroy();
+		GLStateCache::OnBufferDeleted(sData->quadIndexBuffer);
+		glDeleteBuffers(1, &sData->quadIndexBuffer);
+
+		delete sData;
+		sData = nullptr;
+	}
+
+	void Renderer2D::BeginScene(float left, float right, float bottom, float top)
+	{
+		BeginScene(Mat4::Orthographic(left, right, bottom, top, -1.0f, 1.0f));
+	}
+
+	void Renderer2D::BeginScene(const float* viewProjection)
+	{
+		std::copy(viewProjection, viewProjection + 16, sData->viewProjection);
+
+		sData->quads.shader->Bind();
+		sData->quads.shader->SetMat4("uViewProjection", sData->viewProjection);
+		sData->circles.shader->Bind();
+		sData->circles.shader->SetMat4("uViewProjection", sData->viewProjection);
+		sData->lines.shader->Bind();
+		sData->lines.shader->SetMat4("uViewProjection", sData->viewProjection);
+	}
+
+	void Renderer2D::EndScene()
+	{
+		Flush();
+	}
+
+	void Renderer2D::Flush()
+	{
+		GLStateCache::SetBlend(true);
+		GLStateCache::SetBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+		GLStateCache::SetDepthTest(false);
+
+		FlushQuads();
+		FlushCircles();
+		FlushLines();
+	}
+
+	void Renderer2D::FlushQuads()
+	{
+		auto& quads = sData->quads;
+		uint32_t vertexCount = quads.VertexCount();
+		int baseVertex = quads.Unmap();
+		if (baseVertex >= 0) {
+			for (uint32_t i = 0; i < sData->usedTextureSlots; i++)
+				sData->textureSlots[i]->Bind(i);
+
+			quads.shader->Bind();
+			GLStateCache::BindVertexArray(quads.GetVertexArray());
+			glDrawElementsBaseVertex(GL_TRIANGLES, (vertexCount / 4) * 6, GL_UNSIGNED_INT, nullptr, baseVertex);
+			quads.buffer->FenceSegment();
+			sData->stats.drawCalls++;
+		}
+		sData->usedTextureSlots = 1;
+	}
+
+	void Renderer2D::FlushCircles()
+	{
+		auto& circles = sData->circles;
+		uint32_t vertexCount = circles.VertexCount();
+		int baseVertex = circles.Unmap();
+		if (baseVertex < 0)
+			return;
+
+		circles.shader->Bind();
+		GLStateCache::BindVertexArray(circles.GetVertexArray());
+		glDrawElementsBaseVertex(GL_TRIANGLES, (vertexCount / 4) * 6, GL_UNSIGNED_INT, nullptr, baseVertex);
+		circles.buffer->FenceSegment();
+		sData->stats.drawCalls++;
+	}
+
+	void Renderer2D::FlushLines()
+	{
+		auto& lines = sData->lines;
+		uint32_t vertexCount = lines.VertexCount();
+		int firstVertex = lines.Unmap();
+		if (firstVertex < 0)
+			return;
+
+		lines.shader->Bind();
+		GLStateCache::BindVertexArray(lines.GetVertexArray());
+		glDrawArrays(GL_LINES, firstVertex, vertexCount);
+		lines.buffer->FenceSegment();
+		sData->stats.drawCalls++;
+	}
+
+	void Renderer2D::DrawQuad(float x, float y, float z, float width, float height, const Color& color)
+	{
+		SubmitQuad(x, y, z, width, height, 0.0f, nullptr, color, 1.0f);
+	}
+
+	void Renderer2D::DrawQuad(float x, float y, float z, float width, float height, const std::shared_ptr<Texture2D>& texture, const Color& tint, float tiling)
+	{
+		SubmitQuad(x, y, z, width, height, 0.0f, texture.get(), tint, tiling);
+	}
+
+	void Renderer2D::DrawRotatedQuad(float x, float y, float z, float width, float height, float rotation, const Color& color)
+	{
+		SubmitQuad(x, y, z, width, height, rotation, nullptr, color, 1.0f);
+	}
+
+	void Renderer2D::DrawRotatedQuad(float x, float y, float z, float width, float height, float rotation, const std::shared_ptr<Texture2D>& texture, const Color& tint, float tiling)
+	{
+		SubmitQuad(x, y, z, width, height, rotation, texture.get(), tint, tiling);
+	}
+
+	void Renderer2D::SubmitQuad(float x, float y, float z, float width, float height, float rotation, const Texture2D* texture, const Color& color, float tiling)
+	{
+		auto& quads = sData->quads;
+		if (!quads.HasRoomFor(4)) {
+			FlushQuads();
+			quads.HasRoomFor(4);
+		}
+
+		float texIndex = 0.0f;
+		if (texture) {
+			uint32_t slot = 1;
+			while (slot < sData->usedTextureSlots && sData->textureSlots[slot] != texture)
+				slot++;
+
+			if (slot == sData->usedTextureSlots) {
+				if (slot == sData->textureSlotCount) {
+					FlushQuads();
+					quads.HasRoomFor(4);
+					slot = 1;
+				}
+				sData->textureSlots[slot] = texture;
+				sData->usedTextureSlots = slot + 1;
+			}
+			texIndex = static_cast<float>(slot);
+		}
+
+		float cosine = 1.0f, sine = 0.0f;
+		if (rotation != 0.0f) {
+			cosine = std::cos(rotation);
+			sine = std::sin(rotation);
+		}
+
+		for (int i = 0; i < 4; i++) {
+			float cornerX = sQuadCorners[i][0] * width;
+			float cornerY = sQuadCorners[i][1] * height;
+
+			QuadVertex* vertex = quads.next++;
+			vertex->position[0] = x + cornerX * cosine - cornerY * sine;
+			vertex->position[1] = y + cornerX * sine + cornerY * cosine;
+			vertex->position[2] = z;
+			vertex->color[0] = color.r;
+			vertex->color[1] = color.g;
+			vertex->color[2] = color.b;
+			vertex->color[3] = color.a;
+			vertex->texCoord[0] = sQuadTexCoords[i][0];
+			vertex->texCoord[1] = sQuadTexCoords[i][1];
+			vertex->texIndex = texIndex;
+			vertex->tiling = tiling;
+		}
+
+		sData->stats.quadCount++;
+	}
+
+	void Renderer2D::DrawCircle(float x, float y, float z, float radius, const Color& color, float thickness, float fade)
+	{
+		auto& circles = sData->circles;
+		if (!circles.HasRoomFor(4)) {
+			FlushCircles();
+			circles.HasRoomFor(4);
+		}
+
+		for (int i = 0; i < 4; i++) {
+			CircleVertex* vertex = circles.next++;
+			vertex->worldPosition[0] = x + sQuadCorners[i][0] * 2.0f * radius;
+			vertex->worldPosition[1] = y + sQuadCorners[i][1] * 2.0f * radius;
+			vertex->worldPosition[2] = z;
+			vertex->localPosition[0] = sQuadCorners[i][0] * 2.0f;
+			vertex->localPosition[1] = sQuadCorners[i][1] * 2.0f;
+			vertex->color[0] = color.r;
+			vertex->color[1] = color.g;
+			vertex->color[2] = color.b;
+			vertex->color[3] = color.a;
+			vertex->thickness = thickness;
+			vertex->fade = fade;
+		}
+
+		sData->stats.circleCount++;
+	}
+
+	void Renderer2D::DrawLine(float x0, float y0, float x1, float y1, const Color& color, float z)
+	{
+		auto& lines = sData->lines;
+		if (!lines.HasRoomFor(2)) {
+			FlushLines();
+			lines.HasRoomFor(2);
+		}
+
+		LineVertex* start = lines.next++;
+		LineVertex* end = lines.next++;
+		*start = { { x0, y0, z }, { color.r, color.g, color.b, color.a } };
+		*end = { { x1, y1, z }, { color.r, color.g, color.b, color.a } };
+
+		sData->stats.lineCount++;
+	}
+
+	static uint64_t GetTotalBufferStalls()
+	{
+		return sData->quads.buffer->GetStallCount()
+			+ sData->circles.buffer->GetStallCount()
+			+ sData->lines.buffer->GetStallCount();
+	}
+
+	void Renderer2D::ResetStats()
+	{
+		sData->stats = Statistics();
+		sData->stallsAtReset = GetTotalBufferStalls();
+	}
+
+	const Renderer2D::Statistics& Renderer2D::GetStats()
+	{
+		sData->stats.bufferStalls = GetTotalBufferStalls() - sData->stallsAtReset;
+		return sData->stats;
+	}
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "Texture.h"
+#include "Jerboa/Math/Matrix.h"
+
+#include <memory>
+#include <cstdint>
+
+namespace Jerboa {
+	struct Color
+	{
+		float r = 1.0f, g = 1.0f, b = 1.0f, a = 1.0f;
+	};
+
+	// Batched 2D renderer. Quads, circles and lines are accumulated into large streaming
+	// vertex batches and submitted with one draw call per batch; textured quads share
+	// a batch as long as free texture slots remain. Draws into whichever window's context is
+	// current, as long as it shares objects with the context Init() ran in.
+	class Renderer2D
+	{
+	public:
+		struct Statistics
+		{
+			uint32_t drawCalls = 0;
+			uint32_t quadCount = 0;
+			uint32_t circleCount = 0;
+			uint32_t lineCount = 0;
+			uint64_t bufferStalls = 0;
+		};
+
+		static void Init();
+		static void Shutdown();
+
+		// Orthographic camera covering [left, right] x [bottom, top]
+		static void BeginScene(float left, float right, float bottom, float top);
+		// Column-major 4x4 view-projection matrix
+		static void BeginScene(const float* viewProjection);
+		static void BeginScene(const Mat4& viewProjection) { BeginScene(viewProjection.m); }
+		static void EndScene();
+		static void Flush();
+
+		static void DrawQuad(float x, float y, float z, float width, float height, const Color& color);
+		static void DrawQuad(float x, float y, float z, float width, float height, const std::shared_ptr<Texture2D>& texture, const Color& tint = Color(), float tiling = 1.0f);
+		static void DrawRotatedQuad(float x, float y, float z, float width, float height, float rotation, const Color& color);
+		static void DrawRotatedQuad(float x, float y, float z, float width, float height, float rotation, const std::shared_ptr<Texture2D>& texture, const Color& tint = Color(), float tiling = 1.0f);
+
+		// thickness is relative to the radius, 1 fills the circle
+		static void DrawCircle(float x, float y, float z, float radius, const Color& color, float thickness = 1.0f, float fade = 0.005f);
+		static void DrawLine(float x0, float y0, float x1, float y1, const Color& color, float z = 0.0f);
+
+		static void ResetStats();
+		static const Statistics& GetStats();
+	private:
+		static void SubmitQuad(float x, float y, float z, float width, float height, float rotation, const Texture2D* texture, const Color& color, float tiling);
+		static void FlushQuads();
+		static void FlushCircles();
+		static void FlushLines();
+	};
+}
@@ -0,0 +1,78 @@
+#include "jerboa-pch.h"
+#include "ResolutionScaleGovernor.h"
+
+#include <cmath>
+
+namespace Jerboa {
+	namespace {
+		constexpr float SmoothingFactor = 0.1f;
+		// Scale is changed in steps of this size so that tiny adjustments don't resize every frame
+		constexpr float ScaleQuantum = 1.0f / 64.0f;
+	}
+
+	ResolutionScaleGovernor::ResolutionScaleGovernor()
+		: ResolutionScaleGovernor(Settings())
+	{
+	}
+
+	ResolutionScaleGovernor::ResolutionScaleGovernor(const Settings& settings)
+		: mSettings(settings), mScale(settings.maxScale)
+	{
+		JERBOA_ASSERT(settings.minScale > 0.0f && settings.minScale <= settings.maxScale, "Invalid resolution scale range");
+	}
+
+	bool ResolutionScaleGovernor::Update(float frameTimeMs)
+	{
+		if (frameTimeMs <= 0.0f)
+			return false;
+
+		if (!mHasSample) {
+			mSmoothedFrameTimeMs = frameTimeMs;
+			mHasSample = true;
+		}
+		else {
+			mSmoothedFrameTimeMs += (frameTimeMs - mSmoothedFrameTimeMs) * SmoothingFactor;
+		}
+
+		if (++mFramesSinceChange < mSettings.cooldownFrames)
+			return false;
+
+		float scale = mScale;
+		if (mSmoothedFrameTimeMs > mSettings.budgetMs) {
+			// Fill cost is roughly proportional to pixel count, i.e. to scale squared
+			scale = mScale * std::sqrt(mSettings.budgetMs / mSmoothedFrameTimeMs);
+			scale = std::floor(scale / ScaleQuantum) * ScaleQuantum;
+		}
+		else if (mSmoothedFrameTimeMs < mSettings.budgetMs * mSettings.headroom) {
+			scale = mScale + mSettings.scaleUpStep;
+		}
+
+		scale = Clamp(scale);
+		if (scale == mScale)
+			return false;
+
+		mScale = scale;
+		mFramesSinceChange = 0;
+		return true;
+	}
+
+	void ResolutionScaleGovernor::Reset()
+	{
+		mScale = mSettings.maxScale;
+		mSmoothedFrameTimeMs = 0.0f;
+		mFramesSinceChange = 0;
+		mHasSample = false;
+	}
+
+	void ResolutionScaleGovernor::SetSettings(const Settings& settings)
+	{
+		JERBOA_ASSERT(settings.minScale > 0.0f && settings.minScale <= settings.maxScale, "Invalid resolution scale range");
+		mSettings = settings;
+		mScale = Clamp(mScale);
+	}
+
+	float ResolutionScaleGovernor::Clamp(float scale) const
+	{
+		return std::min(std::max(scale, mSettings.minScale), mSettings.maxScale);
+	}
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+
+namespace Jerboa {
+	// Picks an internal render resolution scale that keeps frame time within budget.
+	// Feed it the GPU frame time where available, CPU frame time with vsync on never
+	// drops below the refresh interval and would keep the scale from recovering.
+	class ResolutionScaleGovernor
+	{
+	public:
+		struct Settings
+		{
+			float budgetMs = 1000.0f / 60.0f;
+			float minScale = 0.5f;
+			float maxScale = 1.0f;
+			float scaleUpStep = 0.05f;
+			// Scale back up only while frames take less than this fraction of the budget
+			float headroom = 0.8f;
+			// Frames to wait after a change before reacting again, gives the smoothed
+			// frame time a chance to reflect the new resolution
+			uint32_t cooldownFrames = 30;
+		};
+
+		ResolutionScaleGovernor();
+		ResolutionScaleGovernor(const Settings& settings);
+
+		// Returns true when the scale changed
+		bool Update(float frameTimeMs);
+		void Reset();
+
+		inline float GetScale() const { return mScale; }
+		inline float GetSmoothedFrameTime() const { return mSmoothedFrameTimeMs; }
+		inline const Settings& GetSettings() const { return mSettings; }
+		void SetSettings(const Settings& settings);
+	private:
+		float Clamp(float scale) const;
+
+		Settings mSettings;
+		float mScale;
+		float mSmoothedFrameTimeMs = 0.0f;
+		uint32_t mFramesSinceChange = 0;
+		bool mHasSample = false;
+	};
+}
@@ -0,0 +1,135 @@
+#include "jerboa-pch.h"
+#include "Shader.h"
+
+#include "GLStateCache.h"
+#include "ShaderCache.h"
+#include "Jerboa/Core/Time.h"
+
+#include "glad/glad.h"
+
+namespace Jerboa {
+	Shader::Shader(const std::string& name, const std::string& vertexSource, const std::string& fragmentSource)
+		: mName(name)
+	{
+		Timestamp start = Time::Now();
+		uint64_t sourceHash = ShaderCache::HashSources(name, vertexSource, fragmentSource);
+
+		mRendererID = ShaderCache::Load(name, sourceHash);
+		if (mRendererID) {
+			ShaderCache::RecordLoad(true, Time::ToMilliseconds(Time::Now() - start));
+			return;
+		}
+
+		mRendererID = CompileAndLink(vertexSource, fragmentSource);
+		if (!mRendererID)
+			return;
+
+		ShaderCache::RecordLoad(false, Time::ToMilliseconds(Time::Now() - start));
+		ShaderCache::Store(name, sourceHash, mRendererID);
+	}
+
+	uint32_t Shader::CompileAndLink(const std::string& vertexSource, const std::string& fragmentSource)
+	{
+		uint32_t vertexShader = CompileStage(GL_VERTEX_SHADER, vertexSource);
+		uint32_t fragmentShader = CompileStage(GL_FRAGMENT_SHADER, fragmentSource);
+		if (!vertexShader || !fragmentShader) {
+			glDeleteShader(vertexShader);
+			glDeleteShader(fragmentShader);
+			return 0;
+		}
+
+		uint32_t program = glCreateProgram();
+		if (ShaderCache::IsEnabled())
+			glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+		glAttachShader(program, vertexShader);
+		glAttachShader(program, fragmentShader);
+		glLinkProgram(program);
+
+		glDetachShader(program, vertexShader);
+		glDetachShader(program, fragmentShader);
+		glDeleteShader(vertexShader);
+		glDeleteShader(fragmentShader);
+
+		int linked = 0;
+		glGetProgramiv(program, GL_LINK_STATUS, &linked);
+		if (!linked) {
+			char infoLog[1024];
+			glGetProgramInfoLog(program, sizeof(infoLog), nullptr, infoLog);
+			JERBOA_LOG_ERROR("Failed to link shader \"{}\": {}", mName, infoLog);
+			glDeleteProgram(program);
+			return 0;
+		}
+
+		return program;
+	}
+
+	Shader::~Shader()
+	{
+		GLStateCache::OnProgramDeleted(mRendererID);
+		glDeleteProgram(mRendererID);
+	}
+
+	void Shader::Bind() const
+	{
+		GLStateCache::UseProgram(mRendererID);
+	}
+
+	void Shader::SetInt(const std::string& name, int value)
+	{
+		glUniform1i(GetUniformLocation(name), value);
+	}
+
+	void Shader::SetIntArray(const std::string& name, const int* values, uint32_t count)
+	{
+		glUniform1iv(GetUniformLocation(name), count, values);
+	}
+
+	void Shader::SetFloat(const std::string& name, float value)
+	{
+		glUniform1f(GetUniformLocation(name), value);
+	}
+
+	void Shader::SetMat4(const std::string& name, const float* matrix)
+	{
+		glUniformMatrix4fv(GetUniformLocation(name), 1, GL_FALSE, matrix);
+	}
+
+	std::shared_ptr<Shader> Shader::Create(const std::string& name, const std::string& vertexSource, const std::string& fragmentSource)
+	{
+		return std::make_shared<Shader>(name, vertexSource, fragmentSource);
+	}
+
+	uint32_t Shader::CompileStage(uint32_t type, const std::string& source)
+	{
+		uint32_t shader = glCreateShader(type);
+		const char* sourcePtr = source.c_str();
+		glShaderSource(shader, 1, &sourcePtr, nullptr);
+		glCompileShader(shader);
+
+		int compiled = 0;
+		glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+		if (!compiled) {
+			char infoLog[1024];
+			glGetShaderInfoLog(shader, sizeof(infoLog), nullptr, infoLog);
+			JERBOA_LOG_ERROR("Failed to compile {} shader of \"{}\": {}", type == GL_VERTEX_SHADER ? "vertex" : "fragment", mName, infoLog);
+			glDeleteShader(shader);
+			return 0;
+		}
+
+		return shader;
+	}
+
+	int Shader::GetUniformLocation(const std::string& name)
+	{
+		auto it = mUniformLocations.find(name);
+		if (it != mUniformLocations.end())
+			return it->second;
+
+		int location = glGetUniformLocation(mRendererID, name.c_str());
+		if (location == -1)
+			JERBOA_LOG_WARN("Shader \"{}\" has no uniform \"{}\"", mName, name);
+
+		mUniformLocations[name] = location;
+		return location;
+	}
+}
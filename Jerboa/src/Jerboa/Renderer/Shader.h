@@ -0,0 +1,39 @@
+#pragma once
+
+#include <string>
+#include <memory>
+#include <unordered_map>
+#include <cstdint>
+
+namespace Jerboa {
+	class Shader
+	{
+	public:
+		Shader(const std::string& name, const std::string& vertexSource, const std::string& fragmentSource);
+		~Shader();
+
+		Shader(const Shader&) = delete;
+		Shader& operator=(const Shader&) = delete;
+
+		void Bind() const;
+
+		void SetInt(const std::string& name, int value);
+		void SetIntArray(const std::string& name, const int* values, uint32_t count);
+		void SetFloat(const std::string& name, float value);
+		void SetMat4(const std::string& name, const float* matrix);
+
+		inline bool IsValid() const { return mRendererID != 0; }
+		inline uint32_t GetRendererID() const { return mRendererID; }
+		inline const std::string& GetName() const { return mName; }
+
+		static std::shared_ptr<Shader> Create(const std::string& name, const std::string& vertexSource, const std::string& fragmentSource);
+	private:
+		uint32_t CompileAndLink(const std::string& vertexSource, const std::string& fragmentSource);
+		uint32_t CompileStage(uint32_t type, const std::string& source);
+		int GetUniformLocation(const std::string& name);
+
+		std::string mName;
+		uint32_t mRendererID = 0;
+		std::unordered_map<std::string, int> mUniformLocations;
+	};
+}
@@ -0,0 +1,246 @@
+#include "jerboa-pch.h"
+#include "ShaderCache.h"
+
+#include "glad/glad.h"
+
+#include <filesystem>
+
+namespace Jerboa {
+	static constexpr uint32_t sMagic = 0x4250534a; // "JSPB"
+	static constexpr uint32_t sFormatVersion = 1;
+
+	struct ProgramBinaryHeader
+	{
+		uint32_t magic;
+		uint32_t formatVersion;
+		uint64_t driverHash;
+		uint64_t sourceHash;
+		uint64_t payloadHash;
+		uint32_t binaryFormat;
+		uint32_t binaryLength;
+	};
+
+	struct ShaderCacheData
+	{
+		std::filesystem::path directory;
+		uint64_t driverHash = 0;
+		bool enabled = false;
+		ShaderCache::Statistics stats;
+	};
+
+	static ShaderCacheData sCache;
+	// File contents by file name, a binary is taken out when it is loaded
+	static std::unordered_map<std::string, std::vector<char>> sPrefetched;
+
+	static uint64_t HashBytes(const void* data, size_t size, uint64_t hash = 0xcbf29ce484222325ull)
+	{
+		// FNV-1a
+		const uint8_t* bytes = static_cast<const uint8_t*>(data);
+		for (size_t i = 0; i < size; i++) {
+			hash ^= bytes[i];
+			hash *= 0x100000001b3ull;
+		}
+		return hash;
+	}
+
+	static uint64_t HashString(const char* string, uint64_t hash)
+	{
+		return string ? HashBytes(string, std::strlen(string), hash) : hash;
+	}
+
+	static std::filesystem::path GetBinaryPath(const std::string& name, uint64_t sourceHash)
+	{
+		char hash[17];
+		std::snprintf(hash, sizeof(hash), "%016llx", static_cast<unsigned long long>(sourceHash));
+		return sCache.directory / (name + "-" + hash + ".bin");
+	}
+
+	void ShaderCache::Prefetch(const std::string& directory)
+	{
+		sPrefetched.clear();
+		std::error_code error;
+		if (directory.empty() || !std::filesystem::is_directory(directory, error))
+			return;
+
+		size_t bytes = 0;
+		for (const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator(directory, error)) {
+			if (entry.path().extension() != ".bin")
+				continue;
+
+			std::ifstream file(entry.path(), std::ios::binary);
+			std::vector<char> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+			bytes += data.size();
+			sPrefetched[entry.path().filename().string()] = std::move(data);
+		}
+		JERBOA_LOG_TRACE("Prefetched {} cached shader binaries ({} KB)", sPrefetched.size(), bytes / 1024);
+	}
+
+	void ShaderCache::Init(const std::string& directory)
+	{
+		sCache = ShaderCacheData();
+		if (directory.empty()) {
+			sPrefetched.clear();
+			return;
+		}
+
+		int formatCount = 0;
+		glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+		if (formatCount <= 0) {
+			JERBOA_LOG_WARN("Shader cache disabled, the driver supports no program binary formats");
+			return;
+		}
+
+		std::error_code error;
+		std::filesystem::create_directories(directory, error);
+		if (error) {
+			JERBOA_LOG_WARN("Shader cache disabled, could not create \"{}\": {}", directory, error.message());
+			return;
+		}
+
+		// Binaries are only valid for the exact driver that produced them
+		uint64_t hash = HashString(reinterpret_cast<const char*>(glGetString(GL_VENDOR)), 0xcbf29ce484222325ull);
+		hash = HashString(reinterpret_cast<const char*>(glGetString(GL_RENDERER)), hash);
+		hash = HashString(reinterpret_cast<const char*>(glGetString(GL_VERSION)), hash);
+
+		sCache.directory = directory;
+		sCache.driverHash = hash;
+		sCache.enabled = true;
+	}
+
+	bool ShaderCache::IsEnabled()
+	{
+		return sCache.enabled;
+	}
+
+	uint64_t ShaderCache::HashSources(const std::string& name, const std::string& vertexSource, const std::string& fragmentSource)
+	{
+		uint64_t hash = HashBytes(name.data(), name.size());
+		hash = HashBytes(vertexSource.data(), vertexSource.size(), hash);
+		return HashBytes(fragmentSource.data(), fragmentSource.size(), hash);
+	}
+
+	uint32_t ShaderCache::Load(const std::string& name, uint64_t sourceHash)
+	{
+		if (!sCache.enabled)
+			return 0;
+
+		std::filesystem::path path = GetBinaryPath(name, sourceHash);
+		std::vector<char> data;
+		auto prefetched = sPrefetched.find(path.filename().string());
+		if (prefetched != sPrefetched.end()) {
+			data = std::move(prefetched->second);
+			sPrefetched.erase(prefetched);
+		}
+		else {
+			std::ifstream file(path, std::ios::binary);
+			if (!file)
+				return 0;
+			data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+		}
+
+		auto reject = [&](const char* reason) -> uint32_t {
+			JERBOA_LOG_WARN("Rejected cached binary of shader \"{}\": {}", name, reason);
+			sCache.stats.rejected++;
+			std::error_code error;
+			std::filesystem::remove(path, error);
+			return 0;
+		};
+
+		ProgramBinaryHeader header;
+		if (data.size() < sizeof(header))
+			return reject("truncated header");
+		std::memcpy(&header, data.data(), sizeof(header));
+		if (header.magic != sMagic || header.formatVersion != sFormatVersion)
+			return reject("unknown file format");
+		if (header.driverHash != sCache.driverHash)
+			return reject("built by a different driver");
+		if (header.sourceHash != sourceHash)
+			return reject("source hash mismatch");
+
+		const char* binary = data.data() + sizeof(header);
+		if (data.size() - sizeof(header) < header.binaryLength)
+			return reject("truncated binary");
+		if (HashBytes(binary, header.binaryLength) != header.payloadHash)
+			return reject("corrupted binary");
+
+		uint32_t program = glCreateProgram();
+		glProgramBinary(program, header.binaryFormat, binary, static_cast<GLsizei>(header.binaryLength));
+
+		// The driver may still refuse the binary, e.g. after an update that kept the version string
+		int linked = 0;
+		glGetProgramiv(program, GL_LINK_STATUS, &linked);
+		if (!linked) {
+			glDeleteProgram(program);
+			return reject("driver refused the binary");
+		}
+
+		return program;
+	}
+
+	void ShaderCache::Store(const std::string& name, uint64_t sourceHash, uint32_t program)
+	{
+		if (!sCache.enabled)
+			return;
+
+		int length = 0;
+		glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+		if (length <= 0)
+			return;
+
+		std::vector<char> binary(length);
+		GLenum binaryFormat = 0;
+		glGetProgramBinary(program, length, &length, &binaryFormat, binary.data());
+
+		ProgramBinaryHeader header;
+		header.magic = sMagic;
+		header.formatVersion = sFormatVersion;
+		header.driverHash = sCache.driverHash;
+		header.sourceHash = sourceHash;
+		header.payloadHash = HashBytes(binary.data(), length);
+		header.binaryFormat = binaryFormat;
+		header.binaryLength = static_cast<uint32_t>(length);
+
+		// Written to a temporary file first so a crash never leaves a half-written binary behind
+		std::filesystem::path path = GetBinaryPath(name, sourceHash);
+		std::filesystem::path temporaryPath = path;
+		temporaryPath += ".tmp";
+		{
+			std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+			file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+			file.write(binary.data(), length);
+			if (!file) {
+				JERBOA_LOG_WARN("Could not write cached binary of shader \"{}\"", name);
+				return;
+			}
+		}
+
+		std::error_code error;
+		std::filesystem::rename(temporaryPath, path, error);
+		if (error)
+			JERBOA_LOG_WARN("Could not store cached binary of shader \"{}\": {}", name, error.message());
+	}
+
+	void ShaderCache::RecordLoad(bool fromCache, double milliseconds)
+	{
+		if (fromCache) {
+			sCache.stats.hits++;
+			sCache.stats.cachedLoadMs += milliseconds;
+		}
+		else {
+			sCache.stats.misses++;
+			sCache.stats.compiledLoadMs += milliseconds;
+		}
+	}
+
+	const ShaderCache::Statistics& ShaderCache::GetStats()
+	{
+		return sCache.stats;
+	}
+
+	void ShaderCache::LogStats()
+	{
+		[[maybe_unused]] const Statistics& stats = sCache.stats;
+		JERBOA_LOG_INFO("Shaders: {} loaded from cache in {:.2f} ms (warm), {} compiled in {:.2f} ms (cold), {} cached binaries rejected",
+			stats.hits, stats.cachedLoadMs, stats.misses, stats.compiledLoadMs, stats.rejected);
+	}
+}
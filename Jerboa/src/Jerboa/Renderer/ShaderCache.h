@@ -0,0 +1,40 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+
+namespace Jerboa {
+	// Stores linked program binaries (glGetProgramBinary) on disk, keyed by a hash of the
+	// shader sources and of the driver identification. Binaries are validated on load and
+	// rejected ones are deleted, so the caller falls back to compiling from source.
+	class ShaderCache
+	{
+	public:
+		struct Statistics
+		{
+			uint32_t hits = 0;
+			uint32_t misses = 0;
+			uint32_t rejected = 0;
+			double cachedLoadMs = 0.0;
+			double compiledLoadMs = 0.0;
+		};
+
+		// Reads the cached binaries into memory. Needs no GL context, so it can run on another
+		// thread while the context is created, as long as it finishes before Init().
+		static void Prefetch(const std::string& directory);
+		// An empty directory disables the cache
+		static void Init(const std::string& directory);
+		static bool IsEnabled();
+
+		static uint64_t HashSources(const std::string& name, const std::string& vertexSource, const std::string& fragmentSource);
+
+		// Returns a linked program, or 0 if there is no valid binary for this driver
+		static uint32_t Load(const std::string& name, uint64_t sourceHash);
+		static void Store(const std::string& name, uint64_t sourceHash, uint32_t program);
+
+		// Shaders report how long creating a program took and whether it came from the cache
+		static void RecordLoad(bool fromCache, double milliseconds);
+		static const Statistics& GetStats();
+		static void LogStats();
+	};
+}
@@ -0,0 +1,98 @@
+#include "jerboa-pch.h"
+#include "StreamingBuffer.h"
+
+#include "GLStateCache.h"
+
+#include "glad/glad.h"
+
+namespace Jerboa {
+	static bool SupportsBufferStorage()
+	{
+		return GLVersion.major > 4 || (GLVersion.major == 4 && GLVersion.minor >= 4);
+	}
+
+	StreamingBuffer::StreamingBuffer(uint32_t target, size_t segmentSize, uint32_t segmentCount)
+		: mTarget(target), mSegmentSize(segmentSize), mSegmentCount(segmentCount), mFences(segmentCount, nullptr)
+	{
+		JERBOA_ASSERT(segmentCount > 0, "A streaming buffer needs at least one segment");
+
+		size_t capacity = mSegmentSize * mSegmentCount;
+		glGenBuffers(1, &mRendererID);
+		GLStateCache::BindBuffer(mTarget, mRendererID);
+
+		if (SupportsBufferStorage()) {
+			GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+			glBufferStorage(mTarget, capacity, nullptr, flags);
+			mPersistentData = static_cast<uint8_t*>(glMapBufferRange(mTarget, 0, capacity, flags));
+			JERBOA_ASSERT(mPersistentData, "Failed to persistently map streaming buffer");
+		}
+		else {
+			glBufferData(mTarget, capacity, nullptr, GL_STREAM_DRAW);
+		}
+	}
+
+	StreamingBuffer::~StreamingBuffer()
+	{
+		for (void* fence : mFences) {
+			if (fence)
+				glDeleteSync(static_cast<GLsync>(fence));
+		}
+
+		if (mPersistentData) {
+			GLStateCache::BindBuffer(mTarget, mRendererID);
+			glUnmapBuffer(mTarget);
+		}
+		GLStateCache::OnBufferDeleted(mRendererID);
+		glDeleteBuffers(1, &mRendererID);
+	}
+
+	void* StreamingBuffer::MapSegment()
+	{
+		WaitForSegment(mCurrentSegment);
+
+		if (mPersistentData)
+			return mPersistentData + GetSegmentOffset();
+
+		GLStateCache::BindBuffer(mTarget, mRendererID);
+		GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_FLUSH_EXPLICIT_BIT;
+		return glMapBufferRange(mTarget, GetSegmentOffset(), mSegmentSize, flags);
+	}
+
+	size_t StreamingBuffer::UnmapSegment(size_t bytesWritten)
+	{
+		JERBOA_ASSERT(bytesWritten <= mSegmentSize, "Wrote past the end of a streaming buffer segment");
+
+		if (!mPersistentData) {
+			GLStateCache::BindBuffer(mTarget, mRendererID);
+			if (bytesWritten > 0)
+				glFlushMappedBufferRange(mTarget, 0, bytesWritten);
+			glUnmapBuffer(mTarget);
+		}
+
+		return GetSegmentOffset();
+	}
+
+	void StreamingBuffer::FenceSegment()
+	{
+		mFences[mCurrentSegment] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		mCurrentSegment = (mCurrentSegment + 1) % mSegmentCount;
+	}
+
+	void StreamingBuffer::WaitForSegment(uint32_t segment)
+	{
+		GLsync fence = static_cast<GLsync>(mFences[segment]);
+		if (!fence)
+			return;
+
+		GLenum result = glClientWaitSync(fence, 0, 0);
+		if (result == GL_TIMEOUT_EXPIRED) {
+			mStallCount++;
+			do {
+				result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+			} while (result == GL_TIMEOUT_EXPIRED);
+		}
+
+		glDeleteSync(fence);
+		mFences[segment] = nullptr;
+	}
+}
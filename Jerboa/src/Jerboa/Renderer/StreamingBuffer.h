@@ -0,0 +1,50 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace Jerboa {
+	// GPU buffer rewritten by the CPU every frame. The buffer is split into segments
+	// which are handed out round-robin; each segment is fenced once the draws reading it
+	// are submitted, and only reused after the GPU signalled that fence.
+	// Uses a persistent coherent mapping when GL 4.4 / ARB_buffer_storage is available,
+	// and unsynchronized glMapBufferRange per segment otherwise.
+	class StreamingBuffer
+	{
+	public:
+		StreamingBuffer(uint32_t target, size_t segmentSize, uint32_t segmentCount = 4);
+		~StreamingBuffer();
+
+		StreamingBuffer(const StreamingBuffer&) = delete;
+		StreamingBuffer& operator=(const StreamingBuffer&) = delete;
+
+		// Returns a write pointer to the current segment, waiting for the GPU only if
+		// it still reads from it
+		void* MapSegment();
+		// Ends writing to the current segment, returns its byte offset inside the buffer
+		size_t UnmapSegment(size_t bytesWritten);
+		// Fences the current segment after the draws reading it were issued and advances
+		void FenceSegment();
+
+		inline uint32_t GetRendererID() const { return mRendererID; }
+		inline size_t GetSegmentSize() const { return mSegmentSize; }
+		inline size_t GetSegmentOffset() const { return mCurrentSegment * mSegmentSize; }
+		inline bool IsPersistentlyMapped() const { return mPersistentData != nullptr; }
+
+		// Number of times MapSegment had to block on the GPU
+		inline uint64_t GetStallCount() const { return mStallCount; }
+	private:
+		void WaitForSegment(uint32_t segment);
+
+		uint32_t mTarget;
+		uint32_t mRendererID = 0;
+		size_t mSegmentSize;
+		uint32_t mSegmentCount;
+		uint32_t mCurrentSegment = 0;
+
+		uint8_t* mPersistentData = nullptr;
+		std::vector<void*> mFences;
+		uint64_t mStallCount = 0;
+	};
+}
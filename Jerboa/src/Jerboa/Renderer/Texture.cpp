@@ -0,0 +1,50 @@
+#include "jerboa-pch.h"
+#include "Texture.h"
+
+#include "GLStateCache.h"
+
+#include "glad/glad.h"
+
+namespace Jerboa {
+	Texture2D::Texture2D(uint32_t width, uint32_t height)
+		: mWidth(width), mHeight(height)
+	{
+		glGenTextures(1, &mRendererID);
+		GLStateCache::BindTexture2D(0, mRendererID);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, mWidth, mHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	}
+
+	Texture2D::~Texture2D()
+	{
+		GLStateCache::OnTextureDeleted(mRendererID);
+		glDeleteTextures(1, &mRendererID);
+	}
+
+	void Texture2D::SetData(const void* data)
+	{
+		GLStateCache::BindTexture2D(0, mRendererID);
+		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, mWidth, mHeight, GL_RGBA, GL_UNSIGNED_BYTE, data);
+	}
+
+	void Texture2D::SetRows(const void* data, uint32_t firstRow, uint32_t rowCount)
+	{
+		JERBOA_ASSERT(firstRow + rowCount <= mHeight, "Texture rows out of range");
+		GLStateCache::BindTexture2D(0, mRendererID);
+		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, firstRow, mWidth, rowCount, GL_RGBA, GL_UNSIGNED_BYTE, data);
+	}
+
+	void Texture2D::Bind(uint32_t slot) const
+	{
+		GLStateCache::BindTexture2D(slot, mRendererID);
+	}
+
+	std::shared_ptr<Texture2D> Texture2D::Create(uint32_t width, uint32_t height)
+	{
+		return std::make_shared<Texture2D>(width, height);
+	}
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <memory>
+#include <cstdint>
+
+namespace Jerboa {
+	// RGBA8 2D texture
+	class Texture2D
+	{
+	public:
+		Texture2D(uint32_t width, uint32_t height);
+		~Texture2D();
+
+		Texture2D(const Texture2D&) = delete;
+		Texture2D& operator=(const Texture2D&) = delete;
+
+		// data must hold width * height RGBA8 pixels
+		void SetData(const void* data);
+		// data holds width * rowCount RGBA8 pixels, for uploads spread over several frames
+		void SetRows(const void* data, uint32_t firstRow, uint32_t rowCount);
+		void Bind(uint32_t slot = 0) const;
+
+		inline uint32_t GetWidth() const { return mWidth; }
+		inline uint32_t GetHeight() const { return mHeight; }
+		inline uint32_t GetRendererID() const { return mRendererID; }
+
+		static std::shared_ptr<Texture2D> Create(uint32_t width, uint32_t height);
+	private:
+		uint32_t mRendererID = 0;
+		uint32_t mWidth, mHeight;
+	};
+}
@@ -0,0 +1,131 @@
+#include "jerboa-pch.h"
+#include "Archetype.h"
+
+namespace Jerboa {
+	namespace {
+		constexpr std::align_val_t ChunkAlignment{ 64 };
+
+		uint32_t AlignUp(uint32_t offset, uint32_t alignment)
+		{
+			return (offset + alignment - 1) & ~(alignment - 1);
+		}
+
+		std::byte* AllocateChunk()
+		{
+			return static_cast<std::byte*>(::operator new(Archetype::ChunkSize, ChunkAlignment));
+		}
+
+		void FreeChunk(std::byte* chunk)
+		{
+			::operator delete(chunk, ChunkAlignment);
+		}
+	}
+
+	Archetype::Archetype(const ComponentMask& mask)
+		: mMask(mask)
+	{
+		mColumnOfComponent.fill(NoColumn);
+
+		uint32_t bytesPerEntity = sizeof(Entity);
+		for (ComponentID id = 0; id < MaxComponentTypes; id++) {
+			if (!mask.test(id))
+				continue;
+
+			const ComponentInfo& info = ComponentRegistry::GetInfo(id);
+			mColumnOfComponent[id] = (int32_t)mComponents.size();
+			mComponents.push_back(id);
+			mColumnInfos.push_back(&info);
+			mColumnSizes.push_back(info.size);
+			bytesPerEntity += info.size;
+		}
+
+		// Start from the unpadded estimate and shrink until the aligned arrays fit
+		mColumnOffsets.resize(mComponents.size());
+		for (mChunkCapacity = (uint32_t)(ChunkSize / bytesPerEntity); mChunkCapacity > 0; mChunkCapacity--) {
+			uint32_t offset = mChunkCapacity * (uint32_t)sizeof(Entity);
+			for (size_t column = 0; column < mComponents.size(); column++) {
+				offset = AlignUp(offset, mColumnInfos[column]->alignment);
+				mColumnOffsets[column] = offset;
+				offset += mChunkCapacity * mColumnSizes[column];
+			}
+
+			if (offset <= ChunkSize)
+				break;
+		}
+		JERBOA_ASSERT(mChunkCapacity > 0, "Component set doesn't fit into a chunk");
+	}
+
+	Archetype::~Archetype()
+	{
+		for (uint32_t chunk = 0; chunk < mChunks.size(); chunk++) {
+			for (uint32_t row = 0; row < mChunks[chunk].count; row++)
+				DestructRow(chunk, row);
+			FreeChunk(mChunks[chunk].data);
+		}
+
+		if (mSpareChunk)
+			FreeChunk(mSpareChunk);
+	}
+
+	void Archetype::Allocate(Entity entity, uint32_t& chunk, uint32_t& row)
+	{
+		AllocateRows(1, chunk, row);
+		GetEntities(chunk)[row] = entity;
+	}
+
+	uint32_t Archetype::AllocateRows(uint32_t count, uint32_t& chunk, uint32_t& firstRow)
+	{
+		if (mChunks.empty() || mChunks.back().count == mChunkCapacity) {
+			std::byte* data = mSpareChunk ? mSpareChunk : AllocateChunk();
+			mSpareChunk = nullptr;
+			mChunks.push_back({ data, 0 });
+		}
+
+		chunk = (uint32_t)mChunks.size() - 1;
+		firstRow = mChunks.back().count;
+		uint32_t added = std::min(count, mChunkCapacity - firstRow);
+		mChunks.back().count += added;
+		mEntityCount += added;
+		return added;
+	}
+
+	Entity Archetype::Remove(uint32_t chunk, uint32_t row, bool destructComponents)
+	{
+		JERBOA_ASSERT(chunk < mChunks.size() && row < mChunks[chunk].count, "Archetype row out of range");
+
+		if (destructComponents)
+			DestructRow(chunk, row);
+
+		uint32_t lastChunk = (uint32_t)mChunks.size() - 1;
+		uint32_t lastRow = mChunks[lastChunk].count - 1;
+
+		Entity moved;
+		if (chunk != lastChunk || row != lastRow) {
+			for (int32_t column = 0; column < (int32_t)mComponents.size(); column++) {
+				void* source = GetComponent(lastChunk, lastRow, column);
+				mColumnInfos[column]->moveConstruct(GetComponent(chunk, row, column), source);
+				mColumnInfos[column]->destruct(source);
+			}
+
+			moved = GetEntities(lastChunk)[lastRow];
+			GetEntities(chunk)[row] = moved;
+		}
+
+		mEntityCount--;
+		if (--mChunks[lastChunk].count == 0) {
+			if (mSpareChunk)
+				FreeChunk(mChunks[lastChunk].data);
+			else
+				mSpareChunk = mChunks[lastChunk].data;
+			mChunks.pop_back();
+		}
+
+		return moved;
+	}
+
+	void Archetype::DestructRow(uint32_t chunk, uint32_t row)
+	{
+		for (int32_t column = 0; column < (int32_t)mComponents.size(); column++)
+			mColumnInfos[column]->destruct(GetComponent(chunk, row, column));
+	}
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "Entity.h"
+#include "Component.h"
+
+#include <vector>
+#include <array>
+#include <unordered_map>
+#include <cstddef>
+
+namespace Jerboa {
+	struct ArchetypeChunk
+	{
+		std::byte* data;
+		uint32_t count;
+	};
+
+	// Stores all entities with exactly one component set. Entities live in fixed-size
+	// chunks, each chunk holds an entity array followed by one array per component so
+	// iterating a component touches contiguous memory. Removal swaps the last entity of
+	// the archetype into the hole, so only the last chunk is ever partially filled.
+	class Archetype
+	{
+	public:
+		static constexpr size_t ChunkSize = 16 * 1024;
+		static constexpr int32_t NoColumn = -1;
+
+		Archetype(const ComponentMask& mask);
+		~Archetype();
+
+		Archetype(const Archetype&) = delete;
+		Archetype& operator=(const Archetype&) = delete;
+
+		inline const ComponentMask& GetMask() const { return mMask; }
+		inline const std::vector<ComponentID>& GetComponents() const { return mComponents; }
+		inline uint32_t GetChunkCapacity() const { return mChunkCapacity; }
+		inline uint32_t GetChunkCount() const { return (uint32_t)mChunks.size(); }
+		inline const ArchetypeChunk& GetChunk(uint32_t chunk) const { return mChunks[chunk]; }
+		inline uint32_t GetEntityCount() const { return mEntityCount; }
+
+		inline int32_t GetColumn(ComponentID id) const { return mColumnOfComponent[id]; }
+		inline Entity* GetEntities(uint32_t chunk) const { return reinterpret_cast<Entity*>(mChunks[chunk].data); }
+		inline void* GetColumnData(uint32_t chunk, int32_t column) const { return mChunks[chunk].data + mColumnOffsets[column]; }
+		inline void* GetComponent(uint32_t chunk, uint32_t row, int32_t column) const
+		{
+			return mChunks[chunk].data + mColumnOffsets[column] + (size_t)row * mColumnSizes[column];
+		}
+
+		// Appends an entity, its components are left unconstructed
+		void Allocate(Entity entity, uint32_t& chunk, uint32_t& row);
+		// Appends up to count rows to the last chunk, or to a new one if it is full, and
+		// returns how many were added. Entities and components are left unwritten.
+		uint32_t AllocateRows(uint32_t count, uint32_t& chunk, uint32_t& firstRow);
+		// Removes the entity at chunk/row by moving the archetype's last entity into its
+		// place and returns the moved entity, or a null entity if the removed one was last.
+		// Components are destructed unless they were already moved out or destructed.
+		Entity Remove(uint32_t chunk, uint32_t row, bool destructComponents);
+
+		// Cached transitions to the archetypes with one component added or removed
+		std::unordered_map<ComponentID, Archetype*> addEdges;
+		std::unordered_map<ComponentID, Archetype*> removeEdges;
+	private:
+		void DestructRow(uint32_t chunk, uint32_t row);
+
+		ComponentMask mMask;
+		std::vector<ComponentID> mComponents;
+		std::array<int32_t, MaxComponentTypes> mColumnOfComponent;
+		std::vector<uint32_t> mColumnOffsets;
+		std::vector<uint32_t> mColumnSizes;
+		std::vector<const ComponentInfo*> mColumnInfos;
+		uint32_t mChunkCapacity = 0;
+
+		std::vector<ArchetypeChunk> mChunks;
+		// One empty chunk is kept around so an entity moving back and forth across a
+		// chunk boundary doesn't allocate every time
+		std::byte* mSpareChunk = nullptr;
+		uint32_t mEntityCount = 0;
+	};
+}
@@ -0,0 +1,45 @@
+#include "jerboa-pch.h"
+#include "Component.h"
+
+#include <mutex>
+#include <atomic>
+
+namespace Jerboa {
+	namespace {
+		struct ComponentRegistryData
+		{
+			std::mutex mutex;
+			std::array<ComponentInfo, MaxComponentTypes> infos;
+			std::atomic<uint32_t> count{ 0 };
+		};
+
+		ComponentRegistryData& GetData()
+		{
+			static ComponentRegistryData data;
+			return data;
+		}
+	}
+
+	const ComponentInfo& ComponentRegistry::GetInfo(ComponentID id)
+	{
+		JERBOA_ASSERT(id < GetCount(), "Unknown component ID");
+		return GetData().infos[id];
+	}
+
+	uint32_t ComponentRegistry::GetCount()
+	{
+		return GetData().count.load(std::memory_order_acquire);
+	}
+
+	ComponentID ComponentRegistry::Register(const ComponentInfo& info)
+	{
+		ComponentRegistryData& data = GetData();
+		std::lock_guard<std::mutex> lock(data.mutex);
+
+		uint32_t id = data.count.load(std::memory_order_relaxed);
+		JERBOA_ASSERT(id < MaxComponentTypes, "Too many component types, raise MaxComponentTypes");
+		data.infos[id] = info;
+		data.count.store(id + 1, std::memory_order_release);
+		return id;
+	}
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <bitset>
+#include <new>
+#include <type_traits>
+#include <typeinfo>
+#include <cstdint>
+
+namespace Jerboa {
+	using ComponentID = uint32_t;
+
+	static constexpr uint32_t MaxComponentTypes = 128;
+	using ComponentMask = std::bitset<MaxComponentTypes>;
+
+	// Type-erased operations the ECS needs to store components in raw chunk memory
+	struct ComponentInfo
+	{
+		const char* name;
+		uint32_t size;
+		uint32_t alignment;
+		void (*defaultConstruct)(void* destination);
+		void (*moveConstruct)(void* destination, void* source);
+		void (*destruct)(void* component);
+	};
+
+	// Assigns every component type a dense ID on first use
+	class ComponentRegistry
+	{
+	public:
+		// const T and T& share the ID of T
+		template<typename T>
+		static ComponentID GetID()
+		{
+			return GetUnqualifiedID<std::remove_cv_t<std::remove_reference_t<T>>>();
+		}
+
+		static const ComponentInfo& GetInfo(ComponentID id);
+		static uint32_t GetCount();
+	private:
+		template<typename T>
+		static ComponentID GetUnqualifiedID()
+		{
+			static const ComponentID id = Register(MakeInfo<T>());
+			return id;
+		}
+
+		static ComponentID Register(const ComponentInfo& info);
+
+		template<typename T>
+		static ComponentInfo MakeInfo()
+		{
+			static_assert(std::is_move_constructible_v<T>, "Components must be move constructible");
+			static_assert(alignof(T) <= 64, "Components can't be aligned beyond a cache line");
+
+			ComponentInfo info;
+			info.name = typeid(T).name();
+			info.size = (uint32_t)sizeof(T);
+			info.alignment = (uint32_t)alignof(T);
+			info.defaultConstruct = [](void* destination) {
+				if constexpr (std::is_default_constructible_v<T>)
+					new (destination) T();
+			};
+			info.moveConstruct = [](void* destination, void* source) { new (destination) T(std::move(*static_cast<T*>(source))); };
+			info.destruct = [](void* component) { static_cast<T*>(component)->~T(); };
+			return info;
+		}
+	};
+
+	template<typename... Components>
+	ComponentMask MakeComponentMask()
+	{
+		ComponentMask mask;
+		(mask.set(ComponentRegistry::GetID<Components>()), ...);
+		return mask;
+	}
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+
+namespace Jerboa {
+	// Handle to an entity in a World. The generation detects handles to destroyed
+	// entities whose index has been reused.
+	struct Entity
+	{
+		static constexpr uint32_t NullIndex = 0xffffffff;
+
+		uint32_t index = NullIndex;
+		uint32_t generation = 0;
+
+		inline bool IsNull() const { return index == NullIndex; }
+		inline uint64_t GetID() const { return ((uint64_t)generation << 32) | index; }
+
+		inline bool operator==(const Entity& other) const { return index == other.index && generation == other.generation; }
+		inline bool operator!=(const Entity& other) const { return !(*this == other); }
+	};
+}
+
+namespace std {
+	template<>
+	struct hash<Jerboa::Entity>
+	{
+		size_t operator()(const Jerboa::Entity& entity) const
+		{
+			return hash<uint64_t>()(entity.GetID());
+		}
+	};
+}
@@ -0,0 +1,27 @@
+#include "jerboa-pch.h"
+#include "Query.h"
+
+#include "World.h"
+
+namespace Jerboa {
+	uint32_t QueryBase::Count() const
+	{
+		mWorld->RefreshQuery(*mData);
+
+		uint32_t count = 0;
+		for (const Archetype* archetype : mData->archetypes)
+			count += archetype->GetEntityCount();
+		return count;
+	}
+
+	void QueryBase::BeginIteration() const
+	{
+		mWorld->RefreshQuery(*mData);
+		mWorld->mIterationDepth.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	void QueryBase::EndIteration() const
+	{
+		mWorld->mIterationDepth.fetch_sub(1, std::memory_order_relaxed);
+	}
+}
@@ -0,0 +1,133 @@
+#pragma once
+
+#include "Archetype.h"
+#include "Jerboa/Core/JobSystem.h"
+
+#include <vector>
+#include <array>
+#include <utility>
+#include <type_traits>
+
+namespace Jerboa {
+	class World;
+
+	// Matching archetypes of one component set, cached by the World and extended as new
+	// archetypes appear
+	struct QueryData
+	{
+		ComponentMask include;
+		std::vector<Archetype*> archetypes;
+		size_t archetypesChecked = 0;
+	};
+
+	class QueryBase
+	{
+	public:
+		QueryBase(World* world, QueryData* data)
+			: mWorld(world), mData(data) {}
+
+		uint32_t Count() const;
+	protected:
+		// Picks up archetypes created since the last iteration and blocks structural
+		// changes in the World until the matching End
+		void BeginIteration() const;
+		void EndIteration() const;
+
+		World* mWorld;
+		QueryData* mData;
+	};
+
+	// Iterates all entities that have at least the components Ts. Components requested
+	// as const are only read, which lets the SystemScheduler run readers in parallel.
+	template<typename... Ts>
+	class Query : public QueryBase
+	{
+	public:
+		using QueryBase::QueryBase;
+
+		static ComponentMask GetReadMask()
+		{
+			ComponentMask mask;
+			((std::is_const_v<Ts> ? (void)mask.set(ComponentRegistry::GetID<Ts>()) : (void)0), ...);
+			return mask;
+		}
+
+		static ComponentMask GetWriteMask()
+		{
+			ComponentMask mask;
+			((!std::is_const_v<Ts> ? (void)mask.set(ComponentRegistry::GetID<Ts>()) : (void)0), ...);
+			return mask;
+		}
+
+		// function(uint32_t count, const Entity* entities, Ts*... componentArrays)
+		template<typename Function>
+		void ForEachChunk(Function&& function) const
+		{
+			BeginIteration();
+			for (Archetype* archetype : mData->archetypes) {
+				const std::array<int32_t, sizeof...(Ts)> columns = GetColumns(archetype);
+				for (uint32_t chunk = 0; chunk < archetype->GetChunkCount(); chunk++)
+					InvokeChunk(function, archetype, chunk, columns, std::index_sequence_for<Ts...>());
+			}
+			EndIteration();
+		}
+
+		// function(Ts&... components) or function(Entity entity, Ts&... components)
+		template<typename Function>
+		void ForEach(Function&& function) const
+		{
+			ForEachChunk([&function](uint32_t count, const Entity* entities, Ts*... components) {
+				for (uint32_t i = 0; i < count; i++)
+					InvokeEntity(function, entities[i], components[i]...);
+			});
+		}
+
+		// Like ForEach, with chunks spread over the JobSystem. function runs concurrently
+		// and must only touch the components it is given.
+		template<typename Function>
+		void ParallelForEach(Function&& function) const
+		{
+			BeginIteration();
+
+			struct ChunkRef { Archetype* archetype; uint32_t chunk; };
+			std::vector<ChunkRef> chunks;
+			for (Archetype* archetype : mData->archetypes)
+				for (uint32_t chunk = 0; chunk < archetype->GetChunkCount(); chunk++)
+					chunks.push_back({ archetype, chunk });
+
+			JobSystem::ParallelFor((uint32_t)chunks.size(), 1, [&](uint32_t begin, uint32_t end) {
+				auto perChunk = [&function](uint32_t count, const Entity* entities, Ts*... components) {
+					for (uint32_t i = 0; i < count; i++)
+						InvokeEntity(function, entities[i], components[i]...);
+				};
+
+				for (uint32_t i = begin; i < end; i++)
+					InvokeChunk(perChunk, chunks[i].archetype, chunks[i].chunk, GetColumns(chunks[i].archetype), std::index_sequence_for<Ts...>());
+			});
+
+			EndIteration();
+		}
+	private:
+		static std::array<int32_t, sizeof...(Ts)> GetColumns(const Archetype* archetype)
+		{
+			return { archetype->GetColumn(ComponentRegistry::GetID<Ts>())... };
+		}
+
+		template<typename Function, size_t... Indices>
+		static void InvokeChunk(Function& function, const Archetype* archetype, uint32_t chunk,
+			const std::array<int32_t, sizeof...(Ts)>& columns, std::index_sequence<Indices...>)
+		{
+			function(archetype->GetChunk(chunk).count, archetype->GetEntities(chunk),
+				static_cast<Ts*>(archetype->GetColumnData(chunk, columns[Indices]))...);
+		}
+
+		template<typename Function>
+		static void InvokeEntity(Function& function, Entity entity, Ts&... components)
+		{
+			if constexpr (std::is_invocable_v<Function&, Entity, Ts&...>)
+				function(entity, components...);
+			else
+				function(components...);
+		}
+	};
+}
@@ -0,0 +1,12 @@
+#include "jerboa-pch.h"
+#include "SceneLayer.h"
+
+namespace Jerboa {
+	SceneLayer::SceneLayer(const std::string& debugName)
+		: Layer(debugName) {}
+
+	void SceneLayer::OnUpdate()
+	{
+		mScheduler.Run(mWorld);
+	}
+}
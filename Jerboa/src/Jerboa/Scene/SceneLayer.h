@@ -0,0 +1,24 @@
+#pragma once
+
+#include "Jerboa/Core/Layer.h"
+#include "World.h"
+#include "SystemScheduler.h"
+
+namespace Jerboa {
+	// Layer that owns a World and runs its systems every OnUpdate. Register systems in
+	// OnAttach of a derived layer; overrides of OnUpdate call SceneLayer::OnUpdate to
+	// keep running them.
+	class SceneLayer : public Layer
+	{
+	public:
+		SceneLayer(const std::string& debugName = "SceneLayer");
+
+		virtual void OnUpdate() override;
+
+		inline World& GetWorld() { return mWorld; }
+		inline SystemScheduler& GetScheduler() { return mScheduler; }
+	protected:
+		World mWorld;
+		SystemScheduler mScheduler;
+	};
+}
@@ -0,0 +1,622 @@
+#include "jerboa-pch.h"
+#include "SceneSerializer.h"
+#include "World.h"
+
+#include "Jerboa/Core/Compression.h"
+#include "Jerboa/Core/JobSystem.h"
+#include "Jerboa/Core/ScratchAllocator.h"
+
+#include <fstream>
+#include <mutex>
+#include <atomic>
+#include <cstring>
+
+namespace Jerboa {
+	static constexpr uint32_t sMagic = 0x4e43534a; // "JSCN"
+	static constexpr uint32_t sFormatVersion = 1;
+
+	namespace {
+		struct Registration
+		{
+			bool registered = false;
+			std::string name;
+			uint64_t nameHash = 0;
+			uint32_t version = 0;
+			SceneSerializer::MigrateFunction migrate = nullptr;
+		};
+
+		using Registrations = std::array<Registration, MaxComponentTypes>;
+
+		struct SceneSerializerData
+		{
+			std::mutex mutex;
+			Registrations registrations;
+		};
+
+		SceneSerializerData& GetData()
+		{
+			static SceneSerializerData data;
+			return data;
+		}
+
+		// Saving and loading work on a copy, so registering doesn't have to wait for them
+		Registrations CopyRegistrations()
+		{
+			SceneSerializerData& data = GetData();
+			std::lock_guard<std::mutex> lock(data.mutex);
+			return data.registrations;
+		}
+
+		uint64_t AlignOffset(uint64_t offset, uint64_t alignment)
+		{
+			return (offset + alignment - 1) & ~(alignment - 1);
+		}
+
+		// Entities first, then one column per component, each starting on a cache line.
+		// Returns the payload size, offsets may be nullptr.
+		uint64_t GetPayloadLayout(uint32_t entityCount, const uint32_t* sizes, uint32_t columnCount, uint32_t* offsets)
+		{
+			uint64_t offset = (uint64_t)entityCount * sizeof(Entity);
+			for (uint32_t column = 0; column < columnCount; column++) {
+				offset = AlignOffset(offset, SceneFile::PayloadAlignment);
+				if (offsets)
+					offsets[column] = (uint32_t)offset;
+				offset += (uint64_t)entityCount * sizes[column];
+			}
+			return offset;
+		}
+
+		template<typename T>
+		bool IsTableValid(uint64_t offset, uint64_t count, uint64_t fileSize)
+		{
+			return offset % alignof(T) == 0 && offset <= fileSize && count <= (fileSize - offset) / sizeof(T);
+		}
+
+		void WritePadding(std::ofstream& file, uint64_t& position, uint64_t target)
+		{
+			static const char zeros[SceneFile::PayloadAlignment] = {};
+			file.write(zeros, target - position);
+			position = target;
+		}
+
+		template<typename T>
+		void WriteTable(std::ofstream& file, uint64_t& position, const std::vector<T>& table)
+		{
+			file.write(reinterpret_cast<const char*>(table.data()), table.size() * sizeof(T));
+			position += table.size() * sizeof(T);
+		}
+	}
+
+	uint64_t SceneFile::HashName(std::string_view name)
+	{
+		// FNV-1a
+		uint64_t hash = 0xcbf29ce484222325ull;
+		for (char character : name) {
+			hash ^= static_cast<uint8_t>(character);
+			hash *= 0x100000001b3ull;
+		}
+		return hash;
+	}
+
+	bool SceneFile::Open(const std::string& path)
+	{
+		Close();
+		if (!mFile.Open(path)) {
+			JERBOA_LOG_ERROR("Could not map scene \"{}\"", path);
+			return false;
+		}
+
+		const uint8_t* data = mFile.GetData();
+		const uint64_t size = mFile.GetSize();
+		const SceneFileHeader* header = reinterpret_cast<const SceneFileHeader*>(data);
+
+		bool valid = size >= sizeof(SceneFileHeader) && header->magic == sMagic && header->formatVersion == sFormatVersion
+			&& IsTableValid<SceneComponentRecord>(header->componentsOffset, header->componentCount, size)
+			&& IsTableValid<SceneArchetypeRecord>(header->archetypesOffset, header->archetypeCount, size)
+			&& IsTableValid<uint32_t>(header->archetypeComponentsOffset, header->archetypeComponentCount, size)
+			&& IsTableValid<SceneChunkRecord>(header->chunksOffset, header->chunkCount, size)
+			&& header->namesOffset <= size && header->namesSize <= size - header->namesOffset;
+		if (valid) {
+			mHeader = header;
+			mComponents = reinterpret_cast<const SceneComponentRecord*>(data + header->componentsOffset);
+			mArchetypes = reinterpret_cast<const SceneArchetypeRecord*>(data + header->archetypesOffset);
+			mArchetypeComponents = reinterpret_cast<const uint32_t*>(data + header->archetypeComponentsOffset);
+			mChunks = reinterpret_cast<const SceneChunkRecord*>(data + header->chunksOffset);
+			mNames = reinterpret_cast<const char*>(data + header->namesOffset);
+		}
+
+		for (uint32_t i = 0; valid && i < header->componentCount; i++) {
+			const SceneComponentRecord& component = mComponents[i];
+			valid = (uint64_t)component.nameOffset + component.nameLength <= header->namesSize
+				&& component.size > 0 && component.alignment > 0 && component.alignment <= PayloadAlignment
+				&& (component.alignment & (component.alignment - 1)) == 0;
+		}
+
+		for (uint32_t i = 0; valid && i < header->archetypeCount; i++) {
+			const SceneArchetypeRecord& archetype = mArchetypes[i];
+			valid = (uint64_t)archetype.firstComponent + archetype.componentCount <= header->archetypeComponentCount
+				&& archetype.componentCount <= MaxComponentTypes
+				&& (uint64_t)archetype.firstChunk + archetype.chunkCount <= header->chunkCount;
+			for (uint32_t component = 0; valid && component < archetype.componentCount; component++)
+				valid = mArchetypeComponents[archetype.firstComponent + component] < header->componentCount;
+		}
+
+		uint64_t entityCount = 0;
+		for (uint32_t i = 0; valid && i < header->chunkCount; i++) {
+			const SceneChunkRecord& chunk = mChunks[i];
+			valid = chunk.archetype < header->archetypeCount && chunk.entityCount > 0
+				&& i >= mArchetypes[chunk.archetype].firstChunk && i - mArchetypes[chunk.archetype].firstChunk < mArchetypes[chunk.archetype].chunkCount
+				&& chunk.offset % PayloadAlignment == 0 && chunk.offset <= size && chunk.storedSize <= size - chunk.offset
+				&& (chunk.compression == SceneCompression::LZ || (chunk.compression == SceneCompression::None && chunk.storedSize == chunk.rawSize));
+			if (!valid)
+				break;
+
+			// The payload layout follows from the schema, so columns can't point outside of it
+			const SceneArchetypeRecord& archetype = mArchetypes[chunk.archetype];
+			uint32_t sizes[MaxComponentTypes];
+			for (uint32_t column = 0; column < archetype.componentCount; column++)
+				sizes[column] = mComponents[mArchetypeComponents[archetype.firstComponent + column]].size;
+			valid = GetPayloadLayout(chunk.entityCount, sizes, archetype.componentCount, nullptr) == chunk.rawSize;
+			entityCount += chunk.entityCount;
+		}
+
+		if (!valid || entityCount != header->entityCount || header->entityCount > header->recordCount) {
+			JERBOA_LOG_ERROR("\"{}\" is not a valid scene", path);
+			Close();
+			return false;
+		}
+
+		mPath = path;
+		return true;
+	}
+
+	void SceneFile::Close()
+	{
+		mFile.Close();
+		mPath.clear();
+		mHeader = nullptr;
+		mComponents = nullptr;
+		mArchetypes = nullptr;
+		mArchetypeComponents = nullptr;
+		mChunks = nullptr;
+		mNames = nullptr;
+	}
+
+	std::string_view SceneFile::GetComponentName(const SceneComponentRecord& component) const
+	{
+		return std::string_view(mNames + component.nameOffset, component.nameLength);
+	}
+
+	int32_t SceneFile::FindComponent(std::string_view name) const
+	{
+		const uint64_t hash = HashName(name);
+		for (uint32_t i = 0; i < mHeader->componentCount; i++) {
+			if (mComponents[i].nameHash == hash && GetComponentName(mComponents[i]) == name)
+				return (int32_t)i;
+		}
+		return NoColumn;
+	}
+
+	int32_t SceneFile::GetColumn(const SceneArchetypeRecord& archetype, uint32_t component) const
+	{
+		const uint32_t* components = GetArchetypeComponents(archetype);
+		for (uint32_t column = 0; column < archetype.componentCount; column++) {
+			if (components[column] == component)
+				return (int32_t)column;
+		}
+		return NoColumn;
+	}
+
+	uint32_t SceneFile::GetColumnOffset(const SceneChunkRecord& chunk, int32_t column) const
+	{
+		const SceneArchetypeRecord& archetype = mArchetypes[chunk.archetype];
+		const uint32_t* components = GetArchetypeComponents(archetype);
+		JERBOA_ASSERT(column >= 0 && (uint32_t)column < archetype.componentCount, "Scene column out of range");
+
+		uint64_t offset = (uint64_t)chunk.entityCount * sizeof(Entity);
+		for (int32_t previous = 0; previous < column; previous++)
+			offset = AlignOffset(offset, PayloadAlignment) + (uint64_t)chunk.entityCount * mComponents[components[previous]].size;
+		return (uint32_t)AlignOffset(offset, PayloadAlignment);
+	}
+
+	const uint8_t* SceneFile::GetRawChunk(const SceneChunkRecord& chunk) const
+	{
+		return chunk.compression == SceneCompression::None ? mFile.GetData() + chunk.offset : nullptr;
+	}
+
+	bool SceneFile::ReadChunk(const SceneChunkRecord& chunk, void* destination) const
+	{
+		const uint8_t* stored = mFile.GetData() + chunk.offset;
+		if (chunk.compression == SceneCompression::None) {
+			std::memcpy(destination, stored, chunk.rawSize);
+			return true;
+		}
+		return Compression::Decompress(stored, chunk.storedSize, destination, chunk.rawSize);
+	}
+
+	void SceneSerializer::Register(ComponentID id, std::string_view name, uint32_t version, MigrateFunction migrate)
+	{
+		SceneSerializerData& data = GetData();
+		std::lock_guard<std::mutex> lock(data.mutex);
+
+		const uint64_t hash = SceneFile::HashName(name);
+		for (Registration& registration : data.registrations) {
+			if (registration.registered && registration.nameHash == hash && registration.name == name)
+				registration = Registration();
+		}
+
+		Registration& registration = data.registrations[id];
+		registration.registered = true;
+		registration.name = std::string(name);
+		registration.nameHash = hash;
+		registration.version = version;
+		registration.migrate = migrate;
+	}
+
+	bool SceneSerializer::Save(const World& world, const std::string& path, bool compress)
+	{
+		world.AssertNotIterating();
+		const Registrations registrations = CopyRegistrations();
+
+		// Schemas of the registered components the world uses
+		std::vector<SceneComponentRecord> components;
+		std::string names;
+		std::array<int32_t, MaxComponentTypes> componentRecords;
+		componentRecords.fill(SceneFile::NoColumn);
+
+		struct PendingChunk
+		{
+			const Archetype* archetype;
+			uint32_t chunk;
+			uint32_t fileArchetype;
+		};
+
+		std::vector<SceneArchetypeRecord> archetypes;
+		std::vector<uint32_t> archetypeComponents;
+		std::vector<std::vector<int32_t>> archetypeColumns;
+		std::vector<PendingChunk> pending;
+		for (const std::unique_ptr<Archetype>& archetype : world.mArchetypes) {
+			if (archetype->GetEntityCount() == 0)
+				continue;
+
+			SceneArchetypeRecord record = {};
+			record.firstComponent = (uint32_t)archetypeComponents.size();
+			std::vector<int32_t> columns;
+			for (ComponentID id : archetype->GetComponents()) {
+				const Registration& registration = registrations[id];
+				if (!registration.registered)
+					continue;
+
+				if (componentRecords[id] == SceneFile::NoColumn) {
+					const ComponentInfo& info = ComponentRegistry::GetInfo(id);
+					SceneComponentRecord component = {};
+					component.nameHash = registration.nameHash;
+					component.nameOffset = (uint32_t)names.size();
+					component.nameLength = (uint32_t)registration.name.size();
+					component.version = registration.version;
+					component.size = info.size;
+					component.alignment = info.alignment;
+					componentRecords[id] = (int32_t)components.size();
+					components.push_back(component);
+					names += registration.name;
+				}
+
+				archetypeComponents.push_back((uint32_t)componentRecords[id]);
+				columns.push_back(archetype->GetColumn(id));
+			}
+
+			record.componentCount = (uint32_t)columns.size();
+			record.firstChunk = (uint32_t)pending.size();
+			record.chunkCount = archetype->GetChunkCount();
+			for (uint32_t chunk = 0; chunk < archetype->GetChunkCount(); chunk++)
+				pending.push_back({ archetype.get(), chunk, (uint32_t)archetypes.size() });
+
+			archetypes.push_back(record);
+			archetypeColumns.push_back(std::move(columns));
+		}
+
+		// Payloads are built and compressed in parallel, then written in order
+		std::vector<SceneChunkRecord> chunks(pending.size());
+		std::vector<std::vector<uint8_t>> payloads(pending.size());
+		JobSystem::ParallelFor((uint32_t)pending.size(), 4, [&](uint32_t begin, uint32_t end) {
+			for (uint32_t i = begin; i < end; i++) {
+				ScratchScope scratch;
+				const PendingChunk& source = pending[i];
+				const SceneArchetypeRecord& archetype = archetypes[source.fileArchetype];
+				const std::vector<int32_t>& columns = archetypeColumns[source.fileArchetype];
+				const uint32_t count = source.archetype->GetChunk(source.chunk).count;
+
+				uint32_t sizes[MaxComponentTypes], offsets[MaxComponentTypes];
+				for (uint32_t column = 0; column < archetype.componentCount; column++)
+					sizes[column] = components[archetypeComponents[archetype.firstComponent + column]].size;
+				const uint32_t rawSize = (uint32_t)GetPayloadLayout(count, sizes, archetype.componentCount, offsets);
+
+				// Padding is zeroed so saving the same world twice gives the same file
+				uint8_t* raw = static_cast<uint8_t*>(scratch.GetArena().Allocate(rawSize, SceneFile::PayloadAlignment));
+				std::memset(raw, 0, rawSize);
+				std::memcpy(raw, source.archetype->GetEntities(source.chunk), count * sizeof(Entity));
+				for (uint32_t column = 0; column < archetype.componentCount; column++)
+					std::memcpy(raw + offsets[column], source.archetype->GetColumnData(source.chunk, columns[column]), (size_t)count * sizes[column]);
+
+				SceneChunkRecord& chunk = chunks[i];
+				chunk.rawSize = rawSize;
+				chunk.archetype = source.fileArchetype;
+				chunk.entityCount = count;
+				chunk.compression = SceneCompression::None;
+
+				// Chunks that don't shrink are stored raw and can be read in place
+				size_t compressedSize = 0;
+				uint8_t* compressed = nullptr;
+				if (compress) {
+					compressed = static_cast<uint8_t*>(scratch.GetArena().Allocate(rawSize));
+					compressedSize = Compression::Compress(raw, rawSize, compressed, rawSize - 1);
+				}
+
+				if (compressedSize > 0) {
+					chunk.compression = SceneCompression::LZ;
+					payloads[i].assign(compressed, compressed + compressedSize);
+				}
+				else {
+					payloads[i].assign(raw, raw + rawSize);
+				}
+				chunk.storedSize = (uint32_t)payloads[i].size();
+			}
+		});
+
+		SceneFileHeader header = {};
+		header.magic = sMagic;
+		header.formatVersion = sFormatVersion;
+		header.componentCount = (uint32_t)components.size();
+		header.archetypeCount = (uint32_t)archetypes.size();
+		header.chunkCount = (uint32_t)chunks.size();
+		header.entityCount = world.mEntityCount;
+		header.recordCount = (uint32_t)world.mRecords.size();
+		header.archetypeComponentCount = (uint32_t)archetypeComponents.size();
+
+		uint64_t offset = sizeof(SceneFileHeader);
+		header.componentsOffset = offset;
+		offset += components.size() * sizeof(SceneComponentRecord);
+		header.archetypesOffset = offset;
+		offset += archetypes.size() * sizeof(SceneArchetypeRecord);
+		header.archetypeComponentsOffset = offset;
+		offset += archetypeComponents.size() * sizeof(uint32_t);
+		header.chunksOffset = offset = AlignOffset(offset, alignof(SceneChunkRecord));
+		offset += chunks.size() * sizeof(SceneChunkRecord);
+		header.namesOffset = offset;
+		header.namesSize = names.size();
+		offset += names.size();
+		for (SceneChunkRecord& chunk : chunks) {
+			chunk.offset = offset = AlignOffset(offset, SceneFile::PayloadAlignment);
+			offset += chunk.storedSize;
+		}
+
+		std::ofstream file(path, std::ios::binary);
+		if (!file) {
+			JERBOA_LOG_ERROR("Could not write scene \"{}\"", path);
+			return false;
+		}
+
+		uint64_t position = 0;
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		position += sizeof(header);
+		WriteTable(file, position, components);
+		WriteTable(file, position, archetypes);
+		WriteTable(file, position, archetypeComponents);
+		WritePadding(file, position, header.chunksOffset);
+		WriteTable(file, position, chunks);
+		file.write(names.data(), names.size());
+		position += names.size();
+		for (size_t i = 0; i < chunks.size(); i++) {
+			WritePadding(file, position, chunks[i].offset);
+			file.write(reinterpret_cast<const char*>(payloads[i].data()), payloads[i].size());
+			position += payloads[i].size();
+		}
+
+		if (!file) {
+			JERBOA_LOG_ERROR("Could not write scene \"{}\"", path);
+			return false;
+		}
+		return true;
+	}
+
+	bool SceneSerializer::Load(World& world, const std::string& path)
+	{
+		SceneFile file;
+		if (!file.Open(path))
+			return false;
+		return Load(world, file);
+	}
+
+	bool SceneSerializer::Load(World& world, const SceneFile& file)
+	{
+		JERBOA_ASSERT(file.IsOpen(), "Loading a scene file that is not open");
+		JERBOA_ASSERT(world.mEntityCount == 0, "Scenes can only be loaded into worlds without entities");
+		world.AssertNotIterating();
+		const Registrations registrations = CopyRegistrations();
+
+		// Match the file's components to the registered ones
+		struct ComponentPlan
+		{
+			bool load = false;
+			ComponentID id = 0;
+			MigrateFunction migrate = nullptr;
+		};
+
+		std::vector<ComponentPlan> componentPlans(file.GetComponentCount());
+		for (uint32_t i = 0; i < file.GetComponentCount(); i++) {
+			const SceneComponentRecord& component = file.GetComponent(i);
+			const std::string_view name = file.GetComponentName(component);
+
+			ComponentID id = 0;
+			while (id < MaxComponentTypes && !(registrations[id].registered && registrations[id].nameHash == component.nameHash && registrations[id].name == name))
+				id++;
+			if (id == MaxComponentTypes) {
+				JERBOA_LOG_WARN("\"{}\": component \"{}\" is not registered and is skipped", file.GetPath(), name);
+				continue;
+			}
+
+			const Registration& registration = registrations[id];
+			const ComponentInfo& info = ComponentRegistry::GetInfo(id);
+			ComponentPlan& plan = componentPlans[i];
+			if (component.version != registration.version && registration.migrate) {
+				plan.migrate = registration.migrate;
+			}
+			else if (component.version != registration.version) {
+				JERBOA_LOG_WARN("\"{}\": component \"{}\" was saved with version {}, version {} has no migration and it is skipped",
+					file.GetPath(), name, component.version, registration.version);
+				continue;
+			}
+			else if (component.size != info.size || component.alignment != info.alignment) {
+				JERBOA_LOG_WARN("\"{}\": component \"{}\" changed its layout without a version bump and is skipped", file.GetPath(), name);
+				continue;
+			}
+			plan.load = true;
+			plan.id = id;
+		}
+
+		struct ColumnPlan
+		{
+			int32_t fileColumn;
+			int32_t column;
+			uint32_t fileSize;
+			uint32_t fileVersion;
+			MigrateFunction migrate;
+		};
+
+		struct ArchetypePlan
+		{
+			Archetype* archetype;
+			std::vector<ColumnPlan> columns;
+		};
+
+		std::vector<ArchetypePlan> archetypePlans(file.GetArchetypeCount());
+		for (uint32_t i = 0; i < file.GetArchetypeCount(); i++) {
+			const SceneArchetypeRecord& record = file.GetArchetype(i);
+			const uint32_t* components = file.GetArchetypeComponents(record);
+
+			ComponentMask mask;
+			for (uint32_t column = 0; column < record.componentCount; column++) {
+				if (componentPlans[components[column]].load)
+					mask.set(componentPlans[components[column]].id);
+			}
+
+			ArchetypePlan& plan = archetypePlans[i];
+			plan.archetype = world.GetArchetype(mask);
+			for (uint32_t column = 0; column < record.componentCount; column++) {
+				const ComponentPlan& component = componentPlans[components[column]];
+				if (component.load) {
+					const SceneComponentRecord& schema = file.GetComponent(components[column]);
+					plan.columns.push_back({ (int32_t)column, plan.archetype->GetColumn(component.id), schema.size, schema.version, component.migrate });
+				}
+			}
+		}
+
+		// Rows are allocated up front, a file chunk may straddle two archetype chunks
+		struct Placement
+		{
+			Archetype* archetype;
+			uint32_t chunk;
+			uint32_t row;
+			uint32_t count;
+			uint32_t fileRow;
+		};
+
+		std::vector<Placement> placements;
+		std::vector<uint32_t> chunkPlacements(file.GetChunkCount() + 1);
+		for (uint32_t i = 0; i < file.GetChunkCount(); i++) {
+			const SceneChunkRecord& chunk = file.GetChunk(i);
+			Archetype* archetype = archetypePlans[chunk.archetype].archetype;
+			chunkPlacements[i] = (uint32_t)placements.size();
+			for (uint32_t fileRow = 0; fileRow < chunk.entityCount;) {
+				Placement placement;
+				placement.archetype = archetype;
+				placement.fileRow = fileRow;
+				placement.count = archetype->AllocateRows(chunk.entityCount - fileRow, placement.chunk, placement.row);
+				placements.push_back(placement);
+				fileRow += placement.count;
+			}
+		}
+		chunkPlacements[file.GetChunkCount()] = (uint32_t)placements.size();
+
+		const uint32_t recordCount = file.GetHeader().recordCount;
+		world.mRecords.assign(recordCount, World::EntityRecord());
+		world.mFreeIndices.clear();
+
+		// Entities are only known once their chunk is decompressed, each index is claimed
+		// before its record is written so a corrupt file listing one twice fails instead
+		std::vector<std::atomic<uint64_t>> claimedIndices((recordCount + 63) / 64);
+
+		// Chunks are decompressed and copied column by column in parallel
+		std::atomic<bool> failed{ false };
+		JobSystem::ParallelFor(file.GetChunkCount(), 4, [&](uint32_t begin, uint32_t end) {
+			for (uint32_t i = begin; i < end && !failed.load(std::memory_order_relaxed); i++) {
+				ScratchScope scratch;
+				const SceneChunkRecord& chunk = file.GetChunk(i);
+				const uint8_t* raw = file.GetRawChunk(chunk);
+				if (!raw) {
+					uint8_t* buffer = static_cast<uint8_t*>(scratch.GetArena().Allocate(chunk.rawSize, SceneFile::PayloadAlignment));
+					if (!file.ReadChunk(chunk, buffer)) {
+						failed.store(true, std::memory_order_relaxed);
+						return;
+					}
+					raw = buffer;
+				}
+
+				const Entity* entities = reinterpret_cast<const Entity*>(raw);
+				const ArchetypePlan& plan = archetypePlans[chunk.archetype];
+				for (uint32_t p = chunkPlacements[i]; p < chunkPlacements[i + 1]; p++) {
+					const Placement& placement = placements[p];
+					Entity* target = placement.archetype->GetEntities(placement.chunk) + placement.row;
+					for (uint32_t row = 0; row < placement.count; row++) {
+						const Entity entity = entities[placement.fileRow + row];
+						const uint64_t bit = 1ull << (entity.index % 64);
+						if (entity.index >= recordCount || (claimedIndices[entity.index / 64].fetch_or(bit, std::memory_order_relaxed) & bit)) {
+							failed.store(true, std::memory_order_relaxed);
+							return;
+						}
+
+						target[row] = entity;
+						World::EntityRecord& record = world.mRecords[entity.index];
+						record.archetype = placement.archetype;
+						record.chunk = placement.chunk;
+						record.row = placement.row + row;
+						record.generation = entity.generation;
+					}
+
+					for (const ColumnPlan& column : plan.columns) {
+						const uint8_t* source = raw + file.GetColumnOffset(chunk, column.fileColumn) + (size_t)placement.fileRow * column.fileSize;
+						void* destination = placement.archetype->GetComponent(placement.chunk, placement.row, column.column);
+						if (column.migrate)
+							column.migrate(column.fileVersion, source, destination, placement.count);
+						else
+							std::memcpy(destination, source, (size_t)placement.count * column.fileSize);
+					}
+				}
+			}
+		});
+
+		// Free indices are handed out lowest first
+		uint32_t liveCount = 0;
+		for (uint32_t index = recordCount; index-- > 0;) {
+			if (world.mRecords[index].archetype)
+				liveCount++;
+			else
+				world.mFreeIndices.push_back(index);
+		}
+
+		if (failed.load() || liveCount != file.GetEntityCount()) {
+			// Placements are the last rows of their archetypes, removing them backwards moves nothing
+			for (size_t p = placements.size(); p-- > 0;) {
+				for (uint32_t row = placements[p].count; row-- > 0;)
+					placements[p].archetype->Remove(placements[p].chunk, placements[p].row + row, false);
+			}
+			world.mRecords.clear();
+			world.mFreeIndices.clear();
+			JERBOA_LOG_ERROR("\"{}\" has corrupt chunks, nothing was loaded", file.GetPath());
+			return false;
+		}
+
+		world.mEntityCount = liveCount;
+		return true;
+	}
+}
@@ -0,0 +1,158 @@
+#pragma once
+
+#include "Entity.h"
+#include "Component.h"
+#include "Jerboa/Core/MappedFile.h"
+
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <cstdint>
+
+namespace Jerboa {
+	class World;
+
+	// Scene layout: header, component schemas, archetypes, the component list of each
+	// archetype, chunk records, names, then the chunk payloads each starting on a
+	// PayloadAlignment boundary. A payload is laid out like an archetype chunk: the entity
+	// array followed by one array per component, each column starting on a cache line.
+	// Offsets are relative to the start of the file, so uncompressed payloads can be read
+	// straight from a mapping.
+	struct SceneFileHeader
+	{
+		uint32_t magic;
+		uint32_t formatVersion;
+		uint32_t componentCount;
+		uint32_t archetypeCount;
+		uint32_t chunkCount;
+		uint32_t entityCount;
+		// Highest entity index plus one, indices and generations survive a round trip
+		uint32_t recordCount;
+		uint32_t archetypeComponentCount;
+		uint64_t componentsOffset;
+		uint64_t archetypesOffset;
+		uint64_t archetypeComponentsOffset;
+		uint64_t chunksOffset;
+		uint64_t namesOffset;
+		uint64_t namesSize;
+	};
+
+	struct SceneComponentRecord
+	{
+		uint64_t nameHash;
+		uint32_t nameOffset;
+		uint32_t nameLength;
+		// Schema version of the component when the scene was saved
+		uint32_t version;
+		uint32_t size;
+		uint32_t alignment;
+		uint32_t reserved;
+	};
+
+	struct SceneArchetypeRecord
+	{
+		// Range in the archetype component list, which holds component record indices
+		uint32_t firstComponent;
+		uint32_t componentCount;
+		// The chunks of an archetype are stored next to each other
+		uint32_t firstChunk;
+		uint32_t chunkCount;
+	};
+
+	enum class SceneCompression : uint32_t
+	{
+		None,
+		LZ
+	};
+
+	struct SceneChunkRecord
+	{
+		uint64_t offset;
+		uint32_t storedSize;
+		uint32_t rawSize;
+		uint32_t archetype;
+		uint32_t entityCount;
+		SceneCompression compression;
+		uint32_t reserved;
+	};
+
+	// Memory-mapped scene file. Opening validates the tables, payloads are only paged in
+	// when they are read.
+	class SceneFile
+	{
+	public:
+		static constexpr uint32_t PayloadAlignment = 64;
+		static constexpr int32_t NoColumn = -1;
+
+		bool Open(const std::string& path);
+		void Close();
+
+		inline bool IsOpen() const { return mFile.IsOpen(); }
+		inline const std::string& GetPath() const { return mPath; }
+		inline const SceneFileHeader& GetHeader() const { return *mHeader; }
+
+		inline uint32_t GetComponentCount() const { return mHeader->componentCount; }
+		inline const SceneComponentRecord& GetComponent(uint32_t index) const { return mComponents[index]; }
+		std::string_view GetComponentName(const SceneComponentRecord& component) const;
+		// Index of the component record, or NoColumn
+		int32_t FindComponent(std::string_view name) const;
+
+		inline uint32_t GetArchetypeCount() const { return mHeader->archetypeCount; }
+		inline const SceneArchetypeRecord& GetArchetype(uint32_t index) const { return mArchetypes[index]; }
+		inline const uint32_t* GetArchetypeComponents(const SceneArchetypeRecord& archetype) const { return mArchetypeComponents + archetype.firstComponent; }
+		// Column of a component record in the archetype's payloads, or NoColumn
+		int32_t GetColumn(const SceneArchetypeRecord& archetype, uint32_t component) const;
+
+		inline uint32_t GetChunkCount() const { return mHeader->chunkCount; }
+		inline uint32_t GetEntityCount() const { return mHeader->entityCount; }
+		inline const SceneChunkRecord& GetChunk(uint32_t index) const { return mChunks[index]; }
+		uint32_t GetColumnOffset(const SceneChunkRecord& chunk, int32_t column) const;
+
+		// Payload in the mapping, nullptr for compressed chunks
+		const uint8_t* GetRawChunk(const SceneChunkRecord& chunk) const;
+		// Decompresses or copies the payload, destination must hold chunk.rawSize bytes.
+		// Thread safe.
+		bool ReadChunk(const SceneChunkRecord& chunk, void* destination) const;
+
+		static uint64_t HashName(std::string_view name);
+	private:
+		MappedFile mFile;
+		std::string mPath;
+		const SceneFileHeader* mHeader = nullptr;
+		const SceneComponentRecord* mComponents = nullptr;
+		const SceneArchetypeRecord* mArchetypes = nullptr;
+		const uint32_t* mArchetypeComponents = nullptr;
+		const SceneChunkRecord* mChunks = nullptr;
+		const char* mNames = nullptr;
+	};
+
+	// Saves and loads the components of a World that were registered for serialization.
+	// Chunks are compressed and decompressed in parallel on the job system, loading copies
+	// whole columns into freshly allocated archetype chunks.
+	class SceneSerializer
+	{
+	public:
+		// Converts count components saved with an older schema version, destination is
+		// uninitialized memory for count components of the current version
+		using MigrateFunction = void (*)(uint32_t fileVersion, const void* source, void* destination, uint32_t count);
+
+		// Components are matched by name between the file and the running program. Bump the
+		// version when the layout changes, scenes saved with another version are converted
+		// by migrate or lose the component. Registering a name again moves it to the new type.
+		template<typename T>
+		static void RegisterComponent(std::string_view name, uint32_t version = 1, MigrateFunction migrate = nullptr)
+		{
+			static_assert(std::is_trivially_copyable_v<T>, "Serialized components are saved as raw bytes and must be trivially copyable");
+			Register(ComponentRegistry::GetID<T>(), name, version, migrate);
+		}
+
+		// Entities keep their index and generation, unregistered components are not saved
+		static bool Save(const World& world, const std::string& path, bool compress = true);
+
+		// The world must not have any entities
+		static bool Load(World& world, const std::string& path);
+		static bool Load(World& world, const SceneFile& file);
+	private:
+		static void Register(ComponentID id, std::string_view name, uint32_t version, MigrateFunction migrate);
+	};
+}
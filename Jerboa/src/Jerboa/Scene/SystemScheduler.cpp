@@ -0,0 +1,79 @@
+#include "jerboa-pch.h"
+#include "SystemScheduler.h"
+
+#include "Jerboa/Core/JobSystem.h"
+#include "Jerboa/Profiling/Profiler.h"
+#include "Jerboa/Profiling/MemoryTracker.h"
+
+namespace Jerboa {
+	void SystemScheduler::AddExclusiveSystem(const std::string& name, std::function<void(World&)> function)
+	{
+		System system;
+		system.name = name;
+		system.exclusive = true;
+		system.run = std::move(function);
+		AddSystem(std::move(system));
+	}
+
+	void SystemScheduler::Run(World& world)
+	{
+		JERBOA_PROFILE_SCOPE("SystemScheduler::Run");
+		JERBOA_MEMORY_TAG(Scene);
+
+		for (const std::vector<uint32_t>& stage : mStages) {
+			if (stage.size() == 1) {
+				mSystems[stage[0]].run(world);
+				continue;
+			}
+
+			// Queries get created and extended here on the calling thread, systems running
+			// in parallel then only read the query cache
+			for (uint32_t index : stage)
+				mSystems[index].prepare(world);
+			world.RefreshQueries();
+
+			JobCounter counter;
+			for (size_t i = 1; i < stage.size(); i++) {
+				System& system = mSystems[stage[i]];
+				JobSystem::Submit([&system, &world]() { system.run(world); }, counter);
+			}
+
+			mSystems[stage[0]].run(world);
+			JobSystem::Wait(counter);
+		}
+	}
+
+	void SystemScheduler::LogStages() const
+	{
+		for (size_t stage = 0; stage < mStages.size(); stage++) {
+			std::string names;
+			for (uint32_t index : mStages[stage])
+				names += (names.empty() ? "" : ", ") + mSystems[index].name;
+			JERBOA_LOG_INFO("System stage {}: {}", stage, names);
+		}
+	}
+
+	void SystemScheduler::AddSystem(System&& system)
+	{
+		// A system goes into the first stage after every earlier system it conflicts with
+		uint32_t stage = 0;
+		for (const System& other : mSystems) {
+			if (Conflicts(system, other))
+				stage = std::max(stage, other.stage + 1);
+		}
+
+		system.stage = stage;
+		if (stage >= mStages.size())
+			mStages.resize(stage + 1);
+		mStages[stage].push_back((uint32_t)mSystems.size());
+		mSystems.push_back(std::move(system));
+	}
+
+	bool SystemScheduler::Conflicts(const System& a, const System& b)
+	{
+		if (a.exclusive || b.exclusive)
+			return true;
+
+		return (a.writes & (b.reads | b.writes)).any() || (a.reads & b.writes).any();
+	}
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "World.h"
+
+#include <string>
+#include <vector>
+#include <functional>
+
+namespace Jerboa {
+	// Runs systems over a World once per Run(). Systems declare the components they read
+	// and write, systems that don't conflict are grouped into stages and a stage's systems
+	// run in parallel on the JobSystem. Conflicting systems keep their registration order.
+	class SystemScheduler
+	{
+	public:
+		// function(Query<Ts...>&), components declared const are read-only
+		template<typename... Ts, typename Function>
+		void AddSystem(const std::string& name, Function&& function)
+		{
+			System system;
+			system.name = name;
+			system.reads = Query<Ts...>::GetReadMask();
+			system.writes = Query<Ts...>::GetWriteMask();
+			system.prepare = [](World& world) { world.GetQuery<Ts...>(); };
+			system.run = [function = std::forward<Function>(function)](World& world) mutable {
+				Query<Ts...> query = world.GetQuery<Ts...>();
+				function(query);
+			};
+			AddSystem(std::move(system));
+		}
+
+		// Runs alone and may make structural changes to the World
+		void AddExclusiveSystem(const std::string& name, std::function<void(World&)> function);
+
+		void Run(World& world);
+
+		inline uint32_t GetSystemCount() const { return (uint32_t)mSystems.size(); }
+		inline uint32_t GetStageCount() const { return (uint32_t)mStages.size(); }
+		void LogStages() const;
+	private:
+		struct System
+		{
+			std::string name;
+			ComponentMask reads;
+			ComponentMask writes;
+			bool exclusive = false;
+			std::function<void(World&)> prepare;
+			std::function<void(World&)> run;
+			uint32_t stage = 0;
+		};
+
+		void AddSystem(System&& system);
+		static bool Conflicts(const System& a, const System& b);
+
+		std::vector<System> mSystems;
+		std::vector<std::vector<uint32_t>> mStages;
+	};
+}
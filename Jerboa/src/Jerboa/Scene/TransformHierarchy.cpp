@@ -0,0 +1,524 @@
+#include "jerboa-pch.h"
+#include "TransformHierarchy.h"
+
+#include "Jerboa/Core/JobSystem.h"
+#include "Jerboa/Profiling/Profiler.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#define JERBOA_TRANSFORM_SSE
+	#include <emmintrin.h>
+#endif
+
+namespace Jerboa {
+	namespace {
+		constexpr TransformMatrix Identity = { {
+			1.0f, 0.0f, 0.0f, 0.0f,
+			0.0f, 1.0f, 0.0f, 0.0f,
+			0.0f, 0.0f, 1.0f, 0.0f,
+			0.0f, 0.0f, 0.0f, 1.0f
+		} };
+
+		struct LocalTransforms
+		{
+			const float* positionX; const float* positionY; const float* positionZ;
+			const float* rotationX; const float* rotationY; const float* rotationZ; const float* rotationW;
+			const float* scaleX; const float* scaleY; const float* scaleZ;
+		};
+
+		void ComposeLocalMatrix(const LocalTransforms& transforms, uint32_t slot, TransformMatrix& out)
+		{
+			float x = transforms.rotationX[slot], y = transforms.rotationY[slot], z = transforms.rotationZ[slot], w = transforms.rotationW[slot];
+			float sx = transforms.scaleX[slot], sy = transforms.scaleY[slot], sz = transforms.scaleZ[slot];
+			float* m = out.m;
+
+			m[0] = (1.0f - 2.0f * (y * y + z * z)) * sx;
+			m[1] = 2.0f * (x * y + w * z) * sx;
+			m[2] = 2.0f * (x * z - w * y) * sx;
+			m[3] = 0.0f;
+			m[4] = 2.0f * (x * y - w * z) * sy;
+			m[5] = (1.0f - 2.0f * (x * x + z * z)) * sy;
+			m[6] = 2.0f * (y * z + w * x) * sy;
+			m[7] = 0.0f;
+			m[8] = 2.0f * (x * z + w * y) * sz;
+			m[9] = 2.0f * (y * z - w * x) * sz;
+			m[10] = (1.0f - 2.0f * (x * x + y * y)) * sz;
+			m[11] = 0.0f;
+			m[12] = transforms.positionX[slot];
+			m[13] = transforms.positionY[slot];
+			m[14] = transforms.positionZ[slot];
+			m[15] = 1.0f;
+		}
+
+		// Composes the local matrices of the given slots, four nodes per iteration with
+		// one node per SIMD lane
+		void ComposeLocalMatrices(const LocalTransforms& transforms, const uint32_t* slots, uint32_t count, TransformMatrix* locals)
+		{
+			uint32_t i = 0;
+#ifdef JERBOA_TRANSFORM_SSE
+			auto gather = [slots](const float* values, uint32_t i) {
+				return _mm_set_ps(values[slots[i + 3]], values[slots[i + 2]], values[slots[i + 1]], values[slots[i]]);
+			};
+
+			const __m128 one = _mm_set1_ps(1.0f);
+			const __m128 two = _mm_set1_ps(2.0f);
+			for (; i + 4 <= count; i += 4) {
+				__m128 x = gather(transforms.rotationX, i), y = gather(transforms.rotationY, i);
+				__m128 z = gather(transforms.rotationZ, i), w = gather(transforms.rotationW, i);
+				__m128 sx = gather(transforms.scaleX, i), sy = gather(transforms.scaleY, i), sz = gather(transforms.scaleZ, i);
+
+				__m128 xx = _mm_mul_ps(x, x), yy = _mm_mul_ps(y, y), zz = _mm_mul_ps(z, z);
+				__m128 xy = _mm_mul_ps(x, y), xz = _mm_mul_ps(x, z), yz = _mm_mul_ps(y, z);
+				__m128 wx = _mm_mul_ps(w, x), wy = _mm_mul_ps(w, y), wz = _mm_mul_ps(w, z);
+
+				__m128 c0x = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(yy, zz))), sx);
+				__m128 c0y = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xy, wz)), sx);
+				__m128 c0z = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xz, wy)), sx);
+				__m128 c1x = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xy, wz)), sy);
+				__m128 c1y = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, zz))), sy);
+				__m128 c1z = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(yz, wx)), sy);
+				__m128 c2x = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xz, wy)), sz);
+				__m128 c2y = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(yz, wx)), sz);
+				__m128 c2z = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, yy))), sz);
+				__m128 c3x = gather(transforms.positionX, i), c3y = gather(transforms.positionY, i), c3z = gather(transforms.positionZ, i);
+				__m128 zero = _mm_setzero_ps(), c3w = one;
+
+				// Lanes hold nodes, transposing turns them into one column per node
+				__m128 c0w = zero, c1w = zero, c2w = zero;
+				_MM_TRANSPOSE4_PS(c0x, c0y, c0z, c0w);
+				_MM_TRANSPOSE4_PS(c1x, c1y, c1z, c1w);
+				_MM_TRANSPOSE4_PS(c2x, c2y, c2z, c2w);
+				_MM_TRANSPOSE4_PS(c3x, c3y, c3z, c3w);
+
+				const __m128 columns[4][4] = {
+					{ c0x, c1x, c2x, c3x },
+					{ c0y, c1y, c2y, c3y },
+					{ c0z, c1z, c2z, c3z },
+					{ c0w, c1w, c2w, c3w }
+				};
+				for (uint32_t lane = 0; lane < 4; lane++) {
+					float* m = locals[slots[i + lane]].m;
+					_mm_store_ps(m, columns[lane][0]);
+					_mm_store_ps(m + 4, columns[lane][1]);
+					_mm_store_ps(m + 8, columns[lane][2]);
+					_mm_store_ps(m + 12, columns[lane][3]);
+				}
+			}
+#endif
+			for (; i < count; i++)
+				ComposeLocalMatrix(transforms, slots[i], locals[slots[i]]);
+		}
+
+		void Multiply(const TransformMatrix& a, const TransformMatrix& b, TransformMatrix& out)
+		{
+#ifdef JERBOA_TRANSFORM_SSE
+			__m128 a0 = _mm_load_ps(a.m), a1 = _mm_load_ps(a.m + 4), a2 = _mm_load_ps(a.m + 8), a3 = _mm_load_ps(a.m + 12);
+			for (int column = 0; column < 4; column++) {
+				const float* b_ = b.m + column * 4;
+				__m128 result = _mm_mul_ps(a0, _mm_set1_ps(b_[0]));
+				result = _mm_add_ps(result, _mm_mul_ps(a1, _mm_set1_ps(b_[1])));
+				result = _mm_add_ps(result, _mm_mul_ps(a2, _mm_set1_ps(b_[2])));
+				result = _mm_add_ps(result, _mm_mul_ps(a3, _mm_set1_ps(b_[3])));
+				_mm_store_ps(out.m + column * 4, result);
+			}
+#else
+			for (int column = 0; column < 4; column++)
+				for (int row = 0; row < 4; row++)
+					out.m[column * 4 + row] = a.m[row] * b.m[column * 4] + a.m[4 + row] * b.m[column * 4 + 1]
+						+ a.m[8 + row] * b.m[column * 4 + 2] + a.m[12 + row] * b.m[column * 4 + 3];
+#endif
+		}
+
+		// All slots must be on the same level, their parents are already up to date
+		void ComputeWorldMatrices(const uint32_t* slots, uint32_t count, const uint32_t* parentSlots, const TransformMatrix* locals, TransformMatrix* worlds)
+		{
+			for (uint32_t i = 0; i < count; i++) {
+				uint32_t slot = slots[i];
+				uint32_t parent = parentSlots[slot];
+				if (parent == 0xffffffff)
+					worlds[slot] = locals[slot];
+				else
+					Multiply(worlds[parent], locals[slot], worlds[slot]);
+			}
+		}
+
+		template<typename Function>
+		void RunSplit(uint32_t count, uint32_t threshold, Function&& function)
+		{
+			if (count < threshold)
+				function(0u, count);
+			else
+				JobSystem::ParallelFor(count, threshold / 4, function);
+		}
+	}
+
+	TransformHierarchy::TransformHierarchy()
+	{
+		mLevelStart.push_back(0);
+	}
+
+	TransformHandle TransformHierarchy::Create(TransformHandle parent)
+	{
+		JERBOA_ASSERT(parent.IsNull() || IsValid(parent), "Parent transform is not valid");
+
+		uint32_t index;
+		if (!mFreeNodes.empty()) {
+			index = mFreeNodes.back();
+			mFreeNodes.pop_back();
+		}
+		else {
+			index = (uint32_t)mNodes.size();
+			mNodes.emplace_back();
+		}
+
+		uint32_t slot = (uint32_t)mSlotNode.size();
+		Node& node = mNodes[index];
+		node.alive = true;
+		node.slot = slot;
+
+		mSlotNode.push_back(index);
+		mParentSlot.push_back(NoSlot);
+		mPositionX.push_back(0.0f); mPositionY.push_back(0.0f); mPositionZ.push_back(0.0f);
+		mRotationX.push_back(0.0f); mRotationY.push_back(0.0f); mRotationZ.push_back(0.0f); mRotationW.push_back(1.0f);
+		mScaleX.push_back(1.0f); mScaleY.push_back(1.0f); mScaleZ.push_back(1.0f);
+		mLocal.push_back(Identity);
+		mWorld.push_back(Identity);
+		mLocalDirty.push_back(0);
+		mWorldDirty.push_back(0);
+
+		if (!parent.IsNull())
+			Link(index, parent.index);
+
+		mOrderDirty = true;
+		MarkChanged(slot);
+		return { index, node.generation };
+	}
+
+	void TransformHierarchy::Destroy(TransformHandle handle)
+	{
+		JERBOA_ASSERT(IsValid(handle), "Destroying an invalid transform");
+
+		Unlink(handle.index);
+
+		mScratch.clear();
+		mScratch.push_back(handle.index);
+		while (!mScratch.empty()) {
+			uint32_t index = mScratch.back();
+			mScratch.pop_back();
+
+			for (uint32_t child = mNodes[index].firstChild; child != TransformHandle::NullIndex; child = mNodes[child].nextSibling)
+				mScratch.push_back(child);
+
+			Node& node = mNodes[index];
+			RemoveSlot(node.slot);
+			uint32_t generation = node.generation + 1;
+			node = Node();
+			node.generation = generation;
+			mFreeNodes.push_back(index);
+		}
+
+		mOrderDirty = true;
+	}
+
+	bool TransformHierarchy::IsValid(TransformHandle node) const
+	{
+		return node.index < mNodes.size() && mNodes[node.index].alive && mNodes[node.index].generation == node.generation;
+	}
+
+	void TransformHierarchy::SetParent(TransformHandle handle, TransformHandle parent)
+	{
+		JERBOA_ASSERT(IsValid(handle), "Transform is not valid");
+		JERBOA_ASSERT(parent.IsNull() || IsValid(parent), "Parent transform is not valid");
+
+		if (!parent.IsNull()) {
+			for (uint32_t ancestor = parent.index; ancestor != TransformHandle::NullIndex; ancestor = mNodes[ancestor].parent)
+				JERBOA_ASSERT(ancestor != handle.index, "Parenting a transform to its own descendant");
+		}
+
+		Unlink(handle.index);
+		if (!parent.IsNull())
+			Link(handle.index, parent.index);
+
+		mOrderDirty = true;
+		MarkChanged(mNodes[handle.index].slot);
+	}
+
+	TransformHandle TransformHierarchy::GetParent(TransformHandle handle) const
+	{
+		JERBOA_ASSERT(IsValid(handle), "Transform is not valid");
+
+		uint32_t parent = mNodes[handle.index].parent;
+		if (parent == TransformHandle::NullIndex)
+			return TransformHandle();
+		return { parent, mNodes[parent].generation };
+	}
+
+	void TransformHierarchy::SetLocalPosition(TransformHandle node, float x, float y, float z)
+	{
+		uint32_t slot = GetSlot(node);
+		mPositionX[slot] = x; mPositionY[slot] = y; mPositionZ[slot] = z;
+		MarkChanged(slot);
+	}
+
+	void TransformHierarchy::SetLocalRotation(TransformHandle node, float x, float y, float z, float w)
+	{
+		uint32_t slot = GetSlot(node);
+		mRotationX[slot] = x; mRotationY[slot] = y; mRotationZ[slot] = z; mRotationW[slot] = w;
+		MarkChanged(slot);
+	}
+
+	void TransformHierarchy::SetLocalScale(TransformHandle node, float x, float y, float z)
+	{
+		uint32_t slot = GetSlot(node);
+		mScaleX[slot] = x; mScaleY[slot] = y; mScaleZ[slot] = z;
+		MarkChanged(slot);
+	}
+
+	const TransformMatrix& TransformHierarchy::GetWorldMatrix(TransformHandle node) const
+	{
+		return mWorld[GetSlot(node)];
+	}
+
+	void TransformHierarchy::Update()
+	{
+		JERBOA_PROFILE_SCOPE("TransformHierarchy::Update");
+
+		mStats = Statistics();
+		if (mOrderDirty) {
+			RebuildOrder();
+			mStats.reordered = true;
+		}
+
+		if (mChangedNodes.empty())
+			return;
+
+		CollectDirtySlots();
+		UpdateWorldMatrices();
+	}
+
+	uint32_t TransformHierarchy::GetSlot(TransformHandle node) const
+	{
+		JERBOA_ASSERT(IsValid(node), "Transform is not valid");
+		return mNodes[node.index].slot;
+	}
+
+	void TransformHierarchy::MarkChanged(uint32_t slot)
+	{
+		if (mLocalDirty[slot])
+			return;
+
+		mLocalDirty[slot] = 1;
+		mChangedNodes.push_back(mSlotNode[slot]);
+	}
+
+	void TransformHierarchy::Link(uint32_t node, uint32_t parent)
+	{
+		Node& child = mNodes[node];
+		child.parent = parent;
+		child.previousSibling = TransformHandle::NullIndex;
+		child.nextSibling = mNodes[parent].firstChild;
+		if (child.nextSibling != TransformHandle::NullIndex)
+			mNodes[child.nextSibling].previousSibling = node;
+		mNodes[parent].firstChild = node;
+	}
+
+	void TransformHierarchy::Unlink(uint32_t node)
+	{
+		Node& child = mNodes[node];
+		if (child.parent == TransformHandle::NullIndex)
+			return;
+
+		if (child.previousSibling != TransformHandle::NullIndex)
+			mNodes[child.previousSibling].nextSibling = child.nextSibling;
+		else
+			mNodes[child.parent].firstChild = child.nextSibling;
+
+		if (child.nextSibling != TransformHandle::NullIndex)
+			mNodes[child.nextSibling].previousSibling = child.previousSibling;
+
+		child.parent = child.nextSibling = child.previousSibling = TransformHandle::NullIndex;
+	}
+
+	void TransformHierarchy::RemoveSlot(uint32_t slot)
+	{
+		uint32_t last = (uint32_t)mSlotNode.size() - 1;
+		if (slot != last) {
+			mSlotNode[slot] = mSlotNode[last];
+			mPositionX[slot] = mPositionX[last]; mPositionY[slot] = mPositionY[last]; mPositionZ[slot] = mPositionZ[last];
+			mRotationX[slot] = mRotationX[last]; mRotationY[slot] = mRotationY[last]; mRotationZ[slot] = mRotationZ[last]; mRotationW[slot] = mRotationW[last];
+			mScaleX[slot] = mScaleX[last]; mScaleY[slot] = mScaleY[last]; mScaleZ[slot] = mScaleZ[last];
+			mLocal[slot] = mLocal[last];
+			mWorld[slot] = mWorld[last];
+			mLocalDirty[slot] = mLocalDirty[last];
+			mWorldDirty[slot] = mWorldDirty[last];
+			mNodes[mSlotNode[slot]].slot = slot;
+		}
+
+		mSlotNode.pop_back();
+		mParentSlot.pop_back();
+		mPositionX.pop_back(); mPositionY.pop_back(); mPositionZ.pop_back();
+		mRotationX.pop_back(); mRotationY.pop_back(); mRotationZ.pop_back(); mRotationW.pop_back();
+		mScaleX.pop_back(); mScaleY.pop_back(); mScaleZ.pop_back();
+		mLocal.pop_back();
+		mWorld.pop_back();
+		mLocalDirty.pop_back();
+		mWorldDirty.pop_back();
+	}
+
+	void TransformHierarchy::RebuildOrder()
+	{
+		JERBOA_PROFILE_SCOPE("TransformHierarchy::RebuildOrder");
+
+		const uint32_t count = (uint32_t)mSlotNode.size();
+
+		// Breadth-first from all roots, one level at a time
+		std::vector<uint32_t>& order = mScratch;
+		order.clear();
+		order.reserve(count);
+		for (uint32_t node : mSlotNode) {
+			if (mNodes[node].parent == TransformHandle::NullIndex)
+				order.push_back(node);
+		}
+
+		mLevelStart.clear();
+		mLevelStart.push_back(0);
+		for (size_t levelBegin = 0; levelBegin < order.size();) {
+			size_t levelEnd = order.size();
+			for (size_t i = levelBegin; i < levelEnd; i++) {
+				for (uint32_t child = mNodes[order[i]].firstChild; child != TransformHandle::NullIndex; child = mNodes[child].nextSibling)
+					order.push_back(child);
+			}
+			mLevelStart.push_back((uint32_t)levelEnd);
+			levelBegin = levelEnd;
+		}
+		JERBOA_ASSERT(order.size() == count, "Transform hierarchy links are inconsistent");
+
+		auto permute = [&](auto& values) {
+			std::remove_reference_t<decltype(values)> sorted(count);
+			for (uint32_t i = 0; i < count; i++)
+				sorted[i] = values[mNodes[order[i]].slot];
+			values.swap(sorted);
+		};
+		permute(mPositionX); permute(mPositionY); permute(mPositionZ);
+		permute(mRotationX); permute(mRotationY); permute(mRotationZ); permute(mRotationW);
+		permute(mScaleX); permute(mScaleY); permute(mScaleZ);
+		permute(mLocal);
+		permute(mWorld);
+		permute(mLocalDirty);
+		permute(mWorldDirty);
+
+		for (uint32_t i = 0; i < count; i++) {
+			mSlotNode[i] = order[i];
+			mNodes[order[i]].slot = i;
+		}
+		for (uint32_t i = 0; i < count; i++) {
+			uint32_t parent = mNodes[order[i]].parent;
+			mParentSlot[i] = parent == TransformHandle::NullIndex ? NoSlot : mNodes[parent].slot;
+		}
+
+		mOrderDirty = false;
+	}
+
+	void TransformHierarchy::CollectDirtySlots()
+	{
+		mLocalDirtySlots.clear();
+		mDirtySlots.clear();
+
+		// Once a large part of the hierarchy changed, one pass in level order is cheaper
+		// than walking the subtree of every changed node
+		const uint32_t count = (uint32_t)mSlotNode.size();
+		if (mChangedNodes.size() > count / 8) {
+			for (uint32_t slot = 0; slot < count; slot++) {
+				if (mLocalDirty[slot])
+					mLocalDirtySlots.push_back(slot);
+
+				uint32_t parent = mParentSlot[slot];
+				if (mLocalDirty[slot] || (parent != NoSlot && mWorldDirty[parent])) {
+					mWorldDirty[slot] = 1;
+					mDirtySlots.push_back(slot);
+				}
+			}
+			mChangedNodes.clear();
+
+			mStats.changedNodes = (uint32_t)mLocalDirtySlots.size();
+			mStats.updatedNodes = (uint32_t)mDirtySlots.size();
+			return;
+		}
+
+		for (uint32_t index : mChangedNodes) {
+			const Node& changed = mNodes[index];
+			if (!changed.alive || mLocalDirty[changed.slot] != 1)
+				continue;
+
+			// 2 marks the slot as queued, a node can be in the list twice after being
+			// destroyed and its index reused
+			mLocalDirty[changed.slot] = 2;
+			mLocalDirtySlots.push_back(changed.slot);
+
+			// Everything below a changed node needs a new world matrix, a subtree that is
+			// already marked was reached from a changed ancestor or descendant before
+			mScratch.clear();
+			mScratch.push_back(index);
+			while (!mScratch.empty()) {
+				const Node& node = mNodes[mScratch.back()];
+				mScratch.pop_back();
+				if (mWorldDirty[node.slot])
+					continue;
+
+				mWorldDirty[node.slot] = 1;
+				mDirtySlots.push_back(node.slot);
+				for (uint32_t child = node.firstChild; child != TransformHandle::NullIndex; child = mNodes[child].nextSibling)
+					mScratch.push_back(child);
+			}
+		}
+		mChangedNodes.clear();
+
+		// Slots are in level order, sorting the dirty slots groups them by level. Once a
+		// large part of the hierarchy is dirty a linear scan is cheaper than sorting.
+		if (mDirtySlots.size() > count / 8) {
+			mDirtySlots.clear();
+			for (uint32_t slot = 0; slot < count; slot++) {
+				if (mWorldDirty[slot])
+					mDirtySlots.push_back(slot);
+			}
+		}
+		else {
+			std::sort(mDirtySlots.begin(), mDirtySlots.end());
+		}
+
+		mStats.changedNodes = (uint32_t)mLocalDirtySlots.size();
+		mStats.updatedNodes = (uint32_t)mDirtySlots.size();
+	}
+
+	void TransformHierarchy::UpdateWorldMatrices()
+	{
+		const LocalTransforms transforms = {
+			mPositionX.data(), mPositionY.data(), mPositionZ.data(),
+			mRotationX.data(), mRotationY.data(), mRotationZ.data(), mRotationW.data(),
+			mScaleX.data(), mScaleY.data(), mScaleZ.data()
+		};
+
+		const uint32_t* localSlots = mLocalDirtySlots.data();
+		TransformMatrix* locals = mLocal.data();
+		RunSplit((uint32_t)mLocalDirtySlots.size(), ParallelThreshold, [&](uint32_t begin, uint32_t end) {
+			ComposeLocalMatrices(transforms, localSlots + begin, end - begin, locals);
+		});
+
+		// Levels run one after another, the nodes within a level are independent
+		const uint32_t* parentSlots = mParentSlot.data();
+		TransformMatrix* worlds = mWorld.data();
+		auto levelBegin = mDirtySlots.begin();
+		for (size_t level = 1; level < mLevelStart.size() && levelBegin != mDirtySlots.end(); level++) {
+			auto levelEnd = std::lower_bound(levelBegin, mDirtySlots.end(), mLevelStart[level]);
+			const uint32_t* slots = &*levelBegin;
+			RunSplit((uint32_t)(levelEnd - levelBegin), ParallelThreshold, [&](uint32_t begin, uint32_t end) {
+				ComputeWorldMatrices(slots + begin, end - begin, parentSlots, locals, worlds);
+			});
+			levelBegin = levelEnd;
+		}
+
+		for (uint32_t slot : mLocalDirtySlots)
+			mLocalDirty[slot] = 0;
+		for (uint32_t slot : mDirtySlots)
+			mWorldDirty[slot] = 0;
+	}
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include "Jerboa/Math/Matrix.h"
+
+#include <vector>
+#include <cstdint>
+
+namespace Jerboa {
+	struct TransformHandle
+	{
+		static constexpr uint32_t NullIndex = 0xffffffff;
+
+		uint32_t index = NullIndex;
+		uint32_t generation = 0;
+
+		inline bool IsNull() const { return index == NullIndex; }
+		inline bool operator==(const TransformHandle& other) const { return index == other.index && generation == other.generation; }
+		inline bool operator!=(const TransformHandle& other) const { return !(*this == other); }
+	};
+
+	using TransformMatrix = Mat4;
+
+	// Parent/child transforms. Local position/rotation/scale live in SoA arrays kept in
+	// breadth-first order, so every level of the hierarchy is one contiguous range and
+	// parents always come before their children. Update() only recomputes the subtrees
+	// below nodes that changed, level by level, splitting large levels across the JobSystem.
+	class TransformHierarchy
+	{
+	public:
+		struct Statistics
+		{
+			uint32_t changedNodes = 0;
+			uint32_t updatedNodes = 0;
+			bool reordered = false;
+		};
+
+		// Levels with fewer dirty nodes than this are updated on the calling thread
+		static constexpr uint32_t ParallelThreshold = 4096;
+
+		TransformHierarchy();
+
+		TransformHandle Create(TransformHandle parent = TransformHandle());
+		// Destroys the node and its whole subtree
+		void Destroy(TransformHandle node);
+		bool IsValid(TransformHandle node) const;
+
+		// The node keeps its local transform, so its world transform follows the new parent
+		void SetParent(TransformHandle node, TransformHandle parent);
+		TransformHandle GetParent(TransformHandle node) const;
+
+		void SetLocalPosition(TransformHandle node, float x, float y, float z);
+		// Unit quaternion
+		void SetLocalRotation(TransformHandle node, float x, float y, float z, float w);
+		void SetLocalScale(TransformHandle node, float x, float y, float z);
+
+		// Valid after the Update() following the last change
+		const TransformMatrix& GetWorldMatrix(TransformHandle node) const;
+
+		void Update();
+
+		inline uint32_t GetNodeCount() const { return (uint32_t)mSlotNode.size(); }
+		inline uint32_t GetLevelCount() const { return (uint32_t)mLevelStart.size() - 1; }
+		inline const Statistics& GetStats() const { return mStats; }
+	private:
+		struct Node
+		{
+			uint32_t slot = NoSlot;
+			uint32_t parent = TransformHandle::NullIndex;
+			uint32_t firstChild = TransformHandle::NullIndex;
+			uint32_t nextSibling = TransformHandle::NullIndex;
+			uint32_t previousSibling = TransformHandle::NullIndex;
+			uint32_t generation = 0;
+			bool alive = false;
+		};
+
+		static constexpr uint32_t NoSlot = 0xffffffff;
+
+		uint32_t GetSlot(TransformHandle node) const;
+		void MarkChanged(uint32_t slot);
+		void Link(uint32_t node, uint32_t parent);
+		void Unlink(uint32_t node);
+		void RemoveSlot(uint32_t slot);
+
+		void RebuildOrder();
+		void CollectDirtySlots();
+		void UpdateWorldMatrices();
+
+		std::vector<Node> mNodes;
+		std::vector<uint32_t> mFreeNodes;
+
+		// Per slot, in breadth-first order once mOrderDirty is cleared
+		std::vector<uint32_t> mSlotNode;
+		std::vector<uint32_t> mParentSlot;
+		std::vector<float> mPositionX, mPositionY, mPositionZ;
+		std::vector<float> mRotationX, mRotationY, mRotationZ, mRotationW;
+		std::vector<float> mScaleX, mScaleY, mScaleZ;
+		std::vector<TransformMatrix> mLocal;
+		std::vector<TransformMatrix> mWorld;
+		std::vector<uint8_t> mLocalDirty;
+		std::vector<uint8_t> mWorldDirty;
+
+		// mLevelStart[d] is the first slot of depth d, the last entry is the node count
+		std::vector<uint32_t> mLevelStart;
+		bool mOrderDirty = false;
+
+		std::vector<uint32_t> mChangedNodes;
+		std::vector<uint32_t> mLocalDirtySlots;
+		std::vector<uint32_t> mDirtySlots;
+		std::vector<uint32_t> mScratch;
+
+		Statistics mStats;
+	};
+}
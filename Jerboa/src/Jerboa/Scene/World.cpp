@@ -0,0 +1,200 @@
+#include "jerboa-pch.h"
+#include "World.h"
+
+namespace Jerboa {
+	World::World()
+	{
+		mEmptyArchetype = GetArchetype(ComponentMask());
+	}
+
+	World::~World()
+	{
+		AssertNotIterating();
+	}
+
+	Entity World::CreateEntity()
+	{
+		Entity entity = AllocateEntity();
+		PlaceEntity(entity, mEmptyArchetype);
+		return entity;
+	}
+
+	void World::DestroyEntity(Entity entity)
+	{
+		AssertNotIterating();
+		JERBOA_ASSERT(IsAlive(entity), "Destroying an entity that is not alive");
+
+		EntityRecord& record = mRecords[entity.index];
+		Entity moved = record.archetype->Remove(record.chunk, record.row, true);
+		if (!moved.IsNull())
+			OnEntityMoved(moved, record.chunk, record.row);
+
+		record.archetype = nullptr;
+		record.generation++;
+		mFreeIndices.push_back(entity.index);
+		mEntityCount--;
+	}
+
+	bool World::IsAlive(Entity entity) const
+	{
+		return entity.index < mRecords.size()
+			&& mRecords[entity.index].archetype != nullptr
+			&& mRecords[entity.index].generation == entity.generation;
+	}
+
+	void World::RefreshQueries()
+	{
+		for (auto& [mask, query] : mQueries)
+			RefreshQuery(*query);
+	}
+
+	Entity World::AllocateEntity()
+	{
+		AssertNotIterating();
+
+		Entity entity;
+		if (!mFreeIndices.empty()) {
+			entity.index = mFreeIndices.back();
+			mFreeIndices.pop_back();
+		}
+		else {
+			entity.index = (uint32_t)mRecords.size();
+			mRecords.emplace_back();
+		}
+
+		entity.generation = mRecords[entity.index].generation;
+		mEntityCount++;
+		return entity;
+	}
+
+	void World::PlaceEntity(Entity entity, Archetype* archetype)
+	{
+		EntityRecord& record = mRecords[entity.index];
+		record.archetype = archetype;
+		archetype->Allocate(entity, record.chunk, record.row);
+	}
+
+	void World::MoveEntity(Entity entity, Archetype* target)
+	{
+		AssertNotIterating();
+		JERBOA_ASSERT(IsAlive(entity), "Changing components of an entity that is not alive");
+
+		EntityRecord& record = mRecords[entity.index];
+		Archetype* source = record.archetype;
+		uint32_t sourceChunk = record.chunk;
+		uint32_t sourceRow = record.row;
+
+		uint32_t targetChunk, targetRow;
+		target->Allocate(entity, targetChunk, targetRow);
+
+		const std::vector<ComponentID>& components = source->GetComponents();
+		for (int32_t sourceColumn = 0; sourceColumn < (int32_t)components.size(); sourceColumn++) {
+			const ComponentInfo& info = ComponentRegistry::GetInfo(components[sourceColumn]);
+			void* component = source->GetComponent(sourceChunk, sourceRow, sourceColumn);
+
+			int32_t targetColumn = target->GetColumn(components[sourceColumn]);
+			if (targetColumn != Archetype::NoColumn)
+				info.moveConstruct(target->GetComponent(targetChunk, targetRow, targetColumn), component);
+			info.destruct(component);
+		}
+
+		Entity moved = source->Remove(sourceChunk, sourceRow, false);
+		if (!moved.IsNull())
+			OnEntityMoved(moved, sourceChunk, sourceRow);
+
+		record.archetype = target;
+		record.chunk = targetChunk;
+		record.row = targetRow;
+	}
+
+	void World::OnEntityMoved(Entity moved, uint32_t chunk, uint32_t row)
+	{
+		EntityRecord& record = mRecords[moved.index];
+		record.chunk = chunk;
+		record.row = row;
+	}
+
+	bool World::HasComponent(Entity entity, ComponentID id) const
+	{
+		JERBOA_ASSERT(IsAlive(entity), "Entity is not alive");
+		return mRecords[entity.index].archetype->GetColumn(id) != Archetype::NoColumn;
+	}
+
+	void* World::GetComponentData(Entity entity, ComponentID id) const
+	{
+		JERBOA_ASSERT(IsAlive(entity), "Entity is not alive");
+
+		const EntityRecord& record = mRecords[entity.index];
+		int32_t column = record.archetype->GetColumn(id);
+		if (column == Archetype::NoColumn)
+			return nullptr;
+
+		return record.archetype->GetComponent(record.chunk, record.row, column);
+	}
+
+	Archetype* World::GetArchetype(const ComponentMask& mask)
+	{
+		auto it = mArchetypeLookup.find(mask);
+		if (it != mArchetypeLookup.end())
+			return it->second;
+
+		AssertNotIterating();
+		mArchetypes.push_back(std::make_unique<Archetype>(mask));
+		Archetype* archetype = mArchetypes.back().get();
+		mArchetypeLookup[mask] = archetype;
+		return archetype;
+	}
+
+	Archetype* World::GetArchetypeWith(Archetype* archetype, ComponentID id)
+	{
+		auto it = archetype->addEdges.find(id);
+		if (it != archetype->addEdges.end())
+			return it->second;
+
+		ComponentMask mask = archetype->GetMask();
+		mask.set(id);
+		Archetype* target = GetArchetype(mask);
+		archetype->addEdges[id] = target;
+		target->removeEdges[id] = archetype;
+		return target;
+	}
+
+	Archetype* World::GetArchetypeWithout(Archetype* archetype, ComponentID id)
+	{
+		auto it = archetype->removeEdges.find(id);
+		if (it != archetype->removeEdges.end())
+			return it->second;
+
+		ComponentMask mask = archetype->GetMask();
+		mask.reset(id);
+		Archetype* target = GetArchetype(mask);
+		archetype->removeEdges[id] = target;
+		target->addEdges[id] = archetype;
+		return target;
+	}
+
+	QueryData& World::GetQueryData(const ComponentMask& mask)
+	{
+		std::unique_ptr<QueryData>& query = mQueries[mask];
+		if (!query) {
+			query = std::make_unique<QueryData>();
+			query->include = mask;
+			RefreshQuery(*query);
+		}
+		return *query;
+	}
+
+	void World::RefreshQuery(QueryData& query) const
+	{
+		for (; query.archetypesChecked < mArchetypes.size(); query.archetypesChecked++) {
+			Archetype* archetype = mArchetypes[query.archetypesChecked].get();
+			if ((archetype->GetMask() & query.include) == query.include)
+				query.archetypes.push_back(archetype);
+		}
+	}
+
+	void World::AssertNotIterating() const
+	{
+		JERBOA_ASSERT(mIterationDepth.load(std::memory_order_relaxed) == 0, "Structural changes are not allowed while a query iterates");
+	}
+}
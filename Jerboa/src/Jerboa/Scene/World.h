@@ -0,0 +1,143 @@
+#pragma once
+
+#include "Entity.h"
+#include "Component.h"
+#include "Archetype.h"
+#include "Query.h"
+#include "Jerboa/Core/Assert.h"
+
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include <atomic>
+
+namespace Jerboa {
+	// Owns entities and their components, grouped into archetypes by component set.
+	// Adding or removing components moves an entity between archetypes, so structural
+	// changes are not allowed while a query iterates.
+	class World
+	{
+	public:
+		World();
+		~World();
+
+		World(const World&) = delete;
+		World& operator=(const World&) = delete;
+
+		Entity CreateEntity();
+
+		template<typename... Ts>
+		Entity CreateEntity(Ts&&... components)
+		{
+			Entity entity = AllocateEntity();
+			Archetype* archetype = GetArchetype(MakeComponentMask<std::decay_t<Ts>...>());
+			PlaceEntity(entity, archetype);
+			(new (GetComponentData(entity, ComponentRegistry::GetID<Ts>())) std::decay_t<Ts>(std::forward<Ts>(components)), ...);
+			return entity;
+		}
+
+		// Creates count entities with copies of the given components
+		template<typename... Ts>
+		void CreateEntities(uint32_t count, Entity* outEntities, const Ts&... components)
+		{
+			Archetype* archetype = GetArchetype(MakeComponentMask<Ts...>());
+			const std::array<int32_t, sizeof...(Ts)> columns = { archetype->GetColumn(ComponentRegistry::GetID<Ts>())... };
+			for (uint32_t i = 0; i < count; i++) {
+				Entity entity = AllocateEntity();
+				PlaceEntity(entity, archetype);
+				const EntityRecord& record = mRecords[entity.index];
+				size_t column = 0;
+				(new (archetype->GetComponent(record.chunk, record.row, columns[column++])) Ts(components), ...);
+				if (outEntities)
+					outEntities[i] = entity;
+			}
+		}
+
+		void DestroyEntity(Entity entity);
+		bool IsAlive(Entity entity) const;
+
+		template<typename T, typename... Args>
+		T& AddComponent(Entity entity, Args&&... args)
+		{
+			ComponentID id = ComponentRegistry::GetID<T>();
+			JERBOA_ASSERT(!HasComponent(entity, id), "Entity already has this component");
+
+			MoveEntity(entity, GetArchetypeWith(mRecords[entity.index].archetype, id));
+			return *new (GetComponentData(entity, id)) T(std::forward<Args>(args)...);
+		}
+
+		template<typename T>
+		void RemoveComponent(Entity entity)
+		{
+			ComponentID id = ComponentRegistry::GetID<T>();
+			JERBOA_ASSERT(HasComponent(entity, id), "Entity doesn't have this component");
+
+			MoveEntity(entity, GetArchetypeWithout(mRecords[entity.index].archetype, id));
+		}
+
+		template<typename T>
+		bool HasComponent(Entity entity) const { return HasComponent(entity, ComponentRegistry::GetID<T>()); }
+
+		template<typename T>
+		T& GetComponent(Entity entity)
+		{
+			void* data = GetComponentData(entity, ComponentRegistry::GetID<T>());
+			JERBOA_ASSERT(data, "Entity doesn't have this component");
+			return *static_cast<T*>(data);
+		}
+
+		template<typename T>
+		T* TryGetComponent(Entity entity) { return static_cast<T*>(GetComponentData(entity, ComponentRegistry::GetID<T>())); }
+
+		// Queries are cached per component set, getting one repeatedly is a hash lookup
+		template<typename... Ts>
+		Query<Ts...> GetQuery() { return Query<Ts...>(this, &GetQueryData(MakeComponentMask<Ts...>())); }
+
+		inline uint32_t GetEntityCount() const { return mEntityCount; }
+		inline uint32_t GetArchetypeCount() const { return (uint32_t)mArchetypes.size(); }
+
+		// Brings all cached queries up to date. Queries refresh themselves, the scheduler
+		// calls this before running systems in parallel so they never write shared query state.
+		void RefreshQueries();
+	private:
+		struct EntityRecord
+		{
+			Archetype* archetype = nullptr;
+			uint32_t chunk = 0;
+			uint32_t row = 0;
+			uint32_t generation = 0;
+		};
+
+		Entity AllocateEntity();
+		void PlaceEntity(Entity entity, Archetype* archetype);
+		// Moves an entity's shared components to target and destructs the others,
+		// components only target has are left unconstructed
+		void MoveEntity(Entity entity, Archetype* target);
+		void OnEntityMoved(Entity moved, uint32_t chunk, uint32_t row);
+
+		bool HasComponent(Entity entity, ComponentID id) const;
+		void* GetComponentData(Entity entity, ComponentID id) const;
+
+		Archetype* GetArchetype(const ComponentMask& mask);
+		Archetype* GetArchetypeWith(Archetype* archetype, ComponentID id);
+		Archetype* GetArchetypeWithout(Archetype* archetype, ComponentID id);
+
+		QueryData& GetQueryData(const ComponentMask& mask);
+		void RefreshQuery(QueryData& query) const;
+		void AssertNotIterating() const;
+
+		std::vector<EntityRecord> mRecords;
+		std::vector<uint32_t> mFreeIndices;
+		uint32_t mEntityCount = 0;
+
+		std::vector<std::unique_ptr<Archetype>> mArchetypes;
+		std::unordered_map<ComponentMask, Archetype*> mArchetypeLookup;
+		Archetype* mEmptyArchetype;
+
+		std::unordered_map<ComponentMask, std::unique_ptr<QueryData>> mQueries;
+		std::atomic<int32_t> mIterationDepth{ 0 };
+
+		friend class QueryBase;
+		friend class SceneSerializer;
+	};
+}
@@ -0,0 +1,452 @@
+#include "jerboa-pch.h"
+#include "DynamicAABBTree.h"
+
+#include "Jerboa/Core/ScratchAllocator.h"
+#include "Jerboa/Core/StlAllocator.h"
+
+namespace Jerboa {
+	DynamicAABBTree::DynamicAABBTree()
+		: DynamicAABBTree(Settings())
+	{
+	}
+
+	DynamicAABBTree::DynamicAABBTree(const Settings& settings)
+		: mSettings(settings)
+	{
+	}
+
+	ProxyID DynamicAABBTree::CreateProxy(const AABB& bounds, uint64_t userData)
+	{
+		uint32_t leaf = AllocateNode();
+		Node& node = mNodes[leaf];
+		node.bounds = bounds;
+		node.fatBounds = ComputeFatBounds(bounds, Vec3());
+		node.userData = userData;
+		node.height = 0;
+
+		InsertLeaf(leaf);
+		mProxyCount++;
+		return leaf;
+	}
+
+	void DynamicAABBTree::DestroyProxy(ProxyID proxy)
+	{
+		JERBOA_ASSERT(proxy < mNodes.size() && mNodes[proxy].height == 0, "Destroying an invalid proxy");
+
+		RemoveLeaf(proxy);
+		FreeNode(proxy);
+		mProxyCount--;
+	}
+
+	bool DynamicAABBTree::MoveProxy(ProxyID proxy, const AABB& bounds, const Vec3& displacement)
+	{
+		JERBOA_ASSERT(proxy < mNodes.size() && mNodes[proxy].height == 0, "Moving an invalid proxy");
+
+		Node& node = mNodes[proxy];
+		node.bounds = bounds;
+
+		// Keep the fat bounds while they contain the proxy and haven't become much larger
+		// than needed, e.g. after the proxy stopped moving
+		if (node.fatBounds.Contains(bounds)) {
+			AABB largest = ComputeFatBounds(bounds, displacement).Expanded(4.0f * mSettings.margin);
+			if (largest.Contains(node.fatBounds))
+				return false;
+		}
+
+		RemoveLeaf(proxy);
+		mNodes[proxy].fatBounds = ComputeFatBounds(bounds, displacement);
+		InsertLeaf(proxy);
+		return true;
+	}
+
+	void DynamicAABBTree::CreateProxies(const AABB* bounds, const uint64_t* userData, uint32_t count, ProxyID* proxies)
+	{
+		if (mRoot != NullNode) {
+			SpatialIndex::CreateProxies(bounds, userData, count, proxies);
+			return;
+		}
+
+		for (uint32_t i = 0; i < count; i++) {
+			uint32_t leaf = AllocateNode();
+			Node& node = mNodes[leaf];
+			node.bounds = bounds[i];
+			node.fatBounds = ComputeFatBounds(bounds[i], Vec3());
+			node.userData = userData ? userData[i] : 0;
+			node.height = 0;
+			proxies[i] = leaf;
+		}
+		mProxyCount += count;
+
+		ScratchScope scratch;
+		uint32_t* leaves = scratch.GetArena().NewArray<uint32_t>(count);
+		std::copy(proxies, proxies + count, leaves);
+		mRoot = BuildTopDown(leaves, count);
+	}
+
+	const AABB& DynamicAABBTree::GetBounds(ProxyID proxy) const
+	{
+		JERBOA_ASSERT(proxy < mNodes.size() && mNodes[proxy].height == 0, "Invalid proxy");
+		return mNodes[proxy].bounds;
+	}
+
+	uint64_t DynamicAABBTree::GetUserData(ProxyID proxy) const
+	{
+		JERBOA_ASSERT(proxy < mNodes.size() && mNodes[proxy].height == 0, "Invalid proxy");
+		return mNodes[proxy].userData;
+	}
+
+	void DynamicAABBTree::Query(const AABB& box, std::vector<ProxyID>& results) const
+	{
+		ForEachOverlap(box, [&results](ProxyID proxy) { results.push_back(proxy); });
+	}
+
+	void DynamicAABBTree::RayCast(const Ray& ray, float maxDistance, const RayCastCallback& callback) const
+	{
+		if (mRoot == NullNode)
+			return;
+
+		Vec3 inverseDirection = ray.GetInverseDirection();
+		NodeStack stack;
+		stack.Push(mRoot);
+		while (!stack.IsEmpty()) {
+			const Node& node = mNodes[stack.Pop()];
+			float distance;
+			if (!IntersectRay(node.fatBounds, ray, inverseDirection, maxDistance, distance))
+				continue;
+
+			if (!node.IsLeaf()) {
+				stack.Push(node.child1);
+				stack.Push(node.child2);
+				continue;
+			}
+
+			if (!IntersectRay(node.bounds, ray, inverseDirection, maxDistance, distance))
+				continue;
+
+			maxDistance = callback((ProxyID)(&node - mNodes.data()), distance);
+			if (maxDistance <= 0.0f)
+				return;
+		}
+	}
+
+	void DynamicAABBTree::FindPairs(std::vector<ProxyPair>& pairs) const
+	{
+		pairs.clear();
+		if (mRoot == NullNode)
+			return;
+
+		// Collides the tree with itself: every inner node's children against each other, and
+		// overlapping node pairs down to their leaves, so disjoint subtrees are skipped whole
+		ScratchScope scratch;
+		std::vector<std::pair<uint32_t, uint32_t>, ArenaStlAllocator<std::pair<uint32_t, uint32_t>>> stack(scratch.GetArena());
+		stack.reserve(mProxyCount);
+		for (uint32_t index = 0; index < (uint32_t)mNodes.size(); index++)
+			if (mNodes[index].height > 0)
+				stack.push_back({ mNodes[index].child1, mNodes[index].child2 });
+
+		while (!stack.empty()) {
+			auto [a, b] = stack.back();
+			stack.pop_back();
+
+			const Node& nodeA = mNodes[a];
+			const Node& nodeB = mNodes[b];
+			if (!nodeA.fatBounds.Intersects(nodeB.fatBounds))
+				continue;
+
+			if (nodeA.IsLeaf() && nodeB.IsLeaf()) {
+				if (nodeA.bounds.Intersects(nodeB.bounds))
+					pairs.push_back({ std::min(a, b), std::max(a, b) });
+			}
+			// Descend into the larger node
+			else if (nodeB.IsLeaf() || (!nodeA.IsLeaf() && nodeA.fatBounds.GetSurfaceArea() > nodeB.fatBounds.GetSurfaceArea())) {
+				stack.push_back({ nodeA.child1, b });
+				stack.push_back({ nodeA.child2, b });
+			}
+			else {
+				stack.push_back({ a, nodeB.child1 });
+				stack.push_back({ a, nodeB.child2 });
+			}
+		}
+	}
+
+	void DynamicAABBTree::Rebuild()
+	{
+		ScratchScope scratch;
+		uint32_t* leaves = scratch.GetArena().NewArray<uint32_t>(mProxyCount);
+		uint32_t leafCount = 0;
+		for (uint32_t index = 0; index < (uint32_t)mNodes.size(); index++) {
+			if (mNodes[index].height == 0)
+				leaves[leafCount++] = index;
+			else if (mNodes[index].height > 0)
+				FreeNode(index);
+		}
+
+		mRoot = leafCount == 0 ? NullNode : BuildTopDown(leaves, leafCount);
+	}
+
+	uint32_t DynamicAABBTree::GetHeight() const
+	{
+		return mRoot == NullNode ? 0 : (uint32_t)mNodes[mRoot].height;
+	}
+
+	float DynamicAABBTree::GetAreaRatio() const
+	{
+		if (mRoot == NullNode)
+			return 0.0f;
+
+		float totalArea = 0.0f;
+		for (const Node& node : mNodes)
+			if (node.height >= 0)
+				totalArea += node.fatBounds.GetSurfaceArea();
+
+		float rootArea = mNodes[mRoot].fatBounds.GetSurfaceArea();
+		return rootArea > 0.0f ? totalArea / rootArea : 0.0f;
+	}
+
+	void DynamicAABBTree::Validate() const
+	{
+		if (mRoot == NullNode) {
+			JERBOA_ASSERT(mProxyCount == 0, "Empty tree with proxies");
+			return;
+		}
+
+		JERBOA_ASSERT(mNodes[mRoot].parent == NullNode, "Root has a parent");
+		[[maybe_unused]] uint32_t leaves = ValidateNode(mRoot);
+		JERBOA_ASSERT(leaves == mProxyCount, "Leaf count doesn't match the proxy count");
+	}
+
+	uint32_t DynamicAABBTree::ValidateNode(uint32_t index) const
+	{
+		const Node& node = mNodes[index];
+		if (node.IsLeaf()) {
+			JERBOA_ASSERT(node.height == 0, "Leaf with a height");
+			JERBOA_ASSERT(node.fatBounds.Contains(node.bounds), "Fat bounds don't contain the proxy");
+			return 1;
+		}
+
+		[[maybe_unused]] const Node& child1 = mNodes[node.child1];
+		[[maybe_unused]] const Node& child2 = mNodes[node.child2];
+		JERBOA_ASSERT(child1.parent == index && child2.parent == index, "Child doesn't point to its parent");
+		JERBOA_ASSERT(node.height == 1 + std::max(child1.height, child2.height), "Wrong node height");
+		JERBOA_ASSERT(node.fatBounds.Contains(child1.fatBounds) && node.fatBounds.Contains(child2.fatBounds), "Node doesn't contain its children");
+		return ValidateNode(node.child1) + ValidateNode(node.child2);
+	}
+
+	uint32_t DynamicAABBTree::AllocateNode()
+	{
+		if (mFreeList == NullNode) {
+			mNodes.emplace_back();
+			return (uint32_t)mNodes.size() - 1;
+		}
+
+		uint32_t index = mFreeList;
+		Node& node = mNodes[index];
+		mFreeList = node.parent;
+		node = Node();
+		return index;
+	}
+
+	void DynamicAABBTree::FreeNode(uint32_t index)
+	{
+		Node& node = mNodes[index];
+		node.height = -1;
+		node.child1 = node.child2 = NullNode;
+		node.parent = mFreeList;
+		mFreeList = index;
+	}
+
+	AABB DynamicAABBTree::ComputeFatBounds(const AABB& bounds, const Vec3& displacement) const
+	{
+		AABB fat = bounds.Expanded(mSettings.margin);
+		Vec3 predicted = displacement * mSettings.displacementMultiplier;
+		(predicted.x < 0.0f ? fat.min.x : fat.max.x) += predicted.x;
+		(predicted.y < 0.0f ? fat.min.y : fat.max.y) += predicted.y;
+		(predicted.z < 0.0f ? fat.min.z : fat.max.z) += predicted.z;
+		return fat;
+	}
+
+	void DynamicAABBTree::InsertLeaf(uint32_t leaf)
+	{
+		if (mRoot == NullNode) {
+			mRoot = leaf;
+			mNodes[leaf].parent = NullNode;
+			return;
+		}
+
+		// Descend towards the sibling with the lowest surface area cost. Every node on the
+		// way grows to contain the leaf, which is paid as the inherited cost.
+		const AABB leafBounds = mNodes[leaf].fatBounds;
+		uint32_t index = mRoot;
+		while (!mNodes[index].IsLeaf()) {
+			const Node& node = mNodes[index];
+			float area = node.fatBounds.GetSurfaceArea();
+			float combinedArea = AABB::Merge(node.fatBounds, leafBounds).GetSurfaceArea();
+
+			// Cost of making a new parent for this node and the leaf
+			float cost = 2.0f * combinedArea;
+			float inheritedCost = 2.0f * (combinedArea - area);
+
+			auto descendCost = [&](uint32_t child) {
+				const AABB& childBounds = mNodes[child].fatBounds;
+				float merged = AABB::Merge(childBounds, leafBounds).GetSurfaceArea();
+				return (mNodes[child].IsLeaf() ? merged : merged - childBounds.GetSurfaceArea()) + inheritedCost;
+			};
+			float cost1 = descendCost(node.child1);
+			float cost2 = descendCost(node.child2);
+
+			if (cost < cost1 && cost < cost2)
+				break;
+			index = cost1 < cost2 ? node.child1 : node.child2;
+		}
+
+		uint32_t sibling = index;
+		uint32_t oldParent = mNodes[sibling].parent;
+		uint32_t newParent = AllocateNode();
+
+		Node& parent = mNodes[newParent];
+		parent.parent = oldParent;
+		parent.fatBounds = AABB::Merge(leafBounds, mNodes[sibling].fatBounds);
+		parent.height = mNodes[sibling].height + 1;
+		parent.child1 = sibling;
+		parent.child2 = leaf;
+		mNodes[sibling].parent = newParent;
+		mNodes[leaf].parent = newParent;
+
+		if (oldParent == NullNode)
+			mRoot = newParent;
+		else if (mNodes[oldParent].child1 == sibling)
+			mNodes[oldParent].child1 = newParent;
+		else
+			mNodes[oldParent].child2 = newParent;
+
+		RefitAncestors(newParent);
+	}
+
+	void DynamicAABBTree::RemoveLeaf(uint32_t leaf)
+	{
+		if (leaf == mRoot) {
+			mRoot = NullNode;
+			return;
+		}
+
+		uint32_t parent = mNodes[leaf].parent;
+		uint32_t grandParent = mNodes[parent].parent;
+		uint32_t sibling = mNodes[parent].child1 == leaf ? mNodes[parent].child2 : mNodes[parent].child1;
+
+		mNodes[sibling].parent = grandParent;
+		FreeNode(parent);
+
+		if (grandParent == NullNode) {
+			mRoot = sibling;
+			return;
+		}
+
+		if (mNodes[grandParent].child1 == parent)
+			mNodes[grandParent].child1 = sibling;
+		else
+			mNodes[grandParent].child2 = sibling;
+		RefitAncestors(grandParent);
+	}
+
+	void DynamicAABBTree::RefitAncestors(uint32_t index)
+	{
+		while (index != NullNode) {
+			index = Balance(index);
+
+			Node& node = mNodes[index];
+			const Node& child1 = mNodes[node.child1];
+			const Node& child2 = mNodes[node.child2];
+			node.height = 1 + std::max(child1.height, child2.height);
+			node.fatBounds = AABB::Merge(child1.fatBounds, child2.fatBounds);
+
+			index = node.parent;
+		}
+	}
+
+	// Rotates the taller grandchild subtree up when the children's heights differ by more
+	// than one. Returns the node now in a's place.
+	uint32_t DynamicAABBTree::Balance(uint32_t a)
+	{
+		Node& nodeA = mNodes[a];
+		if (nodeA.IsLeaf() || nodeA.height < 2)
+			return a;
+
+		uint32_t b = nodeA.child1;
+		uint32_t c = nodeA.child2;
+		int32_t balance = mNodes[c].height - mNodes[b].height;
+		if (balance >= -1 && balance <= 1)
+			return a;
+
+		// The taller child replaces a, a takes the taller child's shorter child
+		bool rotateC = balance > 1;
+		uint32_t up = rotateC ? c : b;
+		uint32_t stay = rotateC ? b : c;
+		Node& nodeUp = mNodes[up];
+		uint32_t f = nodeUp.child1;
+		uint32_t g = nodeUp.child2;
+
+		nodeUp.child1 = a;
+		nodeUp.parent = nodeA.parent;
+		nodeA.parent = up;
+
+		if (nodeUp.parent == NullNode)
+			mRoot = up;
+		else if (mNodes[nodeUp.parent].child1 == a)
+			mNodes[nodeUp.parent].child1 = up;
+		else
+			mNodes[nodeUp.parent].child2 = up;
+
+		uint32_t taller = mNodes[f].height > mNodes[g].height ? f : g;
+		uint32_t shorter = taller == f ? g : f;
+		nodeUp.child2 = taller;
+		if (rotateC)
+			nodeA.child2 = shorter;
+		else
+			nodeA.child1 = shorter;
+		mNodes[shorter].parent = a;
+
+		nodeA.fatBounds = AABB::Merge(mNodes[stay].fatBounds, mNodes[shorter].fatBounds);
+		nodeA.height = 1 + std::max(mNodes[stay].height, mNodes[shorter].height);
+		nodeUp.fatBounds = AABB::Merge(nodeA.fatBounds, mNodes[taller].fatBounds);
+		nodeUp.height = 1 + std::max(nodeA.height, mNodes[taller].height);
+		return up;
+	}
+
+	// Splits at the median centroid along the longest axis of the centroids' bounds
+	uint32_t DynamicAABBTree::BuildTopDown(uint32_t* leaves, uint32_t count)
+	{
+		if (count == 1) {
+			mNodes[leaves[0]].parent = NullNode;
+			return leaves[0];
+		}
+
+		AABB centroids = { mNodes[leaves[0]].fatBounds.GetCenter(), mNodes[leaves[0]].fatBounds.GetCenter() };
+		for (uint32_t i = 1; i < count; i++) {
+			Vec3 center = mNodes[leaves[i]].fatBounds.GetCenter();
+			centroids = { Min(centroids.min, center), Max(centroids.max, center) };
+		}
+
+		Vec3 size = centroids.max - centroids.min;
+		int axis = size.x > size.y ? (size.x > size.z ? 0 : 2) : (size.y > size.z ? 1 : 2);
+		auto key = [this, axis](uint32_t leaf) {
+			const AABB& bounds = mNodes[leaf].fatBounds;
+			return axis == 0 ? bounds.min.x + bounds.max.x : axis == 1 ? bounds.min.y + bounds.max.y : bounds.min.z + bounds.max.z;
+		};
+
+		uint32_t half = count / 2;
+		std::nth_element(leaves, leaves + half, leaves + count, [&key](uint32_t a, uint32_t b) { return key(a) < key(b); });
+
+		uint32_t child1 = BuildTopDown(leaves, half);
+		uint32_t child2 = BuildTopDown(leaves + half, count - half);
+
+		uint32_t index = AllocateNode();
+		Node& node = mNodes[index];
+		node.child1 = child1;
+		node.child2 = child2;
+		node.height = 1 + std::max(mNodes[child1].height, mNodes[child2].height);
+		node.fatBounds = AABB::Merge(mNodes[child1].fatBounds, mNodes[child2].fatBounds);
+		mNodes[child1].parent = index;
+		mNodes[child2].parent = index;
+		return index;
+	}
+}
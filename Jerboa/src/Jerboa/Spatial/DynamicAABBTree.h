@@ -0,0 +1,142 @@
+#pragma once
+
+#include "SpatialIndex.h"
+
+namespace Jerboa {
+	// Bounding volume hierarchy updated incrementally. Leaves hold fattened bounds, so a proxy
+	// that stays inside its fat box moves without touching the tree; inserts descend by
+	// surface area cost and tree rotations keep it balanced. Suits scenes with mixed object
+	// sizes, clusters and empty space.
+	class DynamicAABBTree : public SpatialIndex
+	{
+	public:
+		struct Settings
+		{
+			// Added on every side of the bounds stored in the tree
+			float margin = 0.1f;
+			// The fat bounds extend this many displacements in the direction of movement
+			float displacementMultiplier = 4.0f;
+		};
+
+		DynamicAABBTree();
+		DynamicAABBTree(const Settings& settings);
+
+		virtual ProxyID CreateProxy(const AABB& bounds, uint64_t userData = 0) override;
+		virtual void DestroyProxy(ProxyID proxy) override;
+		virtual bool MoveProxy(ProxyID proxy, const AABB& bounds, const Vec3& displacement = Vec3()) override;
+		// Into an empty tree, builds it top down instead of inserting one leaf at a time
+		virtual void CreateProxies(const AABB* bounds, const uint64_t* userData, uint32_t count, ProxyID* proxies) override;
+
+		virtual const AABB& GetBounds(ProxyID proxy) const override;
+		virtual uint64_t GetUserData(ProxyID proxy) const override;
+		virtual uint32_t GetProxyCount() const override { return mProxyCount; }
+
+		virtual void Query(const AABB& box, std::vector<ProxyID>& results) const override;
+		virtual void RayCast(const Ray& ray, float maxDistance, const RayCastCallback& callback) const override;
+		virtual void FindPairs(std::vector<ProxyPair>& pairs) const override;
+
+		// callback(ProxyID) for every proxy overlapping box, without the virtual call and the
+		// result vector
+		template<typename Callback>
+		void ForEachOverlap(const AABB& box, Callback&& callback) const
+		{
+			if (mRoot == NullNode)
+				return;
+
+			NodeStack stack;
+			stack.Push(mRoot);
+			while (!stack.IsEmpty()) {
+				const Node& node = mNodes[stack.Pop()];
+				if (!node.fatBounds.Intersects(box))
+					continue;
+
+				if (node.IsLeaf()) {
+					if (node.bounds.Intersects(box))
+						callback((ProxyID)(&node - mNodes.data()));
+				}
+				else {
+					stack.Push(node.child1);
+					stack.Push(node.child2);
+				}
+			}
+		}
+
+		// Rebuilds the inner nodes top down from the current leaves, e.g. after many changes
+		void Rebuild();
+
+		uint32_t GetHeight() const;
+		// Summed surface area of all nodes over the root's, lower is a tighter tree
+		float GetAreaRatio() const;
+		// Asserts the structure is consistent
+		void Validate() const;
+	private:
+		static constexpr uint32_t NullNode = 0xffffffff;
+
+		struct Node
+		{
+			AABB fatBounds;
+			// The proxy's bounds, leaves only
+			AABB bounds;
+			uint64_t userData = 0;
+			// The next free node while on the free list
+			uint32_t parent = NullNode;
+			uint32_t child1 = NullNode;
+			uint32_t child2 = NullNode;
+			// 0 for leaves, -1 for free nodes
+			int32_t height = -1;
+
+			inline bool IsLeaf() const { return child1 == NullNode; }
+		};
+
+		// Traversal stack on the calling thread's stack unless the tree is very deep
+		class NodeStack
+		{
+		public:
+			inline void Push(uint32_t node)
+			{
+				if (mCount < FixedCapacity)
+					mFixed[mCount] = node;
+				else
+					mOverflow.push_back(node);
+				mCount++;
+			}
+
+			inline uint32_t Pop()
+			{
+				mCount--;
+				if (mCount < FixedCapacity)
+					return mFixed[mCount];
+
+				uint32_t node = mOverflow.back();
+				mOverflow.pop_back();
+				return node;
+			}
+
+			inline bool IsEmpty() const { return mCount == 0; }
+		private:
+			static constexpr uint32_t FixedCapacity = 128;
+
+			uint32_t mFixed[FixedCapacity];
+			std::vector<uint32_t> mOverflow;
+			uint32_t mCount = 0;
+		};
+
+		uint32_t AllocateNode();
+		void FreeNode(uint32_t node);
+		AABB ComputeFatBounds(const AABB& bounds, const Vec3& displacement) const;
+
+		void InsertLeaf(uint32_t leaf);
+		void RemoveLeaf(uint32_t leaf);
+		uint32_t Balance(uint32_t node);
+		void RefitAncestors(uint32_t node);
+		uint32_t BuildTopDown(uint32_t* leaves, uint32_t count);
+
+		uint32_t ValidateNode(uint32_t node) const;
+
+		Settings mSettings;
+		std::vector<Node> mNodes;
+		uint32_t mRoot = NullNode;
+		uint32_t mFreeList = NullNode;
+		uint32_t mProxyCount = 0;
+	};
+}
@@ -0,0 +1,40 @@
+#include "jerboa-pch.h"
+#include "SpatialIndex.h"
+
+namespace Jerboa {
+	void SpatialIndex::CreateProxies(const AABB* bounds, const uint64_t* userData, uint32_t count, ProxyID* proxies)
+	{
+		for (uint32_t i = 0; i < count; i++)
+			proxies[i] = CreateProxy(bounds[i], userData ? userData[i] : 0);
+	}
+
+	uint32_t SpatialIndex::MoveProxies(const ProxyID* proxies, const AABB* bounds, const Vec3* displacements, uint32_t count)
+	{
+		uint32_t changed = 0;
+		for (uint32_t i = 0; i < count; i++)
+			changed += MoveProxy(proxies[i], bounds[i], displacements ? displacements[i] : Vec3()) ? 1 : 0;
+		return changed;
+	}
+
+	void SpatialIndex::QueryBatch(const AABB* boxes, uint32_t count, std::vector<ProxyID>& results, std::vector<uint32_t>& offsets) const
+	{
+		results.clear();
+		offsets.resize(count + 1);
+		for (uint32_t i = 0; i < count; i++) {
+			offsets[i] = (uint32_t)results.size();
+			Query(boxes[i], results);
+		}
+		offsets[count] = (uint32_t)results.size();
+	}
+
+	bool SpatialIndex::RayCastClosest(const Ray& ray, float maxDistance, RayHit& hit) const
+	{
+		hit = RayHit();
+		RayCast(ray, maxDistance, [&hit](ProxyID proxy, float distance) {
+			hit.proxy = proxy;
+			hit.distance = distance;
+			return distance;
+		});
+		return hit.proxy != NullProxy;
+	}
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "Jerboa/Math/Bounds.h"
+
+#include <vector>
+#include <functional>
+#include <cstdint>
+
+namespace Jerboa {
+	using ProxyID = uint32_t;
+	static constexpr ProxyID NullProxy = 0xffffffff;
+
+	// a < b
+	struct ProxyPair
+	{
+		ProxyID a, b;
+	};
+
+	struct RayHit
+	{
+		ProxyID proxy = NullProxy;
+		float distance = 0.0f;
+	};
+
+	// Called for every proxy whose bounds the ray enters within the current maximum distance,
+	// with the entry distance. Returns the new maximum: the entry distance to only look for
+	// closer proxies, the old maximum to ignore this one, 0 to stop.
+	using RayCastCallback = std::function<float(ProxyID proxy, float distance)>;
+
+	// Broad-phase index of axis-aligned bounds, so scenes can pick the structure that fits
+	// their workload. Queries and pairs are exact for the bounds the proxies were given;
+	// the const functions can run concurrently with each other.
+	class SpatialIndex
+	{
+	public:
+		virtual ~SpatialIndex() = default;
+
+		virtual ProxyID CreateProxy(const AABB& bounds, uint64_t userData = 0) = 0;
+		virtual void DestroyProxy(ProxyID proxy) = 0;
+		// displacement is the expected movement until the next update. Returns whether the
+		// structure had to change.
+		virtual bool MoveProxy(ProxyID proxy, const AABB& bounds, const Vec3& displacement = Vec3()) = 0;
+
+		// userData and displacements may be null. Returns the number of structural changes.
+		virtual void CreateProxies(const AABB* bounds, const uint64_t* userData, uint32_t count, ProxyID* proxies);
+		virtual uint32_t MoveProxies(const ProxyID* proxies, const AABB* bounds, const Vec3* displacements, uint32_t count);
+
+		virtual const AABB& GetBounds(ProxyID proxy) const = 0;
+		virtual uint64_t GetUserData(ProxyID proxy) const = 0;
+		virtual uint32_t GetProxyCount() const = 0;
+
+		// Appends every proxy overlapping box
+		virtual void Query(const AABB& box, std::vector<ProxyID>& results) const = 0;
+		// Results of boxes[i] are results[offsets[i]] to results[offsets[i + 1]]
+		void QueryBatch(const AABB* boxes, uint32_t count, std::vector<ProxyID>& results, std::vector<uint32_t>& offsets) const;
+
+		virtual void RayCast(const Ray& ray, float maxDistance, const RayCastCallback& callback) const = 0;
+		// Closest proxy bounds the ray enters
+		bool RayCastClosest(const Ray& ray, float maxDistance, RayHit& hit) const;
+
+		// Replaces pairs with every pair of overlapping proxies
+		virtual void FindPairs(std::vector<ProxyPair>& pairs) const = 0;
+	};
+}
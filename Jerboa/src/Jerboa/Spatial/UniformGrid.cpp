@@ -0,0 +1,417 @@
+#include "jerboa-pch.h"
+#include "UniformGrid.h"
+
+#include <cmath>
+#include <limits>
+
+namespace Jerboa {
+	namespace {
+		// Cell coordinates are packed into 21 bits per axis
+		constexpr int32_t CoordinateLimit = (1 << 20) - 1;
+		constexpr uint32_t MinTableCapacity = 64;
+		// Batched moves drop empty cells once there are this many and they are half the table
+		constexpr uint32_t EmptyCellThreshold = 1024;
+
+		inline int32_t ToCell(float coordinate, float inverseCellSize)
+		{
+			float cell = std::floor(coordinate * inverseCellSize);
+			return (int32_t)std::fmax(std::fmin(cell, (float)CoordinateLimit), (float)-CoordinateLimit);
+		}
+	}
+
+	uint64_t UniformGrid::CellRange::GetCellCount() const
+	{
+		if (max[0] < min[0] || max[1] < min[1] || max[2] < min[2])
+			return 0;
+		return (uint64_t)(max[0] - min[0] + 1) * (uint64_t)(max[1] - min[1] + 1) * (uint64_t)(max[2] - min[2] + 1);
+	}
+
+	UniformGrid::UniformGrid()
+		: UniformGrid(Settings())
+	{
+	}
+
+	UniformGrid::UniformGrid(const Settings& settings)
+		: mSettings(settings), mInverseCellSize(1.0f / settings.cellSize)
+	{
+		JERBOA_ASSERT(settings.cellSize > 0.0f, "Grid cells need a positive size");
+
+		for (int axis = 0; axis < 3; axis++) {
+			mOccupied.min[axis] = std::numeric_limits<int32_t>::max();
+			mOccupied.max[axis] = std::numeric_limits<int32_t>::min();
+		}
+	}
+
+	ProxyID UniformGrid::CreateProxy(const AABB& bounds, uint64_t userData)
+	{
+		ProxyID proxy;
+		if (!mFreeProxies.empty()) {
+			proxy = mFreeProxies.back();
+			mFreeProxies.pop_back();
+		}
+		else {
+			proxy = (ProxyID)mProxies.size();
+			mProxies.emplace_back();
+		}
+
+		Proxy& data = mProxies[proxy];
+		data.bounds = bounds;
+		data.userData = userData;
+		data.cells = GetCellRange(bounds);
+		data.alive = true;
+
+		AddToCells(proxy);
+		mProxyCount++;
+		return proxy;
+	}
+
+	void UniformGrid::DestroyProxy(ProxyID proxy)
+	{
+		JERBOA_ASSERT(proxy < mProxies.size() && mProxies[proxy].alive, "Destroying an invalid proxy");
+
+		RemoveFromCells(proxy);
+		mProxies[proxy].alive = false;
+		mFreeProxies.push_back(proxy);
+		mProxyCount--;
+	}
+
+	bool UniformGrid::MoveProxy(ProxyID proxy, const AABB& bounds, const Vec3&)
+	{
+		JERBOA_ASSERT(proxy < mProxies.size() && mProxies[proxy].alive, "Moving an invalid proxy");
+
+		Proxy& data = mProxies[proxy];
+		data.bounds = bounds;
+		CellRange cells = GetCellRange(bounds);
+		if (cells == data.cells)
+			return false;
+
+		RemoveFromCells(proxy);
+		mProxies[proxy].cells = cells;
+		AddToCells(proxy);
+		return true;
+	}
+
+	uint32_t UniformGrid::MoveProxies(const ProxyID* proxies, const AABB* bounds, const Vec3* displacements, uint32_t count)
+	{
+		uint32_t changed = SpatialIndex::MoveProxies(proxies, bounds, displacements, count);
+		if (mEmptyCellCount > EmptyCellThreshold && mEmptyCellCount * 2 > mCells.size())
+			RemoveEmptyCells();
+		return changed;
+	}
+
+	const AABB& UniformGrid::GetBounds(ProxyID proxy) const
+	{
+		JERBOA_ASSERT(proxy < mProxies.size() && mProxies[proxy].alive, "Invalid proxy");
+		return mProxies[proxy].bounds;
+	}
+
+	uint64_t UniformGrid::GetUserData(ProxyID proxy) const
+	{
+		JERBOA_ASSERT(proxy < mProxies.size() && mProxies[proxy].alive, "Invalid proxy");
+		return mProxies[proxy].userData;
+	}
+
+	void UniformGrid::Query(const AABB& box, std::vector<ProxyID>& results) const
+	{
+		for (ProxyID proxy : mOversized)
+			if (mProxies[proxy].bounds.Intersects(box))
+				results.push_back(proxy);
+
+		CellRange range = GetCellRange(box);
+		for (int axis = 0; axis < 3; axis++) {
+			range.min[axis] = std::max(range.min[axis], mOccupied.min[axis]);
+			range.max[axis] = std::min(range.max[axis], mOccupied.max[axis]);
+		}
+
+		// A proxy in several of the visited cells is only reported from the first cell both
+		// ranges share
+		auto visit = [&](const Cell& cell) {
+			for (ProxyID proxy : cell.proxies) {
+				const Proxy& data = mProxies[proxy];
+				if (cell.x == std::max(data.cells.min[0], range.min[0]) && cell.y == std::max(data.cells.min[1], range.min[1])
+					&& cell.z == std::max(data.cells.min[2], range.min[2]) && data.bounds.Intersects(box))
+					results.push_back(proxy);
+			}
+		};
+
+		uint64_t rangeCells = range.GetCellCount();
+		if (rangeCells == 0)
+			return;
+
+		// Large queries walk the existing cells instead of every cell in range
+		if (rangeCells > mCells.size()) {
+			for (const Cell& cell : mCells)
+				if (range.Contains(cell.x, cell.y, cell.z))
+					visit(cell);
+			return;
+		}
+
+		for (int32_t z = range.min[2]; z <= range.max[2]; z++)
+			for (int32_t y = range.min[1]; y <= range.max[1]; y++)
+				for (int32_t x = range.min[0]; x <= range.max[0]; x++) {
+					uint32_t cell = FindCell(MakeKey(x, y, z));
+					if (cell != NoCell)
+						visit(mCells[cell]);
+				}
+	}
+
+	void UniformGrid::RayCast(const Ray& ray, float maxDistance, const RayCastCallback& callback) const
+	{
+		Vec3 inverseDirection = ray.GetInverseDirection();
+		float distance;
+		for (ProxyID proxy : mOversized) {
+			if (IntersectRay(mProxies[proxy].bounds, ray, inverseDirection, maxDistance, distance)) {
+				maxDistance = callback(proxy, distance);
+				if (maxDistance <= 0.0f)
+					return;
+			}
+		}
+
+		if (mOccupied.GetCellCount() == 0)
+			return;
+
+		// Start marching where the ray enters the occupied cells
+		const float cellSize = mSettings.cellSize;
+		AABB occupied = {
+			{ mOccupied.min[0] * cellSize, mOccupied.min[1] * cellSize, mOccupied.min[2] * cellSize },
+			{ (mOccupied.max[0] + 1) * cellSize, (mOccupied.max[1] + 1) * cellSize, (mOccupied.max[2] + 1) * cellSize }
+		};
+		float entry;
+		if (!IntersectRay(occupied, ray, inverseDirection, maxDistance, entry))
+			return;
+
+		const float origin[3] = { ray.origin.x, ray.origin.y, ray.origin.z };
+		const float inverse[3] = { inverseDirection.x, inverseDirection.y, inverseDirection.z };
+		const float direction[3] = { ray.direction.x, ray.direction.y, ray.direction.z };
+		Vec3 start = ray.GetPoint(entry);
+		const float startPoint[3] = { start.x, start.y, start.z };
+
+		int32_t cell[3], step[3];
+		float next[3], delta[3];
+		for (int axis = 0; axis < 3; axis++) {
+			cell[axis] = std::min(std::max(ToCell(startPoint[axis], mInverseCellSize), mOccupied.min[axis]), mOccupied.max[axis]);
+			if (direction[axis] == 0.0f) {
+				step[axis] = 0;
+				next[axis] = std::numeric_limits<float>::infinity();
+				delta[axis] = std::numeric_limits<float>::infinity();
+				continue;
+			}
+
+			step[axis] = direction[axis] > 0.0f ? 1 : -1;
+			float boundary = (cell[axis] + (step[axis] > 0 ? 1 : 0)) * cellSize;
+			next[axis] = (boundary - origin[axis]) * inverse[axis];
+			delta[axis] = cellSize * std::fabs(inverse[axis]);
+		}
+
+		// Cells along the ray change monotonically per axis, so the cells a proxy covers are
+		// visited consecutively: a proxy is new unless it covers the previous cell
+		int32_t previous[3] = { 0, 0, 0 };
+		bool first = true;
+		while (true) {
+			uint32_t index = FindCell(MakeKey(cell[0], cell[1], cell[2]));
+			if (index != NoCell) {
+				for (ProxyID proxy : mCells[index].proxies) {
+					const Proxy& data = mProxies[proxy];
+					if (!first && data.cells.Contains(previous[0], previous[1], previous[2]))
+						continue;
+
+					if (IntersectRay(data.bounds, ray, inverseDirection, maxDistance, distance)) {
+						maxDistance = callback(proxy, distance);
+						if (maxDistance <= 0.0f)
+							return;
+					}
+				}
+			}
+
+			int axis = next[0] < next[1] ? (next[0] < next[2] ? 0 : 2) : (next[1] < next[2] ? 1 : 2);
+			if (next[axis] > maxDistance)
+				return;
+
+			previous[0] = cell[0]; previous[1] = cell[1]; previous[2] = cell[2];
+			first = false;
+			cell[axis] += step[axis];
+			next[axis] += delta[axis];
+			if (cell[axis] < mOccupied.min[axis] || cell[axis] > mOccupied.max[axis])
+				return;
+		}
+	}
+
+	void UniformGrid::FindPairs(std::vector<ProxyPair>& pairs) const
+	{
+		pairs.clear();
+
+		// A pair sharing several cells is reported from the first cell both ranges share
+		for (const Cell& cell : mCells) {
+			const uint32_t count = (uint32_t)cell.proxies.size();
+			for (uint32_t i = 0; i < count; i++) {
+				ProxyID a = cell.proxies[i];
+				const Proxy& dataA = mProxies[a];
+				for (uint32_t j = i + 1; j < count; j++) {
+					ProxyID b = cell.proxies[j];
+					const Proxy& dataB = mProxies[b];
+					if (cell.x == std::max(dataA.cells.min[0], dataB.cells.min[0]) && cell.y == std::max(dataA.cells.min[1], dataB.cells.min[1])
+						&& cell.z == std::max(dataA.cells.min[2], dataB.cells.min[2]) && dataA.bounds.Intersects(dataB.bounds))
+						pairs.push_back({ std::min(a, b), std::max(a, b) });
+				}
+			}
+		}
+
+		for (ProxyID oversized : mOversized) {
+			const AABB& bounds = mProxies[oversized].bounds;
+			for (ProxyID other = 0; other < (ProxyID)mProxies.size(); other++) {
+				const Proxy& data = mProxies[other];
+				if (!data.alive || other == oversized || (data.oversizedIndex != NoCell && other < oversized))
+					continue;
+				if (data.bounds.Intersects(bounds))
+					pairs.push_back({ std::min(oversized, other), std::max(oversized, other) });
+			}
+		}
+	}
+
+	void UniformGrid::RemoveEmptyCells()
+	{
+		std::vector<Cell> cells;
+		cells.reserve(mCells.size() - mEmptyCellCount);
+		for (Cell& cell : mCells)
+			if (!cell.proxies.empty())
+				cells.push_back(std::move(cell));
+		mCells = std::move(cells);
+		mEmptyCellCount = 0;
+
+		for (int axis = 0; axis < 3; axis++) {
+			mOccupied.min[axis] = std::numeric_limits<int32_t>::max();
+			mOccupied.max[axis] = std::numeric_limits<int32_t>::min();
+		}
+		for (const Cell& cell : mCells) {
+			const int32_t coordinates[3] = { cell.x, cell.y, cell.z };
+			for (int axis = 0; axis < 3; axis++) {
+				mOccupied.min[axis] = std::min(mOccupied.min[axis], coordinates[axis]);
+				mOccupied.max[axis] = std::max(mOccupied.max[axis], coordinates[axis]);
+			}
+		}
+
+		uint32_t capacity = MinTableCapacity;
+		while (capacity < mCells.size() * 2)
+			capacity *= 2;
+		RebuildTable(capacity);
+	}
+
+	UniformGrid::CellRange UniformGrid::GetCellRange(const AABB& bounds) const
+	{
+		CellRange range;
+		range.min[0] = ToCell(bounds.min.x, mInverseCellSize);
+		range.min[1] = ToCell(bounds.min.y, mInverseCellSize);
+		range.min[2] = ToCell(bounds.min.z, mInverseCellSize);
+		range.max[0] = ToCell(bounds.max.x, mInverseCellSize);
+		range.max[1] = ToCell(bounds.max.y, mInverseCellSize);
+		range.max[2] = ToCell(bounds.max.z, mInverseCellSize);
+		return range;
+	}
+
+	uint64_t UniformGrid::MakeKey(int32_t x, int32_t y, int32_t z)
+	{
+		constexpr uint64_t mask = (1ull << 21) - 1;
+		return ((uint64_t)(x + CoordinateLimit) & mask) | (((uint64_t)(y + CoordinateLimit) & mask) << 21) | (((uint64_t)(z + CoordinateLimit) & mask) << 42);
+	}
+
+	uint32_t UniformGrid::GetSlot(uint64_t key) const
+	{
+		return (uint32_t)((key * 0x9e3779b97f4a7c15ull) >> 32) & ((uint32_t)mTable.size() - 1);
+	}
+
+	uint32_t UniformGrid::FindCell(uint64_t key) const
+	{
+		if (mTable.empty())
+			return NoCell;
+
+		const uint32_t mask = (uint32_t)mTable.size() - 1;
+		for (uint32_t slot = GetSlot(key); ; slot = (slot + 1) & mask) {
+			uint32_t cell = mTable[slot];
+			if (cell == NoCell || mCells[cell].key == key)
+				return cell;
+		}
+	}
+
+	uint32_t UniformGrid::FindOrAddCell(int32_t x, int32_t y, int32_t z)
+	{
+		// Keep the table at most 70% full
+		if ((mCells.size() + 1) * 10 > mTable.size() * 7)
+			RebuildTable(std::max(MinTableCapacity, (uint32_t)mTable.size() * 2));
+
+		const uint64_t key = MakeKey(x, y, z);
+		const uint32_t mask = (uint32_t)mTable.size() - 1;
+		uint32_t slot = GetSlot(key);
+		for (; mTable[slot] != NoCell; slot = (slot + 1) & mask)
+			if (mCells[mTable[slot]].key == key)
+				return mTable[slot];
+
+		mTable[slot] = (uint32_t)mCells.size();
+		mCells.push_back({ key, x, y, z, {} });
+		mEmptyCellCount++;
+		return mTable[slot];
+	}
+
+	void UniformGrid::RebuildTable(uint32_t capacity)
+	{
+		mTable.assign(capacity, NoCell);
+		const uint32_t mask = capacity - 1;
+		for (uint32_t cell = 0; cell < (uint32_t)mCells.size(); cell++) {
+			uint32_t slot = GetSlot(mCells[cell].key);
+			while (mTable[slot] != NoCell)
+				slot = (slot + 1) & mask;
+			mTable[slot] = cell;
+		}
+	}
+
+	void UniformGrid::AddToCells(ProxyID proxy)
+	{
+		const CellRange range = mProxies[proxy].cells;
+		if (range.GetCellCount() > mSettings.maxCellsPerProxy) {
+			mProxies[proxy].oversizedIndex = (uint32_t)mOversized.size();
+			mOversized.push_back(proxy);
+			return;
+		}
+
+		for (int axis = 0; axis < 3; axis++) {
+			mOccupied.min[axis] = std::min(mOccupied.min[axis], range.min[axis]);
+			mOccupied.max[axis] = std::max(mOccupied.max[axis], range.max[axis]);
+		}
+
+		for (int32_t z = range.min[2]; z <= range.max[2]; z++)
+			for (int32_t y = range.min[1]; y <= range.max[1]; y++)
+				for (int32_t x = range.min[0]; x <= range.max[0]; x++) {
+					Cell& cell = mCells[FindOrAddCell(x, y, z)];
+					if (cell.proxies.empty())
+						mEmptyCellCount--;
+					cell.proxies.push_back(proxy);
+				}
+	}
+
+	void UniformGrid::RemoveFromCells(ProxyID proxy)
+	{
+		Proxy& data = mProxies[proxy];
+		if (data.oversizedIndex != NoCell) {
+			ProxyID last = mOversized.back();
+			mOversized[data.oversizedIndex] = last;
+			mProxies[last].oversizedIndex = data.oversizedIndex;
+			mOversized.pop_back();
+			data.oversizedIndex = NoCell;
+			return;
+		}
+
+		const CellRange& range = data.cells;
+		for (int32_t z = range.min[2]; z <= range.max[2]; z++)
+			for (int32_t y = range.min[1]; y <= range.max[1]; y++)
+				for (int32_t x = range.min[0]; x <= range.max[0]; x++) {
+					uint32_t index = FindCell(MakeKey(x, y, z));
+					JERBOA_ASSERT(index != NoCell, "Proxy missing from its grid cell");
+
+					std::vector<ProxyID>& proxies = mCells[index].proxies;
+					auto it = std::find(proxies.begin(), proxies.end(), proxy);
+					*it = proxies.back();
+					proxies.pop_back();
+					if (proxies.empty())
+						mEmptyCellCount++;
+				}
+	}
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include "SpatialIndex.h"
+
+namespace Jerboa {
+	// Unbounded grid of equally sized cells stored in a hash table, each cell listing the
+	// proxies overlapping it. Moves that stay within the same cells only update the bounds.
+	// Suits many similarly sized objects spread evenly, with the cell size about the size
+	// of a typical object; proxies covering too many cells are kept in a separate list.
+	class UniformGrid : public SpatialIndex
+	{
+	public:
+		struct Settings
+		{
+			float cellSize = 4.0f;
+			// Larger proxies are tested by every query instead of being added to cells
+			uint32_t maxCellsPerProxy = 64;
+		};
+
+		UniformGrid();
+		UniformGrid(const Settings& settings);
+
+		virtual ProxyID CreateProxy(const AABB& bounds, uint64_t userData = 0) override;
+		virtual void DestroyProxy(ProxyID proxy) override;
+		virtual bool MoveProxy(ProxyID proxy, const AABB& bounds, const Vec3& displacement = Vec3()) override;
+		// Drops cells emptied by the moves
+		virtual uint32_t MoveProxies(const ProxyID* proxies, const AABB* bounds, const Vec3* displacements, uint32_t count) override;
+
+		virtual const AABB& GetBounds(ProxyID proxy) const override;
+		virtual uint64_t GetUserData(ProxyID proxy) const override;
+		virtual uint32_t GetProxyCount() const override { return mProxyCount; }
+
+		virtual void Query(const AABB& box, std::vector<ProxyID>& results) const override;
+		virtual void RayCast(const Ray& ray, float maxDistance, const RayCastCallback& callback) const override;
+		virtual void FindPairs(std::vector<ProxyPair>& pairs) const override;
+
+		inline uint32_t GetCellCount() const { return (uint32_t)mCells.size() - mEmptyCellCount; }
+		inline uint32_t GetOversizedCount() const { return (uint32_t)mOversized.size(); }
+
+		// Removes the cells that no longer hold any proxy
+		void RemoveEmptyCells();
+	private:
+		static constexpr uint32_t NoCell = 0xffffffff;
+
+		struct CellRange
+		{
+			int32_t min[3];
+			int32_t max[3];
+
+			inline bool operator==(const CellRange& other) const
+			{
+				return min[0] == other.min[0] && min[1] == other.min[1] && min[2] == other.min[2]
+					&& max[0] == other.max[0] && max[1] == other.max[1] && max[2] == other.max[2];
+			}
+			inline bool Contains(int32_t x, int32_t y, int32_t z) const
+			{
+				return x >= min[0] && x <= max[0] && y >= min[1] && y <= max[1] && z >= min[2] && z <= max[2];
+			}
+			uint64_t GetCellCount() const;
+		};
+
+		struct Proxy
+		{
+			AABB bounds;
+			uint64_t userData = 0;
+			CellRange cells;
+			// Index in mOversized, NoCell while the proxy is in cells
+			uint32_t oversizedIndex = NoCell;
+			bool alive = false;
+		};
+
+		struct Cell
+		{
+			uint64_t key;
+			int32_t x, y, z;
+			std::vector<ProxyID> proxies;
+		};
+
+		CellRange GetCellRange(const AABB& bounds) const;
+		static uint64_t MakeKey(int32_t x, int32_t y, int32_t z);
+		uint32_t GetSlot(uint64_t key) const;
+		uint32_t FindCell(uint64_t key) const;
+		uint32_t FindOrAddCell(int32_t x, int32_t y, int32_t z);
+		void RebuildTable(uint32_t capacity);
+
+		void AddToCells(ProxyID proxy);
+		void RemoveFromCells(ProxyID proxy);
+
+		Settings mSettings;
+		float mInverseCellSize;
+
+		std::vector<Proxy> mProxies;
+		std::vector<ProxyID> mFreeProxies;
+		std::vector<ProxyID> mOversized;
+		uint32_t mProxyCount = 0;
+
+		// Open addressing from the hashed cell key to an index in mCells
+		std::vector<uint32_t> mTable;
+		std::vector<Cell> mCells;
+		uint32_t mEmptyCellCount = 0;
+		// Union of the cell ranges of all proxies in cells, bounds ray marching
+		CellRange mOccupied;
+	};
+}
@@ -2,7 +2,49 @@
 #include "ImGuiApp.h"
 #include "GLFW/glfw3.h"
 
+#include "Jerboa/Renderer/GLStateCache.h"
+#include "Jerboa/Profiling/MemoryTracker.h"
+
 namespace Jerboa::UI {
+	static bool sHasCachedFrame = false;
+
+	// Input on secondary viewports goes straight to the callbacks the GLFW backend installs
+	// on their windows, bypassing our event bus; they are wrapped to notice it
+	static bool sViewportInput = false;
+	static void (*sCreatePlatformWindow)(ImGuiViewport*) = nullptr;
+	static GLFWcursorposfun sViewportCursorPosCallback = nullptr;
+	static GLFWmousebuttonfun sViewportMouseButtonCallback = nullptr;
+	static GLFWscrollfun sViewportScrollCallback = nullptr;
+	static GLFWkeyfun sViewportKeyCallback = nullptr;
+	static GLFWcharfun sViewportCharCallback = nullptr;
+
+	static void CreatePlatformWindow(ImGuiViewport* viewport)
+	{
+		sCreatePlatformWindow(viewport);
+
+		auto* window = static_cast<GLFWwindow*>(viewport->PlatformHandle);
+		sViewportCursorPosCallback = glfwSetCursorPosCallback(window, [](GLFWwindow* window, double x, double y) {
+			sViewportInput = true;
+			if (sViewportCursorPosCallback) sViewportCursorPosCallback(window, x, y);
+		});
+		sViewportMouseButtonCallback = glfwSetMouseButtonCallback(window, [](GLFWwindow* window, int button, int action, int mods) {
+			sViewportInput = true;
+			if (sViewportMouseButtonCallback) sViewportMouseButtonCallback(window, button, action, mods);
+		});
+		sViewportScrollCallback = glfwSetScrollCallback(window, [](GLFWwindow* window, double xOffset, double yOffset) {
+			sViewportInput = true;
+			if (sViewportScrollCallback) sViewportScrollCallback(window, xOffset, yOffset);
+		});
+		sViewportKeyCallback = glfwSetKeyCallback(window, [](GLFWwindow* window, int key, int scancode, int action, int mods) {
+			sViewportInput = true;
+			if (sViewportKeyCallback) sViewportKeyCallback(window, key, scancode, action, mods);
+		});
+		sViewportCharCallback = glfwSetCharCallback(window, [](GLFWwindow* window, unsigned int codepoint) {
+			sViewportInput = true;
+			if (sViewportCharCallback) sViewportCharCallback(window, codepoint);
+		});
+	}
+
 	void ImGuiApp::Initialize(Window* window) {
 		static bool initialized = false;
 		JERBOA_ASSERT(!initialized, "ImGuiApp::Initialize() should only be called once");
@@ -10,6 +52,13 @@ namespace Jerboa::UI {
 			return;
 		initialized = true;
 
+#ifdef JERBOA_MEMORY_TRACKING
+		// ImGui allocates through malloc unless told otherwise
+		ImGui::SetAllocatorFunctions(
+			[](size_t size, void*) { return MemoryTracker::Allocate(size, MemoryTag::ImGui); },
+			[](void* pointer, void*) { MemoryTracker::Free(pointer); });
+#endif
+
 		// Setup Dear ImGui context
 		IMGUI_CHECKVERSION();
 		ImGui::CreateContext();
@@ -23,10 +72,18 @@ namespace Jerboa::UI {
 		auto glfwWindow = static_cast<GLFWwindow*>(window->GetNativeWindow());
 		ImGui_ImplGlfw_InitForOpenGL(glfwWindow, true);
 		ImGui_ImplOpenGL3_Init("#version 330");
+
+		ImGuiPlatformIO& platformIO = ImGui::GetPlatformIO();
+		sCreatePlatformWindow = platformIO.Platform_CreateWindow;
+		if (sCreatePlatformWindow)
+			platformIO.Platform_CreateWindow = CreatePlatformWindow;
 	}
 
 	void ImGuiApp::ShutDown()
 	{
+		sHasCachedFrame = false;
+		if (sCreatePlatformWindow)
+			ImGui::GetPlatformIO().Platform_CreateWindow = sCreatePlatformWindow;
 		ImGui_ImplOpenGL3_Shutdown();
 		ImGui_ImplGlfw_Shutdown();
 		ImGui::DestroyContext();
@@ -42,6 +99,9 @@ namespace Jerboa::UI {
 	void ImGuiApp::EndFrame()
 	{
 		ImGui::Render();
+
+		// The OpenGL3 backend sets its own state and restores it with glGet* queries
+		GLStateCache::BeginExternal();
 		ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
 
 		ImGuiIO& io = ImGui::GetIO();
@@ -52,5 +112,33 @@ namespace Jerboa::UI {
 			ImGui::RenderPlatformWindowsDefault();
 			glfwMakeContextCurrent(backup_current_context);
 		}
+		GLStateCache::EndExternal();
+
+		sHasCachedFrame = true;
+	}
+
+	void ImGuiApp::RenderCachedFrame()
+	{
+		// The draw data stays valid until the next ImGui::NewFrame()
+		GLStateCache::BeginExternal();
+		ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+		GLStateCache::EndExternal();
+	}
+
+	bool ImGuiApp::HasCachedFrame()
+	{
+		return sHasCachedFrame;
+	}
+
+	bool ImGuiApp::ConsumeViewportInput()
+	{
+		bool input = sViewportInput;
+		sViewportInput = false;
+		return input;
+	}
+
+	bool ImGuiApp::WantsContinuousUpdate()
+	{
+		return ImGui::GetIO().WantTextInput;
 	}
 }
\ No newline at end of file
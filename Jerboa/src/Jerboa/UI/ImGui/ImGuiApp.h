@@ -13,6 +13,16 @@ namespace Jerboa::UI {
 		void ShutDown();
 		void BeginFrame();
 		void EndFrame();
+
+		// Draws the previous frame's ImDrawData again without building the UI or
+		// touching the secondary platform windows, which keep showing their last image
+		void RenderCachedFrame();
+		bool HasCachedFrame();
+
+		// True if a secondary viewport window received input since the last call
+		bool ConsumeViewportInput();
+		// True while ImGui needs per-frame updates regardless of input, e.g. a blinking text cursor
+		bool WantsContinuousUpdate();
 	};
 }
 
@@ -0,0 +1,163 @@
+#include "jerboa-pch.h"
+#include "LogPanel.h"
+
+#include "imgui.h"
+
+#include "Jerboa/Core/Log.h"
+
+namespace Jerboa::UI {
+	namespace {
+		// spdlog's levels, in order
+		const char* const sLevelNames[] = { "trace", "debug", "info", "warn", "error", "critical" };
+		constexpr int sLevelCount = sizeof(sLevelNames) / sizeof(sLevelNames[0]);
+
+		const ImVec4 sLevelColors[] = {
+			{ 0.6f, 0.6f, 0.6f, 1.0f }, { 0.6f, 0.8f, 1.0f, 1.0f }, { 0.4f, 0.9f, 0.4f, 1.0f },
+			{ 1.0f, 0.8f, 0.2f, 1.0f }, { 1.0f, 0.4f, 0.3f, 1.0f }, { 1.0f, 0.2f, 0.8f, 1.0f }
+		};
+
+		struct LogPanelData
+		{
+			int minLevel = 0;
+			uint32_t hiddenCategories = 0;
+			ImGuiTextFilter textFilter;
+			bool follow = true;
+
+			// Numbers of the lines that pass the filters in ascending order, a circular buffer
+			// as large as the log ring since it can't hold more lines than that
+			std::vector<uint64_t> matches;
+			uint64_t matchesBegin = 0;
+			uint64_t matchesEnd = 0;
+			// The first line that wasn't filtered yet
+			uint64_t scanned = 0;
+			// Lines before this one were cleared
+			uint64_t cleared = 0;
+
+			LogRing::Line line;
+		};
+		LogPanelData sData;
+
+		bool PassesFilters(uint8_t level, uint8_t category)
+		{
+			return level >= sData.minLevel && !(sData.hiddenCategories & (1u << category));
+		}
+
+		void Refilter()
+		{
+			sData.matchesBegin = sData.matchesEnd = 0;
+			sData.scanned = 0;
+		}
+
+		void FilterNewLines(const LogRing& ring)
+		{
+			const uint64_t mask = ring.GetCapacity() - 1;
+			if (sData.matches.size() != ring.GetCapacity())
+				sData.matches.resize(ring.GetCapacity());
+
+			const bool filterText = sData.textFilter.IsActive();
+			const uint64_t end = ring.GetEnd();
+			uint64_t number = std::max({ sData.scanned, sData.cleared, ring.GetBegin() });
+			for (; number < end; number++) {
+				uint8_t level, category;
+				LogRing::ReadResult result;
+				if (filterText) {
+					result = ring.Read(number, sData.line);
+					level = sData.line.level;
+					category = sData.line.category;
+				}
+				else {
+					result = ring.ReadInfo(number, level, category);
+				}
+
+				// Still being written, picked up again next frame
+				if (result == LogRing::ReadResult::Pending)
+					break;
+				if (result == LogRing::ReadResult::Lost || !PassesFilters(level, category))
+					continue;
+				if (filterText && !sData.textFilter.PassFilter(sData.line.text, sData.line.text + sData.line.length))
+					continue;
+
+				if (sData.matchesEnd - sData.matchesBegin == sData.matches.size())
+					sData.matchesBegin++;
+				sData.matches[sData.matchesEnd++ & mask] = number;
+			}
+			sData.scanned = number;
+
+			// Lines the ring overwrote since
+			const uint64_t begin = ring.GetBegin();
+			while (sData.matchesBegin != sData.matchesEnd && sData.matches[sData.matchesBegin & mask] < begin)
+				sData.matchesBegin++;
+		}
+	}
+
+	void LogPanel::Draw(bool* open)
+	{
+		if (!ImGui::Begin("Log", open)) {
+			ImGui::End();
+			return;
+		}
+
+		LogRing& ring = Log::GetConsoleRing();
+		bool filtersChanged = false;
+
+		ImGui::SetNextItemWidth(100.0f);
+		filtersChanged |= ImGui::Combo("Level", &sData.minLevel, sLevelNames, sLevelCount);
+		for (uint32_t category = 0; category < ring.GetCategoryCount(); category++) {
+			// Category names are stored as std::string, so the view is null-terminated
+			const std::string_view name = ring.GetCategoryName(static_cast<uint8_t>(category));
+			bool shown = !(sData.hiddenCategories & (1u << category));
+			ImGui::SameLine();
+			ImGui::PushID((int)category);
+			if (ImGui::Checkbox(name.data(), &shown)) {
+				sData.hiddenCategories ^= 1u << category;
+				filtersChanged = true;
+			}
+			ImGui::PopID();
+		}
+		ImGui::SameLine();
+		ImGui::Checkbox("Follow", &sData.follow);
+		ImGui::SameLine();
+		if (ImGui::Button("Clear")) {
+			sData.cleared = ring.GetEnd();
+			filtersChanged = true;
+		}
+		filtersChanged |= sData.textFilter.Draw("Filter", 200.0f);
+
+		// Refiltering is bounded by the ring's capacity
+		if (filtersChanged)
+			Refilter();
+		FilterNewLines(ring);
+
+		const uint64_t mask = ring.GetCapacity() - 1;
+		const uint64_t matchCount = sData.matchesEnd - sData.matchesBegin;
+		const uint64_t kept = ring.GetEnd() - std::max(ring.GetBegin(), sData.cleared);
+		ImGui::Text("%llu of %llu lines", static_cast<unsigned long long>(matchCount), static_cast<unsigned long long>(kept));
+		if (ring.GetLostCount() > 0) {
+			ImGui::SameLine();
+			ImGui::TextColored(ImVec4(1.0f, 0.6f, 0.2f, 1.0f), "%llu lost while flooded", static_cast<unsigned long long>(ring.GetLostCount()));
+		}
+
+		ImGui::BeginChild("Lines", ImVec2(0.0f, 0.0f), false, ImGuiWindowFlags_HorizontalScrollbar);
+		ImGuiListClipper clipper;
+		clipper.Begin((int)matchCount);
+		while (clipper.Step()) {
+			for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; row++) {
+				const uint64_t number = sData.matches[(sData.matchesBegin + row) & mask];
+				if (ring.Read(number, sData.line) != LogRing::ReadResult::Ready) {
+					// Overwritten between filtering and drawing, gone next frame
+					ImGui::TextDisabled("...");
+					continue;
+				}
+				ImGui::PushStyleColor(ImGuiCol_Text, sLevelColors[std::min<int>(sData.line.level, sLevelCount - 1)]);
+				ImGui::TextUnformatted(sData.line.text, sData.line.text + sData.line.length);
+				ImGui::PopStyleColor();
+			}
+		}
+		clipper.End();
+
+		if (sData.follow && ImGui::GetScrollY() >= ImGui::GetScrollMaxY())
+			ImGui::SetScrollHereY(1.0f);
+		ImGui::EndChild();
+		ImGui::End();
+	}
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+namespace Jerboa::UI {
+	// The recent lines of every logger, filtered by level, logger and text. Only lines added
+	// since the last frame are filtered and only the visible rows are drawn, so a long log
+	// costs no more per frame than a short one.
+	namespace LogPanel {
+		void Draw(bool* open = nullptr);
+	};
+}
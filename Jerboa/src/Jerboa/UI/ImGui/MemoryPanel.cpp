@@ -0,0 +1,86 @@
+#include "jerboa-pch.h"
+#include "MemoryPanel.h"
+
+#include "imgui.h"
+
+#include "Jerboa/Profiling/MemoryTracker.h"
+
+namespace Jerboa::UI {
+	static void BytesText(int64_t bytes)
+	{
+		if (bytes >= 1024 * 1024)
+			ImGui::Text("%.2f MB", bytes / (1024.0 * 1024.0));
+		else if (bytes >= 1024)
+			ImGui::Text("%.1f KB", bytes / 1024.0);
+		else
+			ImGui::Text("%lld B", static_cast<long long>(bytes));
+	}
+
+	static void StatsRow(const char* name, const MemoryTagStats& stats)
+	{
+		ImGui::TableNextRow();
+		ImGui::TableNextColumn();
+		ImGui::TextUnformatted(name);
+		ImGui::TableNextColumn();
+		BytesText(stats.liveBytes);
+		ImGui::TableNextColumn();
+		BytesText(stats.peakBytes);
+		ImGui::TableNextColumn();
+		ImGui::Text("%lld", static_cast<long long>(stats.liveAllocations));
+		ImGui::TableNextColumn();
+		ImGui::Text("%llu", static_cast<unsigned long long>(stats.totalAllocations));
+		ImGui::TableNextColumn();
+		ImGui::Text("%llu", static_cast<unsigned long long>(stats.frameAllocations));
+	}
+
+	void MemoryPanel::Draw(bool* open)
+	{
+		if (!ImGui::Begin("Memory", open)) {
+			ImGui::End();
+			return;
+		}
+
+		if (!MemoryTracker::IsEnabled()) {
+			ImGui::TextWrapped("Memory tracking is disabled, generate the project files with --memory-tracking to enable it.");
+			ImGui::End();
+			return;
+		}
+
+		if (ImGui::BeginTable("Tags", 6, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg)) {
+			ImGui::TableSetupColumn("Tag");
+			ImGui::TableSetupColumn("Live");
+			ImGui::TableSetupColumn("Peak");
+			ImGui::TableSetupColumn("Live allocations");
+			ImGui::TableSetupColumn("Total allocations");
+			ImGui::TableSetupColumn("Last frame");
+			ImGui::TableHeadersRow();
+
+			for (uint32_t tag = 0; tag < MemoryTracker::TagCount; tag++)
+				StatsRow(MemoryTracker::GetTagName(static_cast<MemoryTag>(tag)), MemoryTracker::GetStats(static_cast<MemoryTag>(tag)));
+			StatsRow("Total", MemoryTracker::GetTotalStats());
+			ImGui::EndTable();
+		}
+
+		// Oldest frame first
+		static float allocations[MemoryTracker::FrameHistory];
+		uint32_t frameCount = MemoryTracker::GetRecordedFrameCount();
+		float maxAllocations = 1.0f;
+		for (uint32_t i = 0; i < frameCount; i++) {
+			uint32_t framesAgo = frameCount - 1 - i;
+			uint32_t total = 0;
+			for (uint32_t tag = 0; tag < MemoryTracker::TagCount; tag++)
+				total += MemoryTracker::GetFrameAllocations(static_cast<MemoryTag>(tag), framesAgo);
+			allocations[i] = static_cast<float>(total);
+			maxAllocations = std::max(maxAllocations, allocations[i]);
+		}
+		ImGui::PlotHistogram("Allocations per frame", allocations, static_cast<int>(frameCount), 0, nullptr, 0.0f, maxAllocations, ImVec2(0.0f, 80.0f));
+
+		static char path[256] = "memory.csv";
+		ImGui::InputText("##Path", path, sizeof(path));
+		ImGui::SameLine();
+		if (ImGui::Button("Dump CSV"))
+			MemoryTracker::WriteCSV(path);
+
+		ImGui::End();
+	}
+}
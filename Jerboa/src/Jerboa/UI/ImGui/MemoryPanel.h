@@ -0,0 +1,9 @@
+#pragma once
+
+namespace Jerboa::UI {
+	// Live bytes, peaks and allocations per frame of every memory tag, with a CSV export of
+	// the per-frame history. Needs a build with memory tracking enabled.
+	namespace MemoryPanel {
+		void Draw(bool* open = nullptr);
+	};
+}
@@ -0,0 +1,71 @@
+#include "jerboa-pch.h"
+#include "ProfilerPanel.h"
+
+#include "imgui.h"
+
+#include "Jerboa/Profiling/Profiler.h"
+#include "Jerboa/Profiling/GPUProfiler.h"
+
+namespace Jerboa::UI {
+	void ProfilerPanel::Draw(bool* open)
+	{
+		if (!ImGui::Begin("Profiler", open)) {
+			ImGui::End();
+			return;
+		}
+
+		// GPU results lag behind, the oldest frames in the history have both timelines
+		uint64_t frameIndex = Profiler::GetFrameIndex();
+		uint64_t shownIndex = frameIndex > GPUProfiler::MaxFramesInFlight ? frameIndex - GPUProfiler::MaxFramesInFlight : 0;
+		const ProfileFrame* frame = Profiler::GetFrame(shownIndex);
+		if (!frame || frame->end == 0) {
+			ImGui::Text("Waiting for frames...");
+			ImGui::End();
+			return;
+		}
+
+		ImGui::Text("Frame %llu: CPU %.3f ms, GPU %.3f ms", static_cast<unsigned long long>(frame->index),
+			Time::ToMilliseconds(frame->end - frame->start), GPUProfiler::GetLastFrameTime());
+		if (!GPUProfiler::IsSupported())
+			ImGui::TextColored(ImVec4(1.0f, 0.6f, 0.2f, 1.0f), "GPU timer queries unavailable");
+		else if (GPUProfiler::GetDroppedFrames() > 0)
+			ImGui::Text("GPU frames dropped: %llu", static_cast<unsigned long long>(GPUProfiler::GetDroppedFrames()));
+
+		if (ImGui::BeginTable("Zones", 4, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY)) {
+			ImGui::TableSetupColumn("Track");
+			ImGui::TableSetupColumn("Zone");
+			ImGui::TableSetupColumn("Start (ms)");
+			ImGui::TableSetupColumn("Duration (ms)");
+			ImGui::TableHeadersRow();
+
+			// Zones are recorded when they end; show each track in start order instead
+			static std::vector<ProfileZone> zones;
+			zones.assign(frame->zones.begin(), frame->zones.end());
+			std::sort(zones.begin(), zones.end(), [](const ProfileZone& a, const ProfileZone& b) {
+				return a.track != b.track ? a.track < b.track : a.start < b.start;
+			});
+
+			for (const ProfileZone& zone : zones) {
+				ImGui::TableNextRow();
+				ImGui::TableNextColumn();
+				if (zone.track == Profiler::GPUTrack)
+					ImGui::TextUnformatted("GPU");
+				else
+					ImGui::Text("CPU %u", zone.track);
+
+				ImGui::TableNextColumn();
+				ImGui::Text("%*s%s", static_cast<int>(zone.depth * 2), "", zone.name);
+
+				// GPU zones can start before the CPU frame began if submission was queued late
+				double start = static_cast<double>(static_cast<int64_t>(zone.start - frame->start)) / 1000000.0;
+				ImGui::TableNextColumn();
+				ImGui::Text("%.3f", start);
+				ImGui::TableNextColumn();
+				ImGui::Text("%.3f", Time::ToMilliseconds(zone.end - zone.start));
+			}
+			ImGui::EndTable();
+		}
+
+		ImGui::End();
+	}
+}
@@ -0,0 +1,9 @@
+#pragma once
+
+namespace Jerboa::UI {
+	// Shows the CPU and GPU zones of the most recent frame whose GPU results arrived,
+	// on one timeline relative to the start of that frame
+	namespace ProfilerPanel {
+		void Draw(bool* open = nullptr);
+	};
+}
@@ -0,0 +1,129 @@
+#include "Benchmark.h"
+
+#include "Jerboa/Core/Time.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+#ifdef JERBOA_PLATFORM_LINUX
+	#include <pthread.h>
+	#include <sched.h>
+#elif defined(JERBOA_PLATFORM_WINDOWS)
+	#include <windows.h>
+#endif
+
+namespace {
+	constexpr uint64_t MaxIterations = 1ull << 40;
+
+	double Measure(const BenchmarkFunction& function, uint64_t iterations)
+	{
+		Jerboa::Timestamp start = Jerboa::Time::Now();
+		function(iterations);
+		return (double)(Jerboa::Time::Now() - start);
+	}
+
+	double Median(std::vector<double> values)
+	{
+		std::sort(values.begin(), values.end());
+		size_t middle = values.size() / 2;
+		return values.size() % 2 ? values[middle] : (values[middle - 1] + values[middle]) / 2.0;
+	}
+
+	BenchmarkResult Summarize(const std::string& name, uint64_t iterations, const std::vector<double>& samples)
+	{
+		BenchmarkResult result;
+		result.name = name;
+		result.iterations = iterations;
+		result.samples = (uint32_t)samples.size();
+		result.medianNs = Median(samples);
+		result.minNs = *std::min_element(samples.begin(), samples.end());
+		result.maxNs = *std::max_element(samples.begin(), samples.end());
+
+		double sum = 0.0;
+		for (double sample : samples)
+			sum += sample;
+		result.meanNs = sum / samples.size();
+
+		double squares = 0.0;
+		std::vector<double> deviations;
+		for (double sample : samples) {
+			squares += (sample - result.meanNs) * (sample - result.meanNs);
+			deviations.push_back(std::abs(sample - result.medianNs));
+		}
+		result.stddevNs = samples.size() > 1 ? std::sqrt(squares / (samples.size() - 1)) : 0.0;
+		result.madNs = Median(deviations);
+		return result;
+	}
+}
+
+void BenchmarkSuite::Add(const std::string& name, BenchmarkSetup setup)
+{
+	mBenchmarks.push_back({ name, std::move(setup) });
+}
+
+std::vector<BenchmarkResult> BenchmarkSuite::Run(const BenchmarkSettings& settings) const
+{
+	const double sampleNs = settings.sampleMs * 1e6;
+	const uint32_t sampleCount = std::max(settings.samples, 1u);
+
+	std::vector<BenchmarkResult> results;
+	for (const Entry& entry : mBenchmarks) {
+		if (!settings.filter.empty() && entry.name.find(settings.filter) == std::string::npos)
+			continue;
+
+		BenchmarkFunction function = entry.setup();
+		if (!function) {
+			std::printf("%-48s skipped\n", entry.name.c_str());
+			continue;
+		}
+
+		// Grows the iteration count until one call lasts a sample, overshooting a little
+		// so the loop ends in a few steps
+		uint64_t iterations = 1;
+		double elapsed = Measure(function, iterations);
+		while (elapsed < sampleNs && iterations < MaxIterations) {
+			double scale = elapsed > 0.0 ? std::min(sampleNs / elapsed * 1.2, 100.0) : 100.0;
+			iterations = std::max(iterations + 1, (uint64_t)(iterations * scale));
+			elapsed = Measure(function, iterations);
+		}
+
+		Jerboa::Timestamp warmupStart = Jerboa::Time::Now();
+		while (Jerboa::Time::ToMilliseconds(Jerboa::Time::Now() - warmupStart) < settings.warmupMs)
+			Measure(function, iterations);
+
+		std::vector<double> samples;
+		for (uint32_t i = 0; i < sampleCount; i++)
+			samples.push_back(Measure(function, iterations) / iterations);
+
+		BenchmarkResult result = Summarize(entry.name, iterations, samples);
+		std::printf("%-48s %12.2f ns  +-%5.1f%%  min %12.2f ns  %10llu iterations\n", result.name.c_str(), result.medianNs,
+			result.medianNs > 0.0 ? result.madNs / result.medianNs * 100.0 : 0.0, result.minNs, (unsigned long long)result.iterations);
+		std::fflush(stdout);
+		results.push_back(std::move(result));
+	}
+	return results;
+}
+
+int PinCurrentThread(int cpu)
+{
+#ifdef JERBOA_PLATFORM_LINUX
+	if (cpu < 0)
+		cpu = sched_getcpu();
+	if (cpu < 0 || cpu >= CPU_SETSIZE)
+		return -1;
+
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	CPU_SET(cpu, &set);
+	return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0 ? cpu : -1;
+#elif defined(JERBOA_PLATFORM_WINDOWS)
+	if (cpu < 0)
+		cpu = (int)GetCurrentProcessorNumber();
+	if (cpu >= (int)(sizeof(DWORD_PTR) * 8))
+		return -1;
+	return SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)1 << cpu) != 0 ? cpu : -1;
+#else
+	return -1;
+#endif
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <functional>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+// Measured body of a benchmark, performs the operation iterations times
+using BenchmarkFunction = std::function<void(uint64_t iterations)>;
+// Builds the fixture of a benchmark and returns the body, which owns the fixture. An empty
+// function skips the benchmark, e.g. when there is no display to open a window on.
+using BenchmarkSetup = std::function<BenchmarkFunction()>;
+
+struct BenchmarkSettings
+{
+	// Untimed runs before the samples, so caches, branch predictors and clocks settle
+	double warmupMs = 100.0;
+	// Iterations per sample are calibrated so one sample takes about this long
+	double sampleMs = 10.0;
+	uint32_t samples = 25;
+	// CPU the benchmark thread is pinned to, -1 pins to the CPU it starts on
+	int cpu = -1;
+	// Only benchmarks whose name contains the filter run
+	std::string filter;
+};
+
+// Times are per iteration
+struct BenchmarkResult
+{
+	std::string name;
+	uint64_t iterations = 0;
+	uint32_t samples = 0;
+	double medianNs = 0.0;
+	double meanNs = 0.0;
+	double minNs = 0.0;
+	double maxNs = 0.0;
+	double stddevNs = 0.0;
+	// Median absolute deviation from the median, unlike stddev not inflated by outliers
+	double madNs = 0.0;
+};
+
+class BenchmarkSuite
+{
+public:
+	// Names are grouped with slashes, e.g. "EventBus/Publish/16 observers"
+	void Add(const std::string& name, BenchmarkSetup setup);
+
+	std::vector<BenchmarkResult> Run(const BenchmarkSettings& settings) const;
+private:
+	struct Entry
+	{
+		std::string name;
+		BenchmarkSetup setup;
+	};
+
+	std::vector<Entry> mBenchmarks;
+};
+
+// Returns the CPU the thread was pinned to, or -1 if pinning is not supported
+int PinCurrentThread(int cpu);
+
+// Keeps the compiler from optimizing away a value that is computed but never used
+template<typename T>
+inline void DoNotOptimize(const T& value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+	asm volatile("" : : "r,m"(value) : "memory");
+#else
+	static volatile const void* sink;
+	sink = &value;
+#endif
+}
+
+// Benchmarks of the engine's core paths, see the matching .cpp files
+void AddEventBusBenchmarks(BenchmarkSuite& suite);
+void AddLayerStackBenchmarks(BenchmarkSuite& suite);
+void AddLogBenchmarks(BenchmarkSuite& suite);
+void AddWindowBenchmarks(BenchmarkSuite& suite);
+void AddIPCBenchmarks(BenchmarkSuite& suite);
+void AddTelemetryBenchmarks(BenchmarkSuite& suite);
@@ -0,0 +1,276 @@
+#include "BenchmarkReport.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <utility>
+
+namespace {
+	constexpr uint32_t FormatVersion = 1;
+	// Noise of a run is measured as this many median absolute deviations
+	constexpr double NoiseDeviations = 3.0;
+
+	void WriteString(std::FILE* file, const std::string& string)
+	{
+		std::fputc('"', file);
+		for (char character : string) {
+			if (character == '"' || character == '\\')
+				std::fputc('\\', file);
+			if ((unsigned char)character >= 0x20)
+				std::fputc(character, file);
+		}
+		std::fputc('"', file);
+	}
+
+	// Just enough JSON to read reports back, which may have been edited or merged by hand
+	struct JsonValue
+	{
+		enum class Type { Null, Bool, Number, String, Array, Object };
+
+		Type type = Type::Null;
+		double number = 0.0;
+		std::string string;
+		std::vector<JsonValue> elements;
+		std::vector<std::pair<std::string, JsonValue>> members;
+
+		const JsonValue* Find(const char* key) const {
+			for (const auto& member : members) {
+				if (member.first == key)
+					return &member.second;
+			}
+			return nullptr;
+		}
+
+		double GetNumber(const char* key, double fallback = 0.0) const {
+			const JsonValue* value = Find(key);
+			return value && value->type == Type::Number ? value->number : fallback;
+		}
+
+		std::string GetString(const char* key) const {
+			const JsonValue* value = Find(key);
+			return value && value->type == Type::String ? value->string : std::string();
+		}
+	};
+
+	class JsonParser
+	{
+	public:
+		JsonParser(const std::string& text) : mCursor(text.c_str()), mEnd(text.c_str() + text.size()) {}
+
+		bool Parse(JsonValue& value) {
+			if (!ParseValue(value, 0))
+				return false;
+			SkipWhitespace();
+			return mCursor == mEnd;
+		}
+	private:
+		static constexpr int MaxDepth = 32;
+
+		void SkipWhitespace() {
+			while (mCursor < mEnd && std::strchr(" \t\r\n", *mCursor))
+				mCursor++;
+		}
+
+		bool Consume(char character) {
+			SkipWhitespace();
+			if (mCursor == mEnd || *mCursor != character)
+				return false;
+			mCursor++;
+			return true;
+		}
+
+		bool ParseLiteral(const char* literal) {
+			size_t length = std::strlen(literal);
+			if ((size_t)(mEnd - mCursor) < length || std::strncmp(mCursor, literal, length) != 0)
+				return false;
+			mCursor += length;
+			return true;
+		}
+
+		// Escapes other than quotes and backslashes are kept as they are, reports don't write them
+		bool ParseString(std::string& string) {
+			if (!Consume('"'))
+				return false;
+			while (mCursor < mEnd && *mCursor != '"') {
+				if (*mCursor == '\\' && mCursor + 1 < mEnd && (mCursor[1] == '"' || mCursor[1] == '\\'))
+					mCursor++;
+				string.push_back(*mCursor++);
+			}
+			return Consume('"');
+		}
+
+		bool ParseValue(JsonValue& value, int depth) {
+			SkipWhitespace();
+			if (mCursor == mEnd || depth > MaxDepth)
+				return false;
+
+			switch (*mCursor) {
+			case '{':
+				mCursor++;
+				value.type = JsonValue::Type::Object;
+				if (Consume('}'))
+					return true;
+				do {
+					value.members.emplace_back();
+					if (!ParseString(value.members.back().first) || !Consume(':') || !ParseValue(value.members.back().second, depth + 1))
+						return false;
+				} while (Consume(','));
+				return Consume('}');
+			case '[':
+				mCursor++;
+				value.type = JsonValue::Type::Array;
+				if (Consume(']'))
+					return true;
+				do {
+					value.elements.emplace_back();
+					if (!ParseValue(value.elements.back(), depth + 1))
+						return false;
+				} while (Consume(','));
+				return Consume(']');
+			case '"':
+				value.type = JsonValue::Type::String;
+				return ParseString(value.string);
+			case 't':
+				value.type = JsonValue::Type::Bool;
+				value.number = 1.0;
+				return ParseLiteral("true");
+			case 'f':
+				value.type = JsonValue::Type::Bool;
+				return ParseLiteral("false");
+			case 'n':
+				return ParseLiteral("null");
+			default: {
+				char* end = nullptr;
+				value.type = JsonValue::Type::Number;
+				value.number = std::strtod(mCursor, &end);
+				if (end == mCursor)
+					return false;
+				mCursor = end;
+				return true;
+			}
+			}
+		}
+
+		const char* mCursor;
+		const char* mEnd;
+	};
+
+	const BenchmarkResult* FindResult(const BenchmarkReport& report, const std::string& name)
+	{
+		auto it = std::find_if(report.results.begin(), report.results.end(), [&](const BenchmarkResult& result) { return result.name == name; });
+		return it != report.results.end() ? &*it : nullptr;
+	}
+}
+
+bool WriteReport(const BenchmarkReport& report, const std::string& path)
+{
+	std::FILE* file = std::fopen(path.c_str(), "w");
+	if (!file) {
+		std::fprintf(stderr, "Could not write benchmark report to \"%s\"\n", path.c_str());
+		return false;
+	}
+
+	std::fprintf(file, "{\n\t\"format\": \"jerboa-bench\",\n\t\"version\": %u,\n\t\"configuration\": ", FormatVersion);
+	WriteString(file, report.configuration);
+	std::fprintf(file, ",\n\t\"cpu\": %d,\n\t\"warmup_ms\": %.3f,\n\t\"sample_ms\": %.3f,\n\t\"samples\": %u,\n\t\"benchmarks\": [",
+		report.cpu, report.settings.warmupMs, report.settings.sampleMs, report.settings.samples);
+
+	for (size_t i = 0; i < report.results.size(); i++) {
+		const BenchmarkResult& result = report.results[i];
+		std::fprintf(file, "%s\n\t\t{ \"name\": ", i ? "," : "");
+		WriteString(file, result.name);
+		std::fprintf(file, ", \"iterations\": %llu, \"samples\": %u, \"median_ns\": %.4f, \"mean_ns\": %.4f, \"min_ns\": %.4f, "
+			"\"max_ns\": %.4f, \"stddev_ns\": %.4f, \"mad_ns\": %.4f }", (unsigned long long)result.iterations, result.samples,
+			result.medianNs, result.meanNs, result.minNs, result.maxNs, result.stddevNs, result.madNs);
+	}
+	std::fprintf(file, "\n\t]\n}\n");
+
+	bool written = std::ferror(file) == 0;
+	written &= std::fclose(file) == 0;
+	if (!written)
+		std::fprintf(stderr, "Could not write benchmark report to \"%s\"\n", path.c_str());
+	return written;
+}
+
+bool ReadReport(const std::string& path, BenchmarkReport& report)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file) {
+		std::fprintf(stderr, "Could not open benchmark report \"%s\"\n", path.c_str());
+		return false;
+	}
+	std::string text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+	JsonValue root;
+	const JsonValue* benchmarks = nullptr;
+	if (JsonParser(text).Parse(root) && root.type == JsonValue::Type::Object)
+		benchmarks = root.Find("benchmarks");
+	if (!benchmarks || benchmarks->type != JsonValue::Type::Array || root.GetString("format") != "jerboa-bench") {
+		std::fprintf(stderr, "\"%s\" is not a benchmark report\n", path.c_str());
+		return false;
+	}
+	if (root.GetNumber("version") != FormatVersion) {
+		std::fprintf(stderr, "Benchmark report \"%s\" has version %g, expected %u\n", path.c_str(), root.GetNumber("version"), FormatVersion);
+		return false;
+	}
+
+	report.configuration = root.GetString("configuration");
+	report.cpu = (int)root.GetNumber("cpu", -1.0);
+	report.settings.warmupMs = root.GetNumber("warmup_ms");
+	report.settings.sampleMs = root.GetNumber("sample_ms");
+	report.settings.samples = (uint32_t)root.GetNumber("samples");
+	report.results.clear();
+	for (const JsonValue& benchmark : benchmarks->elements) {
+		BenchmarkResult result;
+		result.name = benchmark.GetString("name");
+		if (result.name.empty())
+			continue;
+		result.iterations = (uint64_t)benchmark.GetNumber("iterations");
+		result.samples = (uint32_t)benchmark.GetNumber("samples");
+		result.medianNs = benchmark.GetNumber("median_ns");
+		result.meanNs = benchmark.GetNumber("mean_ns");
+		result.minNs = benchmark.GetNumber("min_ns");
+		result.maxNs = benchmark.GetNumber("max_ns");
+		result.stddevNs = benchmark.GetNumber("stddev_ns");
+		result.madNs = benchmark.GetNumber("mad_ns");
+		report.results.push_back(std::move(result));
+	}
+	return true;
+}
+
+uint32_t CompareReports(const BenchmarkReport& baseline, const BenchmarkReport& current, double thresholdPercent)
+{
+	if (baseline.configuration != current.configuration)
+		std::printf("Comparing a %s baseline with a %s build\n", baseline.configuration.c_str(), current.configuration.c_str());
+
+	uint32_t regressions = 0;
+	for (const BenchmarkResult& result : current.results) {
+		const BenchmarkResult* base = FindResult(baseline, result.name);
+		if (!base || base->medianNs <= 0.0) {
+			std::printf("%-48s %12s    -> %12.2f ns  new\n", result.name.c_str(), "", result.medianNs);
+			continue;
+		}
+
+		const double difference = result.medianNs - base->medianNs;
+		const double change = difference / base->medianNs * 100.0;
+		const double noise = NoiseDeviations * std::max(base->madNs, result.madNs);
+		const char* verdict = "";
+		if (std::abs(change) > thresholdPercent && std::abs(difference) > noise) {
+			verdict = difference > 0.0 ? "REGRESSION" : "improved";
+			regressions += difference > 0.0;
+		}
+		std::printf("%-48s %12.2f ns -> %12.2f ns  %+7.1f%%  %s\n", result.name.c_str(), base->medianNs, result.medianNs, change, verdict);
+	}
+
+	for (const BenchmarkResult& result : baseline.results) {
+		if (!FindResult(current, result.name))
+			std::printf("%-48s %12.2f ns    -> %12s     not run\n", result.name.c_str(), result.medianNs, "");
+	}
+
+	std::printf("%u regression%s above %.1f%%\n", regressions, regressions == 1 ? "" : "s", thresholdPercent);
+	return regressions;
+}
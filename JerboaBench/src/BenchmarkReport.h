@@ -0,0 +1,23 @@
+#pragma once
+
+#include "Benchmark.h"
+
+#include <string>
+#include <vector>
+
+struct BenchmarkReport
+{
+	std::string configuration;
+	// CPU the benchmarks ran pinned to, -1 if they were not pinned
+	int cpu = -1;
+	BenchmarkSettings settings;
+	std::vector<BenchmarkResult> results;
+};
+
+bool WriteReport(const BenchmarkReport& report, const std::string& path);
+bool ReadReport(const std::string& path, BenchmarkReport& report);
+
+// Prints the change of every benchmark found in both reports. A benchmark regressed when
+// its median grew by more than thresholdPercent and by more than the noise of both runs.
+// Returns the number of regressions.
+uint32_t CompareReports(const BenchmarkReport& baseline, const BenchmarkReport& current, double thresholdPercent);
@@ -0,0 +1,88 @@
+#include "Benchmark.h"
+
+#include "Jerboa/Core/EventBus.h"
+#include "Jerboa/Core/EventObserver.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+	struct BenchEvent : Jerboa::Event
+	{
+		uint32_t value = 1;
+	};
+
+	struct OtherEvent : Jerboa::Event {};
+
+	class Listener
+	{
+	public:
+		Listener(Jerboa::EventBus* bus)
+			: mObserver(Jerboa::EventObserver::Create(bus, this, &Listener::OnEvent)) {}
+
+		void OnEvent(const BenchEvent& evnt) { mSum += evnt.value; }
+
+		uint64_t GetSum() const { return mSum; }
+	private:
+		Jerboa::EventObserver mObserver;
+		uint64_t mSum = 0;
+	};
+
+	struct PublishFixture
+	{
+		Jerboa::EventBus bus;
+		std::vector<std::unique_ptr<Listener>> listeners;
+	};
+
+	void AddPublish(BenchmarkSuite& suite, uint32_t observerCount)
+	{
+		std::string name = "EventBus/Publish/" + std::to_string(observerCount) + (observerCount == 1 ? " observer" : " observers");
+		suite.Add(name, [observerCount]() -> BenchmarkFunction {
+			auto fixture = std::make_shared<PublishFixture>();
+			for (uint32_t i = 0; i < observerCount; i++)
+				fixture->listeners.push_back(std::make_unique<Listener>(&fixture->bus));
+
+			return [fixture](uint64_t iterations) {
+				// Constructing an event reads the clock, that is not what is measured here
+				const BenchEvent evnt;
+				for (uint64_t i = 0; i < iterations; i++)
+					fixture->bus.Publish(evnt);
+				if (!fixture->listeners.empty())
+					DoNotOptimize(fixture->listeners.front()->GetSum());
+			};
+		});
+	}
+}
+
+void AddEventBusBenchmarks(BenchmarkSuite& suite)
+{
+	// Nobody listens for the event type, but the bus has subscribers of another type
+	suite.Add("EventBus/Publish/unobserved type", []() -> BenchmarkFunction {
+		auto fixture = std::make_shared<PublishFixture>();
+		fixture->listeners.push_back(std::make_unique<Listener>(&fixture->bus));
+
+		return [fixture](uint64_t iterations) {
+			const OtherEvent evnt;
+			for (uint64_t i = 0; i < iterations; i++)
+				fixture->bus.Publish(evnt);
+		};
+	});
+
+	for (uint32_t observerCount : { 1u, 16u, 256u })
+		AddPublish(suite, observerCount);
+
+	// Layers and windows subscribe when they are created, observers come from a pool
+	suite.Add("EventBus/Subscribe and unsubscribe", []() -> BenchmarkFunction {
+		auto fixture = std::make_shared<PublishFixture>();
+		for (uint32_t i = 0; i < 16; i++)
+			fixture->listeners.push_back(std::make_unique<Listener>(&fixture->bus));
+
+		return [fixture](uint64_t iterations) {
+			for (uint64_t i = 0; i < iterations; i++) {
+				Listener listener(&fixture->bus);
+				DoNotOptimize(listener);
+			}
+		};
+	});
+}
@@ -0,0 +1,331 @@
+#include "Benchmark.h"
+
+#ifdef JERBOA_PLATFORM_LINUX
+
+#include "JerboaIPC/IPCChannel.h"
+
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include <sched.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+
+// Compares the shared-memory IPCChannel with a Unix domain socket, the obvious alternative.
+// Every fixture forks a peer process that receives and echoes, so both transports cross a
+// real process boundary. Throughput sends iterations messages one way and waits for the
+// peer to confirm it received all of them, round trip waits for every echo.
+namespace {
+	enum MessageType : uint32_t {
+		Data = 1,
+		// Answered with Ack once every message before it was received
+		Sync,
+		Ack,
+		Ping,
+		Pong,
+		Quit
+	};
+
+	// The peers wait with a timeout, so one whose parent died doesn't linger
+	constexpr int PeerPollMs = 100;
+
+	struct SocketHeader
+	{
+		uint32_t type;
+		uint32_t size;
+	};
+
+	// The benchmark thread is pinned and the peer inherits that, spread it out again so
+	// both sides can run at the same time
+	void UnpinPeer()
+	{
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		const unsigned cpuCount = std::max(std::thread::hardware_concurrency(), 1u);
+		for (unsigned cpu = 0; cpu < cpuCount && cpu < CPU_SETSIZE; cpu++)
+			CPU_SET(cpu, &set);
+		sched_setaffinity(0, sizeof(set), &set);
+	}
+
+	bool IsParentAlive(pid_t parent)
+	{
+		return getppid() == parent;
+	}
+
+	inline void CpuRelax()
+	{
+#if defined(__x86_64__) || defined(__i386__)
+		__builtin_ia32_pause();
+#endif
+	}
+
+	pid_t ForkPeer(void (*peer)(pid_t parent, const std::string& name, int socket, bool spin), const std::string& name, int socket, bool spin)
+	{
+		const pid_t parent = getpid();
+		const pid_t pid = fork();
+		if (pid == 0) {
+			UnpinPeer();
+			peer(parent, name, socket, spin);
+			// Skip the parent's destructors and atexit handlers, they own the fixtures
+			_exit(0);
+		}
+		return pid;
+	}
+
+	void SharedMemoryPeer(pid_t parent, const std::string& name, int, bool spin)
+	{
+		Jerboa::IPCChannel toPeer, toParent;
+		if (!toPeer.Open(name + "-in") || !toParent.Open(name + "-out"))
+			return;
+
+		bool running = true;
+		uint32_t idle = 0;
+		while (running) {
+			const uint32_t received = toPeer.Receive([&](const Jerboa::IPCMessage& message) {
+				if (message.type == Sync)
+					toParent.Send(Ack, 1, nullptr, 0);
+				else if (message.type == Ping)
+					toParent.Send(Pong, 1, message.payload, message.size);
+				else if (message.type == Quit)
+					running = false;
+			});
+			if (received > 0)
+				continue;
+
+			// Waiting announces itself to senders, which then wake the peer with a syscall,
+			// so the spinning peer only polls the ring
+			if (spin)
+				CpuRelax();
+			else
+				toPeer.WaitForMessages(PeerPollMs);
+			if (!spin || ++idle % 4096 == 0)
+				running = running && IsParentAlive(parent);
+		}
+	}
+
+	void SocketPeer(pid_t parent, const std::string&, int socket, bool spin)
+	{
+		std::vector<uint8_t> buffer(64 * 1024);
+		for (;;) {
+			const ssize_t size = recv(socket, buffer.data(), buffer.size(), spin ? MSG_DONTWAIT : 0);
+			if (size < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+				CpuRelax();
+				if (!IsParentAlive(parent))
+					return;
+				continue;
+			}
+			if (size < (ssize_t)sizeof(SocketHeader))
+				return;
+
+			SocketHeader header;
+			std::memcpy(&header, buffer.data(), sizeof(header));
+			if (header.type == Sync) {
+				SocketHeader ack = { Ack, 0 };
+				send(socket, &ack, sizeof(ack), 0);
+			}
+			else if (header.type == Ping) {
+				SocketHeader* pong = reinterpret_cast<SocketHeader*>(buffer.data());
+				pong->type = Pong;
+				send(socket, buffer.data(), (size_t)size, 0);
+			}
+			else if (header.type == Quit) {
+				return;
+			}
+		}
+	}
+
+	class SharedMemoryFixture
+	{
+	public:
+		~SharedMemoryFixture()
+		{
+			if (mPeer > 0) {
+				mToPeer.Send(Quit, 1, nullptr, 0, 1000);
+				waitpid(mPeer, nullptr, 0);
+			}
+		}
+
+		bool Start(bool spin)
+		{
+			static uint32_t sFixtureCount = 0;
+			const std::string name = "/jerboa-bench-" + std::to_string(getpid()) + "-" + std::to_string(sFixtureCount++);
+			if (!mToPeer.Create(name + "-in") || !mToParent.Create(name + "-out"))
+				return false;
+			mSpin = spin;
+			mPeer = ForkPeer(&SharedMemoryPeer, name, -1, spin);
+			return mPeer > 0;
+		}
+
+		void Send(uint32_t type, const void* payload, uint32_t size)
+		{
+			mToPeer.Send(type, 1, payload, size);
+		}
+
+		// Waits for the reply to the last Sync or Ping
+		void WaitForReply()
+		{
+			for (;;) {
+				if (mToParent.Receive([](const Jerboa::IPCMessage&) {}, 1) > 0)
+					return;
+				if (mSpin)
+					CpuRelax();
+				else
+					mToParent.WaitForMessages();
+			}
+		}
+	private:
+		Jerboa::IPCChannel mToPeer;
+		Jerboa::IPCChannel mToParent;
+		pid_t mPeer = -1;
+		bool mSpin = false;
+	};
+
+	class SocketFixture
+	{
+	public:
+		~SocketFixture()
+		{
+			if (mPeer > 0) {
+				Send(Quit, nullptr, 0);
+				waitpid(mPeer, nullptr, 0);
+			}
+			if (mSocket >= 0)
+				close(mSocket);
+		}
+
+		bool Start(bool spin)
+		{
+			// Message boundaries like the channel's slots, and reliable unlike SOCK_DGRAM
+			int sockets[2];
+			if (socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, sockets) != 0)
+				return false;
+			mPeer = ForkPeer(&SocketPeer, std::string(), sockets[1], spin);
+			close(sockets[1]);
+			mSocket = sockets[0];
+			mSpin = spin;
+			return mPeer > 0;
+		}
+
+		void Send(uint32_t type, const void* payload, uint32_t size)
+		{
+			SocketHeader header = { type, size };
+			mBuffer.resize(sizeof(header) + size);
+			std::memcpy(mBuffer.data(), &header, sizeof(header));
+			if (size > 0)
+				std::memcpy(mBuffer.data() + sizeof(header), payload, size);
+			while (send(mSocket, mBuffer.data(), mBuffer.size(), 0) < 0 && errno == EINTR) {}
+		}
+
+		void WaitForReply()
+		{
+			uint8_t reply[1024];
+			for (;;) {
+				const ssize_t size = recv(mSocket, reply, sizeof(reply), mSpin ? MSG_DONTWAIT : 0);
+				if (size >= 0)
+					return;
+				if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+					return;
+				CpuRelax();
+			}
+		}
+	private:
+		int mSocket = -1;
+		pid_t mPeer = -1;
+		bool mSpin = false;
+		std::vector<uint8_t> mBuffer;
+	};
+
+	template<typename Fixture>
+	void AddThroughput(BenchmarkSuite& suite, const char* transport, uint32_t payloadBytes)
+	{
+		std::string name = std::string("IPC/Throughput/") + transport + "/" + std::to_string(payloadBytes) + " bytes";
+		suite.Add(name, [payloadBytes]() -> BenchmarkFunction {
+			auto fixture = std::make_shared<Fixture>();
+			if (!fixture->Start(false))
+				return BenchmarkFunction();
+
+			auto payload = std::make_shared<std::vector<uint8_t>>(payloadBytes, (uint8_t)0x5a);
+			return [fixture, payload](uint64_t iterations) {
+				for (uint64_t i = 0; i < iterations; i++)
+					fixture->Send(Data, payload->data(), (uint32_t)payload->size());
+				// Only counts once the peer has everything
+				fixture->Send(Sync, nullptr, 0);
+				fixture->WaitForReply();
+			};
+		});
+	}
+
+	template<typename Fixture>
+	void AddRoundTrip(BenchmarkSuite& suite, const char* transport, bool spin)
+	{
+		std::string name = std::string("IPC/Round trip/") + transport + (spin ? " (spinning)" : " (blocking)");
+		suite.Add(name, [spin]() -> BenchmarkFunction {
+			// Two spinning processes on one CPU only take turns on the scheduler's tick
+			if (spin && std::thread::hardware_concurrency() < 2)
+				return BenchmarkFunction();
+
+			auto fixture = std::make_shared<Fixture>();
+			if (!fixture->Start(spin))
+				return BenchmarkFunction();
+
+			return [fixture](uint64_t iterations) {
+				const uint64_t value = 42;
+				for (uint64_t i = 0; i < iterations; i++) {
+					fixture->Send(Ping, &value, sizeof(value));
+					fixture->WaitForReply();
+				}
+			};
+		});
+	}
+
+	// What the engine pays per message, without another process in the way
+	void AddInProcess(BenchmarkSuite& suite)
+	{
+		suite.Add("IPC/In process/TrySend and Receive", []() -> BenchmarkFunction {
+			auto channel = std::make_shared<Jerboa::IPCChannel>();
+			const std::string name = "/jerboa-bench-" + std::to_string(getpid()) + "-local";
+			if (!channel->Create(name))
+				return BenchmarkFunction();
+
+			return [channel](uint64_t iterations) {
+				const uint8_t payload[64] = {};
+				uint64_t sum = 0;
+				for (uint64_t i = 0; i < iterations; i++) {
+					channel->TrySend(Data, 1, payload, sizeof(payload));
+					channel->Receive([&sum](const Jerboa::IPCMessage& message) { sum += message.size; });
+				}
+				DoNotOptimize(sum);
+			};
+		});
+	}
+}
+
+void AddIPCBenchmarks(BenchmarkSuite& suite)
+{
+	// A peer that exits early must not take the benchmark down with it
+	signal(SIGPIPE, SIG_IGN);
+
+	for (uint32_t payloadBytes : { 16u, 128u }) {
+		AddThroughput<SharedMemoryFixture>(suite, "Shared memory", payloadBytes);
+		AddThroughput<SocketFixture>(suite, "Unix socket", payloadBytes);
+	}
+	for (bool spin : { false, true }) {
+		AddRoundTrip<SharedMemoryFixture>(suite, "Shared memory", spin);
+		AddRoundTrip<SocketFixture>(suite, "Unix socket", spin);
+	}
+	AddInProcess(suite);
+}
+
+#else
+
+// The channel is Linux only
+void AddIPCBenchmarks(BenchmarkSuite&) {}
+
+#endif
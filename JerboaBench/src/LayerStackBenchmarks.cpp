@@ -0,0 +1,80 @@
+#include "Benchmark.h"
+
+#include "Jerboa/Core/Layer.h"
+#include "Jerboa/Core/LayerStack.h"
+
+#include <memory>
+
+namespace {
+	constexpr uint32_t LayerCount = 1000;
+
+	class CountingLayer : public Jerboa::Layer
+	{
+	public:
+		CountingLayer() : Layer("CountingLayer") {}
+
+		virtual void OnUpdate() override { mUpdates++; }
+		virtual void OnImGuiRender() override { mRenders++; }
+
+		uint64_t GetUpdates() const { return mUpdates; }
+	private:
+		uint64_t mUpdates = 0;
+		uint64_t mRenders = 0;
+	};
+
+	struct LayerStackFixture
+	{
+		Jerboa::LayerStack stack;
+		// Pushed and removed again by the churn benchmark, so the stack never owns it
+		CountingLayer extraLayer;
+
+		LayerStackFixture() {
+			for (uint32_t i = 0; i < LayerCount; i++) {
+				if (i % 10 == 0)
+					stack.PushOverlay(new CountingLayer());
+				else
+					stack.PushLayer(new CountingLayer());
+			}
+		}
+	};
+}
+
+void AddLayerStackBenchmarks(BenchmarkSuite& suite)
+{
+	// One iteration is one frame of Application::Run's layer loop
+	suite.Add("LayerStack/OnUpdate/1000 layers", []() -> BenchmarkFunction {
+		auto fixture = std::make_shared<LayerStackFixture>();
+		return [fixture](uint64_t iterations) {
+			for (uint64_t i = 0; i < iterations; i++) {
+				for (Jerboa::Layer* layer : fixture->stack)
+					layer->OnUpdate();
+			}
+			DoNotOptimize(static_cast<CountingLayer*>(*fixture->stack.begin())->GetUpdates());
+		};
+	});
+
+	// The UI pass asks every layer whether its UI changed, then renders them all
+	suite.Add("LayerStack/ImGui pass/1000 layers", []() -> BenchmarkFunction {
+		auto fixture = std::make_shared<LayerStackFixture>();
+		return [fixture](uint64_t iterations) {
+			for (uint64_t i = 0; i < iterations; i++) {
+				bool dirty = false;
+				for (Jerboa::Layer* layer : fixture->stack)
+					dirty |= layer->ConsumeUIDirty();
+				DoNotOptimize(dirty);
+				for (Jerboa::Layer* layer : fixture->stack)
+					layer->OnImGuiRender();
+			}
+		};
+	});
+
+	suite.Add("LayerStack/Push and remove/1000 layers", []() -> BenchmarkFunction {
+		auto fixture = std::make_shared<LayerStackFixture>();
+		return [fixture](uint64_t iterations) {
+			for (uint64_t i = 0; i < iterations; i++) {
+				fixture->stack.PushLayer(&fixture->extraLayer);
+				fixture->stack.RemoveLayer(&fixture->extraLayer);
+			}
+		};
+	});
+}
@@ -0,0 +1,100 @@
+#include "Benchmark.h"
+
+#include "Jerboa/Core/Log.h"
+
+#include "spdlog/sinks/base_sink.h"
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace {
+	// Formats messages with the logger's pattern like a console sink, then drops them, so
+	// terminal speed doesn't end up in the numbers
+	class DiscardingSink : public spdlog::sinks::base_sink<std::mutex>
+	{
+	public:
+		size_t GetBytes() const { return mBytes; }
+	protected:
+		virtual void sink_it_(const spdlog::details::log_msg& message) override {
+			spdlog::memory_buf_t formatted;
+			formatter_->format(message, formatted);
+			mBytes += formatted.size();
+		}
+
+		virtual void flush_() override {}
+	private:
+		size_t mBytes = 0;
+	};
+
+	// Points the application logger at a single sink for as long as it lives. The
+	// benchmarks call the logger directly, as the logging macros are empty in Release.
+	template<typename Sink>
+	class LoggerFixture
+	{
+	public:
+		LoggerFixture(spdlog::level::level_enum level)
+			: mLogger(Jerboa::Log::GetAppLogger()), mSink(std::make_shared<Sink>()), mLevel(mLogger->level())
+		{
+			// Same pattern as Log::Init
+			mSink->set_pattern("%^[%T] %n: %v%$");
+			mSinks.swap(mLogger->sinks());
+			mLogger->sinks().push_back(mSink);
+			mLogger->set_level(level);
+		}
+
+		~LoggerFixture() {
+			mLogger->sinks().swap(mSinks);
+			mLogger->set_level(mLevel);
+		}
+
+		spdlog::logger& GetLogger() { return *mLogger; }
+		Sink& GetSink() { return *mSink; }
+	private:
+		std::shared_ptr<spdlog::logger> mLogger;
+		std::shared_ptr<Sink> mSink;
+		std::vector<spdlog::sink_ptr> mSinks;
+		spdlog::level::level_enum mLevel;
+	};
+}
+
+void AddLogBenchmarks(BenchmarkSuite& suite)
+{
+	suite.Add("Log/Info/plain", []() -> BenchmarkFunction {
+		auto fixture = std::make_shared<LoggerFixture<DiscardingSink>>(spdlog::level::trace);
+		return [fixture](uint64_t iterations) {
+			for (uint64_t i = 0; i < iterations; i++)
+				fixture->GetLogger().info("Frame finished");
+			DoNotOptimize(fixture->GetSink().GetBytes());
+		};
+	});
+
+	suite.Add("Log/Info/formatted", []() -> BenchmarkFunction {
+		auto fixture = std::make_shared<LoggerFixture<DiscardingSink>>(spdlog::level::trace);
+		return [fixture](uint64_t iterations) {
+			for (uint64_t i = 0; i < iterations; i++)
+				fixture->GetLogger().info("Frame {} took {:.3f} ms, {} draw calls in \"{}\"", i, 16.667, 1024, "Renderer2D");
+			DoNotOptimize(fixture->GetSink().GetBytes());
+		};
+	});
+
+	// What the editor's console adds to every line, formatted straight into the ring
+	suite.Add("Log/Info/console ring", []() -> BenchmarkFunction {
+		auto fixture = std::make_shared<LoggerFixture<Jerboa::LogRingSink>>(spdlog::level::trace);
+		return [fixture](uint64_t iterations) {
+			for (uint64_t i = 0; i < iterations; i++)
+				fixture->GetLogger().info("Frame {} took {:.3f} ms, {} draw calls in \"{}\"", i, 16.667, 1024, "Renderer2D");
+			DoNotOptimize(fixture->GetSink().GetRing().GetEnd());
+		};
+	});
+
+	// Below the logger's level the message is never formatted
+	suite.Add("Log/Trace/filtered out", []() -> BenchmarkFunction {
+		auto fixture = std::make_shared<LoggerFixture<DiscardingSink>>(spdlog::level::info);
+		return [fixture](uint64_t iterations) {
+			for (uint64_t i = 0; i < iterations; i++)
+				fixture->GetLogger().trace("Frame {} took {:.3f} ms, {} draw calls in \"{}\"", i, 16.667, 1024, "Renderer2D");
+			DoNotOptimize(fixture->GetSink().GetBytes());
+		};
+	});
+}
@@ -0,0 +1,129 @@
+#include "Benchmark.h"
+#include "BenchmarkReport.h"
+
+#include "Jerboa/Core/Base.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#if defined(JERBOA_DEBUG)
+	static const char* sConfiguration = "Debug";
+#elif defined(JERBOA_STAGING)
+	static const char* sConfiguration = "Staging";
+#else
+	static const char* sConfiguration = "Release";
+#endif
+
+enum ExitCode {
+	Success = 0,
+	Regressed = 1,
+	Error = 2
+};
+
+struct BenchOptions {
+	BenchmarkSettings settings;
+	bool pin = true;
+	std::string jsonPath;
+	std::string baselinePath;
+	// Set by --compare, which diffs two reports without running anything
+	std::string comparePath;
+	double thresholdPercent = 5.0;
+};
+
+static void PrintUsage()
+{
+	std::printf(
+		"Usage: JerboaBench [--filter text] [--samples count] [--warmup ms] [--sample-time ms] [--cpu index|none]\n"
+		"                   [--json path] [--baseline path] [--threshold percent]\n"
+		"       JerboaBench --compare baseline.json current.json [--threshold percent]\n"
+		"Exits with 1 if a benchmark regressed against the baseline by more than the threshold (default 5%%).\n");
+}
+
+static bool ParseOptions(int argc, char** argv, BenchOptions& options)
+{
+	for (int i = 1; i < argc; i++) {
+		const bool hasValue = i + 1 < argc;
+		if (std::strcmp(argv[i], "--filter") == 0 && hasValue)
+			options.settings.filter = argv[++i];
+		else if (std::strcmp(argv[i], "--samples") == 0 && hasValue)
+			options.settings.samples = (uint32_t)std::max(std::atoi(argv[++i]), 1);
+		else if (std::strcmp(argv[i], "--warmup") == 0 && hasValue)
+			options.settings.warmupMs = std::atof(argv[++i]);
+		else if (std::strcmp(argv[i], "--sample-time") == 0 && hasValue)
+			options.settings.sampleMs = std::atof(argv[++i]);
+		else if (std::strcmp(argv[i], "--cpu") == 0 && hasValue) {
+			i++;
+			options.pin = std::strcmp(argv[i], "none") != 0;
+			options.settings.cpu = options.pin ? std::atoi(argv[i]) : -1;
+		}
+		else if (std::strcmp(argv[i], "--json") == 0 && hasValue)
+			options.jsonPath = argv[++i];
+		else if (std::strcmp(argv[i], "--baseline") == 0 && hasValue)
+			options.baselinePath = argv[++i];
+		else if (std::strcmp(argv[i], "--threshold") == 0 && hasValue)
+			options.thresholdPercent = std::atof(argv[++i]);
+		else if (std::strcmp(argv[i], "--compare") == 0 && i + 2 < argc) {
+			options.baselinePath = argv[++i];
+			options.comparePath = argv[++i];
+		}
+		else
+			return false;
+	}
+	return true;
+}
+
+int main(int argc, char** argv)
+{
+	BenchOptions options;
+	if (!ParseOptions(argc, argv, options)) {
+		PrintUsage();
+		return Error;
+	}
+
+	BenchmarkReport baseline;
+	if (!options.baselinePath.empty() && !ReadReport(options.baselinePath, baseline))
+		return Error;
+
+	if (!options.comparePath.empty()) {
+		BenchmarkReport current;
+		if (!ReadReport(options.comparePath, current))
+			return Error;
+		return CompareReports(baseline, current, options.thresholdPercent) ? Regressed : Success;
+	}
+
+	Jerboa::InitializeCore();
+
+	BenchmarkReport report;
+	report.configuration = sConfiguration;
+	report.settings = options.settings;
+	// Migrating between cores changes caches and clock speed mid sample
+	report.cpu = options.pin ? PinCurrentThread(options.settings.cpu) : -1;
+	if (options.pin && report.cpu < 0)
+		std::printf("Could not pin the benchmark thread, results will be noisier\n");
+	std::printf("JerboaBench (%s), %u samples of %.1f ms after %.0f ms warmup, cpu %d\n", sConfiguration,
+		options.settings.samples, options.settings.sampleMs, options.settings.warmupMs, report.cpu);
+
+	BenchmarkSuite suite;
+	AddEventBusBenchmarks(suite);
+	AddLayerStackBenchmarks(suite);
+	AddLogBenchmarks(suite);
+	AddWindowBenchmarks(suite);
+	AddIPCBenchmarks(suite);
+	AddTelemetryBenchmarks(suite);
+	report.results = suite.Run(options.settings);
+
+	int exitCode = Success;
+	if (!options.jsonPath.empty() && !WriteReport(report, options.jsonPath))
+		exitCode = Error;
+	if (!options.baselinePath.empty()) {
+		std::printf("\nAgainst %s:\n", options.baselinePath.c_str());
+		if (CompareReports(baseline, report, options.thresholdPercent) && exitCode == Success)
+			exitCode = Regressed;
+	}
+
+	Jerboa::ShutdownCore();
+	return exitCode;
+}
@@ -0,0 +1,36 @@
+#include "Benchmark.h"
+
+#include "Jerboa/Profiling/Profiler.h"
+#include "Jerboa/Profiling/Telemetry.h"
+
+// What instrumentation costs while no telemetry viewer is attached, which is the common case
+void AddTelemetryBenchmarks(BenchmarkSuite& suite)
+{
+	suite.Add("Telemetry/Counter/detached", []() -> BenchmarkFunction {
+		return [](uint64_t iterations) {
+			for (uint64_t i = 0; i < iterations; i++)
+				Jerboa::Telemetry::RecordCounter("JerboaBench counter", (double)i);
+		};
+	});
+
+	suite.Add("Telemetry/EndFrame/detached", []() -> BenchmarkFunction {
+		return [](uint64_t iterations) {
+			for (uint64_t i = 0; i < iterations; i++)
+				Jerboa::Telemetry::EndFrame();
+		};
+	});
+
+	// The profiler keeps every zone of a frame, so frames are started regularly to bound the history
+	suite.Add("Profiler/Zone", []() -> BenchmarkFunction {
+		return [](uint64_t iterations) {
+			for (uint64_t i = 0; i < iterations; i++) {
+				if (i % 1024 == 0) {
+					Jerboa::Profiler::EndFrame();
+					Jerboa::Profiler::BeginFrame();
+				}
+				Jerboa::Profiler::BeginZone("JerboaBench zone");
+				Jerboa::Profiler::EndZone();
+			}
+		};
+	});
+}
@@ -0,0 +1,139 @@
+#include "Benchmark.h"
+
+#include "Jerboa/Core/Window.h"
+#include "Jerboa/Core/EventObserver.h"
+#include "Jerboa/Core/Events/KeyPressedEvent.h"
+#include "Jerboa/Core/Events/KeyReleasedEvent.h"
+#include "Jerboa/Core/Events/MouseMovedEvent.h"
+#include "Jerboa/Core/Events/MouseButtonPressedEvent.h"
+#include "Jerboa/Core/Events/MouseButtonReleasedEvent.h"
+
+#define GLFW_INCLUDE_NONE
+#include "GLFW/glfw3.h"
+
+#include <memory>
+
+namespace {
+	// Subscribes to the input events like Application does
+	class InputListener
+	{
+	public:
+		InputListener(Jerboa::EventBus* bus)
+			: mKeyPressedObserver(Jerboa::EventObserver::Create(bus, this, &InputListener::OnKeyPressed)),
+			mKeyReleasedObserver(Jerboa::EventObserver::Create(bus, this, &InputListener::OnKeyReleased)),
+			mMouseMovedObserver(Jerboa::EventObserver::Create(bus, this, &InputListener::OnMouseMoved)),
+			mMouseButtonPressedObserver(Jerboa::EventObserver::Create(bus, this, &InputListener::OnMouseButtonPressed)),
+			mMouseButtonReleasedObserver(Jerboa::EventObserver::Create(bus, this, &InputListener::OnMouseButtonReleased)) {}
+
+		uint64_t GetEventCount() const { return mEventCount; }
+	private:
+		void OnKeyPressed(const Jerboa::KeyPressedEvent&) { mEventCount++; }
+		void OnKeyReleased(const Jerboa::KeyReleasedEvent&) { mEventCount++; }
+		void OnMouseMoved(const Jerboa::MouseMovedEvent&) { mEventCount++; }
+		void OnMouseButtonPressed(const Jerboa::MouseButtonPressedEvent&) { mEventCount++; }
+		void OnMouseButtonReleased(const Jerboa::MouseButtonReleasedEvent&) { mEventCount++; }
+
+		Jerboa::EventObserver mKeyPressedObserver;
+		Jerboa::EventObserver mKeyReleasedObserver;
+		Jerboa::EventObserver mMouseMovedObserver;
+		Jerboa::EventObserver mMouseButtonPressedObserver;
+		Jerboa::EventObserver mMouseButtonReleasedObserver;
+		uint64_t mEventCount = 0;
+	};
+
+	struct WindowFixture
+	{
+		std::unique_ptr<Jerboa::Window> window;
+		std::unique_ptr<InputListener> listener;
+		GLFWwindow* nativeWindow = nullptr;
+		// The callbacks the engine installed, called directly so no OS events are needed
+		GLFWkeyfun keyCallback = nullptr;
+		GLFWcursorposfun cursorPosCallback = nullptr;
+		GLFWmousebuttonfun mouseButtonCallback = nullptr;
+	};
+
+	// Once a window shut GLFW down it is not initialized again, so the benchmarks share
+	// one hidden window that lives until exit. nullptr without a display.
+	WindowFixture* GetWindowFixture()
+	{
+		static std::unique_ptr<WindowFixture> sFixture;
+		static bool sCreated = false;
+		if (sCreated)
+			return sFixture.get();
+		sCreated = true;
+
+		// The engine asserts when it can't create a window, so try first
+		if (!glfwInit())
+			return nullptr;
+		glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+		GLFWwindow* probe = glfwCreateWindow(64, 64, "JerboaBench", nullptr, nullptr);
+		if (!probe) {
+			glfwTerminate();
+			return nullptr;
+		}
+		glfwDestroyWindow(probe);
+
+		Jerboa::WindowProps props("JerboaBench", 640, 360);
+		props.visible = false;
+		sFixture = std::make_unique<WindowFixture>();
+		sFixture->window.reset(Jerboa::Window::Create(props));
+		sFixture->listener = std::make_unique<InputListener>(sFixture->window->GetEventBus().lock().get());
+		sFixture->nativeWindow = static_cast<GLFWwindow*>(sFixture->window->GetNativeWindow());
+
+		// GLFW has no getters for callbacks, setting one returns the previous
+		sFixture->keyCallback = glfwSetKeyCallback(sFixture->nativeWindow, nullptr);
+		glfwSetKeyCallback(sFixture->nativeWindow, sFixture->keyCallback);
+		sFixture->cursorPosCallback = glfwSetCursorPosCallback(sFixture->nativeWindow, nullptr);
+		glfwSetCursorPosCallback(sFixture->nativeWindow, sFixture->cursorPosCallback);
+		sFixture->mouseButtonCallback = glfwSetMouseButtonCallback(sFixture->nativeWindow, nullptr);
+		glfwSetMouseButtonCallback(sFixture->nativeWindow, sFixture->mouseButtonCallback);
+		return sFixture.get();
+	}
+}
+
+void AddWindowBenchmarks(BenchmarkSuite& suite)
+{
+	// Alternates press and release, so both paths through the callback are taken
+	suite.Add("GLFW/Key callback", []() -> BenchmarkFunction {
+		WindowFixture* fixture = GetWindowFixture();
+		if (!fixture || !fixture->keyCallback)
+			return nullptr;
+		return [fixture](uint64_t iterations) {
+			for (uint64_t i = 0; i < iterations; i++)
+				fixture->keyCallback(fixture->nativeWindow, GLFW_KEY_A, 30, i & 1 ? GLFW_RELEASE : GLFW_PRESS, 0);
+			DoNotOptimize(fixture->listener->GetEventCount());
+		};
+	});
+
+	suite.Add("GLFW/Cursor position callback", []() -> BenchmarkFunction {
+		WindowFixture* fixture = GetWindowFixture();
+		if (!fixture || !fixture->cursorPosCallback)
+			return nullptr;
+		return [fixture](uint64_t iterations) {
+			for (uint64_t i = 0; i < iterations; i++)
+				fixture->cursorPosCallback(fixture->nativeWindow, (double)(i & 511), 200.0);
+			DoNotOptimize(fixture->listener->GetEventCount());
+		};
+	});
+
+	suite.Add("GLFW/Mouse button callback", []() -> BenchmarkFunction {
+		WindowFixture* fixture = GetWindowFixture();
+		if (!fixture || !fixture->mouseButtonCallback)
+			return nullptr;
+		return [fixture](uint64_t iterations) {
+			for (uint64_t i = 0; i < iterations; i++)
+				fixture->mouseButtonCallback(fixture->nativeWindow, GLFW_MOUSE_BUTTON_LEFT, i & 1 ? GLFW_RELEASE : GLFW_PRESS, 0);
+			DoNotOptimize(fixture->listener->GetEventCount());
+		};
+	});
+
+	// What every frame pays to find out that nothing happened
+	suite.Add("GLFW/Poll events/empty queue", []() -> BenchmarkFunction {
+		if (!GetWindowFixture())
+			return nullptr;
+		return [](uint64_t iterations) {
+			for (uint64_t i = 0; i < iterations; i++)
+				glfwPollEvents();
+		};
+	});
+}
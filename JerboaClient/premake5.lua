@@ -33,6 +33,26 @@ project "JerboaClient"
 			"JERBOA_PLATFORM_WINDOWS"
 		}
 
+	filter "system:linux"
+		defines 
+		{ 
+			"JERBOA_PLATFORM_LINUX"
+		}
+
+		links
+		{
+			"spdlog",
+			"glfw",
+			"glad",
+			"ImGui",
+			"JerboaIPC",
+			"GL",
+			"X11",
+			"dl",
+			"pthread",
+			"rt"
+		}
+
 	filter "configurations:Debug"
 		defines "JERBOA_DEBUG"
 		symbols "On"
@@ -1,8 +1,16 @@
 #include "Jerboa/EntryPoint.h"
 #include "JerboaApp.h"
 
-Jerboa::Application* Jerboa::CreateApplication() {
+Jerboa::Application* Jerboa::CreateApplication(Jerboa::ApplicationCommandLineArgs args) {
 	Jerboa::ApplicationProps props;
+	props.commandLineArgs = args;
+	props.lazyImGuiRendering = true;
+#ifndef JERBOA_RELEASE
+	// Changed textures and data files are reloaded in place instead of restarting
+	props.assetManagerSettings.hotReload = true;
+	// JerboaViewer can attach to profile without drawing the profiler in the frame
+	props.telemetry = true;
+#endif
 
 	return new JerboaClient::JerboaApp(props);
 }
@@ -1,6 +1,13 @@
 #include "EditorLayer.h"
 #include "imgui.h"
 #include "Jerboa/UI/ImGui/ImGuiApp.h"
+#include "Jerboa/UI/ImGui/ProfilerPanel.h"
+#include "Jerboa/UI/ImGui/MemoryPanel.h"
+#include "Jerboa/UI/ImGui/LogPanel.h"
+#include "Jerboa/Profiling/GPUProfiler.h"
+#include "Jerboa/Renderer/Renderer2D.h"
+
+#include <cmath>
 
 namespace JerboaClient {
 	EditorLayer::EditorLayer()
@@ -10,8 +17,12 @@ namespace JerboaClient {
 	void EditorLayer::OnImGuiRender()
 	{
 		ImGui::ShowDemoWindow();
+		Jerboa::UI::ProfilerPanel::Draw();
+		Jerboa::UI::MemoryPanel::Draw();
+		Jerboa::UI::LogPanel::Draw();
 
-		//ImGui::DockSpaceOverViewport(ImGui::GetMainViewport());
+		ImGui::DockSpaceOverViewport(ImGui::GetMainViewport());
+		DrawViewportPanel();
 
 		ImGui::Begin("Window 1");
 		ImGui::Button("Hello");
@@ -24,19 +35,117 @@ namespace JerboaClient {
 
 	void EditorLayer::OnUpdate()
 	{
-		// TBA
+		UpdateResolutionScale();
+		RenderViewport();
+
+		// The UI is rendered lazily, refresh the live profiler numbers a few times per second
+		if (++mFramesSinceUIRefresh >= sProfilerRefreshInterval) {
+			mFramesSinceUIRefresh = 0;
+			MarkUIDirty();
+		}
+
+		// New log lines show up right away
+		const uint64_t logLines = Jerboa::Log::GetConsoleRing().GetEnd();
+		if (logLines != mLogLinesShown) {
+			mLogLinesShown = logLines;
+			MarkUIDirty();
+		}
 	}
 
 	void EditorLayer::OnAttach() {
 		JERBOA_LOG_INFO("EditorLayer attached");
+
+		Jerboa::FramebufferSpecification spec;
+		spec.width = mViewportWidth;
+		spec.height = mViewportHeight;
+		spec.attachments = { Jerboa::FramebufferFormat::RGBA8, Jerboa::FramebufferFormat::Depth24Stencil8 };
+		mViewportFramebuffer = Jerboa::Framebuffer::Create(spec);
+		mLastFrameStart = Jerboa::Time::Now();
 	}
 
 	void EditorLayer::OnDetach() {
 		JERBOA_LOG_INFO("EditorLayer deattached");
+		mViewportFramebuffer.reset();
 	}
 	
 	void EditorLayer::OnWindowResize(const Jerboa::WindowResizeEvent& evnt)
 	{
 		JERBOA_LOG_TRACE("window resized to {}x{}", evnt.width, evnt.height);
+		// The docked viewport panel follows the window, its new size is picked up in the next UI pass
+		MarkUIDirty();
+	}
+
+	void EditorLayer::UpdateResolutionScale()
+	{
+		Jerboa::Timestamp now = Jerboa::Time::Now();
+		float cpuFrameTimeMs = (float)Jerboa::Time::ToMilliseconds(now - mLastFrameStart);
+		mLastFrameStart = now;
+
+		// GPU time isn't padded by the vsync wait, prefer it when timer queries are available
+		float gpuFrameTimeMs = (float)Jerboa::GPUProfiler::GetLastFrameTime();
+		float frameTimeMs = Jerboa::GPUProfiler::IsSupported() && gpuFrameTimeMs > 0.0f ? gpuFrameTimeMs : cpuFrameTimeMs;
+
+		mResolutionScale.Update(frameTimeMs);
+	}
+
+	void EditorLayer::RenderViewport()
+	{
+		JERBOA_PROFILE_RENDER_SCOPE("EditorLayer::RenderViewport");
+
+		float scale = mResolutionScale.GetScale();
+		uint32_t width = std::max(1u, (uint32_t)(mViewportWidth * scale));
+		uint32_t height = std::max(1u, (uint32_t)(mViewportHeight * scale));
+		if (width != mViewportFramebuffer->GetWidth() || height != mViewportFramebuffer->GetHeight()) {
+			mViewportFramebuffer->Resize(width, height);
+			// The cached UI references the attachment texture and its UVs
+			MarkUIDirty();
+		}
+
+		mViewportFramebuffer->Bind();
+		const float clearColor[4] = { 0.1f, 0.1f, 0.12f, 1.0f };
+		mViewportFramebuffer->ClearAttachment(0, clearColor);
+		mViewportFramebuffer->ClearDepthStencil();
+
+		// Placeholder scene until the editor renders a real one
+		float aspect = (float)mViewportWidth / mViewportHeight;
+		Jerboa::Renderer2D::BeginScene(-aspect, aspect, -1.0f, 1.0f);
+		float time = (float)(Jerboa::Time::ToMilliseconds(Jerboa::Time::Now()) / 1000.0);
+		for (int y = -4; y <= 4; y++) {
+			for (int x = -8; x <= 8; x++) {
+				Jerboa::Color color = { (x + 8) / 16.0f, (y + 4) / 8.0f, 0.6f, 1.0f };
+				Jerboa::Renderer2D::DrawRotatedQuad(x * 0.2f, y * 0.2f, 0.0f, 0.15f, 0.15f, time + (x + y) * 0.1f, color);
+			}
+		}
+		Jerboa::Renderer2D::DrawCircle(std::cos(time) * 0.6f, std::sin(time) * 0.6f, 0.1f, 0.2f, { 1.0f, 0.9f, 0.3f, 1.0f });
+		Jerboa::Renderer2D::EndScene();
+
+		mViewportFramebuffer->Unbind();
+	}
+
+	void EditorLayer::DrawViewportPanel()
+	{
+		ImGui::PushStyleVar(ImGuiStyleVar_WindowPadding, ImVec2(0.0f, 0.0f));
+		ImGui::Begin("Viewport");
+
+		ImVec2 size = ImGui::GetContentRegionAvail();
+		if (size.x >= 1.0f && size.y >= 1.0f) {
+			mViewportWidth = (uint32_t)size.x;
+			mViewportHeight = (uint32_t)size.y;
+		}
+
+		// Only the lower left part of the allocation holds the image, GL textures are bottom-up
+		ImTextureID texture = (ImTextureID)(uintptr_t)mViewportFramebuffer->GetColorAttachment(0);
+		ImVec2 uvMax(mViewportFramebuffer->GetUVMaxX(), mViewportFramebuffer->GetUVMaxY());
+		ImGui::Image(texture, size, ImVec2(0.0f, uvMax.y), ImVec2(uvMax.x, 0.0f));
+
+		ImGui::End();
+		ImGui::PopStyleVar();
+
+		ImGui::Begin("Viewport Stats");
+		ImGui::Text("Panel: %ux%u", mViewportWidth, mViewportHeight);
+		ImGui::Text("Render: %ux%u (%.0f%%)", mViewportFramebuffer->GetWidth(), mViewportFramebuffer->GetHeight(), mResolutionScale.GetScale() * 100.0f);
+		ImGui::Text("Allocated: %ux%u, %u reallocations", mViewportFramebuffer->GetAllocatedWidth(), mViewportFramebuffer->GetAllocatedHeight(), mViewportFramebuffer->GetReallocationCount());
+		ImGui::Text("Frame time: %.2f ms (budget %.2f ms)", mResolutionScale.GetSmoothedFrameTime(), mResolutionScale.GetSettings().budgetMs);
+		ImGui::End();
 	}
 }
\ No newline at end of file
@@ -4,6 +4,9 @@
 #include "Jerboa/Core/Layer.h"
  
 #include "Jerboa/Core/Events/WindowResizeEvent.h"
+#include "Jerboa/Core/Time.h"
+#include "Jerboa/Renderer/Framebuffer.h"
+#include "Jerboa/Renderer/ResolutionScaleGovernor.h"
 
 namespace JerboaClient {
 	class EditorLayer : public Jerboa::Layer
@@ -17,8 +20,21 @@ namespace JerboaClient {
 		virtual void OnImGuiRender() override;
 	private:
 		void OnWindowResize(const Jerboa::WindowResizeEvent& evnt);
+		void UpdateResolutionScale();
+		void RenderViewport();
+		void DrawViewportPanel();
 
 		Jerboa::EventObserver mWindowResizeObserver;
+
+		std::shared_ptr<Jerboa::Framebuffer> mViewportFramebuffer;
+		Jerboa::ResolutionScaleGovernor mResolutionScale;
+		// Size of the viewport panel in window pixels, the framebuffer is this times the resolution scale
+		uint32_t mViewportWidth = 1280, mViewportHeight = 720;
+		Jerboa::Timestamp mLastFrameStart = 0;
+
+		static constexpr unsigned int sProfilerRefreshInterval = 15;
+		unsigned int mFramesSinceUIRefresh = 0;
+		uint64_t mLogLinesShown = 0;
 	};
 }
 
@@ -0,0 +1,46 @@
+-- Client library for the engine's IPCBridge, external tools link only this
+project "JerboaIPC"
+	kind "StaticLib"
+	language "C++"
+	cppdialect "C++17"
+	staticruntime "on"
+
+	targetdir ("%{wks.location}/bin/" .. outputdir .. "/%{prj.name}")
+	objdir ("%{wks.location}/bin-int/" .. outputdir .. "/%{prj.name}")
+
+	files
+	{
+		"src/**.h",
+		"src/**.cpp"
+	}
+
+	includedirs
+	{
+		"src"
+	}
+
+	filter "system:windows"
+		systemversion "latest"
+
+		defines
+		{
+			"JERBOA_PLATFORM_WINDOWS"
+		}
+
+	filter "system:linux"
+		defines
+		{
+			"JERBOA_PLATFORM_LINUX"
+		}
+
+	filter "configurations:Debug"
+		defines "JERBOA_DEBUG"
+		symbols "On"
+
+	filter "configurations:Staging"
+		defines "JERBOA_STAGING"
+		optimize "On"
+
+	filter "configurations:Release"
+		defines "JERBOA_RELEASE"
+		optimize "On"
@@ -0,0 +1,398 @@
+#include "IPCChannel.h"
+
+#include <atomic>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <new>
+
+#ifdef JERBOA_PLATFORM_LINUX
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <sys/syscall.h>
+	#include <linux/futex.h>
+	#include <fcntl.h>
+	#include <unistd.h>
+	#include <ctime>
+#endif
+
+namespace Jerboa {
+	static_assert(std::atomic<uint32_t>::is_always_lock_free && std::atomic<uint64_t>::is_always_lock_free,
+		"Atomics in shared memory must be lock free to work across processes");
+	static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "Futex words must be plain 32-bit integers");
+
+	// Written last when a channel is created, openers that don't see it yet fail
+	static constexpr uint32_t ChannelMagic = 0x4350494a; // "JIPC"
+	static constexpr uint32_t ChannelFormatVersion = 1;
+	static constexpr uint32_t CacheLine = 64;
+
+	// Producers and the consumer update separate cache lines
+	struct IPCChannel::Header
+	{
+		std::atomic<uint32_t> magic;
+		uint32_t formatVersion;
+		uint32_t slotSize;
+		uint32_t slotCount;
+
+		alignas(CacheLine) std::atomic<uint64_t> writePosition;
+		alignas(CacheLine) std::atomic<uint64_t> readPosition;
+		// Futex words, bumped only while the other side sleeps on them
+		alignas(CacheLine) std::atomic<uint32_t> dataSignal;
+		std::atomic<uint32_t> receiverWaiting;
+		alignas(CacheLine) std::atomic<uint32_t> spaceSignal;
+		std::atomic<uint32_t> sendersWaiting;
+		alignas(CacheLine) std::atomic<uint64_t> dropped;
+		std::atomic<uint64_t> skipped;
+	};
+
+	// A slot of position p is free for the sender that claims p while its sequence is p,
+	// holds a message for the receiver when it is p + 1, and is free again for the next lap
+	// once the receiver sets it to p + slotCount
+	struct IPCChannel::Slot
+	{
+		std::atomic<uint64_t> sequence;
+		uint32_t type;
+		uint16_t version;
+		uint16_t reserved;
+		uint32_t size;
+		uint32_t sender;
+		uint64_t sendTime;
+	};
+
+	namespace {
+		constexpr size_t AlignToCacheLine(size_t size)
+		{
+			return (size + CacheLine - 1) / CacheLine * CacheLine;
+		}
+
+		uint64_t Now()
+		{
+			// steady_clock, like Jerboa::Time
+			using namespace std::chrono;
+			return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+		}
+
+		uint32_t RoundUpToPowerOfTwo(uint32_t value)
+		{
+			uint32_t result = 1;
+			while (result < value && result < (1u << 31))
+				result <<= 1;
+			return result;
+		}
+
+#ifdef JERBOA_PLATFORM_LINUX
+		// Not FUTEX_PRIVATE_FLAG, the words are shared between processes
+		void FutexWait(std::atomic<uint32_t>& word, uint32_t expected, int timeoutMs)
+		{
+			timespec timeout;
+			timeout.tv_sec = timeoutMs / 1000;
+			timeout.tv_nsec = (timeoutMs % 1000) * 1000000L;
+			syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAIT, expected, timeoutMs < 0 ? nullptr : &timeout, nullptr, 0);
+		}
+
+		void FutexWakeAll(std::atomic<uint32_t>& word)
+		{
+			syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+		}
+#else
+		void FutexWait(std::atomic<uint32_t>&, uint32_t, int) {}
+		void FutexWakeAll(std::atomic<uint32_t>&) {}
+#endif
+
+		// Milliseconds left until deadline, for timeouts that span several waits
+		int GetRemainingMs(uint64_t deadline)
+		{
+			uint64_t now = Now();
+			return now >= deadline ? 0 : (int)std::max<uint64_t>((deadline - now) / 1000000, 1);
+		}
+	}
+
+	IPCChannel::~IPCChannel()
+	{
+		Close();
+	}
+
+	bool IPCChannel::Create(const std::string& name, uint32_t slotSize, uint32_t slotCount)
+	{
+		Close();
+#ifdef JERBOA_PLATFORM_LINUX
+		const size_t headerSize = AlignToCacheLine(sizeof(Header));
+		slotSize = std::max<uint32_t>((uint32_t)AlignToCacheLine(slotSize), CacheLine);
+		slotCount = RoundUpToPowerOfTwo(std::max(slotCount, 2u));
+		const size_t size = headerSize + (size_t)slotSize * slotCount;
+
+		shm_unlink(name.c_str());
+		int file = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR | O_CLOEXEC, 0600);
+		if (file < 0)
+			return false;
+		void* mapping = MAP_FAILED;
+		if (ftruncate(file, (off_t)size) == 0)
+			mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+		close(file);
+		if (mapping == MAP_FAILED) {
+			shm_unlink(name.c_str());
+			return false;
+		}
+
+		// The mapping starts out zeroed
+		mHeader = new (mapping) Header();
+		mHeader->formatVersion = ChannelFormatVersion;
+		mHeader->slotSize = slotSize;
+		mHeader->slotCount = slotCount;
+		mSlots = static_cast<uint8_t*>(mapping) + headerSize;
+		for (uint32_t i = 0; i < slotCount; i++) {
+			Slot* slot = new (GetSlot(i)) Slot();
+			slot->sequence.store(i, std::memory_order_relaxed);
+		}
+		mHeader->magic.store(ChannelMagic, std::memory_order_release);
+
+		mName = name;
+		mMappingSize = size;
+		mSender = (uint32_t)getpid();
+		mOwner = true;
+		return true;
+#else
+		return false;
+#endif
+	}
+
+	bool IPCChannel::Open(const std::string& name)
+	{
+		Close();
+#ifdef JERBOA_PLATFORM_LINUX
+		const size_t headerSize = AlignToCacheLine(sizeof(Header));
+		int file = shm_open(name.c_str(), O_RDWR | O_CLOEXEC, 0);
+		if (file < 0)
+			return false;
+
+		struct stat status;
+		void* mapping = MAP_FAILED;
+		if (fstat(file, &status) == 0 && (size_t)status.st_size >= headerSize)
+			mapping = mmap(nullptr, (size_t)status.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+		close(file);
+		if (mapping == MAP_FAILED)
+			return false;
+
+		Header* header = static_cast<Header*>(mapping);
+		const size_t size = (size_t)status.st_size;
+		const bool valid = header->magic.load(std::memory_order_acquire) == ChannelMagic && header->formatVersion == ChannelFormatVersion
+			&& header->slotSize >= CacheLine && header->slotCount >= 2 && (header->slotCount & (header->slotCount - 1)) == 0
+			&& headerSize + (size_t)header->slotSize * header->slotCount <= size;
+		if (!valid) {
+			munmap(mapping, size);
+			return false;
+		}
+
+		mHeader = header;
+		mSlots = static_cast<uint8_t*>(mapping) + headerSize;
+		mName = name;
+		mMappingSize = size;
+		mSender = (uint32_t)getpid();
+		mOwner = false;
+		return true;
+#else
+		return false;
+#endif
+	}
+
+	void IPCChannel::Close()
+	{
+#ifdef JERBOA_PLATFORM_LINUX
+		if (mHeader) {
+			munmap(mHeader, mMappingSize);
+			if (mOwner)
+				shm_unlink(mName.c_str());
+		}
+#endif
+		mHeader = nullptr;
+		mSlots = nullptr;
+		mMappingSize = 0;
+		mOwner = false;
+		mName.clear();
+		mStalledPosition = UINT64_MAX;
+	}
+
+	uint32_t IPCChannel::GetMaxPayloadSize() const
+	{
+		return mHeader ? mHeader->slotSize - (uint32_t)sizeof(Slot) : 0;
+	}
+
+	IPCChannel::Slot* IPCChannel::GetSlot(uint64_t position) const
+	{
+		return reinterpret_cast<Slot*>(mSlots + (position & (mHeader->slotCount - 1)) * mHeader->slotSize);
+	}
+
+	IPCChannel::WriteResult IPCChannel::Write(uint32_t type, uint16_t version, const void* payload, uint32_t size)
+	{
+		if (!mHeader || size > GetMaxPayloadSize())
+			return WriteResult::Failed;
+
+		// Claim the slot at the write position, unless it still holds last lap's message
+		uint64_t position = mHeader->writePosition.load(std::memory_order_relaxed);
+		Slot* slot;
+		for (;;) {
+			slot = GetSlot(position);
+			const int64_t difference = (int64_t)(slot->sequence.load(std::memory_order_acquire) - position);
+			if (difference == 0) {
+				if (mHeader->writePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+					break;
+			}
+			else if (difference < 0) {
+				return WriteResult::Full;
+			}
+			else {
+				position = mHeader->writePosition.load(std::memory_order_relaxed);
+			}
+		}
+
+		slot->type = type;
+		slot->version = version;
+		slot->size = size;
+		slot->sender = mSender;
+		slot->sendTime = Now();
+		if (size > 0)
+			std::memcpy(reinterpret_cast<uint8_t*>(slot + 1), payload, size);
+
+		// Fails if the receiver gave up on the slot in the meantime, it counts it as skipped
+		uint64_t expected = position;
+		const bool published = slot->sequence.compare_exchange_strong(expected, position + 1, std::memory_order_release, std::memory_order_relaxed);
+
+		// Orders the publish before reading the flag, WaitForMessages() sets the flag before checking
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (mHeader->receiverWaiting.load(std::memory_order_relaxed)) {
+			mHeader->dataSignal.fetch_add(1, std::memory_order_release);
+			FutexWakeAll(mHeader->dataSignal);
+		}
+
+		return published ? WriteResult::Sent : WriteResult::Failed;
+	}
+
+	bool IPCChannel::TrySend(uint32_t type, uint16_t version, const void* payload, uint32_t size)
+	{
+		WriteResult result = Write(type, version, payload, size);
+		if (result == WriteResult::Full)
+			mHeader->dropped.fetch_add(1, std::memory_order_relaxed);
+		return result == WriteResult::Sent;
+	}
+
+	bool IPCChannel::Send(uint32_t type, uint16_t version, const void* payload, uint32_t size, int timeoutMs)
+	{
+		const uint64_t deadline = timeoutMs < 0 ? UINT64_MAX : Now() + timeoutMs * 1000000ull;
+		for (;;) {
+			const uint32_t signal = mHeader ? mHeader->spaceSignal.load(std::memory_order_acquire) : 0;
+			WriteResult result = Write(type, version, payload, size);
+			if (result != WriteResult::Full)
+				return result == WriteResult::Sent;
+
+			const int remainingMs = timeoutMs < 0 ? WaitForever : GetRemainingMs(deadline);
+			if (remainingMs == 0) {
+				mHeader->dropped.fetch_add(1, std::memory_order_relaxed);
+				return false;
+			}
+
+			// Announce the wait, then check once more so a receiver that freed space in
+			// between either sees the announcement or is seen here
+			mHeader->sendersWaiting.fetch_add(1, std::memory_order_seq_cst);
+			const uint64_t position = mHeader->writePosition.load(std::memory_order_relaxed);
+			if ((int64_t)(GetSlot(position)->sequence.load(std::memory_order_acquire) - position) < 0)
+				FutexWait(mHeader->spaceSignal, signal, remainingMs);
+			mHeader->sendersWaiting.fetch_sub(1, std::memory_order_relaxed);
+		}
+	}
+
+	bool IPCChannel::Peek(IPCMessage& message)
+	{
+		if (!mHeader)
+			return false;
+
+		for (;;) {
+			const uint64_t position = mHeader->readPosition.load(std::memory_order_relaxed);
+			Slot* slot = GetSlot(position);
+			const uint64_t sequence = slot->sequence.load(std::memory_order_acquire);
+			if (sequence == position + 1) {
+				message.type = slot->type;
+				message.version = slot->version;
+				message.sender = slot->sender;
+				message.sendTime = slot->sendTime;
+				message.payload = reinterpret_cast<const uint8_t*>(slot + 1);
+				// Anyone with access can write the slot, never read past it
+				message.size = std::min(slot->size, GetMaxPayloadSize());
+				mStalledPosition = UINT64_MAX;
+				return true;
+			}
+
+			// Empty, or claimed by a sender that hasn't published yet
+			if (mHeader->writePosition.load(std::memory_order_relaxed) <= position)
+				return false;
+
+			const uint64_t now = Now();
+			if (mStalledPosition != position) {
+				mStalledPosition = position;
+				mStalledSince = now;
+				return false;
+			}
+			if (now - mStalledSince < StallTimeoutMs * 1000000ull)
+				return false;
+
+			uint64_t expected = position;
+			if (slot->sequence.compare_exchange_strong(expected, position + mHeader->slotCount, std::memory_order_acq_rel)) {
+				mHeader->skipped.fetch_add(1, std::memory_order_relaxed);
+				mHeader->readPosition.store(position + 1, std::memory_order_release);
+				mStalledPosition = UINT64_MAX;
+			}
+		}
+	}
+
+	void IPCChannel::Pop()
+	{
+		const uint64_t position = mHeader->readPosition.load(std::memory_order_relaxed);
+		GetSlot(position)->sequence.store(position + mHeader->slotCount, std::memory_order_release);
+		mHeader->readPosition.store(position + 1, std::memory_order_release);
+	}
+
+	void IPCChannel::NotifySpace()
+	{
+		// Orders the freed slots before reading the count, see Send()
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (mHeader->sendersWaiting.load(std::memory_order_relaxed)) {
+			mHeader->spaceSignal.fetch_add(1, std::memory_order_release);
+			FutexWakeAll(mHeader->spaceSignal);
+		}
+	}
+
+	bool IPCChannel::WaitForMessages(int timeoutMs)
+	{
+		if (!mHeader)
+			return false;
+
+		const uint64_t deadline = timeoutMs < 0 ? UINT64_MAX : Now() + timeoutMs * 1000000ull;
+		auto isReady = [this]() {
+			return mHeader->writePosition.load(std::memory_order_relaxed) > mHeader->readPosition.load(std::memory_order_relaxed);
+		};
+
+		for (;;) {
+			const uint32_t signal = mHeader->dataSignal.load(std::memory_order_acquire);
+			mHeader->receiverWaiting.store(1, std::memory_order_seq_cst);
+			const bool ready = isReady();
+			const int remainingMs = timeoutMs < 0 ? WaitForever : GetRemainingMs(deadline);
+			if (!ready && remainingMs != 0)
+				FutexWait(mHeader->dataSignal, signal, remainingMs);
+			mHeader->receiverWaiting.store(0, std::memory_order_relaxed);
+
+			if (ready || isReady())
+				return true;
+			if (timeoutMs >= 0 && GetRemainingMs(deadline) == 0)
+				return false;
+		}
+	}
+
+	uint64_t IPCChannel::GetDroppedCount() const
+	{
+		return mHeader ? mHeader->dropped.load(std::memory_order_relaxed) : 0;
+	}
+
+	uint64_t IPCChannel::GetSkippedCount() const
+	{
+		return mHeader ? mHeader->skipped.load(std::memory_order_relaxed) : 0;
+	}
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+#include <climits>
+
+namespace Jerboa {
+	// A message as the receiver sees it. The payload points into the shared ring and is only
+	// valid until the handler returns.
+	struct IPCMessage
+	{
+		uint32_t type;
+		uint16_t version;
+		// Process id of the sender
+		uint32_t sender;
+		// Monotonic time the message was sent, comparable with Jerboa::Time::Now() on the same host
+		uint64_t sendTime;
+		const uint8_t* payload;
+		uint32_t size;
+	};
+
+	// Fixed-size message slots in POSIX shared memory (Linux only). Any number of processes may
+	// send, one thread of one process receives. Sending and receiving only touch atomics in the
+	// shared memory, futex syscalls are made only when the other side is blocked waiting for
+	// messages or for space. The creator owns the name and unlinks it on Close().
+	class IPCChannel
+	{
+	public:
+		static constexpr uint32_t DefaultSlotSize = 256;
+		static constexpr uint32_t DefaultSlotCount = 4096;
+		static constexpr int WaitForever = -1;
+
+		IPCChannel() = default;
+		IPCChannel(const IPCChannel&) = delete;
+		IPCChannel& operator=(const IPCChannel&) = delete;
+		~IPCChannel();
+
+		// Names start with a slash, e.g. "/jerboa-events". A stale channel of the same name,
+		// left behind by a crashed process, is replaced. slotCount is rounded up to a power of two.
+		bool Create(const std::string& name, uint32_t slotSize = DefaultSlotSize, uint32_t slotCount = DefaultSlotCount);
+		bool Open(const std::string& name);
+		void Close();
+
+		inline bool IsOpen() const { return mHeader != nullptr; }
+		inline const std::string& GetName() const { return mName; }
+		uint32_t GetMaxPayloadSize() const;
+
+		// Returns false if the payload is too large, or if the ring is full, which the
+		// receiver counts as a dropped message. Thread and process safe.
+		bool TrySend(uint32_t type, uint16_t version, const void* payload, uint32_t size);
+		// Waits up to timeoutMs for space when the ring is full
+		bool Send(uint32_t type, uint16_t version, const void* payload, uint32_t size, int timeoutMs = WaitForever);
+
+		// Hands up to maxMessages messages to handler(const IPCMessage&) in the order they were
+		// claimed and returns how many. Receiver thread only.
+		template<typename Handler>
+		uint32_t Receive(Handler&& handler, uint32_t maxMessages = UINT32_MAX)
+		{
+			uint32_t count = 0;
+			IPCMessage message;
+			while (count < maxMessages && Peek(message)) {
+				handler(static_cast<const IPCMessage&>(message));
+				Pop();
+				count++;
+			}
+			if (count > 0)
+				NotifySpace();
+			return count;
+		}
+
+		// Blocks until a message can be received, false on timeout. Receiver thread only.
+		bool WaitForMessages(int timeoutMs = WaitForever);
+
+		// Messages senders couldn't fit into the full ring
+		uint64_t GetDroppedCount() const;
+		// Slots the receiver gave up on, see StallTimeoutMs
+		uint64_t GetSkippedCount() const;
+
+		// A sender that dies between claiming a slot and publishing it would block the ring
+		// for good, so the receiver skips a slot that stays claimed for this long. A sender
+		// that does finish after that learns from TrySend() that its message was dropped.
+		static constexpr uint32_t StallTimeoutMs = 1000;
+	private:
+		struct Header;
+		struct Slot;
+
+		enum class WriteResult { Sent, Full, Failed };
+
+		Slot* GetSlot(uint64_t position) const;
+		WriteResult Write(uint32_t type, uint16_t version, const void* payload, uint32_t size);
+		bool Peek(IPCMessage& message);
+		void Pop();
+		void NotifySpace();
+
+		std::string mName;
+		Header* mHeader = nullptr;
+		uint8_t* mSlots = nullptr;
+		size_t mMappingSize = 0;
+		uint32_t mSender = 0;
+		bool mOwner = false;
+
+		// Receiver state
+		uint64_t mStalledPosition = UINT64_MAX;
+		uint64_t mStalledSince = 0;
+	};
+}
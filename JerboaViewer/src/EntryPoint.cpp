@@ -0,0 +1,23 @@
+#include "Jerboa/EntryPoint.h"
+#include "ViewerApp.h"
+
+#include <cstring>
+
+// Usage: JerboaViewer [address] [--no-attach]
+// The address is the application's telemetry socket path, or a TCP port on 127.0.0.1
+Jerboa::Application* Jerboa::CreateApplication(Jerboa::ApplicationCommandLineArgs args) {
+	std::string address = Jerboa::Telemetry::Settings().socketPath;
+	bool autoAttach = true;
+	for (int i = 1; i < args.count; i++) {
+		if (std::strcmp(args[i], "--no-attach") == 0)
+			autoAttach = false;
+		else
+			address = args[i];
+	}
+
+	Jerboa::ApplicationProps props;
+	props.commandLineArgs = args;
+	props.windowProps.title = "JerboaViewer";
+
+	return new JerboaViewer::ViewerApp(props, address, autoAttach);
+}
@@ -0,0 +1,109 @@
+#include "TelemetryCapture.h"
+
+#include "Jerboa/Profiling/TelemetryProtocol.h"
+
+namespace JerboaViewer {
+	void TelemetryCapture::Clear()
+	{
+		mNames.clear();
+		mFrames.clear();
+		mCounters.clear();
+		mCounterIndices.clear();
+		mLogLines.clear();
+		mDroppedRecords = 0;
+		mDiscardedLogLines = 0;
+	}
+
+	bool TelemetryCapture::Decode(const uint8_t* data, size_t size)
+	{
+		using Jerboa::TelemetryRecord;
+
+		Jerboa::TelemetryReader reader(data, size);
+		while (!reader.IsAtEnd()) {
+			uint8_t record;
+			if (!reader.ReadByte(record))
+				return false;
+
+			switch (static_cast<TelemetryRecord>(record)) {
+				case TelemetryRecord::String: {
+					uint64_t id;
+					std::string_view name;
+					if (!reader.ReadVarint(id) || !reader.ReadString(name))
+						return false;
+					mNames[(uint32_t)id] = std::string(name);
+					break;
+				}
+				case TelemetryRecord::Frame: {
+					CapturedFrame frame;
+					if (!reader.ReadVarint(frame.index) || !reader.ReadSigned(frame.start) || !reader.ReadVarint(frame.duration))
+						return false;
+					if (mFrames.size() == MaxFrames)
+						mFrames.pop_front();
+					mFrames.push_back(std::move(frame));
+					break;
+				}
+				case TelemetryRecord::Zone: {
+					uint64_t nameId, track, depth, duration;
+					int64_t start;
+					if (!reader.ReadVarint(nameId) || !reader.ReadVarint(track) || !reader.ReadVarint(depth) || !reader.ReadSigned(start) || !reader.ReadVarint(duration))
+						return false;
+					// Zones always follow their frame
+					if (mFrames.empty())
+						return false;
+					mFrames.back().zones.push_back({ (uint32_t)nameId, (uint32_t)track, (uint32_t)depth, start, duration });
+					break;
+				}
+				case TelemetryRecord::Counter: {
+					uint64_t frame, nameId;
+					double value;
+					if (!reader.ReadVarint(frame) || !reader.ReadVarint(nameId) || !reader.ReadDouble(value))
+						return false;
+
+					auto it = mCounterIndices.find((uint32_t)nameId);
+					if (it == mCounterIndices.end()) {
+						it = mCounterIndices.emplace((uint32_t)nameId, mCounters.size()).first;
+						mCounters.emplace_back().nameId = (uint32_t)nameId;
+					}
+					CounterHistory& counter = mCounters[it->second];
+					counter.lastFrame = frame;
+					counter.lastValue = value;
+					if (counter.values.size() == MaxCounterValues)
+						counter.values.pop_front();
+					counter.values.push_back((float)value);
+					break;
+				}
+				case TelemetryRecord::Log: {
+					CapturedLogLine line;
+					uint64_t loggerId;
+					std::string_view text;
+					if (!reader.ReadByte(line.level) || !reader.ReadVarint(loggerId) || !reader.ReadSigned(line.time) || !reader.ReadString(text))
+						return false;
+					line.loggerId = (uint32_t)loggerId;
+					line.text = std::string(text);
+					if (mLogLines.size() == MaxLogLines) {
+						mLogLines.pop_front();
+						mDiscardedLogLines++;
+					}
+					mLogLines.push_back(std::move(line));
+					break;
+				}
+				case TelemetryRecord::Dropped: {
+					uint64_t count;
+					if (!reader.ReadVarint(count))
+						return false;
+					mDroppedRecords += count;
+					break;
+				}
+				default:
+					return false;
+			}
+		}
+		return true;
+	}
+
+	const char* TelemetryCapture::GetName(uint32_t id) const
+	{
+		auto it = mNames.find(id);
+		return it != mNames.end() ? it->second.c_str() : "?";
+	}
+}
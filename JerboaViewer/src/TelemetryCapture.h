@@ -0,0 +1,77 @@
+#pragma once
+
+#include <deque>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+
+namespace JerboaViewer {
+	struct CapturedZone
+	{
+		uint32_t nameId;
+		uint32_t track;
+		uint32_t depth;
+		// Relative to the frame's start, GPU zones can start before it
+		int64_t start;
+		uint64_t duration;
+	};
+
+	struct CapturedFrame
+	{
+		uint64_t index = 0;
+		// Nanoseconds since the engine accepted the connection
+		int64_t start = 0;
+		uint64_t duration = 0;
+		std::vector<CapturedZone> zones;
+	};
+
+	struct CounterHistory
+	{
+		uint32_t nameId = 0;
+		uint64_t lastFrame = 0;
+		double lastValue = 0.0;
+		// Oldest first, one value per frame the counter was recorded in
+		std::deque<float> values;
+	};
+
+	struct CapturedLogLine
+	{
+		uint8_t level;
+		uint32_t loggerId;
+		int64_t time;
+		std::string text;
+	};
+
+	// What the viewer received from one connection, the oldest data is discarded beyond the limits
+	class TelemetryCapture
+	{
+	public:
+		static constexpr size_t MaxFrames = 1200;
+		static constexpr size_t MaxCounterValues = 600;
+		static constexpr size_t MaxLogLines = 50000;
+
+		void Clear();
+
+		// Decodes the records of one decompressed block, false if it is malformed
+		bool Decode(const uint8_t* data, size_t size);
+
+		const char* GetName(uint32_t id) const;
+
+		inline const std::deque<CapturedFrame>& GetFrames() const { return mFrames; }
+		inline const std::vector<CounterHistory>& GetCounters() const { return mCounters; }
+		inline const std::deque<CapturedLogLine>& GetLogLines() const { return mLogLines; }
+		// Records the engine dropped because it couldn't queue them
+		inline uint64_t GetDroppedRecords() const { return mDroppedRecords; }
+		// Log lines discarded beyond MaxLogLines, so row numbers can stay stable while scrolling
+		inline uint64_t GetDiscardedLogLines() const { return mDiscardedLogLines; }
+	private:
+		std::unordered_map<uint32_t, std::string> mNames;
+		std::deque<CapturedFrame> mFrames;
+		std::vector<CounterHistory> mCounters;
+		std::unordered_map<uint32_t, size_t> mCounterIndices;
+		std::deque<CapturedLogLine> mLogLines;
+		uint64_t mDroppedRecords = 0;
+		uint64_t mDiscardedLogLines = 0;
+	};
+}
@@ -0,0 +1,175 @@
+#include "TelemetryClient.h"
+
+#include "Jerboa/Core/Compression.h"
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+#ifdef JERBOA_PLATFORM_LINUX
+	#include <sys/socket.h>
+	#include <sys/un.h>
+	#include <netinet/in.h>
+	#include <arpa/inet.h>
+	#include <unistd.h>
+#endif
+
+namespace JerboaViewer {
+	namespace {
+		// Keeps a backlog from freezing the UI, the rest is read in the next frames
+		constexpr size_t MaxBytesPerPoll = 16 * 1024 * 1024;
+	}
+
+	TelemetryClient::~TelemetryClient()
+	{
+		Disconnect();
+	}
+
+	TelemetryClient::Address TelemetryClient::ParseAddress(const std::string& text)
+	{
+		Address address;
+		const size_t digits = text[0] == ':' ? 1 : 0;
+		if (!text.empty() && text.size() > digits && text.find_first_not_of("0123456789", digits) == std::string::npos) {
+			address.tcpPort = (uint16_t)std::atoi(text.c_str() + digits);
+			address.socketPath.clear();
+		}
+		else if (!text.empty()) {
+			address.socketPath = text;
+		}
+		return address;
+	}
+
+	bool TelemetryClient::Connect(const Address& address)
+	{
+		Disconnect();
+		mError.clear();
+		mStats = Statistics();
+
+#ifdef JERBOA_PLATFORM_LINUX
+		int result = -1;
+		if (address.tcpPort != 0) {
+			mSocket = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+			sockaddr_in target = {};
+			target.sin_family = AF_INET;
+			target.sin_port = htons(address.tcpPort);
+			target.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+			if (mSocket >= 0)
+				result = connect(mSocket, reinterpret_cast<sockaddr*>(&target), sizeof(target));
+		}
+		else {
+			mSocket = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+			sockaddr_un target = {};
+			target.sun_family = AF_UNIX;
+			if (mSocket >= 0 && address.socketPath.size() < sizeof(target.sun_path)) {
+				std::memcpy(target.sun_path, address.socketPath.c_str(), address.socketPath.size() + 1);
+				result = connect(mSocket, reinterpret_cast<sockaddr*>(&target), sizeof(target));
+			}
+		}
+
+		if (result != 0) {
+			Fail(std::strerror(errno));
+			return false;
+		}
+		return true;
+#else
+		Fail("Telemetry is only supported on Linux");
+		return false;
+#endif
+	}
+
+	void TelemetryClient::Disconnect()
+	{
+#ifdef JERBOA_PLATFORM_LINUX
+		if (mSocket >= 0)
+			close(mSocket);
+#endif
+		mSocket = -1;
+		mHelloReceived = false;
+		mReceived.clear();
+		mReceivedOffset = 0;
+	}
+
+	void TelemetryClient::Fail(const std::string& error)
+	{
+		Disconnect();
+		mError = error;
+	}
+
+	void TelemetryClient::Poll(TelemetryCapture& capture)
+	{
+#ifdef JERBOA_PLATFORM_LINUX
+		size_t polled = 0;
+		while (mSocket >= 0 && polled < MaxBytesPerPoll) {
+			const size_t chunk = 256 * 1024;
+			const size_t oldSize = mReceived.size();
+			mReceived.resize(oldSize + chunk);
+			const ssize_t received = recv(mSocket, mReceived.data() + oldSize, chunk, MSG_DONTWAIT);
+			mReceived.resize(oldSize + (received > 0 ? (size_t)received : 0));
+
+			if (received == 0) {
+				Fail("The application closed the connection");
+				return;
+			}
+			if (received < 0) {
+				if (errno == EINTR)
+					continue;
+				if (errno != EAGAIN && errno != EWOULDBLOCK)
+					Fail(std::strerror(errno));
+				break;
+			}
+
+			polled += (size_t)received;
+			mStats.receivedBytes += (uint64_t)received;
+			if (!DecodeReceived(capture))
+				return;
+		}
+#endif
+	}
+
+	bool TelemetryClient::DecodeReceived(TelemetryCapture& capture)
+	{
+		if (!mHelloReceived) {
+			if (mReceived.size() - mReceivedOffset < sizeof(Jerboa::TelemetryHello))
+				return true;
+			std::memcpy(&mHello, mReceived.data() + mReceivedOffset, sizeof(mHello));
+			mReceivedOffset += sizeof(mHello);
+			if (mHello.magic != Jerboa::TelemetryMagic || mHello.version != Jerboa::TelemetryVersion) {
+				Fail("Not a telemetry stream, or one of another version");
+				return false;
+			}
+			mHelloReceived = true;
+			// Name ids start over with every connection
+			capture.Clear();
+		}
+
+		Jerboa::TelemetryBlockHeader header;
+		while (mReceived.size() - mReceivedOffset >= sizeof(header)) {
+			std::memcpy(&header, mReceived.data() + mReceivedOffset, sizeof(header));
+			if (header.rawSize > Jerboa::TelemetryMaxBlockSize || header.storedSize > header.rawSize) {
+				Fail("Received a corrupt block");
+				return false;
+			}
+			if (mReceived.size() - mReceivedOffset < sizeof(header) + header.storedSize)
+				break;
+
+			const uint8_t* stored = mReceived.data() + mReceivedOffset + sizeof(header);
+			mBlock.resize(header.rawSize);
+			const bool valid = header.storedSize == header.rawSize
+				? (std::memcpy(mBlock.data(), stored, header.rawSize), true)
+				: Jerboa::Compression::Decompress(stored, header.storedSize, mBlock.data(), header.rawSize);
+			if (!valid || !capture.Decode(mBlock.data(), mBlock.size())) {
+				Fail("Received a corrupt block");
+				return false;
+			}
+
+			mReceivedOffset += sizeof(header) + header.storedSize;
+			mStats.rawBytes += header.rawSize;
+			mStats.blocks++;
+		}
+
+		// Keeps the partial block at the front
+		mReceived.erase(mReceived.begin(), mReceived.begin() + mReceivedOffset);
+		mReceivedOffset = 0;
+		return true;
+	}
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "TelemetryCapture.h"
+#include "Jerboa/Profiling/TelemetryProtocol.h"
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace JerboaViewer {
+	// Connection to an engine's Telemetry stream, polled once per viewer frame without blocking
+	class TelemetryClient
+	{
+	public:
+		struct Address
+		{
+			// Unix domain socket path, used unless tcpPort is set
+			std::string socketPath = "/tmp/jerboa-telemetry.sock";
+			uint16_t tcpPort = 0;
+		};
+
+		struct Statistics
+		{
+			uint64_t receivedBytes = 0;
+			uint64_t rawBytes = 0;
+			uint64_t blocks = 0;
+		};
+
+		TelemetryClient() = default;
+		TelemetryClient(const TelemetryClient&) = delete;
+		TelemetryClient& operator=(const TelemetryClient&) = delete;
+		~TelemetryClient();
+
+		// "port" or ":port" connects to 127.0.0.1 over TCP, anything else is a socket path
+		static Address ParseAddress(const std::string& text);
+
+		bool Connect(const Address& address);
+		void Disconnect();
+		inline bool IsConnected() const { return mSocket >= 0; }
+
+		// Reads what arrived and decodes every complete block into the capture. Disconnects
+		// when the engine went away or sent something malformed, see GetError().
+		void Poll(TelemetryCapture& capture);
+
+		inline uint32_t GetProcessId() const { return mHelloReceived ? mHello.processId : 0; }
+		inline const Statistics& GetStats() const { return mStats; }
+		inline const std::string& GetError() const { return mError; }
+	private:
+		void Fail(const std::string& error);
+		bool DecodeReceived(TelemetryCapture& capture);
+
+		int mSocket = -1;
+		bool mHelloReceived = false;
+		Jerboa::TelemetryHello mHello = {};
+		// Received bytes not decoded yet, starting at mReceivedOffset
+		std::vector<uint8_t> mReceived;
+		size_t mReceivedOffset = 0;
+		std::vector<uint8_t> mBlock;
+		Statistics mStats;
+		std::string mError;
+	};
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include "Jerboa/Core/Application.h"
+#include "ViewerLayer.h"
+
+namespace JerboaViewer {
+	class ViewerApp : public Jerboa::Application
+	{
+	public:
+		ViewerApp(const Jerboa::ApplicationProps& props, const std::string& address, bool autoAttach)
+			: Application(props), mAddress(address), mAutoAttach(autoAttach) {}
+
+		virtual void OnInit() {
+			PushLayer(new ViewerLayer(mAddress, mAutoAttach));
+		}
+	private:
+		std::string mAddress;
+		bool mAutoAttach;
+	};
+}
@@ -0,0 +1,269 @@
+#include "ViewerLayer.h"
+#include "imgui.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+namespace JerboaViewer {
+	namespace {
+		// spdlog's levels, in order
+		const char* const sLogLevelNames[] = { "trace", "debug", "info", "warn", "error", "critical" };
+		constexpr int sLogLevelCount = sizeof(sLogLevelNames) / sizeof(sLogLevelNames[0]);
+
+		const ImVec4 sLogLevelColors[] = {
+			{ 0.6f, 0.6f, 0.6f, 1.0f }, { 0.6f, 0.8f, 1.0f, 1.0f }, { 0.4f, 0.9f, 0.4f, 1.0f },
+			{ 1.0f, 0.8f, 0.2f, 1.0f }, { 1.0f, 0.4f, 0.3f, 1.0f }, { 1.0f, 0.2f, 0.8f, 1.0f }
+		};
+
+		// Retries while auto-attach waits for the application to start
+		constexpr Jerboa::Timestamp sAttachRetryInterval = 1000000000;
+
+		double ToMilliseconds(int64_t nanoseconds)
+		{
+			return nanoseconds / 1000000.0;
+		}
+	}
+
+	ViewerLayer::ViewerLayer(const std::string& address, bool autoAttach)
+		: Layer("ViewerLayer"), mAutoAttach(autoAttach)
+	{
+		std::snprintf(mAddress, sizeof(mAddress), "%s", address.c_str());
+	}
+
+	void ViewerLayer::OnUpdate()
+	{
+		const Jerboa::Timestamp now = Jerboa::Time::Now();
+		if (!mClient.IsConnected() && mAutoAttach && now - mLastAttachAttempt >= sAttachRetryInterval) {
+			mLastAttachAttempt = now;
+			if (mClient.Connect(TelemetryClient::ParseAddress(mAddress)))
+				JERBOA_LOG_INFO("Attached to \"{}\"", mAddress);
+		}
+
+		const bool wasConnected = mClient.IsConnected();
+		mClient.Poll(mCapture);
+		if (wasConnected && !mClient.IsConnected())
+			JERBOA_LOG_INFO("Detached: {}", mClient.GetError());
+
+		UpdateLogFilter();
+	}
+
+	void ViewerLayer::OnImGuiRender()
+	{
+		ImGui::DockSpaceOverViewport(ImGui::GetMainViewport());
+		DrawConnectionPanel();
+		DrawFramesPanel();
+		DrawZonesPanel();
+		DrawCountersPanel();
+		DrawLogPanel();
+	}
+
+	void ViewerLayer::DrawConnectionPanel()
+	{
+		ImGui::Begin("Connection");
+		ImGui::InputText("Address", mAddress, sizeof(mAddress));
+		if (mClient.IsConnected()) {
+			if (ImGui::Button("Detach")) {
+				// Otherwise it attaches again right away
+				mAutoAttach = false;
+				mClient.Disconnect();
+			}
+		}
+		else if (ImGui::Button("Attach")) {
+			mLastAttachAttempt = Jerboa::Time::Now();
+			mClient.Connect(TelemetryClient::ParseAddress(mAddress));
+		}
+		ImGui::SameLine();
+		ImGui::Checkbox("Attach automatically", &mAutoAttach);
+		ImGui::SameLine();
+		if (ImGui::Button("Clear")) {
+			mCapture.Clear();
+			mFilteredLogLines.clear();
+			mLogLinesScanned = 0;
+		}
+
+		if (mClient.IsConnected())
+			ImGui::Text("Attached to process %u", mClient.GetProcessId());
+		else if (!mClient.GetError().empty())
+			ImGui::TextColored(ImVec4(1.0f, 0.6f, 0.2f, 1.0f), "Detached: %s", mClient.GetError().c_str());
+		else
+			ImGui::TextUnformatted("Detached");
+
+		const TelemetryClient::Statistics& stats = mClient.GetStats();
+		ImGui::Text("Received %.2f MB in %llu blocks, %.1fx compressed", stats.receivedBytes / (1024.0 * 1024.0),
+			static_cast<unsigned long long>(stats.blocks), stats.receivedBytes > 0 ? (double)stats.rawBytes / stats.receivedBytes : 0.0);
+		if (mCapture.GetDroppedRecords() > 0)
+			ImGui::Text("The application dropped %llu records", static_cast<unsigned long long>(mCapture.GetDroppedRecords()));
+		ImGui::End();
+	}
+
+	const CapturedFrame* ViewerLayer::GetSelectedFrame() const
+	{
+		const std::deque<CapturedFrame>& frames = mCapture.GetFrames();
+		if (frames.empty())
+			return nullptr;
+		if (!mPaused)
+			return &frames.back();
+
+		// Frame indices increase, but frames the application dropped leave gaps
+		auto it = std::lower_bound(frames.begin(), frames.end(), mSelectedFrame, [](const CapturedFrame& frame, uint64_t index) { return frame.index < index; });
+		return it != frames.end() ? &*it : &frames.back();
+	}
+
+	void ViewerLayer::DrawFramesPanel()
+	{
+		ImGui::Begin("Frames");
+		const std::deque<CapturedFrame>& frames = mCapture.GetFrames();
+		if (frames.empty()) {
+			ImGui::TextUnformatted("Waiting for frames...");
+			ImGui::End();
+			return;
+		}
+
+		mFrameTimes.resize(frames.size());
+		float longest = 0.0f;
+		for (size_t i = 0; i < frames.size(); i++) {
+			mFrameTimes[i] = (float)ToMilliseconds((int64_t)frames[i].duration);
+			longest = std::max(longest, mFrameTimes[i]);
+		}
+		ImGui::PlotHistogram("##FrameTimes", mFrameTimes.data(), (int)mFrameTimes.size(), 0, nullptr, 0.0f, longest, ImVec2(ImGui::GetContentRegionAvail().x, 80.0f));
+
+		if (ImGui::Checkbox("Pause", &mPaused) && mPaused)
+			mSelectedFrame = frames.back().index;
+		if (mPaused) {
+			int offset = (int)(frames.back().index - std::min(mSelectedFrame, frames.back().index));
+			const int maxOffset = (int)(frames.back().index - frames.front().index);
+			ImGui::SameLine();
+			if (ImGui::SliderInt("Frames back", &offset, 0, maxOffset))
+				mSelectedFrame = frames.back().index - (uint64_t)offset;
+		}
+
+		const CapturedFrame* frame = GetSelectedFrame();
+		ImGui::Text("Frame %llu: %.3f ms, %zu zones", static_cast<unsigned long long>(frame->index), ToMilliseconds((int64_t)frame->duration), frame->zones.size());
+		ImGui::End();
+	}
+
+	void ViewerLayer::DrawZonesPanel()
+	{
+		ImGui::Begin("Zones");
+		const CapturedFrame* frame = GetSelectedFrame();
+		if (frame && ImGui::BeginTable("Zones", 4, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY)) {
+			ImGui::TableSetupColumn("Track");
+			ImGui::TableSetupColumn("Zone");
+			ImGui::TableSetupColumn("Start (ms)");
+			ImGui::TableSetupColumn("Duration (ms)");
+			ImGui::TableHeadersRow();
+
+			// Zones are recorded when they end; show each track in start order instead
+			mSortedZones.assign(frame->zones.begin(), frame->zones.end());
+			std::sort(mSortedZones.begin(), mSortedZones.end(), [](const CapturedZone& a, const CapturedZone& b) {
+				return a.track != b.track ? a.track < b.track : a.start < b.start;
+			});
+
+			// Same track numbering as Jerboa::Profiler
+			constexpr uint32_t GPUTrack = 0xffff;
+			for (const CapturedZone& zone : mSortedZones) {
+				ImGui::TableNextRow();
+				ImGui::TableNextColumn();
+				if (zone.track == GPUTrack)
+					ImGui::TextUnformatted("GPU");
+				else
+					ImGui::Text("CPU %u", zone.track);
+
+				ImGui::TableNextColumn();
+				ImGui::Text("%*s%s", static_cast<int>(zone.depth * 2), "", mCapture.GetName(zone.nameId));
+				ImGui::TableNextColumn();
+				ImGui::Text("%.3f", ToMilliseconds(zone.start));
+				ImGui::TableNextColumn();
+				ImGui::Text("%.3f", ToMilliseconds((int64_t)zone.duration));
+			}
+			ImGui::EndTable();
+		}
+		ImGui::End();
+	}
+
+	void ViewerLayer::DrawCountersPanel()
+	{
+		ImGui::Begin("Counters");
+		if (ImGui::BeginTable("Counters", 3, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY)) {
+			ImGui::TableSetupColumn("Counter");
+			ImGui::TableSetupColumn("Value");
+			ImGui::TableSetupColumn("History");
+			ImGui::TableHeadersRow();
+
+			for (const CounterHistory& counter : mCapture.GetCounters()) {
+				ImGui::TableNextRow();
+				ImGui::TableNextColumn();
+				ImGui::TextUnformatted(mCapture.GetName(counter.nameId));
+				ImGui::TableNextColumn();
+				ImGui::Text("%.3f", counter.lastValue);
+				ImGui::TableNextColumn();
+
+				// PlotLines wants contiguous values
+				mFrameTimes.assign(counter.values.begin(), counter.values.end());
+				ImGui::PushID((int)counter.nameId);
+				ImGui::PlotLines("##History", mFrameTimes.data(), (int)mFrameTimes.size(), 0, nullptr, 3.4e38f, 3.4e38f, ImVec2(ImGui::GetContentRegionAvail().x, 24.0f));
+				ImGui::PopID();
+			}
+			ImGui::EndTable();
+		}
+		ImGui::End();
+	}
+
+	void ViewerLayer::UpdateLogFilter()
+	{
+		const std::deque<CapturedLogLine>& lines = mCapture.GetLogLines();
+		const uint64_t first = mCapture.GetDiscardedLogLines();
+		const uint64_t end = first + lines.size();
+
+		// The capture was cleared, e.g. by a new connection
+		if (mLogLinesScanned > end) {
+			mFilteredLogLines.clear();
+			mLogLinesScanned = 0;
+		}
+
+		for (uint64_t line = std::max(mLogLinesScanned, first); line < end; line++) {
+			if (lines[(size_t)(line - first)].level >= mMinLogLevel)
+				mFilteredLogLines.push_back(line);
+		}
+		mLogLinesScanned = end;
+
+		auto kept = std::lower_bound(mFilteredLogLines.begin(), mFilteredLogLines.end(), first);
+		mFilteredLogLines.erase(mFilteredLogLines.begin(), kept);
+	}
+
+	void ViewerLayer::DrawLogPanel()
+	{
+		ImGui::Begin("Log");
+		if (ImGui::Combo("Level", &mMinLogLevel, sLogLevelNames, sLogLevelCount)) {
+			mFilteredLogLines.clear();
+			mLogLinesScanned = 0;
+			UpdateLogFilter();
+		}
+		ImGui::SameLine();
+		ImGui::Checkbox("Follow", &mFollowLog);
+
+		ImGui::BeginChild("Lines", ImVec2(0.0f, 0.0f), false, ImGuiWindowFlags_HorizontalScrollbar);
+		const std::deque<CapturedLogLine>& lines = mCapture.GetLogLines();
+		const uint64_t first = mCapture.GetDiscardedLogLines();
+
+		// Only the visible rows are laid out
+		ImGuiListClipper clipper;
+		clipper.Begin((int)mFilteredLogLines.size());
+		while (clipper.Step()) {
+			for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; row++) {
+				const CapturedLogLine& line = lines[(size_t)(mFilteredLogLines[row] - first)];
+				const int level = std::min<int>(line.level, sLogLevelCount - 1);
+				ImGui::TextColored(sLogLevelColors[level], "[%10.3f] %s %s:", line.time / 1000000000.0, mCapture.GetName(line.loggerId), sLogLevelNames[level]);
+				ImGui::SameLine();
+				ImGui::TextUnformatted(line.text.c_str(), line.text.c_str() + line.text.size());
+			}
+		}
+		clipper.End();
+
+		if (mFollowLog && ImGui::GetScrollY() >= ImGui::GetScrollMaxY())
+			ImGui::SetScrollHereY(1.0f);
+		ImGui::EndChild();
+		ImGui::End();
+	}
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "Jerboa/Debug.h"
+#include "Jerboa/Core/Layer.h"
+#include "Jerboa/Core/Time.h"
+#include "TelemetryClient.h"
+#include "TelemetryCapture.h"
+
+#include <deque>
+#include <vector>
+
+namespace JerboaViewer {
+	// Attaches to an application's telemetry stream and shows its frames, zones, counters
+	// and log lines. Detaching keeps the capture around until the next attach.
+	class ViewerLayer : public Jerboa::Layer
+	{
+	public:
+		ViewerLayer(const std::string& address, bool autoAttach);
+
+		virtual void OnUpdate() override;
+		virtual void OnImGuiRender() override;
+	private:
+		void DrawConnectionPanel();
+		void DrawFramesPanel();
+		void DrawZonesPanel();
+		void DrawCountersPanel();
+		void DrawLogPanel();
+
+		// The newest frame unless paused, nullptr before the first one arrived
+		const CapturedFrame* GetSelectedFrame() const;
+		void UpdateLogFilter();
+
+		TelemetryClient mClient;
+		TelemetryCapture mCapture;
+		char mAddress[256] = {};
+		bool mAutoAttach;
+		Jerboa::Timestamp mLastAttachAttempt = 0;
+
+		bool mPaused = false;
+		uint64_t mSelectedFrame = 0;
+		std::vector<float> mFrameTimes;
+		std::vector<CapturedZone> mSortedZones;
+
+		int mMinLogLevel = 0;
+		bool mFollowLog = true;
+		// Absolute numbers of the log lines that pass the level filter, extended as lines arrive
+		std::deque<uint64_t> mFilteredLogLines;
+		uint64_t mLogLinesScanned = 0;
+	};
+}
@@ -0,0 +1,296 @@
+#pragma once
+
+#include "Jerboa/Debug.h"
+#include "Jerboa/Event.h"
+#include "Jerboa/Core/Layer.h"
+#include "Jerboa/Core/Application.h"
+#include "Jerboa/Core/KeyCode.h"
+#include "Jerboa/Core/JobSystem.h"
+#include "Jerboa/Core/FrameAllocator.h"
+#include "Jerboa/Core/ScratchAllocator.h"
+#include "Jerboa/Core/PoolAllocator.h"
+#include "Jerboa/Core/StlAllocator.h"
+#include "Jerboa/Spatial/DynamicAABBTree.h"
+#include "Jerboa/Profiling/MemoryTracker.h"
+#include "Events/MessageEvent.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <cstdio>
+#include <cmath>
+#include <new>
+#include <vector>
+#include <random>
+#include <thread>
+
+#ifdef JERBOA_MEMORY_TRACKING
+// The engine's tracker already counts every allocation, and by subsystem
+static void EnableAllocationCounting() {}
+static uint64_t GetThreadAllocationCount() { return Jerboa::MemoryTracker::GetThreadAllocationCount(); }
+#else
+// Replacing the global operators is only allowed once per program, so this header must only
+// be included by App.cpp. They pass through to malloc and only count once --alloc-check
+// enabled them, each thread counts its own allocations.
+static std::atomic<bool> sCountAllocations{ false };
+static thread_local uint64_t tAllocationCount = 0;
+static void EnableAllocationCounting() { sCountAllocations.store(true, std::memory_order_relaxed); }
+static uint64_t GetThreadAllocationCount() { return tAllocationCount; }
+
+static void* CountedAllocate(size_t size)
+{
+	if (sCountAllocations.load(std::memory_order_relaxed))
+		tAllocationCount++;
+	void* pointer = std::malloc(size == 0 ? 1 : size);
+	if (pointer == nullptr)
+		throw std::bad_alloc();
+	return pointer;
+}
+
+static void* CountedAllocateAligned(size_t size, size_t alignment)
+{
+	if (sCountAllocations.load(std::memory_order_relaxed))
+		tAllocationCount++;
+	if (size == 0)
+		size = 1;
+#if defined(JERBOA_PLATFORM_WINDOWS)
+	void* pointer = _aligned_malloc(size, alignment);
+#else
+	void* pointer = nullptr;
+	if (posix_memalign(&pointer, std::max(alignment, sizeof(void*)), size) != 0)
+		pointer = nullptr;
+#endif
+	if (pointer == nullptr)
+		throw std::bad_alloc();
+	return pointer;
+}
+
+static void FreeAligned(void* pointer)
+{
+#if defined(JERBOA_PLATFORM_WINDOWS)
+	_aligned_free(pointer);
+#else
+	std::free(pointer);
+#endif
+}
+
+void* operator new(size_t size) { return CountedAllocate(size); }
+void* operator new[](size_t size) { return CountedAllocate(size); }
+void* operator new(size_t size, std::align_val_t alignment) { return CountedAllocateAligned(size, (size_t)alignment); }
+void* operator new[](size_t size, std::align_val_t alignment) { return CountedAllocateAligned(size, (size_t)alignment); }
+void operator delete(void* pointer) noexcept { std::free(pointer); }
+void operator delete[](void* pointer) noexcept { std::free(pointer); }
+void operator delete(void* pointer, size_t) noexcept { std::free(pointer); }
+void operator delete[](void* pointer, size_t) noexcept { std::free(pointer); }
+void operator delete(void* pointer, std::align_val_t) noexcept { FreeAligned(pointer); }
+void operator delete[](void* pointer, std::align_val_t) noexcept { FreeAligned(pointer); }
+void operator delete(void* pointer, size_t, std::align_val_t) noexcept { FreeAligned(pointer); }
+void operator delete[](void* pointer, size_t, std::align_val_t) noexcept { FreeAligned(pointer); }
+#endif
+
+// Drives the engine paths that run every frame (event publishing, frame and scratch arenas,
+// pools, jobs, broad-phase updates, next to whatever other layers render) and checks that
+// once warmed up, whole frames complete without a single heap allocation. Counted are the
+// main thread and this layer's own jobs, not the asset, logging or other worker threads.
+// Sandbox exits with status 1 if any allocated, in every configuration.
+class AllocationCheckLayer : public Jerboa::Layer
+{
+public:
+	AllocationCheckLayer(uint32_t checkFrames = 600)
+		: Layer("AllocationCheckLayer"), mCheckFrames(std::max(checkFrames, 1u)),
+		mProbeObserver(Jerboa::EventObserver::Create(GetSharedEventBus(), this, &AllocationCheckLayer::OnProbeEvent)),
+		mMessageObserver(Jerboa::EventObserver::Create(GetSharedEventBus(), this, &AllocationCheckLayer::OnMessageEvent)) {}
+
+	virtual void OnAttach() override {
+		EnableAllocationCounting();
+		mMainThread = std::this_thread::get_id();
+
+		std::mt19937 random(7);
+		std::uniform_real_distribution<float> position(-50.0f, 50.0f);
+		std::uniform_real_distribution<float> velocity(-2.0f, 2.0f);
+
+		mPositions.resize(ObjectCount);
+		mVelocities.resize(ObjectCount);
+		mBounds.resize(ObjectCount);
+		mDisplacements.resize(ObjectCount);
+		mProxies.resize(ObjectCount);
+		for (uint32_t i = 0; i < ObjectCount; i++) {
+			mPositions[i] = { position(random), position(random), position(random) };
+			mVelocities[i] = { velocity(random), velocity(random), velocity(random) };
+			mBounds[i] = { mPositions[i] - Jerboa::Vec3{ 0.5f, 0.5f, 0.5f }, mPositions[i] + Jerboa::Vec3{ 0.5f, 0.5f, 0.5f } };
+		}
+		mTree.CreateProxies(mBounds.data(), nullptr, ObjectCount, mProxies.data());
+		mFrameTotals.reserve(mCheckFrames);
+		Jerboa::Application::Get().GetWindow().SetVSync(false);
+
+		JERBOA_LOG_INFO("AllocationCheckLayer attached: {} warm-up frames, {} checked frames", WarmupFrames, mCheckFrames);
+	}
+
+	virtual void OnUpdate() override {
+		// The count between two updates covers one whole frame of every layer
+		uint64_t count = GetThreadAllocationCount() + mJobAllocations.load(std::memory_order_relaxed);
+		if (mFrame > WarmupFrames)
+			RecordFrame(count - mLastCount);
+		mLastCount = count;
+		mFrame++;
+
+		Simulate();
+	}
+private:
+	static constexpr uint32_t WarmupFrames = 120;
+	static constexpr uint32_t ObjectCount = 2000;
+	static constexpr float DeltaTime = 1.0f / 60.0f;
+
+	class ProbeEvent : public Jerboa::Event
+	{
+	public:
+		ProbeEvent(uint32_t frame, const float* values, uint32_t count)
+			: frame(frame), values(values), count(count) {}
+
+		uint32_t frame;
+		// Lives in the frame arena
+		const float* values;
+		uint32_t count;
+	};
+
+	struct Particle
+	{
+		Jerboa::Vec3 position;
+		float age;
+	};
+
+	void Simulate() {
+		// Frame arena payload carried by an event
+		const uint32_t valueCount = 256;
+		float* values = Jerboa::FrameAllocator::NewArray<float>(valueCount);
+		for (uint32_t i = 0; i < valueCount; i++)
+			values[i] = (float)(mFrame + i);
+		GetSharedEventBus()->Publish(ProbeEvent(mFrame, values, valueCount));
+
+		// Tooling message: interned sender, text copied to the frame arena
+		char text[64];
+		int length = std::snprintf(text, sizeof(text), "frame %u", mFrame);
+		Jerboa::StringID sender = Jerboa::StringTable::Intern("AllocationCheckLayer");
+		GetSharedEventBus()->Publish(MessageEvent(Jerboa::FrameAllocator::CopyString(std::string_view(text, length)), sender));
+		mKeyNameLength += std::strlen(Jerboa::GetKeyName(Jerboa::KeyCode::Space));
+
+		// Pool churn
+		for (uint32_t i = 0; i < 64; i++)
+			mParticles[i] = mParticlePool.New(Particle{ mPositions[i], 0.0f });
+		for (uint32_t i = 0; i < 64; i++)
+			mParticlePool.Delete(mParticles[i]);
+
+		// Jobs with scratch memory on each worker
+		Jerboa::JobSystem::ParallelFor(ObjectCount, 256, [this](uint32_t begin, uint32_t end) {
+			// The main thread's share is counted with the rest of its frame
+			const bool worker = std::this_thread::get_id() != mMainThread;
+			const uint64_t allocations = GetThreadAllocationCount();
+			Jerboa::ScratchScope scratch;
+			std::vector<uint32_t, Jerboa::ArenaStlAllocator<uint32_t>> outside(scratch.GetArena());
+			for (uint32_t i = begin; i < end; i++) {
+				Jerboa::Vec3 displacement = mVelocities[i] * DeltaTime;
+				mPositions[i] = mPositions[i] + displacement;
+				mDisplacements[i] = displacement;
+				mBounds[i] = { mPositions[i] - Jerboa::Vec3{ 0.5f, 0.5f, 0.5f }, mPositions[i] + Jerboa::Vec3{ 0.5f, 0.5f, 0.5f } };
+				if (std::abs(mPositions[i].x) > 50.0f || std::abs(mPositions[i].y) > 50.0f || std::abs(mPositions[i].z) > 50.0f)
+					outside.push_back(i);
+			}
+			for (uint32_t i : outside) {
+				Bounce(mPositions[i].x, mVelocities[i].x);
+				Bounce(mPositions[i].y, mVelocities[i].y);
+				Bounce(mPositions[i].z, mVelocities[i].z);
+			}
+			if (worker)
+				mJobAllocations.fetch_add(GetThreadAllocationCount() - allocations, std::memory_order_relaxed);
+		});
+
+		// Broad phase
+		mTree.MoveProxies(mProxies.data(), mBounds.data(), mDisplacements.data(), ObjectCount);
+		mTree.FindPairs(mPairs);
+	}
+
+	static void Bounce(float position, float& velocity) {
+		if (std::abs(position) > 50.0f && position * velocity > 0.0f)
+			velocity = -velocity;
+	}
+
+	void OnProbeEvent(const ProbeEvent& evnt) {
+		float sum = 0.0f;
+		for (uint32_t i = 0; i < evnt.count; i++)
+			sum += evnt.values[i];
+		mProbeSum += sum;
+	}
+
+	void OnMessageEvent(const MessageEvent& evnt) {
+		mMessageLength += evnt.mMessage.size() + Jerboa::StringTable::Get(evnt.mSender).size();
+	}
+
+	void RecordFrame(uint64_t allocations) {
+		mFrameTotals.push_back(allocations);
+		if (mFrameTotals.size() < mCheckFrames)
+			return;
+
+		uint64_t total = 0, worst = 0, allocatingFrames = 0;
+		for (uint64_t frameAllocations : mFrameTotals) {
+			total += frameAllocations;
+			worst = std::max(worst, frameAllocations);
+			allocatingFrames += frameAllocations > 0 ? 1 : 0;
+		}
+
+		// Printed directly, the check matters most in Release where logging is compiled out
+		std::printf("Allocation check: %zu frames after %u warm-up frames, %zu pairs per frame\n", mFrameTotals.size(), WarmupFrames, mPairs.size());
+		std::printf("  %llu heap allocations in total, %llu frames allocated, worst frame %llu\n",
+			static_cast<unsigned long long>(total), static_cast<unsigned long long>(allocatingFrames), static_cast<unsigned long long>(worst));
+		std::printf("  frame arena high-water mark %zu bytes, particle pool capacity %u\n",
+			Jerboa::FrameAllocator::Get().GetHighWaterMark(), mParticlePool.GetCapacity());
+		std::fflush(stdout);
+		if (total > 0) {
+			std::fprintf(stderr, "Allocation check failed: steady-state frames allocated from the heap\n");
+			ReportAllocatingTags();
+			Jerboa::Application::Get().Close(1);
+			return;
+		}
+
+		Jerboa::Application::Get().Close();
+	}
+
+	void ReportAllocatingTags() {
+		if (!Jerboa::MemoryTracker::IsEnabled()) {
+			std::fprintf(stderr, "  build with --memory-tracking to see which subsystems allocated\n");
+			return;
+		}
+
+		uint32_t frames = std::min(Jerboa::MemoryTracker::GetRecordedFrameCount(), mCheckFrames);
+		for (uint32_t tag = 0; tag < Jerboa::MemoryTracker::TagCount; tag++) {
+			uint64_t allocations = 0;
+			for (uint32_t framesAgo = 0; framesAgo < frames; framesAgo++)
+				allocations += Jerboa::MemoryTracker::GetFrameAllocations(static_cast<Jerboa::MemoryTag>(tag), framesAgo);
+			if (allocations > 0)
+				std::fprintf(stderr, "  %s: %llu allocations in the last %u frames\n", Jerboa::MemoryTracker::GetTagName(static_cast<Jerboa::MemoryTag>(tag)), static_cast<unsigned long long>(allocations), frames);
+		}
+	}
+
+	uint32_t mCheckFrames;
+	uint32_t mFrame = 0;
+	uint64_t mLastCount = 0;
+	std::thread::id mMainThread;
+	std::atomic<uint64_t> mJobAllocations{ 0 };
+	std::vector<uint64_t> mFrameTotals;
+
+	Jerboa::EventObserver mProbeObserver;
+	Jerboa::EventObserver mMessageObserver;
+	float mProbeSum = 0.0f;
+	size_t mMessageLength = 0;
+	size_t mKeyNameLength = 0;
+
+	Jerboa::ObjectPool<Particle> mParticlePool;
+	Particle* mParticles[64] = {};
+
+	Jerboa::DynamicAABBTree mTree;
+	std::vector<Jerboa::Vec3> mPositions;
+	std::vector<Jerboa::Vec3> mVelocities;
+	std::vector<Jerboa::AABB> mBounds;
+	std::vector<Jerboa::Vec3> mDisplacements;
+	std::vector<Jerboa::ProxyID> mProxies;
+	std::vector<Jerboa::ProxyPair> mPairs;
+};
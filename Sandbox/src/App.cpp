@@ -1,36 +1,319 @@
 #include "Jerboa/Debug.h"
 #include "Jerboa/EntryPoint.h"
 #include "Jerboa/Core/Layer.h"
+#include "Jerboa/Core/Time.h"
+#include "Jerboa/Renderer/Renderer2D.h"
 #include "TestLayer.h"
 #include "TestOverlay.h"
+#include "Renderer2DStressLayer.h"
+#include "EcsBenchmarkLayer.h"
+#include "TransformBenchmarkLayer.h"
+#include "MathBenchmarkLayer.h"
+#include "SpatialBenchmarkLayer.h"
+#include "AllocationCheckLayer.h"
+#include "AssetBenchmarkLayer.h"
+#include "SceneBenchmarkLayer.h"
+#include "StressLayer.h"
+#include "StressDriverLayer.h"
 #include "Events/ExternalMessageEvent.h"
 
+#include <cstring>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <algorithm>
+#include <vector>
+
+enum class SandboxMode {
+	Default,
+	Renderer2DStress,
+	Renderer2DBenchmark,
+	EcsBenchmark,
+	TransformBenchmark,
+	MathBenchmark,
+	SpatialBenchmark,
+	AllocationCheck,
+	AssetBenchmark,
+	SceneBenchmark,
+	StressTest
+};
+
+struct SandboxOptions {
+	SandboxMode mode = SandboxMode::Default;
+	uint32_t spriteCount = 100000;
+	uint32_t frameCount = 1000;
+	uint32_t entityCount = 1000000;
+	uint32_t nodeCount = 100000;
+	uint32_t mathCount = 1 << 20;
+	uint32_t objectCount = 20000;
+	uint32_t checkFrames = 600;
+	uint32_t textureCount = 32;
+	uint32_t sceneEntityCount = 1000000;
+	StressSettings stress;
+	std::string startupTracePath;
+	bool ipcBridge = false;
+	std::string ipcChannel;
+	bool telemetry = false;
+	std::string telemetryAddress;
+	uint32_t toolWindowCount = 0;
+};
+
+static void PrintUsage(const char* program)
+{
+	std::fprintf(stderr,
+		"Usage: %s [--help] [--renderer2d-stress [sprites]] [--renderer2d-bench [sprites] [frames]] [--ecs-bench [entities]]\n"
+		"       [--transform-bench [nodes]] [--math-bench [elements]] [--spatial-bench [objects]]\n"
+		"       [--alloc-check [frames]] [--asset-bench [textures]] [--scene-bench [entities]]\n"
+		"       [--stress [layers] [observers] [frames]] [--stress-events perFrame] [--stress-payload bytes]\n"
+		"       [--stress-report path] [--startup-trace path] [--ipc [channel]]\n"
+		"       [--telemetry [socket path or port]] [--windows [count]]\n",
+		program);
+}
+
+// Prints the usage and exits with status 1 on an unknown argument
+static SandboxOptions ParseOptions(const Jerboa::ApplicationCommandLineArgs& args)
+{
+	SandboxOptions options;
+	for (int i = 1; i < args.count; i++) {
+		if (std::strcmp(args[i], "--renderer2d-stress") == 0) {
+			options.mode = SandboxMode::Renderer2DStress;
+			if (i + 1 < args.count && args[i + 1][0] != '-')
+				options.spriteCount = std::atoi(args[++i]);
+			continue;
+		}
+		else if (std::strcmp(args[i], "--renderer2d-bench") == 0) {
+			options.mode = SandboxMode::Renderer2DBenchmark;
+			if (i + 1 < args.count && args[i + 1][0] != '-')
+				options.spriteCount = std::atoi(args[++i]);
+			if (i + 1 < args.count && args[i + 1][0] != '-')
+				options.frameCount = std::atoi(args[++i]);
+			continue;
+		}
+		else if (std::strcmp(args[i], "--ecs-bench") == 0) {
+			options.mode = SandboxMode::EcsBenchmark;
+			if (i + 1 < args.count && args[i + 1][0] != '-')
+				options.entityCount = std::atoi(args[++i]);
+			continue;
+		}
+		else if (std::strcmp(args[i], "--transform-bench") == 0) {
+			options.mode = SandboxMode::TransformBenchmark;
+			if (i + 1 < args.count && args[i + 1][0] != '-')
+				options.nodeCount = std::atoi(args[++i]);
+			continue;
+		}
+		else if (std::strcmp(args[i], "--math-bench") == 0) {
+			options.mode = SandboxMode::MathBenchmark;
+			if (i + 1 < args.count && args[i + 1][0] != '-')
+				options.mathCount = std::atoi(args[++i]);
+			continue;
+		}
+		else if (std::strcmp(args[i], "--spatial-bench") == 0) {
+			options.mode = SandboxMode::SpatialBenchmark;
+			if (i + 1 < args.count && args[i + 1][0] != '-')
+				options.objectCount = std::atoi(args[++i]);
+			continue;
+		}
+		else if (std::strcmp(args[i], "--alloc-check") == 0) {
+			options.mode = SandboxMode::AllocationCheck;
+			if (i + 1 < args.count && args[i + 1][0] != '-')
+				options.checkFrames = std::atoi(args[++i]);
+			continue;
+		}
+		else if (std::strcmp(args[i], "--asset-bench") == 0) {
+			options.mode = SandboxMode::AssetBenchmark;
+			if (i + 1 < args.count && args[i + 1][0] != '-')
+				options.textureCount = std::atoi(args[++i]);
+			continue;
+		}
+		else if (std::strcmp(args[i], "--startup-trace") == 0) {
+			if (i + 1 < args.count)
+				options.startupTracePath = args[++i];
+			continue;
+		}
+		else if (std::strcmp(args[i], "--ipc") == 0) {
+			options.ipcBridge = true;
+			if (i + 1 < args.count && args[i + 1][0] != '-')
+				options.ipcChannel = args[++i];
+			continue;
+		}
+		else if (std::strcmp(args[i], "--telemetry") == 0) {
+			options.telemetry = true;
+			if (i + 1 < args.count && args[i + 1][0] != '-')
+				options.telemetryAddress = args[++i];
+			continue;
+		}
+		else if (std::strcmp(args[i], "--windows") == 0) {
+			options.toolWindowCount = 2;
+			if (i + 1 < args.count && args[i + 1][0] != '-')
+				options.toolWindowCount = std::atoi(args[++i]);
+			continue;
+		}
+		else if (std::strcmp(args[i], "--scene-bench") == 0) {
+			options.mode = SandboxMode::SceneBenchmark;
+			if (i + 1 < args.count && args[i + 1][0] != '-')
+				options.sceneEntityCount = std::atoi(args[++i]);
+			continue;
+		}
+		else if (std::strcmp(args[i], "--stress") == 0) {
+			options.mode = SandboxMode::StressTest;
+			if (i + 1 < args.count && args[i + 1][0] != '-')
+				options.stress.layerCount = std::atoi(args[++i]);
+			if (i + 1 < args.count && args[i + 1][0] != '-')
+				options.stress.observerCount = std::atoi(args[++i]);
+			if (i + 1 < args.count && args[i + 1][0] != '-')
+				options.stress.frameCount = std::atoi(args[++i]);
+			continue;
+		}
+		else if (std::strcmp(args[i], "--stress-events") == 0) {
+			if (i + 1 < args.count)
+				options.stress.eventsPerFrame = std::atoi(args[++i]);
+			continue;
+		}
+		else if (std::strcmp(args[i], "--stress-payload") == 0) {
+			if (i + 1 < args.count)
+				options.stress.payloadBytes = std::atoi(args[++i]);
+			continue;
+		}
+		else if (std::strcmp(args[i], "--stress-report") == 0) {
+			if (i + 1 < args.count)
+				options.stress.reportPath = args[++i];
+			continue;
+		}
+		else if (std::strcmp(args[i], "--help") == 0) {
+			PrintUsage(args[0]);
+			std::exit(0);
+		}
+
+		std::fprintf(stderr, "Unknown argument: %s\n", args[i]);
+		PrintUsage(args[0]);
+		std::exit(1);
+	}
+	return options;
+}
+
 class SandboxApp : public Jerboa::Application
 {
 public:
-	SandboxApp()
+	SandboxApp(const Jerboa::ApplicationProps& props, const SandboxOptions& options)
+		: Application(props), mOptions(options)
 	{
 		JERBOA_LOG_INFO("SanboxApp created");
 	}
 
-	virtual void OnStart() {
+	virtual void OnInit() override {
 		JERBOA_LOG_INFO("SandboxApp started");
+		if (mOptions.toolWindowCount > 0)
+			OpenToolWindows(mOptions.toolWindowCount);
+
+		switch (mOptions.mode) {
+			case SandboxMode::Renderer2DStress:
+				PushLayer(new Renderer2DStressLayer(mOptions.spriteCount));
+				return;
+			case SandboxMode::Renderer2DBenchmark:
+				PushLayer(new Renderer2DStressLayer(mOptions.spriteCount, mOptions.frameCount));
+				return;
+			case SandboxMode::EcsBenchmark:
+				PushLayer(new EcsBenchmarkLayer(mOptions.entityCount));
+				return;
+			case SandboxMode::TransformBenchmark:
+				PushLayer(new TransformBenchmarkLayer(mOptions.nodeCount));
+				return;
+			case SandboxMode::MathBenchmark:
+				PushLayer(new MathBenchmarkLayer(mOptions.mathCount));
+				return;
+			case SandboxMode::SpatialBenchmark:
+				PushLayer(new SpatialBenchmarkLayer(mOptions.objectCount));
+				return;
+			case SandboxMode::AllocationCheck:
+				PushLayer(new Renderer2DStressLayer(20000));
+				PushOverlay(new AllocationCheckLayer(mOptions.checkFrames));
+				return;
+			case SandboxMode::AssetBenchmark:
+				PushLayer(new AssetBenchmarkLayer(mOptions.textureCount));
+				return;
+			case SandboxMode::SceneBenchmark:
+				PushLayer(new SceneBenchmarkLayer(mOptions.sceneEntityCount));
+				return;
+			case SandboxMode::StressTest:
+				PushStressTest(mOptions.stress);
+				return;
+			default:
+				break;
+		}
 		
+		// Other processes can message the test layers, see ExternalMessageEvent for the format
+		if (Jerboa::IPCBridge::IsRunning())
+			Jerboa::IPCBridge::RegisterHandler(ExternalMessageEvent::IPCType, ExternalMessageEvent::IPCVersion, ExternalMessageEvent::IPCVersion, &ExternalMessageEvent::PublishFromIPC);
+
 		auto* testOverlay = new TestOverlay();
 		PushOverlay(testOverlay);
 		PushLayer(new TestLayer());
 		PushLayer(new TestLayer());
 		
 		testOverlay->SendMessageEvent("yoooo");
-		Jerboa::Layer::GetSharedEventBus()->Publish(ExternalMessageEvent("hiiii", "SandBoxApp"));
+		Jerboa::Layer::GetSharedEventBus()->Publish(ExternalMessageEvent("hiiii", Jerboa::StringTable::Intern("SandBoxApp")));
 	}
 
 	~SandboxApp()
 	{
 		JERBOA_LOG_INFO("SanboxApp destroyed");
 	}
+private:
+	// Every window draws the same texture, uploaded once through the main window's context
+	void OpenToolWindows(uint32_t count) {
+		const uint32_t checkerSize = 8;
+		std::vector<uint32_t> pixels(checkerSize * checkerSize);
+		for (uint32_t y = 0; y < checkerSize; y++)
+			for (uint32_t x = 0; x < checkerSize; x++)
+				pixels[y * checkerSize + x] = ((x + y) % 2) ? 0xffffffff : 0xff4080c0;
+		mSharedTexture = Jerboa::Texture2D::Create(checkerSize, checkerSize);
+		mSharedTexture->SetData(pixels.data());
+
+		for (uint32_t i = 0; i < count; i++) {
+			Jerboa::WindowProps props("Sandbox tool window " + std::to_string(i + 1), 480, 320);
+			const float speed = 0.5f + i * 0.25f;
+			OpenWindow(props, [this, speed](Jerboa::Window&) {
+				const float rotation = static_cast<float>(Jerboa::Time::Now() / 1e9) * speed;
+				Jerboa::Renderer2D::BeginScene(-1.0f, 1.0f, -1.0f, 1.0f);
+				for (int y = -2; y <= 2; y++)
+					for (int x = -2; x <= 2; x++)
+						Jerboa::Renderer2D::DrawRotatedQuad(x * 0.4f, y * 0.4f, 0.0f, 0.3f, 0.3f, rotation, mSharedTexture);
+				Jerboa::Renderer2D::EndScene();
+			});
+		}
+		JERBOA_LOG_INFO("Opened {} tool windows sharing the main window's context", count);
+	}
+
+	void PushStressTest(const StressSettings& settings) {
+		auto* driver = new StressDriverLayer(settings);
+		const uint32_t layerCount = std::max(settings.layerCount, 1u);
+		for (uint32_t i = 0; i < layerCount; i++) {
+			uint32_t observerCount = settings.observerCount / layerCount + (i < settings.observerCount % layerCount ? 1 : 0);
+			PushLayer(new StressLayer(i, observerCount, driver->GetCounters()));
+		}
+		PushOverlay(driver);
+	}
+
+	SandboxOptions mOptions;
+	std::shared_ptr<Jerboa::Texture2D> mSharedTexture;
 };
 
-Jerboa::Application* Jerboa::CreateApplication() {
-	return new SandboxApp();
-}
\ No newline at end of file
+Jerboa::Application* Jerboa::CreateApplication(Jerboa::ApplicationCommandLineArgs args) {
+	SandboxOptions options = ParseOptions(args);
+
+	Jerboa::ApplicationProps props;
+	props.commandLineArgs = args;
+	props.startupTracePath = options.startupTracePath;
+	props.ipcBridge = options.ipcBridge;
+	if (!options.ipcChannel.empty())
+		props.ipcBridgeSettings.channel = options.ipcChannel;
+	props.telemetry = options.telemetry;
+	if (!options.telemetryAddress.empty() && options.telemetryAddress.find_first_not_of("0123456789") == std::string::npos)
+		props.telemetrySettings.tcpPort = (uint16_t)std::atoi(options.telemetryAddress.c_str());
+	else if (!options.telemetryAddress.empty())
+		props.telemetrySettings.socketPath = options.telemetryAddress;
+	// Benchmarks run headless, e.g. under xvfb-run with Mesa's llvmpipe
+	props.windowProps.visible = options.mode == SandboxMode::Default || options.mode == SandboxMode::Renderer2DStress;
+
+	return new SandboxApp(props, options);
+}
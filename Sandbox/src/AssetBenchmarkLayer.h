@@ -0,0 +1,228 @@
+#pragma once
+
+#include "Jerboa/Debug.h"
+#include "Jerboa/Core/Layer.h"
+#include "Jerboa/Core/Application.h"
+#include "Jerboa/Core/Time.h"
+#include "Jerboa/Assets/AssetManager.h"
+#include "Jerboa/Assets/ImageCodec.h"
+#include "Jerboa/Renderer/Texture.h"
+
+#include <vector>
+#include <string>
+#include <filesystem>
+#include <fstream>
+#include <algorithm>
+#include <cstdio>
+
+// Writes a set of TGA textures and packs the same textures into an archive, then loads
+// them three times: blocking on the main thread, asynchronously from the loose files and
+// asynchronously from the mapped archive. Prints how long the main thread stalled and how
+// long it took until every texture was usable, then closes the application. Exits with
+// status 1 if any texture failed to load.
+class AssetBenchmarkLayer : public Jerboa::Layer
+{
+public:
+	AssetBenchmarkLayer(uint32_t textureCount = 32)
+		: Layer("AssetBenchmarkLayer"), mTextureCount(std::max(textureCount, 1u)) {}
+
+	virtual void OnAttach() override {
+		Jerboa::Application::Get().GetWindow().SetVSync(false);
+		std::filesystem::create_directories(Directory);
+
+		Jerboa::AssetArchiveWriter writer;
+		std::vector<uint8_t> pixels((size_t)TextureSize * TextureSize * 4), encoded;
+		for (uint32_t i = 0; i < mTextureCount; i++) {
+			for (uint32_t y = 0; y < TextureSize; y++) {
+				for (uint32_t x = 0; x < TextureSize; x++) {
+					uint8_t* pixel = &pixels[((size_t)y * TextureSize + x) * 4];
+					pixel[0] = (uint8_t)(x + i);
+					pixel[1] = (uint8_t)(y * 2);
+					pixel[2] = (uint8_t)((x ^ y) + i * 16);
+					pixel[3] = 0xff;
+				}
+			}
+
+			mPaths.push_back(std::string(Directory) + "/texture" + std::to_string(i) + ".tga");
+			Jerboa::ImageCodec::EncodeTGA(pixels.data(), TextureSize, TextureSize, encoded);
+			std::ofstream(mPaths.back(), std::ios::binary).write(reinterpret_cast<const char*>(encoded.data()), encoded.size());
+			writer.AddTexture(mPaths.back(), TextureSize, TextureSize, pixels.data());
+		}
+		writer.Write(ArchivePath);
+
+		std::printf("Asset benchmark: %u textures of %ux%u\n", mTextureCount, TextureSize, TextureSize);
+	}
+
+	~AssetBenchmarkLayer() {
+		// Runs after the asset manager unmapped the archive
+		std::error_code error;
+		std::filesystem::remove_all(Directory, error);
+	}
+
+	virtual void OnUpdate() override {
+		// The time since the last update covers the whole previous frame, including the
+		// asset uploads that ran right before this update
+		Jerboa::Timestamp now = Jerboa::Time::Now();
+		double frameMs = mLastFrame > 0 ? Jerboa::Time::ToMilliseconds(now - mLastFrame) : 0.0;
+		mLastFrame = now;
+
+		switch (mPhase) {
+		case Phase::Idle:
+			if (mFrame > 0)
+				mIdleFrameMs.push_back(frameMs);
+			if (++mFrame == IdleFrames)
+				StartPhase(Phase::Blocking);
+			break;
+		case Phase::Blocking:
+			// The loads happened during the previous frame
+			RecordFrame(frameMs);
+			mTextures.clear();
+			StartPhase(Phase::Loose);
+			break;
+		case Phase::Loose:
+		case Phase::Archive:
+			RecordFrame(frameMs);
+			if (std::all_of(mHandles.begin(), mHandles.end(), [](const Jerboa::TextureHandle& handle) { return handle.GetState() != Jerboa::AssetState::Loading; }))
+				FinishAsyncPhase();
+			break;
+		case Phase::Draining:
+			// Released textures are unloaded by the asset manager's next update
+			StartPhase(Phase::Archive);
+			break;
+		default:
+			break;
+		}
+	}
+private:
+	static constexpr const char* Directory = "asset-bench";
+	static constexpr const char* ArchivePath = "asset-bench/textures.jpak";
+	static constexpr uint32_t TextureSize = 512;
+	static constexpr uint32_t IdleFrames = 30;
+
+	enum class Phase { Idle, Blocking, Loose, Draining, Archive, Done };
+
+	struct PhaseResult
+	{
+		const char* name;
+		double issueMs = 0.0;
+		double worstFrameMs = 0.0;
+		double totalMs = 0.0;
+		uint32_t frames = 0;
+	};
+
+	void StartPhase(Phase phase) {
+		mPhase = phase;
+		mPhaseStart = Jerboa::Time::Now();
+		switch (phase) {
+		case Phase::Blocking:
+			mResults.push_back({ "blocking ifstream" });
+			if (!LoadBlocking()) {
+				Fail("could not decode a benchmark texture");
+				return;
+			}
+			break;
+		case Phase::Loose:
+			mResults.push_back({ "async loose files" });
+			LoadAsync();
+			break;
+		case Phase::Archive: {
+			mResults.push_back({ "async archive" });
+			Jerboa::Timestamp mountStart = Jerboa::Time::Now();
+			if (!Jerboa::AssetManager::MountArchive(ArchivePath)) {
+				Fail("could not mount the benchmark archive");
+				return;
+			}
+			mMountMs = Jerboa::Time::ToMilliseconds(Jerboa::Time::Now() - mountStart);
+			LoadAsync();
+			break;
+		}
+		default:
+			break;
+		}
+		mResults.back().issueMs = Jerboa::Time::ToMilliseconds(Jerboa::Time::Now() - mPhaseStart);
+	}
+
+	bool LoadBlocking() {
+		std::vector<uint8_t> pixels;
+		for (const std::string& path : mPaths) {
+			std::ifstream file(path, std::ios::binary);
+			std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+			uint32_t width = 0, height = 0;
+			if (!Jerboa::ImageCodec::DecodeTGA(data.data(), data.size(), pixels, width, height))
+				return false;
+
+			mTextures.push_back(Jerboa::Texture2D::Create(width, height));
+			mTextures.back()->SetData(pixels.data());
+		}
+		return true;
+	}
+
+	void LoadAsync() {
+		for (const std::string& path : mPaths)
+			mHandles.push_back(Jerboa::AssetManager::LoadTexture(path));
+	}
+
+	void RecordFrame(double frameMs) {
+		PhaseResult& result = mResults.back();
+		result.worstFrameMs = std::max(result.worstFrameMs, frameMs);
+		result.frames++;
+		result.totalMs = Jerboa::Time::ToMilliseconds(Jerboa::Time::Now() - mPhaseStart);
+	}
+
+	void FinishAsyncPhase() {
+		uint32_t ready = 0;
+		for (const Jerboa::TextureHandle& handle : mHandles)
+			ready += handle.IsReady() && handle.Get() && handle.Get()->GetWidth() == TextureSize ? 1 : 0;
+		if (ready != mTextureCount) {
+			Fail("not every benchmark texture loaded");
+			return;
+		}
+		mHandles.clear();
+
+		if (mPhase == Phase::Loose) {
+			mPhase = Phase::Draining;
+			return;
+		}
+
+		mPhase = Phase::Done;
+		Report();
+		Jerboa::Application::Get().Close();
+	}
+
+	// Checked in every configuration, a broken pipeline must not report timings
+	void Fail(const char* failure) {
+		std::fprintf(stderr, "Asset benchmark failed: %s\n", failure);
+		mPhase = Phase::Done;
+		Jerboa::Application::Get().Close(1);
+	}
+
+	void Report() {
+		std::sort(mIdleFrameMs.begin(), mIdleFrameMs.end());
+		double idleMs = mIdleFrameMs.empty() ? 0.0 : mIdleFrameMs[mIdleFrameMs.size() / 2];
+		Jerboa::AssetManager::Statistics stats = Jerboa::AssetManager::GetStats();
+
+		std::printf("Asset benchmark: median idle frame %.2f ms, archive mapped in %.3f ms\n", idleMs, mMountMs);
+		for (const PhaseResult& result : mResults) {
+			std::printf("  %-18s issue %8.2f ms, worst frame %8.2f ms, all ready after %8.2f ms over %u frames\n",
+				result.name, result.issueMs, result.worstFrameMs, result.totalMs, result.frames);
+		}
+		std::printf("  %u loaded from files, %u from archives, %u failed, %.1f MB uploaded, worst upload slice %.2f ms\n",
+			stats.fileLoads, stats.archiveLoads, stats.failedLoads, stats.uploadedBytes / (1024.0 * 1024.0), stats.maxUploadMs);
+		std::fflush(stdout);
+	}
+
+	uint32_t mTextureCount;
+	std::vector<std::string> mPaths;
+
+	Phase mPhase = Phase::Idle;
+	uint32_t mFrame = 0;
+	Jerboa::Timestamp mLastFrame = 0;
+	Jerboa::Timestamp mPhaseStart = 0;
+	std::vector<double> mIdleFrameMs;
+	std::vector<PhaseResult> mResults;
+	double mMountMs = 0.0;
+
+	std::vector<std::shared_ptr<Jerboa::Texture2D>> mTextures;
+	std::vector<Jerboa::TextureHandle> mHandles;
+};
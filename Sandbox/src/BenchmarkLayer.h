@@ -0,0 +1,61 @@
+#pragma once
+
+#include "Jerboa/Core/Layer.h"
+#include "Jerboa/Core/Application.h"
+#include "Jerboa/Core/Time.h"
+
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <type_traits>
+#include <cstdio>
+
+// Base of the Sandbox benchmarks that measure everything on their first update. Run()
+// prints the report and returns false if a check failed, then the application closes with
+// exit status 1. Reports and checks use printf, so they work in Release where logging and
+// asserts are compiled out.
+class BenchmarkLayer : public Jerboa::Layer
+{
+public:
+	BenchmarkLayer(const std::string& name)
+		: Layer(name) {}
+
+	virtual void OnUpdate() override {
+		const bool passed = Run();
+		std::fflush(stdout);
+		Jerboa::Application::Get().Close(passed ? 0 : 1);
+	}
+protected:
+	static constexpr int Repetitions = 15;
+
+	virtual bool Run() = 0;
+
+	// Median of repetitions runs of function(). If function() returns a double it is taken as
+	// the time of the run in milliseconds, so it can leave setup and checks out of the timing.
+	template<typename Function>
+	static double MedianMilliseconds(Function&& function, int repetitions = Repetitions) {
+		std::vector<double> times;
+		for (int i = 0; i < repetitions; i++) {
+			if constexpr (std::is_same_v<decltype(function()), double>)
+				times.push_back(function());
+			else {
+				Jerboa::Timestamp start = Jerboa::Time::Now();
+				function();
+				times.push_back(Since(start));
+			}
+		}
+		std::sort(times.begin(), times.end());
+		return times[times.size() / 2];
+	}
+
+	static double Since(Jerboa::Timestamp start) {
+		return Jerboa::Time::ToMilliseconds(Jerboa::Time::Now() - start);
+	}
+
+	// Prints what went wrong if condition is false and returns condition
+	static bool Check(bool condition, const char* failure) {
+		if (!condition)
+			std::fprintf(stderr, "Benchmark check failed: %s\n", failure);
+		return condition;
+	}
+};
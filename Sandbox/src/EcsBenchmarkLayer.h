@@ -0,0 +1,140 @@
+#pragma once
+
+#include "BenchmarkLayer.h"
+#include "Jerboa/Debug.h"
+#include "Jerboa/Core/JobSystem.h"
+#include "Jerboa/Scene/World.h"
+#include "Jerboa/Scene/SystemScheduler.h"
+
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <cstdio>
+
+// Measures the ECS on the first update, prints a report and closes the application:
+// creation, serial and parallel iteration over entityCount entities compared with
+// heap-allocated objects with virtual updates, structural changes and a scheduled frame.
+class EcsBenchmarkLayer : public BenchmarkLayer
+{
+public:
+	EcsBenchmarkLayer(uint32_t entityCount = 1000000)
+		: BenchmarkLayer("EcsBenchmarkLayer"), mEntityCount(entityCount) {}
+private:
+	struct Position { float x, y, z; };
+	struct Velocity { float x, y, z; };
+	struct Health { float value; };
+	struct Selected {};
+
+	// What game code does without the ECS
+	struct GameObject
+	{
+		virtual ~GameObject() = default;
+		virtual void Update(float deltaTime) = 0;
+	};
+
+	struct MovingObject : GameObject
+	{
+		Position position = { 0.0f, 0.0f, 0.0f };
+		Velocity velocity = { 1.0f, 0.5f, 0.25f };
+
+		virtual void Update(float deltaTime) override {
+			position.x += velocity.x * deltaTime;
+			position.y += velocity.y * deltaTime;
+			position.z += velocity.z * deltaTime;
+		}
+	};
+
+	static constexpr float DeltaTime = 1.0f / 60.0f;
+
+	void Report(const char* name, double milliseconds, uint32_t count) {
+		std::printf("  %-28s %9.3f ms  %7.2f ns/op\n", name, milliseconds, milliseconds * 1e6 / count);
+	}
+
+	virtual bool Run() override {
+		std::printf("ECS benchmark: %u entities, %u worker threads\n", mEntityCount, Jerboa::JobSystem::GetWorkerCount());
+
+		Jerboa::World world;
+		std::vector<Jerboa::Entity> entities(mEntityCount);
+
+		Jerboa::Timestamp start = Jerboa::Time::Now();
+		uint32_t withHealth = mEntityCount / 2;
+		world.CreateEntities(withHealth, entities.data(), Position{ 0.0f, 0.0f, 0.0f }, Velocity{ 1.0f, 0.5f, 0.25f }, Health{ 100.0f });
+		world.CreateEntities(mEntityCount - withHealth, entities.data() + withHealth, Position{ 0.0f, 0.0f, 0.0f }, Velocity{ 1.0f, 0.5f, 0.25f });
+		Report("create", Since(start), mEntityCount);
+
+		auto move = world.GetQuery<Position, const Velocity>();
+		Report("iterate", MedianMilliseconds([&]() {
+			move.ForEach([](Position& position, const Velocity& velocity) {
+				position.x += velocity.x * DeltaTime;
+				position.y += velocity.y * DeltaTime;
+				position.z += velocity.z * DeltaTime;
+			});
+		}), mEntityCount);
+
+		Report("iterate chunks", MedianMilliseconds([&]() {
+			move.ForEachChunk([](uint32_t count, const Jerboa::Entity*, Position* positions, const Velocity* velocities) {
+				for (uint32_t i = 0; i < count; i++) {
+					positions[i].x += velocities[i].x * DeltaTime;
+					positions[i].y += velocities[i].y * DeltaTime;
+					positions[i].z += velocities[i].z * DeltaTime;
+				}
+			});
+		}), mEntityCount);
+
+		Report("iterate parallel", MedianMilliseconds([&]() {
+			move.ParallelForEach([](Position& position, const Velocity& velocity) {
+				position.x += velocity.x * DeltaTime;
+				position.y += velocity.y * DeltaTime;
+				position.z += velocity.z * DeltaTime;
+			});
+		}), mEntityCount);
+
+		{
+			std::vector<std::unique_ptr<GameObject>> objects;
+			objects.reserve(mEntityCount);
+			for (uint32_t i = 0; i < mEntityCount; i++)
+				objects.push_back(std::make_unique<MovingObject>());
+
+			Report("virtual objects (baseline)", MedianMilliseconds([&]() {
+				for (auto& object : objects)
+					object->Update(DeltaTime);
+			}), mEntityCount);
+		}
+
+		Jerboa::SystemScheduler scheduler;
+		scheduler.AddSystem<Position, const Velocity>("Move", [](auto& query) {
+			query.ParallelForEach([](Position& position, const Velocity& velocity) {
+				position.x += velocity.x * DeltaTime;
+				position.y += velocity.y * DeltaTime;
+				position.z += velocity.z * DeltaTime;
+			});
+		});
+		scheduler.AddSystem<Health>("Regenerate", [](auto& query) {
+			query.ForEach([](Health& health) { health.value = std::min(health.value + DeltaTime, 100.0f); });
+		});
+		scheduler.AddSystem<const Position>("Bounds", [](auto& query) {
+			float maxX = 0.0f;
+			query.ForEach([&maxX](const Position& position) { maxX = std::max(maxX, position.x); });
+		});
+		scheduler.LogStages();
+		Report("scheduled frame", MedianMilliseconds([&]() { scheduler.Run(world); }), mEntityCount);
+
+		const uint32_t structuralCount = std::min(mEntityCount, 100000u);
+		Report("add + remove component", MedianMilliseconds([&]() {
+			for (uint32_t i = 0; i < structuralCount; i++)
+				world.AddComponent<Selected>(entities[i]);
+			for (uint32_t i = 0; i < structuralCount; i++)
+				world.RemoveComponent<Selected>(entities[i]);
+		}, 5) / 2.0, structuralCount);
+
+		start = Jerboa::Time::Now();
+		for (Jerboa::Entity entity : entities)
+			world.DestroyEntity(entity);
+		Report("destroy", Since(start), mEntityCount);
+
+		std::printf("  %u archetypes\n", world.GetArchetypeCount());
+		return true;
+	}
+
+	uint32_t mEntityCount;
+};
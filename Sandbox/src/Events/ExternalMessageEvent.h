@@ -1,12 +1,31 @@
 #pragma once
 
 #include "Jerboa/Core/Event.h"
+#include "Jerboa/Core/EventBus.h"
+#include "Jerboa/Core/FrameAllocator.h"
+#include "JerboaIPC/IPCChannel.h"
 #include "MessageEvent.h"
-#include <string>
+
+#include <string_view>
 
 class ExternalMessageEvent : public MessageEvent {
 public:
-	ExternalMessageEvent(const std::string& message, const std::string& sender) 
+	ExternalMessageEvent(std::string_view message, Jerboa::StringID sender) 
 		: MessageEvent(message, sender) {}
-};
 
+	// Sent by other processes over the IPCBridge. The payload is the length of the sender's
+	// name in one byte, the name, then the message text up to the end of the payload.
+	static constexpr uint32_t IPCType = 1;
+	static constexpr uint16_t IPCVersion = 1;
+
+	static bool PublishFromIPC(const Jerboa::IPCMessage& message, Jerboa::EventBus* eventBus) {
+		if (message.size < 1 || message.size < 1u + message.payload[0])
+			return false;
+
+		const char* text = reinterpret_cast<const char*>(message.payload);
+		const std::string_view sender(text + 1, message.payload[0]);
+		const std::string_view body(text + 1 + sender.size(), message.size - 1 - sender.size());
+		eventBus->Publish(ExternalMessageEvent(Jerboa::FrameAllocator::CopyString(body), Jerboa::StringTable::Intern(sender)));
+		return true;
+	}
+};
@@ -1,17 +1,16 @@
 #pragma once
 
 #include "Jerboa/Core/Event.h"
-#include <string>
+#include "Jerboa/Core/StringTable.h"
+#include <string_view>
 
 class MessageEvent : public Jerboa::Event
 {
 public:
-	MessageEvent(const std::string& message, const std::string& sender) {
-		mMessage = message;
-		mSender = sender;
-	}
+	// The message has to stay valid for the frame, e.g. a literal or a FrameAllocator::CopyString()
+	MessageEvent(std::string_view message, Jerboa::StringID sender)
+		: mMessage(message), mSender(sender) {}
 
-	std::string mMessage;
-	std::string mSender;
+	std::string_view mMessage;
+	Jerboa::StringID mSender;
 };
-
@@ -0,0 +1,20 @@
+#pragma once
+
+#include "Jerboa/Core/Event.h"
+#include <cstdint>
+
+// The stress test spreads its observers over this many event types on the shared bus
+constexpr int StressChannelCount = 4;
+
+template<int Channel>
+class StressEvent : public Jerboa::Event
+{
+public:
+	// The payload has to stay valid for the frame, e.g. a FrameAllocator::CopyArray()
+	StressEvent(const uint8_t* payload, uint32_t size, uint32_t sequence)
+		: mPayload(payload), mSize(size), mSequence(sequence) {}
+
+	const uint8_t* mPayload;
+	uint32_t mSize;
+	uint32_t mSequence;
+};
@@ -0,0 +1,146 @@
+#pragma once
+
+#include "BenchmarkLayer.h"
+#include "Jerboa/Debug.h"
+#include "Jerboa/Math/MathKernels.h"
+#include "Jerboa/Math/Quaternion.h"
+
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+// Times every MathKernels batch kernel at each SIMD level the CPU supports, checks the
+// results against the scalar reference, prints a report and closes the application.
+class MathBenchmarkLayer : public BenchmarkLayer
+{
+public:
+	MathBenchmarkLayer(uint32_t count = 1 << 20)
+		: BenchmarkLayer("MathBenchmarkLayer"), mCount(std::max(count, 1u)) {}
+private:
+	virtual bool Run() override {
+		std::printf("Math benchmark: %u elements, %s supported\n", mCount, Jerboa::MathKernels::GetLevelName(Jerboa::MathKernels::GetSupportedLevel()));
+
+		Jerboa::SimdLevel defaultLevel = Jerboa::MathKernels::GetLevel();
+		RunBenchmarks();
+		Jerboa::MathKernels::SetLevel(defaultLevel);
+		return true;
+	}
+
+	static std::vector<Jerboa::SimdLevel> GetLevels() {
+		std::vector<Jerboa::SimdLevel> levels = { Jerboa::SimdLevel::Scalar };
+		if (Jerboa::MathKernels::GetSupportedLevel() >= Jerboa::SimdLevel::SSE2)
+			levels.push_back(Jerboa::SimdLevel::SSE2);
+		if (Jerboa::MathKernels::GetSupportedLevel() >= Jerboa::SimdLevel::AVX2)
+			levels.push_back(Jerboa::SimdLevel::AVX2);
+		return levels;
+	}
+
+	// Runs benchmark(level) for every level and reports the time per element relative to
+	// the scalar reference. check() returns the deviation from the scalar results.
+	template<typename Benchmark, typename Check>
+	void Measure(const char* name, uint32_t count, Benchmark&& benchmark, Check&& check) {
+		double scalarMilliseconds = 0.0;
+		for (Jerboa::SimdLevel level : GetLevels()) {
+			Jerboa::MathKernels::SetLevel(level);
+			double milliseconds = MedianMilliseconds(benchmark);
+			if (level == Jerboa::SimdLevel::Scalar)
+				scalarMilliseconds = milliseconds;
+
+			std::printf("  %-18s %-6s %8.3f ms  %6.2f ns/op  %5.2fx  deviation %.9g\n", name, Jerboa::MathKernels::GetLevelName(level),
+				milliseconds, milliseconds * 1e6 / count, scalarMilliseconds / milliseconds, static_cast<double>(check(level)));
+		}
+	}
+
+	void RunBenchmarks() {
+		std::mt19937 random(42);
+		std::uniform_real_distribution<float> coordinate(-200.0f, 200.0f);
+		std::uniform_real_distribution<float> size(0.5f, 5.0f);
+		std::uniform_real_distribution<float> angle(-3.14159f, 3.14159f);
+
+		// Transform points
+		{
+			std::vector<Jerboa::Vec3> points(mCount), out(mCount), reference(mCount);
+			for (Jerboa::Vec3& point : points)
+				point = { coordinate(random), coordinate(random), coordinate(random) };
+			Jerboa::Mat4 transform = Jerboa::ComposeTransform({ 1.0f, 2.0f, 3.0f }, Jerboa::Quat::FromEuler({ 0.3f, -0.7f, 1.1f }), { 2.0f, 2.0f, 2.0f });
+
+			Measure("transform points", mCount, [&]() {
+				Jerboa::MathKernels::TransformPoints(transform, points.data(), out.data(), mCount);
+			}, [&](Jerboa::SimdLevel level) {
+				if (level == Jerboa::SimdLevel::Scalar)
+					reference = out;
+				float maxError = 0.0f;
+				for (uint32_t i = 0; i < mCount; i++)
+					maxError = std::max(maxError, Jerboa::Length(out[i] - reference[i]));
+				return maxError;
+			});
+		}
+
+		// Multiply matrices
+		{
+			const uint32_t count = std::max(mCount / 4, 1u);
+			std::vector<Jerboa::Mat4> a(count), b(count), out(count), reference(count);
+			for (uint32_t i = 0; i < count; i++) {
+				Jerboa::Quat rotation = Jerboa::Quat::FromEuler({ angle(random), angle(random), angle(random) });
+				a[i] = Jerboa::ComposeTransform({ coordinate(random), coordinate(random), coordinate(random) }, rotation, { size(random), size(random), size(random) });
+				b[i] = Jerboa::ComposeTransform({ coordinate(random), coordinate(random), coordinate(random) }, Jerboa::Conjugate(rotation), { 1.0f, 1.0f, 1.0f });
+			}
+
+			Measure("multiply matrices", count, [&]() {
+				Jerboa::MathKernels::MultiplyMatrices(a.data(), b.data(), out.data(), count);
+			}, [&](Jerboa::SimdLevel level) {
+				if (level == Jerboa::SimdLevel::Scalar)
+					reference = out;
+				float maxError = 0.0f;
+				for (uint32_t i = 0; i < count; i++)
+					for (int j = 0; j < 16; j++)
+						maxError = std::max(maxError, std::abs(out[i].m[j] - reference[i].m[j]));
+				return maxError;
+			});
+		}
+
+		// Frustum culling, bounds placed so roughly a tenth of them are visible
+		Jerboa::Mat4 viewProjection = Jerboa::Mat4::Perspective(1.0472f, 16.0f / 9.0f, 0.1f, 250.0f)
+			* Jerboa::Mat4::LookAt({ 0.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, -1.0f }, { 0.0f, 1.0f, 0.0f });
+		Jerboa::Frustum frustum = Jerboa::Frustum::FromMatrix(viewProjection);
+		std::vector<uint8_t> visible(mCount), reference(mCount);
+		uint32_t visibleCount = 0;
+		auto countMismatches = [&](Jerboa::SimdLevel level) {
+			if (level == Jerboa::SimdLevel::Scalar)
+				reference = visible;
+			uint32_t mismatches = 0;
+			for (uint32_t i = 0; i < mCount; i++)
+				mismatches += visible[i] != reference[i];
+			return mismatches;
+		};
+
+		{
+			std::vector<Jerboa::Sphere> spheres(mCount);
+			for (Jerboa::Sphere& sphere : spheres)
+				sphere = { { coordinate(random), coordinate(random), coordinate(random) }, size(random) };
+
+			Measure("cull spheres", mCount, [&]() {
+				visibleCount = Jerboa::MathKernels::CullSpheres(frustum, spheres.data(), visible.data(), mCount);
+			}, countMismatches);
+			std::printf("  %u of %u spheres visible\n", visibleCount, mCount);
+		}
+
+		{
+			std::vector<Jerboa::AABB> boxes(mCount);
+			for (Jerboa::AABB& box : boxes) {
+				Jerboa::Vec3 center = { coordinate(random), coordinate(random), coordinate(random) };
+				Jerboa::Vec3 extents = { size(random), size(random), size(random) };
+				box = { center - extents, center + extents };
+			}
+
+			Measure("cull AABBs", mCount, [&]() {
+				visibleCount = Jerboa::MathKernels::CullAABBs(frustum, boxes.data(), visible.data(), mCount);
+			}, countMismatches);
+			std::printf("  %u of %u boxes visible\n", visibleCount, mCount);
+		}
+	}
+
+	uint32_t mCount;
+};
@@ -0,0 +1,154 @@
+#pragma once
+
+#include "Jerboa/Debug.h"
+#include "Jerboa/Core/Layer.h"
+#include "Jerboa/Core/Application.h"
+#include "Jerboa/Core/Time.h"
+#include "Jerboa/Renderer/Renderer2D.h"
+#include "Jerboa/Renderer/GLStateCache.h"
+#include "Jerboa/Profiling/GPUProfiler.h"
+#include "imgui.h"
+
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <cstdio>
+
+// Bounces a large number of sprites around the screen through Renderer2D.
+// With benchmarkFrames > 0 it records that many frames, prints a frame-time
+// report and closes the application.
+class Renderer2DStressLayer : public Jerboa::Layer
+{
+public:
+	Renderer2DStressLayer(uint32_t spriteCount = 100000, uint32_t benchmarkFrames = 0)
+		: Layer("Renderer2DStressLayer"), mBenchmarkFrames(benchmarkFrames)
+	{
+		SetSpriteCount(spriteCount);
+	}
+
+	virtual void OnAttach() override {
+		const uint32_t checkerSize = 8;
+		std::vector<uint32_t> pixels(checkerSize * checkerSize);
+		for (uint32_t y = 0; y < checkerSize; y++)
+			for (uint32_t x = 0; x < checkerSize; x++)
+				pixels[y * checkerSize + x] = ((x + y) % 2) ? 0xffffffff : 0xff808080;
+
+		mCheckerTexture = Jerboa::Texture2D::Create(checkerSize, checkerSize);
+		mCheckerTexture->SetData(pixels.data());
+
+		if (mBenchmarkFrames > 0) {
+			Jerboa::Application::Get().GetWindow().SetVSync(false);
+			mFrameTimes.reserve(mBenchmarkFrames);
+		}
+
+		JERBOA_LOG_INFO("Renderer2DStressLayer attached ({} sprites)", mPositions.size() / 2);
+	}
+
+	virtual void OnUpdate() override {
+		Jerboa::Timestamp now = Jerboa::Time::Now();
+		float deltaTime = mLastFrame ? static_cast<float>((now - mLastFrame) / 1e9) : 0.0f;
+		mLastFrame = now;
+		mLastFrameTime = deltaTime;
+
+		if (mBenchmarkFrames > 0 && deltaTime > 0.0f)
+			RecordFrame(deltaTime);
+
+		Jerboa::Renderer2D::BeginScene(-1.0f, 1.0f, -1.0f, 1.0f);
+
+		const size_t spriteCount = mPositions.size() / 2;
+		for (size_t i = 0; i < spriteCount; i++) {
+			float& x = mPositions[i * 2];
+			float& y = mPositions[i * 2 + 1];
+			float& vx = mVelocities[i * 2];
+			float& vy = mVelocities[i * 2 + 1];
+
+			x += vx * deltaTime;
+			y += vy * deltaTime;
+			if (x < -1.0f || x > 1.0f) vx = -vx;
+			if (y < -1.0f || y > 1.0f) vy = -vy;
+
+			if (i % 4 == 0)
+				Jerboa::Renderer2D::DrawQuad(x, y, 0.0f, 0.01f, 0.01f, mCheckerTexture, mColors[i]);
+			else
+				Jerboa::Renderer2D::DrawQuad(x, y, 0.0f, 0.01f, 0.01f, mColors[i]);
+		}
+
+		Jerboa::Renderer2D::DrawCircle(0.0f, 0.0f, 0.1f, 0.25f, { 1.0f, 1.0f, 1.0f, 0.5f }, 0.05f);
+		Jerboa::Renderer2D::DrawLine(-1.0f, 0.0f, 1.0f, 0.0f, { 1.0f, 0.0f, 0.0f, 1.0f });
+		Jerboa::Renderer2D::DrawLine(0.0f, -1.0f, 0.0f, 1.0f, { 0.0f, 1.0f, 0.0f, 1.0f });
+
+		Jerboa::Renderer2D::EndScene();
+		mLastStats = Jerboa::Renderer2D::GetStats();
+		mBufferStalls += mLastStats.bufferStalls;
+	}
+
+	virtual void OnImGuiRender() override {
+		ImGui::Begin("Renderer2D Stress");
+		ImGui::Text("Frame time: %.3f ms (GPU %.3f ms)", mLastFrameTime * 1000.0f, Jerboa::GPUProfiler::GetLastFrameTime());
+		ImGui::Text("Draw calls: %u", mLastStats.drawCalls);
+		ImGui::Text("Quads: %u  Circles: %u  Lines: %u", mLastStats.quadCount, mLastStats.circleCount, mLastStats.lineCount);
+		ImGui::Text("Streaming buffer stalls: %llu", static_cast<unsigned long long>(mLastStats.bufferStalls));
+
+		const auto& glStats = Jerboa::GLStateCache::GetStats();
+		ImGui::Text("GL state calls: %u issued, %u skipped", glStats.issued, glStats.skipped);
+
+		int spriteCount = static_cast<int>(mPositions.size() / 2);
+		if (ImGui::SliderInt("Sprites", &spriteCount, 1000, 500000))
+			SetSpriteCount(spriteCount);
+		ImGui::End();
+	}
+private:
+	void SetSpriteCount(uint32_t count) {
+		std::mt19937 random(1337);
+		std::uniform_real_distribution<float> position(-1.0f, 1.0f);
+		std::uniform_real_distribution<float> velocity(-0.5f, 0.5f);
+		std::uniform_real_distribution<float> channel(0.2f, 1.0f);
+
+		mPositions.resize(count * 2);
+		mVelocities.resize(count * 2);
+		mColors.resize(count);
+		for (uint32_t i = 0; i < count; i++) {
+			mPositions[i * 2] = position(random);
+			mPositions[i * 2 + 1] = position(random);
+			mVelocities[i * 2] = velocity(random);
+			mVelocities[i * 2 + 1] = velocity(random);
+			mColors[i] = { channel(random), channel(random), channel(random), 1.0f };
+		}
+	}
+
+	void RecordFrame(float deltaTime) {
+		mFrameTimes.push_back(deltaTime * 1000.0f);
+		if (mFrameTimes.size() < mBenchmarkFrames)
+			return;
+
+		std::sort(mFrameTimes.begin(), mFrameTimes.end());
+		float sum = 0.0f;
+		for (float frameTime : mFrameTimes)
+			sum += frameTime;
+
+		auto percentile = [&](float p) { return mFrameTimes[std::min(mFrameTimes.size() - 1, static_cast<size_t>(mFrameTimes.size() * p))]; };
+		// printf rather than the log, which Release builds compile out
+		std::printf("Renderer2D benchmark: %zu sprites, %zu frames, %u draw calls/frame\n", mPositions.size() / 2, mFrameTimes.size(), static_cast<unsigned>(mLastStats.drawCalls));
+		std::printf("  frame time mean %.3f ms, p50 %.3f ms, p99 %.3f ms, max %.3f ms\n",
+			sum / mFrameTimes.size(), percentile(0.5f), percentile(0.99f), mFrameTimes.back());
+		// Any stall means the streaming buffers are too small for the frames in flight
+		std::printf("  %llu streaming buffer stalls in total\n", static_cast<unsigned long long>(mBufferStalls));
+		if (Jerboa::GPUProfiler::IsSupported())
+			std::printf("  last resolved GPU frame time %.3f ms\n", static_cast<double>(Jerboa::GPUProfiler::GetLastFrameTime()));
+		std::fflush(stdout);
+
+		Jerboa::Application::Get().Close();
+	}
+
+	std::vector<float> mPositions;
+	std::vector<float> mVelocities;
+	std::vector<Jerboa::Color> mColors;
+	std::shared_ptr<Jerboa::Texture2D> mCheckerTexture;
+
+	uint32_t mBenchmarkFrames;
+	std::vector<float> mFrameTimes;
+	Jerboa::Timestamp mLastFrame = 0;
+	float mLastFrameTime = 0.0f;
+	Jerboa::Renderer2D::Statistics mLastStats;
+	uint64_t mBufferStalls = 0;
+};
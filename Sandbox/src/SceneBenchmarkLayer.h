@@ -0,0 +1,238 @@
+#pragma once
+
+#include "BenchmarkLayer.h"
+#include "Jerboa/Debug.h"
+#include "Jerboa/Core/JobSystem.h"
+#include "Jerboa/Scene/World.h"
+#include "Jerboa/Scene/SceneSerializer.h"
+
+#include <vector>
+#include <string>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <limits>
+#include <algorithm>
+#include <cstdio>
+
+// Saves a scene of entityCount entities as text, which is what a straightforward
+// serializer does, and in the binary scene format with and without compression, then
+// loads each back into an empty world and checks it against the original. Also reads the
+// positions in place from the mapped uncompressed file. Prints a report and closes the
+// application, with exit status 1 if any scene doesn't match.
+class SceneBenchmarkLayer : public BenchmarkLayer
+{
+public:
+	SceneBenchmarkLayer(uint32_t entityCount = 1000000)
+		: BenchmarkLayer("SceneBenchmarkLayer"), mEntityCount(std::max(entityCount, 1u)) {}
+
+	virtual void OnAttach() override {
+		Jerboa::SceneSerializer::RegisterComponent<Position>("Position");
+		Jerboa::SceneSerializer::RegisterComponent<Velocity>("Velocity");
+		Jerboa::SceneSerializer::RegisterComponent<Health>("Health");
+		Jerboa::SceneSerializer::RegisterComponent<Color>("Color");
+		std::filesystem::create_directories(Directory);
+	}
+
+	~SceneBenchmarkLayer() {
+		std::error_code error;
+		std::filesystem::remove_all(Directory, error);
+	}
+
+private:
+	struct Position { float x, y, z; };
+	struct Velocity { float x, y, z; };
+	struct Health { float value; };
+	struct Color { uint32_t rgba; };
+
+	// Entity kinds, also the first column of a line in the text format
+	enum Kind { Moving, Damageable, Decoration, KindCount };
+
+	struct Checksum
+	{
+		double positions = 0.0;
+		double others = 0.0;
+		uint32_t entities = 0;
+
+		bool operator==(const Checksum& other) const {
+			return positions == other.positions && others == other.others && entities == other.entities;
+		}
+	};
+
+	static constexpr const char* Directory = "scene-bench";
+	// Saving and loading a million entities takes long enough that fewer runs settle
+	static constexpr int SceneRepetitions = 5;
+
+	static uint64_t GetFileSize(const std::string& path) {
+		std::error_code error;
+		return std::filesystem::file_size(path, error);
+	}
+
+	void Report(const char* name, double saveMs, double loadMs, const std::string& path) {
+		std::printf("  %-18s save %9.2f ms  load %9.2f ms  %8.2f MB  %7.1f ns/entity loaded\n",
+			name, saveMs, loadMs, GetFileSize(path) / (1024.0 * 1024.0), loadMs * 1e6 / mEntityCount);
+	}
+
+	// Sums are taken in a fixed order so identical worlds give identical results
+	static Checksum GetChecksum(Jerboa::World& world) {
+		Checksum checksum;
+		world.GetQuery<const Position>().ForEach([&](const Position& position) {
+			checksum.positions += (double)position.x + position.y * 2.0 + position.z * 3.0;
+			checksum.entities++;
+		});
+		world.GetQuery<const Velocity>().ForEach([&](const Velocity& velocity) { checksum.others += (double)velocity.x + velocity.y + velocity.z; });
+		world.GetQuery<const Health>().ForEach([&](const Health& health) { checksum.others += health.value; });
+		world.GetQuery<const Color>().ForEach([&](const Color& color) { checksum.others += color.rgba; });
+		return checksum;
+	}
+
+	void CreateScene(Jerboa::World& world) {
+		std::mt19937 random(11);
+		std::uniform_real_distribution<float> position(-1000.0f, 1000.0f);
+		std::uniform_real_distribution<float> velocity(-5.0f, 5.0f);
+		std::uniform_int_distribution<uint32_t> health(1, 100);
+		const uint32_t palette[] = { 0xff0000ff, 0xff00ff00, 0xffff0000, 0xffffffff };
+
+		for (uint32_t i = 0; i < mEntityCount; i++) {
+			Position p{ position(random), position(random), position(random) };
+			switch (i % KindCount) {
+			case Moving:
+				world.CreateEntity(p, Velocity{ velocity(random), velocity(random), 0.0f });
+				break;
+			case Damageable:
+				world.CreateEntity(p, Velocity{ 0.0f, 0.0f, 0.0f }, Health{ (float)health(random) });
+				break;
+			default:
+				world.CreateEntity(p, Color{ palette[i % 4] });
+				break;
+			}
+		}
+	}
+
+	// Reference text serializer: one line per entity, floats with enough digits to round trip
+	static void SaveText(Jerboa::World& world, const std::string& path) {
+		std::ofstream file(path);
+		file.precision(std::numeric_limits<float>::max_digits10);
+		world.GetQuery<const Position, const Velocity>().ForEach([&](Jerboa::Entity entity, const Position& position, const Velocity& velocity) {
+			const Health* health = world.TryGetComponent<Health>(entity);
+			file << (health ? Damageable : Moving) << ' ' << position.x << ' ' << position.y << ' ' << position.z
+				<< ' ' << velocity.x << ' ' << velocity.y << ' ' << velocity.z;
+			if (health)
+				file << ' ' << health->value;
+			file << '\n';
+		});
+		world.GetQuery<const Position, const Color>().ForEach([&](const Position& position, const Color& color) {
+			file << Decoration << ' ' << position.x << ' ' << position.y << ' ' << position.z << ' ' << color.rgba << '\n';
+		});
+	}
+
+	static void LoadText(Jerboa::World& world, const std::string& path) {
+		std::ifstream file(path);
+		int kind;
+		Position position;
+		Velocity velocity;
+		Health health;
+		Color color;
+		while (file >> kind >> position.x >> position.y >> position.z) {
+			if (kind == Decoration) {
+				file >> color.rgba;
+				world.CreateEntity(position, color);
+				continue;
+			}
+
+			file >> velocity.x >> velocity.y >> velocity.z;
+			if (kind == Damageable) {
+				file >> health.value;
+				world.CreateEntity(position, velocity, health);
+			}
+			else {
+				world.CreateEntity(position, velocity);
+			}
+		}
+	}
+
+	virtual bool Run() override {
+		std::printf("Scene benchmark: %u entities, %u worker threads\n", mEntityCount, Jerboa::JobSystem::GetWorkerCount());
+
+		Jerboa::World world;
+		Jerboa::Timestamp start = Jerboa::Time::Now();
+		CreateScene(world);
+		const Checksum expected = GetChecksum(world);
+		std::printf("  created in %.2f ms\n", Since(start));
+
+		const std::string textPath = std::string(Directory) + "/scene.txt";
+		const std::string rawPath = std::string(Directory) + "/scene-raw.jscene";
+		const std::string compressedPath = std::string(Directory) + "/scene.jscene";
+
+		// Text is slow enough that one run says enough
+		start = Jerboa::Time::Now();
+		SaveText(world, textPath);
+		double saveMs = Since(start);
+		bool matches = true;
+		double loadMs = MedianMilliseconds([&]() {
+			Jerboa::World loaded;
+			Jerboa::Timestamp loadStart = Jerboa::Time::Now();
+			LoadText(loaded, textPath);
+			double milliseconds = Since(loadStart);
+			matches &= GetChecksum(loaded) == expected;
+			return milliseconds;
+		}, 1);
+		if (!Check(matches, "the text scene doesn't match the original"))
+			return false;
+		Report("text (reference)", saveMs, loadMs, textPath);
+
+		for (bool compress : { false, true }) {
+			const std::string& path = compress ? compressedPath : rawPath;
+			bool saved = true;
+			saveMs = MedianMilliseconds([&]() {
+				Jerboa::Timestamp saveStart = Jerboa::Time::Now();
+				saved &= Jerboa::SceneSerializer::Save(world, path, compress);
+				return Since(saveStart);
+			}, SceneRepetitions);
+			if (!Check(saved, "could not save the benchmark scene"))
+				return false;
+
+			loadMs = MedianMilliseconds([&]() {
+				Jerboa::World loaded;
+				Jerboa::Timestamp loadStart = Jerboa::Time::Now();
+				bool loadedScene = Jerboa::SceneSerializer::Load(loaded, path);
+				double milliseconds = Since(loadStart);
+				matches &= loadedScene && GetChecksum(loaded) == expected;
+				return milliseconds;
+			}, SceneRepetitions);
+			if (!Check(matches, "the binary scene doesn't match the original"))
+				return false;
+			Report(compress ? "binary compressed" : "binary", saveMs, loadMs, path);
+		}
+
+		// No world at all: map the file and walk the position columns where they lie
+		double viewMs = MedianMilliseconds([&]() {
+			Jerboa::Timestamp viewStart = Jerboa::Time::Now();
+			Jerboa::SceneFile file;
+			if (!file.Open(rawPath)) {
+				matches = false;
+				return 0.0;
+			}
+
+			Checksum checksum;
+			const int32_t positionRecord = file.FindComponent("Position");
+			for (uint32_t i = 0; i < file.GetChunkCount(); i++) {
+				const Jerboa::SceneChunkRecord& chunk = file.GetChunk(i);
+				const int32_t column = file.GetColumn(file.GetArchetype(chunk.archetype), positionRecord);
+				const Position* positions = reinterpret_cast<const Position*>(file.GetRawChunk(chunk) + file.GetColumnOffset(chunk, column));
+				for (uint32_t row = 0; row < chunk.entityCount; row++)
+					checksum.positions += (double)positions[row].x + positions[row].y * 2.0 + positions[row].z * 3.0;
+				checksum.entities += chunk.entityCount;
+			}
+			double milliseconds = Since(viewStart);
+			matches &= checksum.positions == expected.positions && checksum.entities == expected.entities;
+			return milliseconds;
+		}, SceneRepetitions);
+		if (!Check(matches, "the mapped scene doesn't match the original"))
+			return false;
+		std::printf("  %-18s open + read positions in place %9.2f ms\n", "binary mapped", viewMs);
+		return true;
+	}
+
+	uint32_t mEntityCount;
+};
@@ -0,0 +1,247 @@
+#pragma once
+
+#include "BenchmarkLayer.h"
+#include "Jerboa/Debug.h"
+#include "Jerboa/Spatial/DynamicAABBTree.h"
+#include "Jerboa/Spatial/UniformGrid.h"
+
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+// Runs the same moving-object simulation against the dynamic AABB tree and the uniform
+// grid, once with evenly spread equal objects and once with clustered objects of mixed
+// sizes. Times batch creation, per-frame batch moves, pair finding, box queries and ray
+// casts, checks the results against brute force, prints a report and closes the application.
+class SpatialBenchmarkLayer : public BenchmarkLayer
+{
+public:
+	SpatialBenchmarkLayer(uint32_t objectCount = 20000)
+		: BenchmarkLayer("SpatialBenchmarkLayer"), mObjectCount(std::max(objectCount, 2u)) {}
+private:
+	static constexpr int FrameCount = 60;
+	static constexpr uint32_t QueryCount = 1000;
+	static constexpr uint32_t CheckedQueryCount = 100;
+	static constexpr float DeltaTime = 1.0f / 60.0f;
+
+	struct Workload
+	{
+		const char* name;
+		float worldSize;
+		float cellSize;
+		std::vector<Jerboa::Vec3> positions;
+		std::vector<Jerboa::Vec3> velocities;
+		std::vector<Jerboa::Vec3> extents;
+	};
+
+	struct FrameTimes
+	{
+		double move = 0.0, pairs = 0.0, queries = 0.0, rays = 0.0;
+		uint64_t changes = 0, pairCount = 0;
+	};
+
+	Workload CreateUniformWorkload() {
+		std::mt19937 random(1);
+		Workload workload;
+		workload.name = "uniform";
+		workload.worldSize = std::cbrt((float)mObjectCount) * 3.0f;
+		workload.cellSize = 2.0f;
+
+		std::uniform_real_distribution<float> position(0.0f, workload.worldSize), speed(-2.0f, 2.0f);
+		for (uint32_t i = 0; i < mObjectCount; i++) {
+			workload.positions.push_back({ position(random), position(random), position(random) });
+			workload.velocities.push_back({ speed(random), speed(random), speed(random) });
+			workload.extents.push_back({ 0.5f, 0.5f, 0.5f });
+		}
+		return workload;
+	}
+
+	Workload CreateClusteredWorkload() {
+		std::mt19937 random(2);
+		Workload workload;
+		workload.name = "clustered";
+		workload.worldSize = std::cbrt((float)mObjectCount) * 6.0f;
+		workload.cellSize = 2.0f;
+
+		std::uniform_real_distribution<float> position(0.0f, workload.worldSize), speed(-2.0f, 2.0f), logSize(std::log(0.1f), std::log(4.0f));
+		std::normal_distribution<float> spread(0.0f, workload.worldSize / 16.0f);
+		std::vector<Jerboa::Vec3> clusters;
+		for (int i = 0; i < 8; i++)
+			clusters.push_back({ position(random), position(random), position(random) });
+
+		for (uint32_t i = 0; i < mObjectCount; i++) {
+			const Jerboa::Vec3& cluster = clusters[i % clusters.size()];
+			Jerboa::Vec3 offset = { spread(random), spread(random), spread(random) };
+			Jerboa::Vec3 point = cluster + offset;
+			workload.positions.push_back({ std::fmin(std::fmax(point.x, 0.0f), workload.worldSize), std::fmin(std::fmax(point.y, 0.0f), workload.worldSize),
+				std::fmin(std::fmax(point.z, 0.0f), workload.worldSize) });
+			workload.velocities.push_back({ speed(random), speed(random), speed(random) });
+
+			// A few level-sized objects, the rest spans a factor of 40 in size
+			float size = i % 200 == 0 ? 20.0f : std::exp(logSize(random));
+			workload.extents.push_back({ size, size * 0.5f, size });
+		}
+		return workload;
+	}
+
+	static void GetBounds(const Workload& workload, std::vector<Jerboa::AABB>& bounds) {
+		bounds.resize(workload.positions.size());
+		for (size_t i = 0; i < bounds.size(); i++)
+			bounds[i] = { workload.positions[i] - workload.extents[i], workload.positions[i] + workload.extents[i] };
+	}
+
+	static void Step(Workload& workload) {
+		for (size_t i = 0; i < workload.positions.size(); i++) {
+			Jerboa::Vec3& position = workload.positions[i];
+			Jerboa::Vec3& velocity = workload.velocities[i];
+			position += velocity * DeltaTime;
+			float* coordinates[3] = { &position.x, &position.y, &position.z };
+			float* speeds[3] = { &velocity.x, &velocity.y, &velocity.z };
+			for (int axis = 0; axis < 3; axis++)
+				if (*coordinates[axis] < 0.0f || *coordinates[axis] > workload.worldSize)
+					*speeds[axis] = -*speeds[axis];
+		}
+	}
+
+	virtual bool Run() override {
+		std::printf("Spatial benchmark: %u objects, %d frames\n", mObjectCount, FrameCount);
+
+		const bool uniform = RunWorkload(CreateUniformWorkload());
+		const bool clustered = RunWorkload(CreateClusteredWorkload());
+		return uniform && clustered;
+	}
+
+	// False if the indices disagree with each other or with brute force
+	bool RunWorkload(const Workload& workload) {
+		std::printf("%s workload, world size %.0f\n", workload.name, static_cast<double>(workload.worldSize));
+
+		std::vector<std::vector<Jerboa::ProxyPair>> pairs(2);
+		std::vector<std::vector<float>> rayDistances(2);
+
+		Jerboa::DynamicAABBTree tree;
+		bool matches = RunIndex("AABB tree", tree, workload, pairs[0], rayDistances[0]);
+		std::printf("    height %u, area ratio %.1f\n", tree.GetHeight(), static_cast<double>(tree.GetAreaRatio()));
+		tree.Validate();
+
+		Jerboa::UniformGrid::Settings settings;
+		settings.cellSize = workload.cellSize;
+		Jerboa::UniformGrid grid(settings);
+		matches &= RunIndex("uniform grid", grid, workload, pairs[1], rayDistances[1]);
+		std::printf("    %u cells, %u oversized proxies\n", grid.GetCellCount(), grid.GetOversizedCount());
+
+		const bool pairsAgree = pairs[0].size() == pairs[1].size() && std::equal(pairs[0].begin(), pairs[0].end(), pairs[1].begin(),
+			[](const Jerboa::ProxyPair& a, const Jerboa::ProxyPair& b) { return a.a == b.a && a.b == b.b; });
+		const bool raysAgree = rayDistances[0] == rayDistances[1];
+		std::printf("  tree and grid agree on pairs: %s, ray hits: %s\n", pairsAgree ? "true" : "false", raysAgree ? "true" : "false");
+		return Check(matches, "a spatial index doesn't match brute force") && Check(pairsAgree && raysAgree, "the AABB tree and the uniform grid disagree");
+	}
+
+	// Runs the simulation on index and returns the final frame's sorted pairs and closest ray
+	// hits, false if they don't match brute force
+	bool RunIndex(const char* name, Jerboa::SpatialIndex& index, Workload workload, std::vector<Jerboa::ProxyPair>& pairs, std::vector<float>& rayDistances) {
+		std::vector<Jerboa::AABB> bounds;
+		GetBounds(workload, bounds);
+		std::vector<Jerboa::ProxyID> proxies(bounds.size());
+
+		Jerboa::Timestamp start = Jerboa::Time::Now();
+		index.CreateProxies(bounds.data(), nullptr, (uint32_t)bounds.size(), proxies.data());
+		double createMilliseconds = Since(start);
+
+		std::mt19937 random(3);
+		std::uniform_real_distribution<float> position(0.0f, workload.worldSize), direction(-1.0f, 1.0f);
+		std::vector<Jerboa::AABB> queries(QueryCount);
+		std::vector<Jerboa::Ray> rays(QueryCount);
+		std::vector<Jerboa::ProxyID> results;
+		std::vector<uint32_t> offsets;
+		std::vector<Jerboa::Vec3> displacements(bounds.size());
+
+		FrameTimes total;
+		for (int frame = 0; frame < FrameCount; frame++) {
+			for (uint32_t i = 0; i < QueryCount; i++) {
+				Jerboa::Vec3 center = { position(random), position(random), position(random) };
+				queries[i] = { center - Jerboa::Vec3{ 2.0f, 2.0f, 2.0f }, center + Jerboa::Vec3{ 2.0f, 2.0f, 2.0f } };
+				rays[i] = { { position(random), position(random), position(random) }, Jerboa::Normalize(Jerboa::Vec3{ direction(random), direction(random), direction(random) }) };
+			}
+
+			Step(workload);
+			GetBounds(workload, bounds);
+			for (size_t i = 0; i < displacements.size(); i++)
+				displacements[i] = workload.velocities[i] * DeltaTime;
+
+			start = Jerboa::Time::Now();
+			total.changes += index.MoveProxies(proxies.data(), bounds.data(), displacements.data(), (uint32_t)bounds.size());
+			Jerboa::Timestamp moved = Jerboa::Time::Now();
+			index.FindPairs(pairs);
+			Jerboa::Timestamp paired = Jerboa::Time::Now();
+			index.QueryBatch(queries.data(), QueryCount, results, offsets);
+			Jerboa::Timestamp queried = Jerboa::Time::Now();
+			rayDistances.clear();
+			for (const Jerboa::Ray& ray : rays) {
+				Jerboa::RayHit hit;
+				rayDistances.push_back(index.RayCastClosest(ray, workload.worldSize, hit) ? hit.distance : -1.0f);
+			}
+			Jerboa::Timestamp cast = Jerboa::Time::Now();
+
+			total.move += Jerboa::Time::ToMilliseconds(moved - start);
+			total.pairs += Jerboa::Time::ToMilliseconds(paired - moved);
+			total.queries += Jerboa::Time::ToMilliseconds(queried - paired);
+			total.rays += Jerboa::Time::ToMilliseconds(cast - queried);
+			total.pairCount += pairs.size();
+		}
+
+		std::printf("  %-13s create %7.2f ms | per frame: move %6.2f ms  pairs %6.2f ms  %u queries %6.2f ms  %u rays %6.2f ms\n",
+			name, createMilliseconds, total.move / FrameCount, total.pairs / FrameCount, QueryCount, total.queries / FrameCount, QueryCount, total.rays / FrameCount);
+		const bool matches = CheckResults(bounds, pairs, queries, results, offsets, rays, rayDistances, workload.worldSize);
+		std::printf("    %.0f pairs and %.0f structural changes per frame, results match brute force: %s\n",
+			(double)total.pairCount / FrameCount, (double)total.changes / FrameCount, matches ? "true" : "false");
+
+		std::sort(pairs.begin(), pairs.end(), [](const Jerboa::ProxyPair& a, const Jerboa::ProxyPair& b) { return a.a != b.a ? a.a < b.a : a.b < b.b; });
+		return matches;
+	}
+
+	// Last frame's results against sort and sweep for the pairs and linear scans for the
+	// first queries and rays. The proxy IDs of both indices are the object indices here.
+	static bool CheckResults(const std::vector<Jerboa::AABB>& bounds, std::vector<Jerboa::ProxyPair> pairs, const std::vector<Jerboa::AABB>& queries,
+		const std::vector<Jerboa::ProxyID>& results, const std::vector<uint32_t>& offsets, const std::vector<Jerboa::Ray>& rays, const std::vector<float>& rayDistances, float maxDistance) {
+		std::vector<uint32_t> order(bounds.size());
+		for (uint32_t i = 0; i < order.size(); i++)
+			order[i] = i;
+		std::sort(order.begin(), order.end(), [&bounds](uint32_t a, uint32_t b) { return bounds[a].min.x < bounds[b].min.x; });
+
+		std::vector<Jerboa::ProxyPair> expected;
+		for (size_t i = 0; i < order.size(); i++)
+			for (size_t j = i + 1; j < order.size() && bounds[order[j]].min.x <= bounds[order[i]].max.x; j++)
+				if (bounds[order[i]].Intersects(bounds[order[j]]))
+					expected.push_back({ std::min(order[i], order[j]), std::max(order[i], order[j]) });
+
+		auto byProxies = [](const Jerboa::ProxyPair& a, const Jerboa::ProxyPair& b) { return a.a != b.a ? a.a < b.a : a.b < b.b; };
+		std::sort(expected.begin(), expected.end(), byProxies);
+		std::sort(pairs.begin(), pairs.end(), byProxies);
+		bool matches = pairs.size() == expected.size()
+			&& std::equal(pairs.begin(), pairs.end(), expected.begin(), [](const Jerboa::ProxyPair& a, const Jerboa::ProxyPair& b) { return a.a == b.a && a.b == b.b; });
+
+		for (uint32_t query = 0; query < CheckedQueryCount && matches; query++) {
+			std::vector<Jerboa::ProxyID> found(results.begin() + offsets[query], results.begin() + offsets[query + 1]);
+			std::vector<Jerboa::ProxyID> overlapping;
+			for (uint32_t i = 0; i < bounds.size(); i++)
+				if (bounds[i].Intersects(queries[query]))
+					overlapping.push_back(i);
+			std::sort(found.begin(), found.end());
+			matches = found == overlapping;
+		}
+
+		for (uint32_t ray = 0; ray < CheckedQueryCount && matches; ray++) {
+			Jerboa::Vec3 inverseDirection = rays[ray].GetInverseDirection();
+			float closest = -1.0f, distance;
+			for (const Jerboa::AABB& box : bounds)
+				if (Jerboa::IntersectRay(box, rays[ray], inverseDirection, maxDistance, distance) && (closest < 0.0f || distance < closest))
+					closest = distance;
+			matches = closest == rayDistances[ray];
+		}
+		return matches;
+	}
+
+	uint32_t mObjectCount;
+};
@@ -0,0 +1,154 @@
+#pragma once
+
+#include "Jerboa/Debug.h"
+#include "Jerboa/Core/Layer.h"
+#include "Jerboa/Core/Application.h"
+#include "Jerboa/Core/FrameAllocator.h"
+#include "Jerboa/Core/Time.h"
+#include "StressLayer.h"
+#include "Events/StressEvent.h"
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <algorithm>
+
+struct StressSettings
+{
+	uint32_t layerCount = 2000;
+	// Spread evenly over the layers
+	uint32_t observerCount = 20000;
+	uint32_t eventsPerFrame = 16;
+	uint32_t payloadBytes = 64;
+	uint32_t frameCount = 1000;
+	std::string reportPath = "stress-report.json";
+};
+
+// Drives the stress test from the top of the layer stack: publishes eventsPerFrame events
+// with freshly copied payloads on the shared bus every frame, rotating over the StressEvent
+// channels. Records frameCount frames after a short warmup, writes the frame-time
+// percentiles of the whole frame, the layer pass and event dispatch to the report, and
+// closes the application.
+class StressDriverLayer : public Jerboa::Layer
+{
+public:
+	StressDriverLayer(const StressSettings& settings)
+		: Layer("StressDriverLayer"), mSettings(settings)
+	{
+		mSettings.frameCount = std::max(mSettings.frameCount, 1u);
+	}
+
+	StressCounters* GetCounters() { return &mCounters; }
+
+	virtual void OnAttach() override {
+		Jerboa::Application::Get().GetWindow().SetVSync(false);
+
+		mPayload.resize(mSettings.payloadBytes);
+		for (size_t i = 0; i < mPayload.size(); i++)
+			mPayload[i] = (uint8_t)(i * 31 + 7);
+
+		mFrameMs.reserve(mSettings.frameCount);
+		mLayerPassMs.reserve(mSettings.frameCount);
+		mDispatchMs.reserve(mSettings.frameCount);
+
+		JERBOA_LOG_INFO("Stress test: {} layers, {} observers, {} events/frame of {} bytes, {} frames",
+			mSettings.layerCount, mSettings.observerCount, mSettings.eventsPerFrame, mSettings.payloadBytes, mSettings.frameCount);
+	}
+
+	virtual void OnUpdate() override {
+		const Jerboa::Timestamp now = Jerboa::Time::Now();
+		const bool record = mLastFrame && mWarmupFramesLeft == 0;
+		if (record) {
+			mFrameMs.push_back(Jerboa::Time::ToMilliseconds(now - mLastFrame));
+			mLayerPassMs.push_back(mCounters.layerPassStart ? Jerboa::Time::ToMilliseconds(now - mCounters.layerPassStart) : 0.0);
+		}
+		else if (mLastFrame) {
+			mWarmupFramesLeft--;
+		}
+		mLastFrame = now;
+
+		const uint64_t callbacksBefore = mCounters.callbacks;
+		for (uint32_t i = 0; i < mSettings.eventsPerFrame; i++) {
+			const uint8_t* payload = mPayload.empty() ? nullptr : Jerboa::FrameAllocator::CopyArray(mPayload.data(), mPayload.size());
+			const uint32_t size = (uint32_t)mPayload.size();
+			switch (mSequence % StressChannelCount) {
+				case 0: GetSharedEventBus()->Publish(StressEvent<0>(payload, size, mSequence)); break;
+				case 1: GetSharedEventBus()->Publish(StressEvent<1>(payload, size, mSequence)); break;
+				case 2: GetSharedEventBus()->Publish(StressEvent<2>(payload, size, mSequence)); break;
+				default: GetSharedEventBus()->Publish(StressEvent<3>(payload, size, mSequence)); break;
+			}
+			mSequence++;
+		}
+		mCallbacksPerFrame = mCounters.callbacks - callbacksBefore;
+
+		if (record) {
+			mDispatchMs.push_back(Jerboa::Time::ToMilliseconds(Jerboa::Time::Now() - now));
+			if (mFrameMs.size() == mSettings.frameCount) {
+				Report();
+				Jerboa::Application::Get().Close();
+			}
+		}
+	}
+private:
+	static constexpr uint32_t WarmupFrames = 10;
+
+	struct Percentiles
+	{
+		double mean, p50, p90, p95, p99, p999, max;
+	};
+
+	static Percentiles GetPercentiles(std::vector<double> times) {
+		std::sort(times.begin(), times.end());
+		double sum = 0.0;
+		for (double time : times)
+			sum += time;
+		auto percentile = [&](double p) { return times[std::min(times.size() - 1, static_cast<size_t>(times.size() * p))]; };
+		return { sum / times.size(), percentile(0.5), percentile(0.9), percentile(0.95), percentile(0.99), percentile(0.999), times.back() };
+	}
+
+	static void WritePercentiles(std::ofstream& file, const char* name, const Percentiles& p, bool last) {
+		file << "\t\t\"" << name << "\": { \"mean\": " << p.mean << ", \"p50\": " << p.p50 << ", \"p90\": " << p.p90 << ", \"p95\": " << p.p95
+			<< ", \"p99\": " << p.p99 << ", \"p99.9\": " << p.p999 << ", \"max\": " << p.max << " }" << (last ? "\n" : ",\n");
+	}
+
+	void Report() {
+		const Percentiles frame = GetPercentiles(mFrameMs);
+		const Percentiles layerPass = GetPercentiles(mLayerPassMs);
+		const Percentiles dispatch = GetPercentiles(mDispatchMs);
+
+		JERBOA_LOG_INFO("Stress test: {} callbacks/frame, {} frames", mCallbacksPerFrame, mFrameMs.size());
+		for ([[maybe_unused]] auto [name, p] : { std::pair{ "frame", frame }, std::pair{ "layer pass", layerPass }, std::pair{ "dispatch", dispatch } }) {
+			JERBOA_LOG_INFO("  {:<10} mean {:8.3f} ms  p50 {:8.3f}  p90 {:8.3f}  p95 {:8.3f}  p99 {:8.3f}  p99.9 {:8.3f}  max {:8.3f}",
+				name, p.mean, p.p50, p.p90, p.p95, p.p99, p.p999, p.max);
+		}
+
+		if (mSettings.reportPath.empty())
+			return;
+		std::ofstream file(mSettings.reportPath);
+		if (!file) {
+			JERBOA_LOG_ERROR("Could not write the stress report to \"{}\"", mSettings.reportPath);
+			return;
+		}
+
+		file << "{\n\t\"layers\": " << mSettings.layerCount << ",\n\t\"observers\": " << mSettings.observerCount
+			<< ",\n\t\"events_per_frame\": " << mSettings.eventsPerFrame << ",\n\t\"payload_bytes\": " << mSettings.payloadBytes
+			<< ",\n\t\"callbacks_per_frame\": " << mCallbacksPerFrame << ",\n\t\"frames\": " << mFrameMs.size()
+			<< ",\n\t\"checksum\": " << mCounters.payloadChecksum << ",\n\t\"milliseconds\": {\n";
+		WritePercentiles(file, "frame", frame, false);
+		WritePercentiles(file, "layer_pass", layerPass, false);
+		WritePercentiles(file, "dispatch", dispatch, true);
+		file << "\t}\n}\n";
+		JERBOA_LOG_INFO("Wrote the stress report to \"{}\"", mSettings.reportPath);
+	}
+
+	StressSettings mSettings;
+	StressCounters mCounters;
+	std::vector<uint8_t> mPayload;
+	uint32_t mSequence = 0;
+	uint32_t mWarmupFramesLeft = WarmupFrames;
+	uint64_t mCallbacksPerFrame = 0;
+	Jerboa::Timestamp mLastFrame = 0;
+	std::vector<double> mFrameMs;
+	std::vector<double> mLayerPassMs;
+	std::vector<double> mDispatchMs;
+};
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "Jerboa/Core/Layer.h"
+#include "Jerboa/Core/EventObserver.h"
+#include "Jerboa/Core/Time.h"
+#include "Events/StressEvent.h"
+
+#include <vector>
+#include <memory>
+#include <type_traits>
+#include <cstring>
+
+// Shared by the StressLayers and the StressDriverLayer that reports them
+struct StressCounters
+{
+	uint64_t callbacks = 0;
+	uint64_t payloadChecksum = 0;
+	// When the first StressLayer was updated this frame
+	Jerboa::Timestamp layerPassStart = 0;
+};
+
+// One of many layers of the stress test. It owns observerCount observers on the shared bus,
+// spread over the StressEvent channels, which read the whole payload of every event.
+class StressLayer : public Jerboa::Layer
+{
+public:
+	StressLayer(uint32_t index, uint32_t observerCount, StressCounters* counters)
+		: Layer("StressLayer"), mIndex(index), mCounters(counters)
+	{
+		mObservers.reserve(observerCount);
+		for (uint32_t i = 0; i < observerCount; i++) {
+			switch ((index + i) % StressChannelCount) {
+				case 0: mObservers.push_back(std::make_unique<Observer>(this, std::integral_constant<int, 0>())); break;
+				case 1: mObservers.push_back(std::make_unique<Observer>(this, std::integral_constant<int, 1>())); break;
+				case 2: mObservers.push_back(std::make_unique<Observer>(this, std::integral_constant<int, 2>())); break;
+				default: mObservers.push_back(std::make_unique<Observer>(this, std::integral_constant<int, 3>())); break;
+			}
+		}
+	}
+
+	virtual void OnUpdate() override {
+		if (mIndex == 0)
+			mCounters->layerPassStart = Jerboa::Time::Now();
+		mUpdates++;
+	}
+
+	template<int Channel>
+	void OnStressEvent(const StressEvent<Channel>& evnt) {
+		uint64_t checksum = evnt.mSequence;
+		uint32_t offset = 0;
+		for (; offset + sizeof(uint64_t) <= evnt.mSize; offset += sizeof(uint64_t)) {
+			uint64_t word;
+			std::memcpy(&word, evnt.mPayload + offset, sizeof(word));
+			checksum = (checksum ^ word) * 0x100000001b3ull;
+		}
+		for (; offset < evnt.mSize; offset++)
+			checksum = (checksum ^ evnt.mPayload[offset]) * 0x100000001b3ull;
+
+		mCounters->payloadChecksum += checksum;
+		mCounters->callbacks++;
+	}
+private:
+	// EventObservers subscribe by address and can't be moved, so each gets its own allocation
+	struct Observer
+	{
+		template<int Channel>
+		Observer(StressLayer* layer, std::integral_constant<int, Channel>)
+			: observer(Jerboa::EventObserver::Create(GetSharedEventBus(), layer, &StressLayer::OnStressEvent<Channel>)) {}
+
+		Jerboa::EventObserver observer;
+	};
+
+	uint32_t mIndex;
+	StressCounters* mCounters;
+	std::vector<std::unique_ptr<Observer>> mObservers;
+	uint64_t mUpdates = 0;
+};
@@ -17,11 +17,11 @@ public:
 	}
 
 	void OnExternalMessageEvent(const ExternalMessageEvent& evnt) {
-		JERBOA_LOG_TRACE("TestLayer {} received message \"{}\" from \"{}\"", mNumbering, evnt.mMessage, evnt.mSender);
+		JERBOA_LOG_TRACE("TestLayer {} received message \"{}\" from \"{}\"", mNumbering, evnt.mMessage, Jerboa::StringTable::Get(evnt.mSender));
 	}
 
 	void OnMessageEvent(const MessageEvent& evnt) {
-		JERBOA_LOG_TRACE("TestLayer {} received message \"{}\" from \"{}\"", mNumbering, evnt.mMessage, evnt.mSender);
+		JERBOA_LOG_TRACE("TestLayer {} received message \"{}\" from \"{}\"", mNumbering, evnt.mMessage, Jerboa::StringTable::Get(evnt.mSender));
 	}
 
 	virtual void OnAttach() override {
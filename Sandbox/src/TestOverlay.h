@@ -3,6 +3,8 @@
 #include "Jerboa/Debug.h"
 #include "Jerboa/Core/Layer.h"
 #include "Jerboa/Event.h"
+#include "Jerboa/Core/FrameAllocator.h"
+#include "Jerboa/Core/StringTable.h"
 #include "Events/MessageEvent.h"
 #include "Events/ExternalMessageEvent.h"
 #include <string>
@@ -14,10 +16,11 @@ public:
 		: mExternalMessageObserver(Jerboa::EventObserver::Create(GetSharedEventBus(), this, &TestOverlay::OnExternalMessageEvent))
 	{
 		mNumbering = GetNumbering();
+		mSenderName = Jerboa::StringTable::Intern("TestOverlay " + std::to_string(mNumbering));
 	}
 
 	void OnExternalMessageEvent(const ExternalMessageEvent& evnt) {
-		JERBOA_LOG_TRACE("TestOverlay {} received message \"{}\" from \"{}\"", mNumbering, evnt.mMessage, evnt.mSender);
+		JERBOA_LOG_TRACE("TestOverlay {} received message \"{}\" from \"{}\"", mNumbering, evnt.mMessage, Jerboa::StringTable::Get(evnt.mSender));
 	}
 
 	virtual void OnAttach() override {
@@ -28,8 +31,8 @@ public:
 		JERBOA_LOG_INFO("TestOverlay {} deattached", mNumbering);
 	}
 
-	void SendMessageEvent(const std::string& message) {
-		GetSharedEventBus()->Publish(MessageEvent(message, "TestOverlay " + std::to_string(mNumbering)));
+	void SendMessageEvent(std::string_view message) {
+		GetSharedEventBus()->Publish(MessageEvent(Jerboa::FrameAllocator::CopyString(message), mSenderName));
 	}
 private:
 	static int GetNumbering() {
@@ -39,5 +42,6 @@ private:
 
 	Jerboa::EventObserver mExternalMessageObserver;
 	int mNumbering;
+	Jerboa::StringID mSenderName;
 };
 
@@ -0,0 +1,188 @@
+#pragma once
+
+#include "BenchmarkLayer.h"
+#include "Jerboa/Debug.h"
+#include "Jerboa/Core/JobSystem.h"
+#include "Jerboa/Scene/TransformHierarchy.h"
+
+#include <vector>
+#include <unordered_map>
+#include <memory>
+#include <random>
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <cstdio>
+
+// Measures TransformHierarchy::Update on a nodeCount hierarchy with four children per
+// node for full, sparse and single-branch changes, compares the full update with a
+// recursive per-node recompute, checks the results and closes the application.
+class TransformBenchmarkLayer : public BenchmarkLayer
+{
+public:
+	TransformBenchmarkLayer(uint32_t nodeCount = 100000)
+		: BenchmarkLayer("TransformBenchmarkLayer"), mNodeCount(std::max(nodeCount, 2u)) {}
+private:
+	static constexpr uint32_t Branching = 4;
+
+	// What a naive scene graph does: every node owns its children and recomputes its
+	// world matrix from its parent's every frame
+	struct SceneNode
+	{
+		float position[3] = { 0.0f, 0.0f, 0.0f };
+		float rotation[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+		Jerboa::TransformMatrix world;
+		std::vector<std::unique_ptr<SceneNode>> children;
+	};
+
+	static void Report(const char* name, double milliseconds, uint32_t updated) {
+		std::printf("  %-24s %9.3f ms  %8u nodes updated\n", name, milliseconds, updated);
+	}
+
+	void ReportUpdate(const char* name, Jerboa::TransformHierarchy& hierarchy, const std::function<void(int)>& prepare) {
+		// Times only the update, prepare(iteration) makes the changes it processes
+		int iteration = 0;
+		double milliseconds = MedianMilliseconds([&]() {
+			prepare(iteration++);
+			Jerboa::Timestamp start = Jerboa::Time::Now();
+			hierarchy.Update();
+			return Since(start);
+		});
+		Report(name, milliseconds, hierarchy.GetStats().updatedNodes);
+	}
+
+	static void Rotation(float angle, float* quaternion) {
+		quaternion[0] = 0.0f;
+		quaternion[1] = 0.0f;
+		quaternion[2] = std::sin(angle * 0.5f);
+		quaternion[3] = std::cos(angle * 0.5f);
+	}
+
+	static void Compose(const float* position, const float* rotation, const Jerboa::TransformMatrix& parent, Jerboa::TransformMatrix& out) {
+		float x = rotation[0], y = rotation[1], z = rotation[2], w = rotation[3];
+		const float local[16] = {
+			1.0f - 2.0f * (y * y + z * z), 2.0f * (x * y + w * z), 2.0f * (x * z - w * y), 0.0f,
+			2.0f * (x * y - w * z), 1.0f - 2.0f * (x * x + z * z), 2.0f * (y * z + w * x), 0.0f,
+			2.0f * (x * z + w * y), 2.0f * (y * z - w * x), 1.0f - 2.0f * (x * x + y * y), 0.0f,
+			position[0], position[1], position[2], 1.0f
+		};
+		for (int column = 0; column < 4; column++)
+			for (int row = 0; row < 4; row++)
+				out.m[column * 4 + row] = parent.m[row] * local[column * 4] + parent.m[4 + row] * local[column * 4 + 1]
+					+ parent.m[8 + row] * local[column * 4 + 2] + parent.m[12 + row] * local[column * 4 + 3];
+	}
+
+	static void UpdateRecursive(SceneNode& node, const Jerboa::TransformMatrix& parent) {
+		Compose(node.position, node.rotation, parent, node.world);
+		for (auto& child : node.children)
+			UpdateRecursive(*child, node.world);
+	}
+
+	virtual bool Run() override {
+		std::printf("Transform benchmark: %u nodes, %u worker threads\n", mNodeCount, Jerboa::JobSystem::GetWorkerCount());
+
+		std::mt19937 random(42);
+		std::uniform_real_distribution<float> offset(-1.0f, 1.0f);
+
+		Jerboa::TransformHierarchy hierarchy;
+		std::vector<Jerboa::TransformHandle> nodes(mNodeCount);
+		std::vector<float> angles(mNodeCount);
+
+		Jerboa::Timestamp start = Jerboa::Time::Now();
+		for (uint32_t i = 0; i < mNodeCount; i++) {
+			Jerboa::TransformHandle parent = i == 0 ? Jerboa::TransformHandle() : nodes[(i - 1) / Branching];
+			nodes[i] = hierarchy.Create(parent);
+			float rotation[4];
+			angles[i] = offset(random);
+			Rotation(angles[i], rotation);
+			hierarchy.SetLocalPosition(nodes[i], offset(random), offset(random), 0.0f);
+			hierarchy.SetLocalRotation(nodes[i], rotation[0], rotation[1], rotation[2], rotation[3]);
+		}
+		hierarchy.Update();
+		Report("create + first update", Since(start), hierarchy.GetStats().updatedNodes);
+		std::printf("  %u levels\n", hierarchy.GetLevelCount());
+
+		ReportUpdate("all changed", hierarchy, [&](int iteration) {
+			for (uint32_t i = 0; i < mNodeCount; i++)
+				hierarchy.SetLocalPosition(nodes[i], (float)iteration, 0.0f, 0.0f);
+		});
+
+		// Leaves are the last three quarters of the nodes in this layout
+		std::uniform_int_distribution<uint32_t> leaf(mNodeCount / Branching + 1, mNodeCount - 1);
+		ReportUpdate("1% leaves changed", hierarchy, [&](int iteration) {
+			for (uint32_t i = 0; i < mNodeCount / 100; i++)
+				hierarchy.SetLocalPosition(nodes[leaf(random)], (float)iteration, 1.0f, 0.0f);
+		});
+
+		ReportUpdate("one branch changed", hierarchy, [&](int iteration) {
+			hierarchy.SetLocalScale(nodes[1], 1.0f + iteration * 0.01f, 1.0f, 1.0f);
+		});
+
+		ReportUpdate("nothing changed", hierarchy, [](int) {});
+
+		ReportUpdate("100 reparents", hierarchy, [&](int) {
+			for (uint32_t i = 0; i < 100; i++) {
+				Jerboa::TransformHandle node = nodes[leaf(random)];
+				hierarchy.SetParent(node, nodes[random() % (mNodeCount / Branching)]);
+			}
+		});
+
+		// Same hierarchy as a pointer-based scene graph
+		std::vector<SceneNode*> sceneNodes(mNodeCount);
+		auto root = std::make_unique<SceneNode>();
+		sceneNodes[0] = root.get();
+		for (uint32_t i = 1; i < mNodeCount; i++) {
+			auto& children = sceneNodes[(i - 1) / Branching]->children;
+			children.push_back(std::make_unique<SceneNode>());
+			sceneNodes[i] = children.back().get();
+			sceneNodes[i]->position[0] = offset(random);
+			Rotation(angles[i], sceneNodes[i]->rotation);
+		}
+		const Jerboa::TransformMatrix identity = { { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1 } };
+		Report("recursive baseline", MedianMilliseconds([&]() { UpdateRecursive(*root, identity); }), mNodeCount);
+
+		VerifyAgainstReference(hierarchy, nodes, angles);
+		return true;
+	}
+
+	// Resets every node to a transform derived from its index and checks a sample of the
+	// computed world matrices against a scalar product along the parent chain
+	void VerifyAgainstReference(Jerboa::TransformHierarchy& hierarchy, const std::vector<Jerboa::TransformHandle>& nodes, const std::vector<float>& angles) {
+		std::unordered_map<uint32_t, uint32_t> nodeIndex;
+		for (uint32_t i = 0; i < mNodeCount; i++) {
+			float rotation[4];
+			Rotation(angles[i], rotation);
+			hierarchy.SetLocalPosition(nodes[i], 0.001f * i, 0.0f, 0.0f);
+			hierarchy.SetLocalRotation(nodes[i], rotation[0], rotation[1], rotation[2], rotation[3]);
+			hierarchy.SetLocalScale(nodes[i], 1.0f, 1.0f, 1.0f);
+			nodeIndex[nodes[i].index] = i;
+		}
+		hierarchy.Update();
+
+		std::mt19937 random(7);
+		float maxError = 0.0f;
+		for (int sample = 0; sample < 100; sample++) {
+			Jerboa::TransformHandle node = nodes[random() % mNodeCount];
+			std::vector<uint32_t> chain;
+			for (Jerboa::TransformHandle current = node; !current.IsNull(); current = hierarchy.GetParent(current))
+				chain.push_back(nodeIndex[current.index]);
+
+			Jerboa::TransformMatrix world = { { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1 } };
+			for (auto it = chain.rbegin(); it != chain.rend(); ++it) {
+				const float position[3] = { 0.001f * *it, 0.0f, 0.0f };
+				float rotation[4];
+				Rotation(angles[*it], rotation);
+				Jerboa::TransformMatrix next;
+				Compose(position, rotation, world, next);
+				world = next;
+			}
+
+			const Jerboa::TransformMatrix& computed = hierarchy.GetWorldMatrix(node);
+			for (int i = 0; i < 16; i++)
+				maxError = std::max(maxError, std::abs(world.m[i] - computed.m[i]));
+		}
+		std::printf("  max error against scalar reference: %g\n", static_cast<double>(maxError));
+	}
+
+	uint32_t mNodeCount;
+};
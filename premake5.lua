@@ -1,3 +1,8 @@
+newoption {
+	trigger = "memory-tracking",
+	description = "Replace the global operator new/delete to track allocations per subsystem"
+}
+
 workspace "Jerboa"
     architecture "x64"
     targetdir "build"
@@ -10,6 +15,11 @@ workspace "Jerboa"
 	}
 
 	startproject "JerboaClient"
+
+	-- Counts every heap allocation per subsystem tag, see Jerboa/Profiling/MemoryTracker.h
+	filter "options:memory-tracking"
+		defines "JERBOA_MEMORY_TRACKING"
+	filter {}
 	  
 outputdir = "%{cfg.buildcfg}-%{cfg.system}-%{cfg.architecture}"
 
@@ -19,7 +29,8 @@ jerboa_includedirs =  {
 	"thirdparty/glfw/include", 
 	"thirdparty/glad/include",
 	"thirdparty/imgui",
-	"thirdparty/imgui/backends"
+	"thirdparty/imgui/backends",
+	"../JerboaIPC/src"
 }
 
 jerboa_app_includedirs = {}
@@ -27,8 +38,11 @@ for _, v in pairs(jerboa_includedirs) do
 	table.insert(jerboa_app_includedirs, "%{wks.location}/Jerboa/" .. v)
 end
 
+include "JerboaIPC"
 include "Jerboa"
 include "Sandbox"
+include "JerboaBench"
 include "JerboaClient"
+include "JerboaViewer"
 
 
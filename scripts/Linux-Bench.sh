@@ -0,0 +1,15 @@
+#!/bin/sh
+# Runs the engine microbenchmarks, headless so the GLFW benchmarks get a window.
+# Usage: scripts/Linux-Bench.sh [report.json] [baseline.json] [configuration]
+# Exits with 1 if a benchmark regressed against the baseline.
+cd "$(dirname "$0")/.."
+
+REPORT=${1:-bench.json}
+BASELINE=$2
+CONFIG=${3:-Release}
+
+export LIBGL_ALWAYS_SOFTWARE=1
+export GALLIUM_DRIVER=llvmpipe
+
+xvfb-run -a -s "-screen 0 1280x720x24" \
+	"bin/$CONFIG-linux-x86_64/JerboaBench/JerboaBench" --json "$REPORT" ${BASELINE:+--baseline "$BASELINE"}
@@ -0,0 +1,14 @@
+#!/bin/sh
+# Runs the Renderer2D benchmark headless on Mesa's llvmpipe software rasterizer.
+# Usage: scripts/Linux-BenchRenderer2D.sh [sprites] [frames] [configuration]
+cd "$(dirname "$0")/.."
+
+SPRITES=${1:-100000}
+FRAMES=${2:-1000}
+CONFIG=${3:-Release}
+
+export LIBGL_ALWAYS_SOFTWARE=1
+export GALLIUM_DRIVER=llvmpipe
+
+xvfb-run -a -s "-screen 0 1280x720x24" \
+	"bin/$CONFIG-linux-x86_64/Sandbox/Sandbox" --renderer2d-bench "$SPRITES" "$FRAMES"
@@ -0,0 +1,19 @@
+#!/bin/sh
+# Runs the Sandbox stress test headless and writes its frame-time report.
+# Usage: scripts/Linux-StressSandbox.sh [layers] [observers] [frames] [events/frame] [payload bytes] [report] [configuration]
+cd "$(dirname "$0")/.."
+
+LAYERS=${1:-2000}
+OBSERVERS=${2:-20000}
+FRAMES=${3:-1000}
+EVENTS=${4:-16}
+PAYLOAD=${5:-64}
+REPORT=${6:-stress-report.json}
+CONFIG=${7:-Release}
+
+export LIBGL_ALWAYS_SOFTWARE=1
+export GALLIUM_DRIVER=llvmpipe
+
+xvfb-run -a -s "-screen 0 1280x720x24" \
+	"bin/$CONFIG-linux-x86_64/Sandbox/Sandbox" --stress "$LAYERS" "$OBSERVERS" "$FRAMES" \
+	--stress-events "$EVENTS" --stress-payload "$PAYLOAD" --stress-report "$REPORT"